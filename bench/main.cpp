@@ -0,0 +1,138 @@
+#include "nuno_bench_harness.hpp"
+#include "nuno_load_bench.hpp"
+#include "nuno_query_bench.hpp"
+#include "nuno_stage_bench.hpp"
+#include "nuno_trace_bench.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string_view>
+
+namespace nuno::bench
+{
+    std::atomic<size_t> allocations {0};
+    std::atomic<size_t> allocated_bytes {0};
+}
+
+// Counting replacements for the global allocation functions. Every
+// form is replaced, plain and aligned, so that each delete matches the
+// new that allocated.
+
+namespace
+{
+    void* counted_alloc(std::size_t size, std::size_t align)
+    {
+        nuno::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+        nuno::bench::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0)
+            size = 1;
+        if (align <= alignof(std::max_align_t))
+            return std::malloc(size);
+
+        // aligned_alloc wants a multiple of the alignment
+        return std::aligned_alloc(align, (size + align - 1) / align * align);
+    }
+
+    void* counted_new(std::size_t size, std::size_t align)
+    {
+        if (void* p = counted_alloc(size, align))
+            return p;
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size)                                              { return counted_new(size, 0); }
+void* operator new[](std::size_t size)                                            { return counted_new(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al)                         { return counted_new(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al)                       { return counted_new(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept              { return counted_alloc(size, 0); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept            { return counted_alloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al, std::nothrow_t const&) noexcept   { return counted_alloc(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al, std::nothrow_t const&) noexcept { return counted_alloc(size, static_cast<std::size_t>(al)); }
+
+void operator delete(void* p) noexcept                                            { std::free(p); }
+void operator delete[](void* p) noexcept                                          { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept                               { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept                             { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept                          { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                        { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept             { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept           { std::free(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept                     { std::free(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept                   { std::free(p); }
+void operator delete(void* p, std::align_val_t, std::nothrow_t const&) noexcept   { std::free(p); }
+void operator delete[](void* p, std::align_val_t, std::nothrow_t const&) noexcept { std::free(p); }
+
+namespace
+{
+    constexpr std::string_view usage =
+        "usage: bench [--filter text] [--scale x] [--json file|-] [--label text]\n"
+        "  --filter  run only benchmarks whose name contains text\n"
+        "  --scale   multiply the size of the large generated inputs (default 1)\n"
+        "  --json    write the results as JSON to file, or to stdout for -\n"
+        "  --label   recorded in the JSON, f.i. the commit measured\n";
+}
+
+int main(int argc, char** argv)
+{
+    auto& opts = nuno::bench::options();
+    std::string json_path;
+    std::string label;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if      (arg == "--filter" && has_value) opts.filter = argv[++i];
+        else if (arg == "--scale" && has_value)  opts.scale  = std::atof(argv[++i]);
+        else if (arg == "--json" && has_value)   json_path   = argv[++i];
+        else if (arg == "--label" && has_value)  label       = argv[++i];
+        else
+        {
+            std::cerr << usage;
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (opts.scale <= 0)
+    {
+        std::cerr << "--scale must be positive\n";
+        return 1;
+    }
+
+    opts.quiet = json_path == "-";
+
+    #ifdef NUNO_BENCH_LOAD__
+        nuno::bench::run_load_benches();
+    #endif
+
+    #ifdef NUNO_BENCH_QUERY__
+        nuno::bench::run_query_benches();
+    #endif
+
+    #ifdef NUNO_BENCH_STAGE__
+        nuno::bench::run_stage_benches();
+    #endif
+
+    #ifdef NUNO_BENCH_TRACE__
+        nuno::bench::run_trace_benches();
+    #endif
+
+    if (json_path == "-")
+        nuno::bench::write_json(std::cout, label);
+    else if (!json_path.empty())
+    {
+        std::ofstream out(json_path);
+        if (!out)
+        {
+            std::cerr << "cannot write " << json_path << "\n";
+            return 1;
+        }
+        nuno::bench::write_json(out, label);
+    }
+}
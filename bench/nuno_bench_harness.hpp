@@ -0,0 +1,275 @@
+#ifndef NUNO_BENCH_HARNESS__
+#define NUNO_BENCH_HARNESS__
+
+// Benchmarks report wall time and heap traffic per iteration. Heap
+// traffic is counted by the replacement operator new in main.cpp.
+//
+// A benchmark may also state how much work one iteration does (bytes,
+// rows, queries ...) to be reported as a rate, and records the peak
+// resident set size reached while it ran. Results are kept so that
+// main.cpp can write them out as JSON for comparison between commits.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(__linux__) && __has_include(<sys/resource.h>)
+    #include <sys/resource.h>
+#endif
+
+namespace nuno::bench
+{
+    extern std::atomic<size_t> allocations;
+    extern std::atomic<size_t> allocated_bytes;
+
+    // Work done by one iteration, reported per second
+    struct throughput
+    {
+        double           amount {0};
+        std::string_view unit {};    // "MB" counts bytes; anything else is a count
+    };
+
+    struct bench_result
+    {
+        std::string name;
+        std::string group;
+        size_t      iterations;
+        double      ns_per_iteration;
+        double      allocations_per_iteration;
+        double      bytes_per_iteration;
+        double      rate {0};        // units per second, 0 without a throughput
+        std::string unit {};
+        size_t      peak_rss {0};    // bytes, 0 where unsupported
+    };
+
+    struct bench_options
+    {
+        std::string filter;          // run only names containing this
+        double      scale {1.0};     // multiplies the size of the large inputs
+        bool        quiet {false};   // no table on stdout
+    };
+
+    inline bench_options& options()
+    {
+        static bench_options opts;
+        return opts;
+    }
+
+    inline std::vector<bench_result>& results()
+    {
+        static std::vector<bench_result> all;
+        return all;
+    }
+
+    inline std::string& current_group()
+    {
+        static std::string group;
+        return group;
+    }
+
+    // A size scaled by --scale, never below one
+    inline size_t scaled(size_t n)
+    {
+        auto s = static_cast<size_t>(static_cast<double>(n) * options().scale);
+        return s ? s : 1;
+    }
+
+    inline bool selected(std::string_view name)
+    {
+        return name.find(options().filter) != std::string_view::npos;
+    }
+
+//------------------------------------------------------------------------
+// Result sink
+//------------------------------------------------------------------------
+// Benchmarked code passes its results here so that the optimiser cannot
+// drop the work that produced them.
+
+    template<typename T>
+    inline void do_not_optimize(T const& value)
+    {
+    #if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+    #else
+        static volatile char const* sink;
+        sink = reinterpret_cast<char const volatile*>(&value);
+    #endif
+    }
+
+//------------------------------------------------------------------------
+// Peak resident set size
+//------------------------------------------------------------------------
+// On Linux the high-water mark is reset before each benchmark, so that
+// it reports the peak of that benchmark on top of what was resident
+// already. Elsewhere it is the peak of the process so far.
+
+    inline void reset_peak_rss()
+    {
+    #if defined(__linux__)
+        if (std::FILE* f = std::fopen("/proc/self/clear_refs", "w"))
+        {
+            std::fputs("5", f);
+            std::fclose(f);
+        }
+    #endif
+    }
+
+    inline size_t peak_rss()
+    {
+    #if defined(__linux__)
+        std::ifstream status("/proc/self/status");
+        for (std::string line; std::getline(status, line); )
+            if (line.starts_with("VmHWM:"))
+                return std::stoull(line.substr(6)) * 1024;
+        return 0;
+    #elif __has_include(<sys/resource.h>)
+        rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+        #if defined(__APPLE__)
+            return static_cast<size_t>(usage.ru_maxrss);
+        #else
+            return static_cast<size_t>(usage.ru_maxrss) * 1024;
+        #endif
+    #else
+        return 0;
+    #endif
+    }
+
+//------------------------------------------------------------------------
+// Measuring
+//------------------------------------------------------------------------
+
+    // Runs fn once untimed to warm up, then iterations times
+    template<typename Fn>
+    bench_result measure(std::string_view name, size_t iterations, Fn&& fn, throughput work = {})
+    {
+        reset_peak_rss();
+        fn();
+
+        size_t allocs = allocations.load(std::memory_order_relaxed);
+        size_t bytes  = allocated_bytes.load(std::memory_order_relaxed);
+        auto   start  = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; ++i)
+            fn();
+
+        auto   stop = std::chrono::steady_clock::now();
+        double n    = static_cast<double>(iterations);
+        double ns   = std::chrono::duration<double, std::nano>(stop - start).count() / n;
+
+        bench_result r {
+            std::string(name),
+            current_group(),
+            iterations,
+            ns,
+            static_cast<double>(allocations.load(std::memory_order_relaxed) - allocs) / n,
+            static_cast<double>(allocated_bytes.load(std::memory_order_relaxed) - bytes) / n,
+        };
+
+        if (work.amount > 0 && ns > 0)
+        {
+            bool in_bytes = work.unit == "MB";
+            r.rate = (in_bytes ? work.amount / (1024.0 * 1024.0) : work.amount) * 1e9 / ns;
+            r.unit = std::string(work.unit) + "/s";
+        }
+
+        r.peak_rss = peak_rss();
+        return r;
+    }
+
+    inline void report(bench_result r)
+    {
+        if (!options().quiet)
+        {
+            std::cout << std::left  << std::setw(40) << r.name
+                      << std::right << std::fixed << std::setprecision(0)
+                      << std::setw(14) << r.ns_per_iteration << " ns"
+                      << std::setw(12) << r.allocations_per_iteration << " allocs"
+                      << std::setw(14) << r.bytes_per_iteration << " bytes"
+                      << std::setw(8)  << r.peak_rss / (1024 * 1024) << " MB rss";
+
+            if (!r.unit.empty())
+                std::cout << std::setw(14) << std::setprecision(r.rate < 100 ? 1 : 0) << r.rate << " " << r.unit;
+            std::cout << "\n";
+        }
+
+        results().push_back(std::move(r));
+    }
+
+//------------------------------------------------------------------------
+// JSON output
+//------------------------------------------------------------------------
+
+    inline void write_json_string(std::ostream& out, std::string_view s)
+    {
+        out << '"';
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+        out << '"';
+    }
+
+    inline void write_json(std::ostream& out, std::string_view label)
+    {
+        out << "{\n  \"label\": ";
+        write_json_string(out, label);
+        out << ",\n  \"scale\": " << options().scale << ",\n  \"results\": [";
+
+        auto const& all = results();
+        for (size_t i = 0; i < all.size(); ++i)
+        {
+            auto const& r = all[i];
+            out << (i ? ",\n" : "\n") << "    { \"group\": ";
+            write_json_string(out, r.group);
+            out << ", \"name\": ";
+            write_json_string(out, r.name);
+            out << std::setprecision(6) << std::defaultfloat
+                << ", \"iterations\": " << r.iterations
+                << ", \"ns_per_iteration\": " << r.ns_per_iteration
+                << ", \"allocations_per_iteration\": " << r.allocations_per_iteration
+                << ", \"bytes_per_iteration\": " << r.bytes_per_iteration
+                << ", \"peak_rss_bytes\": " << r.peak_rss;
+
+            if (!r.unit.empty())
+            {
+                out << ", \"rate\": " << r.rate << ", \"unit\": ";
+                write_json_string(out, r.unit);
+            }
+            out << " }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    #define RUN_BENCH(name, iterations, ...)                                    \
+        do {                                                                    \
+            if (::nuno::bench::selected(name))                                  \
+                ::nuno::bench::report(::nuno::bench::measure(name, iterations, __VA_ARGS__)); \
+        } while (false)
+
+    // As RUN_BENCH, reporting amount units of work per iteration as a rate
+    #define RUN_BENCH_RATE(name, iterations, amount, unit, ...)                 \
+        do {                                                                    \
+            if (::nuno::bench::selected(name))                                  \
+                ::nuno::bench::report(::nuno::bench::measure(name, iterations, __VA_ARGS__, \
+                    ::nuno::bench::throughput{ static_cast<double>(amount), unit })); \
+        } while (false)
+
+    #define BENCH_GROUP(msg)                                                    \
+        do {                                                                    \
+            ::nuno::bench::current_group() = (msg);                             \
+            if (!::nuno::bench::options().quiet)                                \
+                std::cout << "-------" << (msg) << "--------------\n";          \
+        } while (false)
+}
+
+#endif
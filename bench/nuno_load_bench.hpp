@@ -0,0 +1,73 @@
+#ifndef NUNO_BENCH_LOAD__
+#define NUNO_BENCH_LOAD__
+
+#include "nuno_bench_harness.hpp"
+#include "../include/nuno.hpp"
+
+#include <string>
+
+namespace nuno::bench
+{
+    // A document of the given number of sections, each with a few keys
+    // and a table of rows_per_table rows
+    inline std::string make_load_source(size_t sections, size_t rows_per_table)
+    {
+        std::string src = "version:int = 3\n// generated\n";
+        for (size_t s = 0; s < sections; ++s)
+        {
+            auto n = std::to_string(s);
+            src += "section" + n + ":\n";
+            src += "    name = section " + n + "\n";
+            src += "    weight:float = 1.5\n";
+            src += "    tags:str[] = a|b|c\n";
+            src += "    # id:int  label:str  score:float  flags:int[]\n";
+            for (size_t r = 0; r < rows_per_table; ++r)
+            {
+                auto i = std::to_string(r);
+                src += "      " + i + "  row_label_" + i + "  " + i + ".25  1|2|3\n";
+            }
+            src += "    :nested\n        depth:int = 1\n    /nested\n";
+        }
+        return src;
+    }
+
+    // A single table of string columns whose cells are too long for the
+    // small-string buffer, so that every cell is a heap allocation
+    inline std::string make_text_source(size_t rows)
+    {
+        std::string src = "# name:str  description:str  comment:str\n";
+        for (size_t r = 0; r < rows; ++r)
+        {
+            auto i = std::to_string(r);
+            src += "  entry_with_a_long_name_" + i
+                +  "  a_rather_verbose_description_" + i
+                +  "  and_an_equally_wordy_comment_" + i + "\n";
+        }
+        return src;
+    }
+
+    inline void run_load_benches()
+    {
+        BENCH_GROUP("Load");
+
+        for (auto [sections, rows] : { std::pair<size_t, size_t>{10, 100}, {50, 1000} })
+        {
+            auto src    = make_load_source(sections, rows);
+            auto suffix = " " + std::to_string(sections) + "x" + std::to_string(rows);
+            size_t iterations = sections * rows > 10000 ? 5 : 50;
+
+            RUN_BENCH("parse" + suffix, iterations, [&] { auto ctx = parse(src); });
+
+            RUN_BENCH("load, owning parser data" + suffix, iterations, [&] { auto ctx = load(src); });
+
+            materialiser_options borrowed;
+            borrowed.own_parser_data = false;
+            RUN_BENCH("load, borrowing parser data" + suffix, iterations, [&] { auto ctx = load(src, borrowed); });
+        }
+
+        auto text = make_text_source(20000);
+        RUN_BENCH("load text table, owning 20000", 5, [&] { auto ctx = load(text); });
+    }
+}
+
+#endif
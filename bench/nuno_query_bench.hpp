@@ -0,0 +1,107 @@
+#ifndef NUNO_BENCH_QUERY__
+#define NUNO_BENCH_QUERY__
+
+#include "nuno_bench_harness.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_query.hpp"
+#include "../include/nuno_query_cache.hpp"
+
+#include <string>
+
+namespace nuno::bench
+{
+    // One wide category: width keys, width subcategories and a table of
+    // width rows, so that enumeration cost dominates path depth
+    inline std::string make_wide_source(size_t width)
+    {
+        std::string src = "wide:\n";
+        for (size_t i = 0; i < width; ++i)
+            src += "    key" + std::to_string(i) + ":int = " + std::to_string(i) + "\n";
+
+        src += "    # name  value:int  weight:float\n";
+        for (size_t i = 0; i < width; ++i)
+        {
+            auto n = std::to_string(i);
+            src += "      row" + n + "  " + n + "  " + n + ".5\n";
+        }
+
+        for (size_t i = 0; i < width; ++i)
+            src += "    :sub" + std::to_string(i) + "\n        x:int = 1\n    /sub" + std::to_string(i) + "\n";
+
+        return src;
+    }
+
+    inline void run_query_benches()
+    {
+        BENCH_GROUP("Query");
+
+        for (size_t width : { 100, 2000 })
+        {
+            auto ctx    = load(make_wide_source(width));
+            auto& doc   = ctx.document;
+            auto suffix = " " + std::to_string(width);
+            auto last   = std::to_string(width - 1);
+            size_t iterations = width > 1000 ? 20 : 500;
+
+            RUN_BENCH("select key by name" + suffix, iterations, [&]
+            {
+                do_not_optimize(query(doc, "wide.key" + last).as_integer());
+            });
+
+            RUN_BENCH("select subcategory by name" + suffix, iterations, [&]
+            {
+                do_not_optimize(query(doc, "wide.sub" + last + ".x").as_integer());
+            });
+
+            RUN_BENCH("select row by name" + suffix, iterations, [&]
+            {
+                do_not_optimize(query(doc, "wide.#0.-row" + last + "-.value").as_integer());
+            });
+
+            RUN_BENCH("enumerate rows" + suffix, iterations, [&]
+            {
+                auto q = query(doc, "wide.#0");
+                do_not_optimize(q.rows().locations().size());
+            });
+
+            RUN_BENCH("enumerate column cells" + suffix, iterations, [&]
+            {
+                auto q = query(doc, "wide.#0.|value|");
+                do_not_optimize(q.empty());
+            });
+
+            RUN_BENCH("glob **.x" + suffix, iterations, [&]
+            {
+                auto q = query(doc, "**.x");
+                do_not_optimize(q.empty());
+            });
+
+            RUN_BENCH("glob wide.*.x" + suffix, iterations, [&]
+            {
+                auto q = query(doc, "wide.*.x");
+                do_not_optimize(q.empty());
+            });
+
+            auto wanted = int64_t(width - 1);
+            RUN_BENCH("find value, scanning" + suffix, iterations, [&]
+            {
+                do_not_optimize(doc.find_value(wanted).size());
+            });
+
+            doc.enable_value_index();
+            RUN_BENCH("find value, indexed" + suffix, iterations, [&]
+            {
+                do_not_optimize(doc.find_value(wanted).size());
+            });
+
+            query_cache cache(doc);
+            auto path = "wide.sub" + last + ".x";
+            RUN_BENCH("cached select subcategory" + suffix, iterations, [&]
+            {
+                do_not_optimize(cache.get_integer(path));
+            });
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef NUNO_BENCH_STAGE__
+#define NUNO_BENCH_STAGE__
+
+#include "nuno_bench_harness.hpp"
+#include "nuno_query_bench.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_editor.hpp"
+#include "../include/nuno_query.hpp"
+#include "../include/nuno_serializer.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace nuno::bench
+{
+    // Nested subcategories: branches top-level categories, each depth
+    // levels deep with a key on every level
+    inline std::string make_deep_source(size_t branches, size_t depth)
+    {
+        std::string src;
+        for (size_t b = 0; b < branches; ++b)
+        {
+            src += "b" + std::to_string(b) + ":\n";
+            for (size_t d = 1; d < depth; ++d)
+            {
+                std::string indent(4 * d, ' ');
+                src += indent + ":l" + std::to_string(d) + "\n";
+                src += indent + "    k:int = " + std::to_string(d) + "\n";
+            }
+            for (size_t d = depth; d-- > 1; )
+                src += std::string(4 * d, ' ') + "/l" + std::to_string(d) + "\n";
+        }
+        return src;
+    }
+
+    // One table of mixed scalar columns
+    inline std::string make_table_source(size_t rows)
+    {
+        std::string src = "data:\n    # id:int  name:str  score:float  active:bool\n";
+        src.reserve(src.size() + rows * 40);
+        for (size_t r = 0; r < rows; ++r)
+        {
+            auto i = std::to_string(r);
+            src += "      " + i + "  item_" + i + "  " + i + ".5  " + (r % 2 ? "true" : "false") + "\n";
+        }
+        return src;
+    }
+
+    // Keys holding long arrays, and a table with an array column
+    inline std::string make_array_source(size_t keys, size_t length)
+    {
+        auto array = [length]
+        {
+            std::string a;
+            for (size_t e = 0; e < length; ++e)
+                a += (e ? "|" : "") + std::to_string(e);
+            return a;
+        }();
+
+        std::string src = "arrays:\n";
+        for (size_t k = 0; k < keys; ++k)
+            src += "    a" + std::to_string(k) + ":int[] = " + array + "\n";
+
+        src += "    # name  values:int[]\n";
+        for (size_t k = 0; k < keys; ++k)
+            src += "      r" + std::to_string(k) + "  " + array + "\n";
+        return src;
+    }
+
+    // Mostly paragraphs and comments, with a few keys between them
+    inline std::string make_prose_source(size_t sections)
+    {
+        std::string src;
+        for (size_t s = 0; s < sections; ++s)
+        {
+            auto n = std::to_string(s);
+            src += "chapter" + n + ":\n";
+            src += "    // Notes on chapter " + n + ", kept with the data they describe\n";
+            for (size_t p = 0; p < 4; ++p)
+                src += "    This paragraph of free text is carried through the document unchanged, "
+                       "line by line, so that a round trip reproduces it exactly.\n";
+            src += "\n    title = Chapter " + n + "\n";
+            src += "    pages:int = " + std::to_string(10 + s % 90) + "\n";
+        }
+        return src;
+    }
+
+    struct stage_source
+    {
+        std::string              name;
+        std::string              text;
+        size_t                   iterations;
+        size_t                   rows;      // table rows, reported as rows/s on load
+        std::vector<std::string> paths;     // looked up by the query stage
+        size_t                   lookups;   // per query iteration
+    };
+
+    inline std::vector<stage_source> make_stage_sources()
+    {
+        std::vector<stage_source> sources;
+
+        std::string deepest = "b0";
+        for (size_t d = 1; d < 60; ++d) deepest += ".l" + std::to_string(d);
+        sources.push_back({ "deep", make_deep_source(scaled(200), 60), 3, 0,
+                            { deepest + ".k", "b0.l1.k", "b1.l1.l2.l3.k" }, 1000 });
+
+        size_t width = scaled(20000);
+        auto last = std::to_string(width - 1);
+        sources.push_back({ "wide", make_wide_source(width), 3, width,
+                            { "wide.key" + last, "wide.sub" + last + ".x", "wide.#0.-row" + last + "-.value" }, 100 });
+
+        size_t rows = scaled(1000000);
+        auto mid = std::to_string(rows / 2);
+        // Rows are found by name with a scan, so few lookups
+        sources.push_back({ "table", make_table_source(rows), 1, rows,
+                            { "data.#0.-" + mid + "-.score", "data.#0.-0-.name" }, 10 });
+
+        sources.push_back({ "arrays", make_array_source(scaled(1000), 1000), 3, scaled(1000),
+                            { "arrays.a0", "arrays.#0.-r1-.values" }, 1000 });
+
+        sources.push_back({ "prose", make_prose_source(scaled(20000)), 3, 0,
+                            { "chapter0.title", "chapter" + std::to_string(scaled(20000) - 1) + ".pages" }, 1000 });
+
+        return sources;
+    }
+
+    // Each source through the stages of a document's life: parse,
+    // materialise, query, serialize and edit
+    inline void run_stage_benches()
+    {
+        for (auto& src : make_stage_sources())
+        {
+            BENCH_GROUP("Stages: " + src.name);
+
+            auto name  = [&](std::string_view stage) { return src.name + " " + std::string(stage); };
+            auto bytes = src.text.size();
+            auto n     = src.iterations;
+
+            RUN_BENCH_RATE(name("parse"), n, bytes, "MB", [&] { auto ctx = parse(src.text); });
+
+            // Borrowing leaves the parse context intact between iterations
+            auto parsed = parse(src.text);
+            materialiser_options borrowed;
+            borrowed.own_parser_data = false;
+            RUN_BENCH_RATE(name("materialise"), n, bytes, "MB", [&] { auto ctx = materialise(parsed, borrowed); });
+
+            if (src.rows)
+                RUN_BENCH_RATE(name("load"), n, src.rows, "rows", [&] { auto ctx = load(src.text); });
+
+            auto ctx  = load(src.text);
+            auto& doc = ctx.document;
+
+            RUN_BENCH_RATE(name("query"), n, src.lookups, "queries", [&]
+            {
+                for (size_t i = 0; i < src.lookups; ++i)
+                    do_not_optimize(query(doc, src.paths[i % src.paths.size()]).empty());
+            });
+
+            std::ostringstream sized;
+            serializer(doc).write(sized);
+            RUN_BENCH_RATE(name("serialize"), n, sized.str().size(), "MB", [&]
+            {
+                std::ostringstream out;
+                serializer(doc).write(out);
+            });
+
+            // Rewrite up to a thousand keys and first cells in place
+            constexpr size_t edits = 1000;
+            std::vector<key_id> keys;
+            for (auto k : doc.keys_range())
+                if (keys.size() < edits && !k.is_array()) keys.push_back(k.id());
+
+            std::vector<std::pair<row_id, column_id>> cells;
+            for (auto r : doc.rows_range())
+                if (cells.size() < edits) cells.push_back({ r.id(), r.table().columns().front() });
+
+            editor ed(doc);
+            RUN_BENCH_RATE(name("edit"), n, keys.size() + cells.size(), "edits", [&]
+            {
+                for (auto k : keys)
+                    ed.set_key_value(k, doc.key(k)->value().val);
+                for (auto [r, c] : cells)
+                    ed.set_cell_value(r, c, doc.row(r)->cells()[0].val);
+            });
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef NUNO_BENCH_TRACE__
+#define NUNO_BENCH_TRACE__
+
+#include "nuno_bench_harness.hpp"
+#include "nuno_stage_bench.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_serializer.hpp"
+
+#include <sstream>
+#include <string>
+
+namespace nuno::bench
+{
+    // Per-row cost of the table stages with the echo options off. The
+    // names carry whether tracing is compiled in, so that a build with
+    // -DNUNO_NO_TRACE can be compared against a default one.
+    inline void run_trace_benches()
+    {
+        std::string mode = trace_enabled ? "tracing in" : "tracing out";
+        BENCH_GROUP("Per row, " + mode);
+
+        size_t rows = scaled(200000);
+        auto src    = make_table_source(rows);
+        auto name   = [&](std::string_view stage) { return "per row " + std::string(stage) + ", " + mode; };
+
+        RUN_BENCH_RATE(name("parse"), 5, rows, "rows", [&] { auto ctx = parse(src); });
+
+        auto parsed = parse(src);
+        materialiser_options borrowed;
+        borrowed.own_parser_data = false;
+        RUN_BENCH_RATE(name("materialise"), 5, rows, "rows", [&] { auto ctx = materialise(parsed, borrowed); });
+
+        auto ctx = load(src);
+        RUN_BENCH_RATE(name("serialize"), 5, rows, "rows", [&]
+        {
+            std::ostringstream out;
+            serializer(ctx.document).write(out);
+        });
+    }
+}
+
+#endif
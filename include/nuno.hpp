@@ -67,15 +67,12 @@ namespace nuno
     {
         doc_context out{};
 
-        auto parse_ctx = parse(src, popt);
-        material_context mat_ctx = 
-            mopt.own_parser_data
-                ? materialise(std::move(parse_ctx), mopt)
-                :  materialise(parse_ctx, mopt);
-        out.document = std::move(mat_ctx.document);
+        if (!popt.metrics)
+            popt.metrics = mopt.metrics;
 
-        out.errors.reserve(parse_ctx.errors.size() + mat_ctx.errors.size());
+        auto parse_ctx = parse(src, popt);
 
+        // Collected first: an owning materialiser moves the parse context
         for (auto const & pe : parse_ctx.errors)
         {
             error<any_error> err;
@@ -83,6 +80,14 @@ namespace nuno
             out.errors.push_back(err);
         }
 
+        material_context mat_ctx = 
+            mopt.own_parser_data
+                ? materialise(std::move(parse_ctx), mopt)
+                :  materialise(parse_ctx, mopt);
+        out.document = std::move(mat_ctx.document);
+
+        out.errors.reserve(out.errors.size() + mat_ctx.errors.size());
+
         for (auto const & se : mat_ctx.errors)
         {
             error<any_error> err;
@@ -0,0 +1,1170 @@
+// nuno_cache.hpp - A Readable Format (NUNO) - On-disk parse cache
+// Version 0.3.0
+// Copyright 2025 Mikael Ueno A
+// Licenced as-is under the MIT licence.
+
+//========================================================================
+// The load cache memoises nuno::load() on disk. The cache key is a
+// 64-bit hash of the source text combined with every parser and
+// materialiser option that affects the resulting document. On a hit
+// the materialised document (including its source context, so that
+// the serializer can still replay authored text) is restored from a
+// binary image instead of being parsed.
+//
+// Images are host-specific cache artefacts: they are written in native
+// byte order and carry a format version and a checksum of their
+// payload. Any mismatch, truncation or corruption is treated as a miss
+// and the image is rewritten.
+//========================================================================
+
+#ifndef NUNO_CACHE_HPP
+#define NUNO_CACHE_HPP
+
+#include "nuno.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace nuno
+{
+//========================================================================
+// Image primitives
+//========================================================================
+
+    namespace detail
+    {
+        class image_writer
+        {
+        public:
+            explicit image_writer(std::string& out) : out_(out) {}
+
+            void raw(const void* p, size_t n) { out_.append(static_cast<const char*>(p), n); }
+            void u8(uint8_t v)                { out_.push_back(static_cast<char>(v)); }
+            void u64(uint64_t v)              { raw(&v, sizeof v); }
+            void f64(double v)                { raw(&v, sizeof v); }
+            void str(std::string_view s)      { u64(s.size()); raw(s.data(), s.size()); }
+
+            template<typename E> requires std::is_enum_v<E>
+            void en(E e) { u64(static_cast<uint64_t>(e)); }
+
+        private:
+            std::string& out_;
+        };
+
+        // All reads are bounds checked. The first failed read poisons
+        // the reader; subsequent reads return zero values and the caller
+        // checks ok() once at the end.
+        class image_reader
+        {
+        public:
+            explicit image_reader(std::string_view in) : in_(in) {}
+
+            bool ok() const noexcept { return ok_; }
+            bool at_end() const noexcept { return pos_ == in_.size(); }
+            size_t remaining() const noexcept { return in_.size() - pos_; }
+            void fail() noexcept { ok_ = false; pos_ = in_.size(); }
+
+            bool raw(void* p, size_t n)
+            {
+                if (!ok_ || n > remaining()) { fail(); return false; }
+                std::memcpy(p, in_.data() + pos_, n);
+                pos_ += n;
+                return true;
+            }
+
+            uint8_t  u8()  { uint8_t  v = 0; raw(&v, sizeof v); return v; }
+            uint64_t u64() { uint64_t v = 0; raw(&v, sizeof v); return v; }
+            double   f64() { double   v = 0; raw(&v, sizeof v); return v; }
+
+            std::string str()
+            {
+                auto n = u64();
+                if (n > remaining()) { fail(); return {}; }
+                std::string s(in_.substr(pos_, n));
+                pos_ += n;
+                return s;
+            }
+
+            // Element counts are sanity-checked against the remaining
+            // input so a corrupt image cannot request huge allocations.
+            size_t count()
+            {
+                auto n = u64();
+                if (n > remaining()) { fail(); return 0; }
+                return static_cast<size_t>(n);
+            }
+
+            template<typename E> requires std::is_enum_v<E>
+            E en() { return static_cast<E>(u64()); }
+
+        private:
+            std::string_view in_;
+            size_t pos_ {0};
+            bool   ok_  {true};
+        };
+    }
+
+//========================================================================
+// Document image
+//========================================================================
+
+    struct document_image
+    {
+        static constexpr char     MAGIC[8]       = {'N','U','N','O','I','M','G','\0'};
+        static constexpr uint64_t FORMAT_VERSION = 4;
+
+        // Serialises a loaded document together with its load errors.
+        static void write(std::string& out, doc_context const& ctx, uint64_t key, uint64_t source_size);
+
+        // Restores an image written by write(). Returns false if the
+        // image does not match key/source_size or is malformed.
+        static bool read(std::string_view in, doc_context& ctx, uint64_t key, uint64_t source_size);
+
+    private:
+        using writer = detail::image_writer;
+        using reader = detail::image_reader;
+
+        template<typename Tag>
+        static void put(writer& w, id<Tag> const& v) { w.u64(v.val); }
+        template<typename Tag>
+        static void get(reader& r, id<Tag>& v) { v.val = r.u64(); }
+
+        static void put(writer& w, std::string const& s) { w.str(s); }
+        static void get(reader& r, std::string& s) { s = r.str(); }
+
+        static void put(writer& w, source_location const& loc) { w.u64(loc.line); w.u64(loc.column); }
+        static void get(reader& r, source_location& loc) { loc.line = r.u64(); loc.column = r.u64(); }
+
+        template<typename T>
+        static void put(writer& w, std::optional<T> const& o)
+        {
+            w.u8(o.has_value());
+            if (o) put(w, *o);
+        }
+
+        template<typename T>
+        static void get(reader& r, std::optional<T>& o)
+        {
+            o.reset();
+            if (r.u8())
+            {
+                T v{};
+                get(r, v);
+                o = std::move(v);
+            }
+        }
+
+        static void put(writer& w, size_t v) { w.u64(v); }
+        static void get(reader& r, size_t& v) { v = r.u64(); }
+
+        template<typename T>
+        static void put(writer& w, std::vector<T> const& v)
+        {
+            w.u64(v.size());
+            for (auto const& e : v)
+                put(w, e);
+        }
+
+        template<typename T>
+        static void get(reader& r, std::vector<T>& v)
+        {
+            auto n = r.count();
+            v.clear();
+            v.reserve(n);
+            for (size_t i = 0; i < n && r.ok(); ++i)
+                get(r, v.emplace_back());
+        }
+
+        template<typename T>
+        static void put(writer& w, shared_list<T> const& v)
+        {
+            w.u64(v.size());
+            for (auto const& e : v)
+                put(w, e);
+        }
+
+        template<typename T>
+        static void get(reader& r, shared_list<T>& v)
+        {
+            v.clear();
+            get(r, v.edit());
+        }
+
+        template<typename T>
+        static void put(writer& w, node_store<T> const& v)
+        {
+            w.u64(v.size());
+            for (auto const& e : v)
+                put(w, e);
+        }
+
+        template<typename T>
+        static void get(reader& r, node_store<T>& v)
+        {
+            auto n = r.count();
+            v.clear();
+            v.reserve(n);
+            for (size_t i = 0; i < n && r.ok(); ++i)
+                get(r, v.emplace_back());
+        }
+
+        static void put(writer& w, typed_value const& tv);
+        static void get(reader& r, typed_value& tv);
+
+        template<typename N>
+        static void put_base(writer& w, N const& n);
+        template<typename N>
+        static void get_base(reader& r, N& n);
+
+        static void put(writer& w, document::source_item_ref const& ref);
+        static void get(reader& r, document::source_item_ref& ref);
+        static void put(writer& w, document::ordered_item_list const& l);
+        static void get(reader& r, document::ordered_item_list& l);
+        static void put(writer& w, document::row_sequence const& l);
+        static void get(reader& r, document::row_sequence& l);
+
+        static void put(writer& w, document::category_node const& n);
+        static void get(reader& r, document::category_node& n);
+        static void put(writer& w, document::table_node const& n);
+        static void get(reader& r, document::table_node& n);
+        static void put(writer& w, column const& c);
+        static void get(reader& r, column& c);
+        static void put(writer& w, document::column_node const& n);
+        static void get(reader& r, document::column_node& n);
+        static void put(writer& w, document::row_node const& n);
+        static void get(reader& r, document::row_node& n);
+        static void put(writer& w, document::key_node const& n);
+        static void get(reader& r, document::key_node& n);
+        static void put(writer& w, document::comment_node const& n);
+        static void get(reader& r, document::comment_node& n);
+        static void put(writer& w, document::paragraph_node const& n);
+        static void get(reader& r, document::paragraph_node& n);
+
+        static void put(writer& w, parse_event const& ev);
+        static void get(reader& r, parse_event& ev);
+        static void put(writer& w, category const& c);
+        static void get(reader& r, category& c);
+        static void put(writer& w, table const& t);
+        static void get(reader& r, table& t);
+        static void put(writer& w, table_row const& row);
+        static void get(reader& r, table_row& row);
+        static void put(writer& w, cst_key const& k);
+        static void get(reader& r, cst_key& k);
+        static void put(writer& w, parse_context const& pc);
+        static void get(reader& r, parse_context& pc);
+
+        static void put(writer& w, error<any_error> const& e);
+        static void get(reader& r, error<any_error>& e);
+
+        static void put(writer& w, document const& doc);
+        static void get(reader& r, document& doc);
+    };
+
+//------------------------------------------------------------------------
+
+    inline void document_image::put(writer& w, typed_value const& tv)
+    {
+        w.u8(static_cast<uint8_t>(tv.val.index()));
+        std::visit([&](auto const& v)
+        {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::string>)              w.str(v);
+            else if constexpr (std::is_same_v<T, int64_t>)             w.u64(static_cast<uint64_t>(v));
+            else if constexpr (std::is_same_v<T, double>)              w.f64(v);
+            else if constexpr (std::is_same_v<T, bool>)                w.u8(v);
+            else if constexpr (std::is_same_v<T, typed_array>)
+            {
+                // Element by element, as for any vector
+                w.u64(v.size());
+                for (size_t i = 0; i < v.size(); ++i)
+                    put(w, v.element(i));
+            }
+        }, tv.val);
+
+        w.en(tv.type);
+        w.en(tv.type_source);
+        w.en(tv.origin);
+        w.en(tv.semantic);
+        w.en(tv.contamination);
+        w.en(tv.creation);
+        w.u8(tv.is_edited);
+    }
+
+    inline void document_image::get(reader& r, typed_value& tv)
+    {
+        switch (r.u8())
+        {
+            case 0: tv.val = std::monostate{}; break;
+            case 1: tv.val = r.str(); break;
+            case 2: tv.val = static_cast<int64_t>(r.u64()); break;
+            case 3: tv.val = r.f64(); break;
+            case 4: tv.val = r.u8() != 0; break;
+            case 5:
+            {
+                std::vector<typed_value> arr;
+                get(r, arr);
+                tv.val = typed_array(std::move(arr));
+                break;
+            }
+            default: r.fail(); return;
+        }
+
+        tv.type          = r.en<value_type>();
+        tv.type_source   = r.en<type_ascription>();
+        tv.origin        = r.en<value_locus>();
+        tv.semantic      = r.en<semantic_state>();
+        tv.contamination = r.en<contamination_state>();
+        tv.creation      = r.en<creation_state>();
+        tv.is_edited     = r.u8() != 0;
+    }
+
+    template<typename N>
+    void document_image::put_base(writer& w, N const& n)
+    {
+        w.en(n.creation);
+        w.u8(n.is_edited);
+        if constexpr (requires { n.source_event_index; })
+            put(w, n.source_event_index);
+        if constexpr (requires { n.semantic; })
+        {
+            w.en(n.semantic);
+            w.en(n.contamination);
+        }
+    }
+
+    template<typename N>
+    void document_image::get_base(reader& r, N& n)
+    {
+        n.creation  = r.en<creation_state>();
+        n.is_edited = r.u8() != 0;
+        if constexpr (requires { n.source_event_index; })
+            get(r, n.source_event_index);
+        if constexpr (requires { n.semantic; })
+        {
+            n.semantic      = r.en<semantic_state>();
+            n.contamination = r.en<contamination_state>();
+        }
+    }
+
+    inline void document_image::put(writer& w, document::source_item_ref const& ref)
+    {
+        w.u8(static_cast<uint8_t>(ref.id.index()));
+        std::visit([&](auto const& v)
+        {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, document::category_close_marker>)
+            {
+                put(w, v.which);
+                w.en(v.form);
+            }
+            else
+                put(w, v);
+        }, ref.id);
+    }
+
+    inline void document_image::get(reader& r, document::source_item_ref& ref)
+    {
+        auto which = r.u8();
+        auto val   = r.u64();
+        switch (which)
+        {
+            case 0: ref.id = key_id{val}; break;
+            case 1: ref.id = category_id{val}; break;
+            case 2: ref.id = document::category_close_marker{category_id{val}, r.en<document::category_close_form>()}; break;
+            case 3: ref.id = table_id{val}; break;
+            case 4: ref.id = row_id{val}; break;
+            case 5: ref.id = comment_id{val}; break;
+            case 6: ref.id = paragraph_id{val}; break;
+            default: r.fail(); break;
+        }
+    }
+
+    inline void document_image::put(writer& w, document::ordered_item_list const& l)
+    {
+        w.u64(l.size());
+        for (auto const& ref : l)
+            put(w, ref);
+    }
+
+    inline void document_image::get(reader& r, document::ordered_item_list& l)
+    {
+        size_t n = r.count();
+        l.clear();
+        l.reserve(n);
+        for (size_t i = 0; i < n && r.ok(); ++i)
+        {
+            document::source_item_ref ref;
+            get(r, ref);
+            if (r.ok() && !l.push_back(ref))
+                r.fail();
+        }
+    }
+
+    // Written as a plain ID list
+    inline void document_image::put(writer& w, document::row_sequence const& l)
+    {
+        w.u64(l.size());
+        for (auto id : l)
+            put(w, id);
+    }
+
+    inline void document_image::get(reader& r, document::row_sequence& l)
+    {
+        std::vector<row_id> ids;
+        get(r, ids);
+
+        l.clear();
+        l.reserve(ids.size());
+        for (auto id : ids)
+        {
+            if (!r.ok() || l.contains(id))
+            {
+                r.fail();
+                return;
+            }
+            l.push_back(id);
+        }
+    }
+
+    inline void document_image::put(writer& w, document::category_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.id);
+        put(w, n.name);
+        put(w, n.parent);
+        put(w, n.children);
+        put(w, n.tables);
+        put(w, n.keys);
+        put(w, n.ordered_items);
+        w.u64(n.contaminated_sources);
+        put(w, n.source_event_index_open);
+        put(w, n.source_event_index_close);
+    }
+
+    inline void document_image::get(reader& r, document::category_node& n)
+    {
+        get_base(r, n);
+        get(r, n.id);
+        get(r, n.name);
+        get(r, n.parent);
+        get(r, n.children);
+        get(r, n.tables);
+        get(r, n.keys);
+        get(r, n.ordered_items);
+        n.contaminated_sources = r.u64();
+        get(r, n.source_event_index_open);
+        get(r, n.source_event_index_close);
+    }
+
+    inline void document_image::put(writer& w, document::table_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.id);
+        put(w, n.owner);
+        put(w, n.columns);
+        put(w, n.rows);
+        put(w, n.ordered_items);
+        w.u64(n.contaminated_sources);
+    }
+
+    inline void document_image::get(reader& r, document::table_node& n)
+    {
+        get_base(r, n);
+        get(r, n.id);
+        get(r, n.owner);
+        get(r, n.columns);
+        get(r, n.rows);
+        get(r, n.ordered_items);
+        n.contaminated_sources = r.u64();
+    }
+
+    inline void document_image::put(writer& w, column const& c)
+    {
+        put(w, c.id);
+        put(w, c.name);
+        w.en(c.type);
+        w.en(c.type_source);
+        put(w, c.declared_type);
+        w.en(c.semantic);
+    }
+
+    inline void document_image::get(reader& r, column& c)
+    {
+        get(r, c.id);
+        get(r, c.name);
+        c.type        = r.en<value_type>();
+        c.type_source = r.en<type_ascription>();
+        get(r, c.declared_type);
+        c.semantic    = r.en<semantic_state>();
+    }
+
+    inline void document_image::put(writer& w, document::column_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.col);
+        put(w, n.table);
+        put(w, n.owner);
+    }
+
+    inline void document_image::get(reader& r, document::column_node& n)
+    {
+        get_base(r, n);
+        get(r, n.col);
+        get(r, n.table);
+        get(r, n.owner);
+    }
+
+    inline void document_image::put(writer& w, document::row_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.id);
+        put(w, n.table);
+        put(w, n.owner);
+        put(w, n.cells);
+    }
+
+    inline void document_image::get(reader& r, document::row_node& n)
+    {
+        get_base(r, n);
+        get(r, n.id);
+        get(r, n.table);
+        get(r, n.owner);
+        get(r, n.cells);
+    }
+
+    inline void document_image::put(writer& w, document::key_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.id);
+        put(w, n.name);
+        put(w, n.owner);
+        w.en(n.type);
+        w.en(n.type_source);
+        put(w, n.value);
+    }
+
+    inline void document_image::get(reader& r, document::key_node& n)
+    {
+        get_base(r, n);
+        get(r, n.id);
+        get(r, n.name);
+        get(r, n.owner);
+        n.type        = r.en<value_type>();
+        n.type_source = r.en<type_ascription>();
+        get(r, n.value);
+    }
+
+    inline void document_image::put(writer& w, document::comment_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.id);
+        put(w, n.text);
+        put(w, n.owner);
+    }
+
+    inline void document_image::get(reader& r, document::comment_node& n)
+    {
+        get_base(r, n);
+        get(r, n.id);
+        get(r, n.text);
+        get(r, n.owner);
+    }
+
+    inline void document_image::put(writer& w, document::paragraph_node const& n)
+    {
+        put_base(w, n);
+        put(w, n.id);
+        put(w, n.text);
+        put(w, n.owner);
+    }
+
+    inline void document_image::get(reader& r, document::paragraph_node& n)
+    {
+        get_base(r, n);
+        get(r, n.id);
+        get(r, n.text);
+        get(r, n.owner);
+    }
+
+//------------------------------------------------------------------------
+
+    inline void document_image::put(writer& w, parse_event const& ev)
+    {
+        w.en(ev.kind);
+        put(w, ev.loc);
+        put(w, ev.text);
+        w.u8(static_cast<uint8_t>(ev.target.index()));
+        std::visit([&](auto const& v)
+        {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, unresolved_name>)
+                w.str(v);
+            else if constexpr (!std::is_same_v<T, std::monostate>)
+                put(w, v);
+        }, ev.target);
+    }
+
+    inline void document_image::get(reader& r, parse_event& ev)
+    {
+        ev.kind = r.en<parse_event_kind>();
+        get(r, ev.loc);
+        get(r, ev.text);
+        switch (r.u8())
+        {
+            case 0: ev.target = std::monostate{}; break;
+            case 1:
+            {
+                // Unresolved names view into the source text, which is
+                // not retained. Rebind the view into the event's own
+                // copy of the line.
+                auto name = r.str();
+                auto pos  = ev.text.find(name);
+                ev.target = pos == std::string::npos
+                          ? unresolved_name{}
+                          : unresolved_name{std::string_view(ev.text).substr(pos, name.size())};
+                break;
+            }
+            case 2: ev.target = category_id{r.u64()}; break;
+            case 3: ev.target = table_id{r.u64()}; break;
+            case 4: ev.target = row_id{r.u64()}; break;
+            case 5: ev.target = key_id{r.u64()}; break;
+            default: r.fail(); break;
+        }
+    }
+
+    inline void document_image::put(writer& w, category const& c)
+    {
+        put(w, c.id);
+        put(w, c.name);
+        put(w, c.parent);
+    }
+
+    inline void document_image::get(reader& r, category& c)
+    {
+        get(r, c.id);
+        get(r, c.name);
+        get(r, c.parent);
+    }
+
+    inline void document_image::put(writer& w, table const& t)
+    {
+        put(w, t.id);
+        put(w, t.owning_category);
+        put(w, t.columns);
+        put(w, t.rows);
+    }
+
+    inline void document_image::get(reader& r, table& t)
+    {
+        get(r, t.id);
+        get(r, t.owning_category);
+        get(r, t.columns);
+        get(r, t.rows);
+    }
+
+    inline void document_image::put(writer& w, table_row const& row)
+    {
+        put(w, row.id);
+        put(w, row.owning_category);
+        put(w, row.cells);
+    }
+
+    inline void document_image::get(reader& r, table_row& row)
+    {
+        get(r, row.id);
+        get(r, row.owning_category);
+        get(r, row.cells);
+    }
+
+    inline void document_image::put(writer& w, cst_key const& k)
+    {
+        put(w, k.owner);
+        put(w, k.name);
+        put(w, k.declared_type);
+        put(w, k.literal);
+        put(w, k.loc);
+    }
+
+    inline void document_image::get(reader& r, cst_key& k)
+    {
+        get(r, k.owner);
+        get(r, k.name);
+        get(r, k.declared_type);
+        get(r, k.literal);
+        get(r, k.loc);
+    }
+
+    inline void document_image::put(writer& w, parse_context const& pc)
+    {
+        put(w, pc.document.events);
+        put(w, pc.document.categories);
+        put(w, pc.document.tables);
+        put(w, pc.document.rows);
+        put(w, pc.document.keys);
+
+        w.u64(pc.errors.size());
+        for (auto const& e : pc.errors)
+        {
+            w.en(e.kind);
+            put(w, e.loc);
+            put(w, e.message);
+        }
+    }
+
+    inline void document_image::get(reader& r, parse_context& pc)
+    {
+        get(r, pc.document.events);
+        get(r, pc.document.categories);
+        get(r, pc.document.tables);
+        get(r, pc.document.rows);
+        get(r, pc.document.keys);
+
+        auto n = r.count();
+        pc.errors.resize(n);
+        for (auto& e : pc.errors)
+        {
+            e.kind = r.en<parse_error_kind>();
+            get(r, e.loc);
+            get(r, e.message);
+        }
+    }
+
+    inline void document_image::put(writer& w, error<any_error> const& e)
+    {
+        put(w, e.loc);
+        put(w, e.message);
+        w.u8(static_cast<uint8_t>(e.kind.index()));
+        std::visit([&](auto const& inner)
+        {
+            w.en(inner.kind);
+            put(w, inner.loc);
+            put(w, inner.message);
+        }, e.kind);
+    }
+
+    inline void document_image::get(reader& r, error<any_error>& e)
+    {
+        get(r, e.loc);
+        get(r, e.message);
+
+        auto read_inner = [&](auto& inner)
+        {
+            using K = decltype(inner.kind);
+            inner.kind = r.en<K>();
+            get(r, inner.loc);
+            get(r, inner.message);
+        };
+
+        switch (r.u8())
+        {
+            case 0: { error<parse_error_kind> pe;    read_inner(pe); e.kind = std::move(pe); break; }
+            case 1: { error<semantic_error_kind> se; read_inner(se); e.kind = std::move(se); break; }
+            default: r.fail(); break;
+        }
+    }
+
+    inline void document_image::put(writer& w, document const& doc)
+    {
+        put(w, doc.next_category_id_);
+        put(w, doc.next_key_id_);
+        put(w, doc.next_comment_id_);
+        put(w, doc.next_paragraph_id_);
+        put(w, doc.next_table_id_);
+        put(w, doc.next_row_id_);
+        put(w, doc.next_column_id_);
+
+        put(w, doc.categories_);
+        put(w, doc.tables_);
+        put(w, doc.columns_);
+        put(w, doc.rows_);
+        put(w, doc.keys_);
+        put(w, doc.comments_);
+        put(w, doc.paragraphs_);
+
+        // Source sets are written as ID lists, which they iterate
+        // in order, so identical documents produce identical images.
+        auto put_set = [&](auto const& s)
+        {
+            std::vector<size_t> v;
+            v.reserve(s.size());
+            for (auto id : s) v.push_back(id.val);
+            put(w, v);
+        };
+        put_set(doc.contaminated_source_keys_);
+        put_set(doc.contaminated_source_rows_);
+
+        w.u8(doc.source_context_ != nullptr);
+        if (doc.source_context_)
+            put(w, *doc.source_context_);
+    }
+
+    inline void document_image::get(reader& r, document& doc)
+    {
+        get(r, doc.next_category_id_);
+        get(r, doc.next_key_id_);
+        get(r, doc.next_comment_id_);
+        get(r, doc.next_paragraph_id_);
+        get(r, doc.next_table_id_);
+        get(r, doc.next_row_id_);
+        get(r, doc.next_column_id_);
+
+        get(r, doc.categories_);
+        get(r, doc.tables_);
+        get(r, doc.columns_);
+        get(r, doc.rows_);
+        get(r, doc.keys_);
+        get(r, doc.comments_);
+        get(r, doc.paragraphs_);
+
+        std::vector<size_t> sources;
+        get(r, sources);
+        doc.contaminated_source_keys_.clear();
+        for (auto id : sources) doc.contaminated_source_keys_.insert(key_id{id});
+        get(r, sources);
+        doc.contaminated_source_rows_.clear();
+        for (auto id : sources) doc.contaminated_source_rows_.insert(row_id{id});
+
+        if (r.u8())
+        {
+            // Allocate first so that unresolved names are bound to
+            // their final storage.
+            auto ctx = std::make_shared<parse_context>();
+            get(r, *ctx);
+            doc.source_context_ = std::move(ctx);
+        }
+    }
+
+    inline void document_image::write(std::string& out, doc_context const& ctx, uint64_t key, uint64_t source_size)
+    {
+        writer w(out);
+        w.raw(MAGIC, sizeof MAGIC);
+        w.u64(FORMAT_VERSION);
+        w.u64(key);
+        w.u64(source_size);
+
+        // The checksum covers everything after it and is patched in
+        // once the payload is written
+        size_t sum_at = out.size();
+        w.u64(0);
+        size_t payload_at = out.size();
+
+        put(w, ctx.errors);
+        put(w, ctx.document);
+
+        uint64_t sum = detail::xxh64::hash(out.data() + payload_at, out.size() - payload_at, key);
+        std::memcpy(out.data() + sum_at, &sum, sizeof sum);
+    }
+
+    inline bool document_image::read(std::string_view in, doc_context& ctx, uint64_t key, uint64_t source_size)
+    {
+        reader r(in);
+
+        char magic[sizeof MAGIC];
+        if (!r.raw(magic, sizeof magic) || std::memcmp(magic, MAGIC, sizeof MAGIC) != 0)
+            return false;
+
+        if (r.u64() != FORMAT_VERSION || r.u64() != key || r.u64() != source_size)
+            return false;
+
+        uint64_t sum = r.u64();
+        if (!r.ok() || detail::xxh64::hash(in.substr(in.size() - r.remaining()), key) != sum)
+            return false;
+
+        get(r, ctx.errors);
+        get(r, ctx.document);
+
+        return r.ok() && r.at_end();
+    }
+
+//========================================================================
+// Load cache
+//========================================================================
+
+    struct load_cache_options
+    {
+        std::filesystem::path directory;                  // Created on first store if missing
+        size_t                max_entries {256};          // Oldest images are evicted beyond this...
+        std::uintmax_t        max_bytes   {64u << 20};    // ...or beyond this total size
+    };
+
+    struct load_cache_stats
+    {
+        size_t hits      {0};
+        size_t misses    {0};
+        size_t stores    {0};
+        size_t evictions {0};
+        size_t rejected  {0};  // images found but discarded as stale or corrupt
+    };
+
+    class load_cache
+    {
+    public:
+        explicit load_cache(load_cache_options opts)
+            : opts_(std::move(opts))
+        {
+        }
+
+        // Loads through the cache. Debug echo options do not take part
+        // in the key, and nothing is echoed on a hit.
+        doc_context load(std::string_view src, parser_options popt = {}, materialiser_options mopt = {});
+
+        // Removes the image for the given input, if any.
+        bool invalidate(std::string_view src, parser_options popt = {}, materialiser_options mopt = {});
+
+        // Removes every image in the cache directory.
+        void clear();
+
+        load_cache_stats const& stats() const noexcept { return stats_; }
+        void reset_stats() noexcept { stats_ = {}; }
+
+        load_cache_options const& options() const noexcept { return opts_; }
+
+        static uint64_t key(std::string_view src, parser_options popt, materialiser_options mopt) noexcept;
+
+        std::filesystem::path path_for(uint64_t key) const;
+
+        static constexpr std::string_view EXTENSION = ".nimg";
+
+    private:
+        load_cache_options opts_;
+        load_cache_stats   stats_;
+
+        bool try_read(std::filesystem::path const& p, doc_context& out, uint64_t key, uint64_t size, size_t& image_bytes);
+        void store(std::filesystem::path const& p, doc_context const& ctx, uint64_t key, uint64_t size);
+        static std::filesystem::path temp_path_for(std::filesystem::path const& p);
+        void enforce_bounds();
+    };
+
+//------------------------------------------------------------------------
+
+    inline uint64_t load_cache::key(std::string_view src, parser_options popt, materialiser_options mopt) noexcept
+    {
+        (void)popt; // no parser option currently affects the CST
+
+        uint64_t h = detail::xxh64::hash(src, document_image::FORMAT_VERSION);
+
+        const uint64_t opts[] =
+        {
+            mopt.own_parser_data ? 1u : 0u,
+            mopt.max_category_depth,
+        };
+
+        return detail::xxh64::hash(opts, sizeof opts, h);
+    }
+
+    inline std::filesystem::path load_cache::path_for(uint64_t key) const
+    {
+        char name[17];
+        constexpr char hex[] = "0123456789abcdef";
+        for (int i = 15; i >= 0; --i, key >>= 4)
+            name[i] = hex[key & 0xF];
+        name[16] = '\0';
+
+        return opts_.directory / (std::string(name) + std::string(EXTENSION));
+    }
+
+    inline doc_context load_cache::load(std::string_view src, parser_options popt, materialiser_options mopt)
+    {
+        auto k = key(src, popt, mopt);
+        auto p = path_for(k);
+
+        // Lookups report to the sink the load itself would report to
+        auto* sink = detail::active_sink(mopt.metrics ? mopt.metrics : popt.metrics);
+        auto started = sink ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+        doc_context out{};
+        size_t image_bytes = 0;
+        if (try_read(p, out, k, src.size(), image_bytes))
+        {
+            ++stats_.hits;
+
+            // Refresh recency for eviction
+            std::error_code ec;
+            std::filesystem::last_write_time(p, std::filesystem::file_time_type::clock::now(), ec);
+
+            if (sink)
+            {
+                cache_metrics m;
+                m.elapsed    = std::chrono::steady_clock::now() - started;
+                m.hits       = 1;
+                m.bytes_read = image_bytes;
+                sink->on_cache(m);
+            }
+            return out;
+        }
+
+        ++stats_.misses;
+        if (sink)
+        {
+            cache_metrics m;
+            m.misses = 1;
+            sink->on_cache(m);
+        }
+        out = nuno::load(src, popt, mopt);
+        store(p, out, k, src.size());
+        return out;
+    }
+
+    inline bool load_cache::try_read(std::filesystem::path const& p, doc_context& out, uint64_t key, uint64_t size, size_t& image_bytes)
+    {
+        std::ifstream in(p, std::ios::binary);
+        if (!in)
+            return false;
+
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        if (document_image::read(bytes, out, key, size))
+        {
+            image_bytes = bytes.size();
+            return true;
+        }
+
+        ++stats_.rejected;
+        out = doc_context{};
+
+        std::error_code ec;
+        std::filesystem::remove(p, ec);
+        return false;
+    }
+
+    inline std::filesystem::path load_cache::temp_path_for(std::filesystem::path const& p)
+    {
+    #if defined(_WIN32)
+        auto pid = _getpid();
+    #else
+        auto pid = getpid();
+    #endif
+
+        std::random_device rd;
+        uint64_t salt = (uint64_t{rd()} << 32) ^ rd();
+
+        char buf[48];
+        char* end = buf;
+        *end++ = '.';
+        end = std::to_chars(end, buf + sizeof buf, static_cast<long long>(pid)).ptr;
+        *end++ = '-';
+        end = std::to_chars(end, buf + sizeof buf, salt, 16).ptr;
+
+        auto tmp = p;
+        tmp += std::string(buf, end);
+        tmp += ".tmp";
+        return tmp;
+    }
+
+    inline void load_cache::store(std::filesystem::path const& p, doc_context const& ctx, uint64_t key, uint64_t size)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(opts_.directory, ec);
+        if (ec) return;
+
+        std::string bytes;
+        document_image::write(bytes, ctx, key, size);
+
+        if (bytes.size() > opts_.max_bytes)
+            return;
+
+        // Write-then-rename so a concurrent reader never observes a
+        // partially written image. The temporary is unique to this
+        // store, so writers of the same image never share it.
+        auto tmp = temp_path_for(p);
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return;
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!out) { out.close(); std::filesystem::remove(tmp, ec); return; }
+        }
+
+        std::filesystem::rename(tmp, p, ec);
+        if (ec) { std::filesystem::remove(tmp, ec); return; }
+
+        ++stats_.stores;
+        enforce_bounds();
+    }
+
+    inline void load_cache::enforce_bounds()
+    {
+        namespace fs = std::filesystem;
+
+        struct entry { fs::path path; fs::file_time_type time; std::uintmax_t size; };
+        std::vector<entry> entries;
+        std::uintmax_t total = 0;
+
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(opts_.directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec))
+        {
+            if (!it->is_regular_file(ec) || it->path().extension() != EXTENSION)
+                continue;
+
+            entry e{it->path(), it->last_write_time(ec), it->file_size(ec)};
+            if (ec) { ec.clear(); continue; }
+            total += e.size;
+            entries.push_back(std::move(e));
+        }
+
+        if (entries.size() <= opts_.max_entries && total <= opts_.max_bytes)
+            return;
+
+        std::ranges::sort(entries, {}, &entry::time);
+
+        size_t count = entries.size();
+        for (auto const& e : entries)
+        {
+            if (count <= opts_.max_entries && total <= opts_.max_bytes)
+                break;
+
+            if (fs::remove(e.path, ec))
+            {
+                ++stats_.evictions;
+                --count;
+                total -= e.size;
+            }
+        }
+    }
+
+    inline bool load_cache::invalidate(std::string_view src, parser_options popt, materialiser_options mopt)
+    {
+        std::error_code ec;
+        return std::filesystem::remove(path_for(key(src, popt, mopt)), ec);
+    }
+
+    inline void load_cache::clear()
+    {
+        namespace fs = std::filesystem;
+
+        std::error_code ec;
+        std::vector<fs::path> doomed;
+        for (auto it = fs::directory_iterator(opts_.directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec))
+            if (it->path().extension() == EXTENSION)
+                doomed.push_back(it->path());
+
+        for (auto const& p : doomed)
+            fs::remove(p, ec);
+    }
+
+//------------------------------------------------------------------------
+
+    inline doc_context load( std::string_view src, parser_options popt, materialiser_options mopt, load_cache& cache )
+    {
+        return cache.load(src, popt, mopt);
+    }
+
+    inline doc_context load( std::string_view src, load_cache& cache )
+    {
+        return cache.load(src);
+    }
+
+} // namespace nuno
+
+#endif // NUNO_CACHE_HPP
@@ -0,0 +1,223 @@
+// nuno_concurrency.hpp - A Readable Format (NUNO) - Shared document access
+// Version 0.3.0
+// Copyright 2025 Mikael Ueno A
+// Licenced as-is under the MIT licence.
+
+//========================================================================
+// Thread-safety contract
+//
+// A document that nothing edits may be read from any number of threads:
+// the const document API, document views, reflect::inspect with a const
+// address and query() all leave the document untouched. Each thread
+// uses its own inspect_context and query_handle (a query_handle may be
+// shared for const extraction, see nuno_query.hpp).
+//
+// Editing is not synchronised by the document itself. shared_document
+// pairs a document with a reader/writer lock: readers hold a shared
+// lock for the duration of a read, and each write runs one editor batch
+// under an exclusive lock, so readers see either all of a write or none
+// of it. Writers take precedence over readers that arrive after them.
+// Every completed write advances the epoch, which readers can
+// use to tell whether anything changed between two reads.
+//
+// Views, query handles and pointers obtained during a read must not be
+// kept past it.
+//
+// versioned_document trades the lock for copy-on-write: readers take a
+// snapshot, an immutable document they share ownership of, and never
+// wait on writers. Each write forks the latest version, edits the fork
+// and publishes it as the next version. Forks share every node storage
+// chunk and member list they do not change (see document::fork), so a
+// version costs a chunk per node it edits plus the member lists of
+// the categories and tables it restructures. Views into a snapshot
+// stay valid for as long as the snapshot is held.
+//========================================================================
+
+#ifndef NUNO_CONCURRENCY_HPP
+#define NUNO_CONCURRENCY_HPP
+
+#include "nuno_document.hpp"
+#include "nuno_editor.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <utility>
+
+namespace nuno
+{
+    class shared_document
+    {
+    public:
+        explicit shared_document(document doc) noexcept
+            : doc_(std::move(doc))
+        {}
+
+        shared_document(shared_document const&) = delete;
+        shared_document& operator=(shared_document const&) = delete;
+
+        // Holds a shared lock for as long as it lives
+        class reader
+        {
+        public:
+            document const& operator*() const noexcept { return *doc_; }
+            document const* operator->() const noexcept { return doc_; }
+
+            // Epoch of the document as seen by this reader
+            uint64_t epoch() const noexcept { return epoch_; }
+
+        private:
+            friend class shared_document;
+            reader(shared_document const& owner)
+                : lock_(owner.lock_shared())
+                , doc_(&owner.doc_)
+                , epoch_(owner.epoch_.load(std::memory_order_acquire))
+            {}
+
+            std::shared_lock<std::shared_mutex> lock_;
+            document const*                     doc_;
+            uint64_t                            epoch_;
+        };
+
+        reader read() const { return reader(*this); }
+
+        // Runs fn(document const&) under a shared lock
+        template<typename Fn>
+        decltype(auto) read(Fn&& fn) const
+        {
+            auto lock = lock_shared();
+            return std::invoke(std::forward<Fn>(fn), std::as_const(doc_));
+        }
+
+        // Runs fn(editor&) as one batch under an exclusive lock. The
+        // epoch advances once the batch has settled, even if fn throws.
+        template<typename Fn>
+        decltype(auto) write(Fn&& fn)
+        {
+            // Holding the turnstile keeps new readers out, so a steady
+            // stream of readers cannot starve the writer.
+            std::lock_guard turn(turnstile_);
+            std::unique_lock lock(mutex_);
+
+            struct advance
+            {
+                std::atomic<uint64_t>& epoch;
+                ~advance() { epoch.fetch_add(1, std::memory_order_release); }
+            } on_exit{epoch_};
+
+            editor ed(doc_);
+            editor::batch batch(ed);
+            return std::invoke(std::forward<Fn>(fn), ed);
+        }
+
+        // Number of writes completed so far
+        uint64_t epoch() const noexcept { return epoch_.load(std::memory_order_acquire); }
+
+    private:
+        mutable std::mutex        turnstile_;
+        mutable std::shared_mutex mutex_;
+        document                  doc_;
+        std::atomic<uint64_t>     epoch_ {0};
+
+        std::shared_lock<std::shared_mutex> lock_shared() const
+        {
+            // Wait behind any writer already queued
+            { std::lock_guard turn(turnstile_); }
+            return std::shared_lock(mutex_);
+        }
+    };
+
+    class versioned_document
+    {
+    public:
+        using snapshot_ptr = std::shared_ptr<const document>;
+
+        explicit versioned_document(document doc)
+            : current_(std::make_shared<const document>(std::move(doc)))
+        {}
+
+        versioned_document(versioned_document const&) = delete;
+        versioned_document& operator=(versioned_document const&) = delete;
+
+        // The latest published version. The snapshot is never edited.
+        snapshot_ptr snapshot() const
+        {
+            std::lock_guard lock(publish_);
+            return current_;
+        }
+
+        // Runs fn(editor&) as one batch on a fork of the latest version
+        // and publishes the result. Writers are serialised; readers are
+        // never blocked. If fn throws nothing is published.
+        template<typename Fn>
+        auto write(Fn&& fn)
+        {
+            std::lock_guard turn(writer_);
+
+            auto next = std::make_shared<document>(snapshot()->fork());
+
+            // The editor is gone before the version becomes visible
+            auto edit = [&]
+            {
+                editor ed(*next);
+                editor::batch batch(ed);
+                return std::invoke(std::forward<Fn>(fn), ed);
+            };
+
+            if constexpr (std::is_void_v<decltype(edit())>)
+            {
+                edit();
+                publish_locked(std::move(next));
+            }
+            else
+            {
+                auto result = edit();
+                publish_locked(std::move(next));
+                return result;
+            }
+        }
+
+        // Replaces the document outright
+        void publish(document doc)
+        {
+            std::lock_guard turn(writer_);
+            publish_locked(std::make_shared<const document>(std::move(doc)));
+        }
+
+        // Publishes the document fn(latest) makes from the latest version,
+        // e.g. a reload of it. Writes wait until it is published, so none
+        // is lost in between. If fn throws nothing is published.
+        template<typename Fn>
+        void rebuild(Fn&& fn)
+        {
+            std::lock_guard turn(writer_);
+            document next = std::invoke(std::forward<Fn>(fn), *snapshot());
+            publish_locked(std::make_shared<const document>(std::move(next)));
+        }
+
+        // Number of versions published after the initial one
+        uint64_t version() const noexcept { return version_.load(std::memory_order_acquire); }
+
+    private:
+        mutable std::mutex     writer_;
+        mutable std::mutex     publish_;    // guards current_ only
+        snapshot_ptr           current_;
+        std::atomic<uint64_t>  version_ {0};
+
+        void publish_locked(snapshot_ptr next)
+        {
+            {
+                std::lock_guard lock(publish_);
+                current_.swap(next);
+            }
+            version_.fetch_add(1, std::memory_order_release);
+            // The previous version is released here, outside the lock
+        }
+    };
+}
+
+#endif
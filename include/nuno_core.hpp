@@ -8,15 +8,64 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <variant>
 #include <vector>
 
+#if defined(NUNO_NO_TRACE)
+    #include <ostream>
+#else
+    #include <iostream>
+#endif
+
 namespace nuno 
 {
+//------------------------------------------------------------------------
+// Debug tracing
+//------------------------------------------------------------------------
+// The echo options of the parser, materialiser and serializer print what
+// they handle. Each echo is written as
+//
+//     NUNO_TRACE_IF(opt.echo_lines) DBG_EMIT << ...;
+//
+// Defining NUNO_NO_TRACE compiles tracing out: NUNO_TRACE_IF discards its
+// statement at compile time, so no echo checks remain in the parsing,
+// materialising and writing loops, DBG_EMIT goes to a stream that takes
+// and drops anything, and <iostream> is not included. The echo options
+// are still accepted and have no effect.
+
+#if defined(NUNO_NO_TRACE)
+    inline constexpr bool trace_enabled = false;
+
+    namespace detail
+    {
+        struct null_trace
+        {
+            template<typename T>
+            null_trace const& operator<<(T const&) const { return *this; }
+            null_trace const& operator<<(std::ostream& (*)(std::ostream&)) const { return *this; }
+        };
+    }
+
+    #define NUNO_TRACE_STREAM(prefix) ::nuno::detail::null_trace{}
+#else
+    inline constexpr bool trace_enabled = true;
+
+    #define NUNO_TRACE_STREAM(prefix) std::cout << prefix
+#endif
+
+    #define NUNO_TRACE_IF(flag) if constexpr (::nuno::trace_enabled) if (flag)
+
     #define TRACE_IMPL(x) std::cout << std::string(x, '-') << " " << __FUNCTION__ << " line " << __LINE__
     #define TRACE(ind) TRACE_IMPL(ind) << std::endl    
     #define TRACE_MSG(ind, msg) TRACE_IMPL(ind) << ": " << msg << std::endl
@@ -81,6 +130,119 @@ namespace nuno
     using comment_id    = id<comment_tag>;
     using paragraph_id  = id<paragraph_tag>;
 
+//========================================================================
+// ID sets
+// ---------------------------
+// A dense bitset indexed by ID value. IDs are handed out in increasing
+// order, so the set stays compact and iterates in ID order.
+//========================================================================
+
+    template<typename Id>
+    class id_bitset
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = Id;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const Id*;
+            using reference         = Id;
+
+            const_iterator() = default;
+
+            Id operator*() const noexcept { return Id{pos_}; }
+
+            const_iterator& operator++() noexcept { pos_ = set_->next_from(pos_ + 1); return *this; }
+            const_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+            bool operator==(const_iterator const& rhs) const noexcept { return pos_ == rhs.pos_; }
+
+        private:
+            friend class id_bitset;
+            const_iterator(const id_bitset* set, size_t pos) : set_(set), pos_(pos) {}
+
+            const id_bitset* set_ {nullptr};
+            size_t           pos_ {npos()};
+        };
+
+        using iterator   = const_iterator;
+        using value_type = Id;
+
+        size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+
+        const_iterator begin() const noexcept { return {this, next_from(0)}; }
+        const_iterator end() const noexcept { return {this, npos()}; }
+
+        bool contains(Id id) const noexcept
+        {
+            size_t w = id.val / BITS;
+            return w < words_.size() && (words_[w] >> (id.val % BITS) & 1);
+        }
+
+        // Both return whether the set changed
+        bool insert(Id id);
+        bool erase(Id id) noexcept;
+
+        void clear() noexcept { words_.clear(); size_ = 0; }
+
+    private:
+        static constexpr size_t BITS = 64;
+
+        std::vector<uint64_t> words_;
+        size_t                size_ {0};
+
+        size_t next_from(size_t pos) const noexcept;
+    };
+
+    template<typename Id>
+    bool id_bitset<Id>::insert(Id id)
+    {
+        size_t w = id.val / BITS;
+        uint64_t bit = uint64_t{1} << (id.val % BITS);
+
+        if (w >= words_.size())
+            words_.resize(std::max(w + 1, words_.size() * 2), 0);
+        else if (words_[w] & bit)
+            return false;
+
+        words_[w] |= bit;
+        ++size_;
+        return true;
+    }
+
+    template<typename Id>
+    bool id_bitset<Id>::erase(Id id) noexcept
+    {
+        if (!contains(id))
+            return false;
+
+        words_[id.val / BITS] &= ~(uint64_t{1} << (id.val % BITS));
+        --size_;
+        return true;
+    }
+
+    template<typename Id>
+    size_t id_bitset<Id>::next_from(size_t pos) const noexcept
+    {
+        size_t w = pos / BITS;
+        if (w >= words_.size())
+            return npos();
+
+        // Mask off the bits below pos, then skip empty words
+        uint64_t bits = words_[w] & (~uint64_t{0} << (pos % BITS));
+        while (bits == 0)
+        {
+            if (++w == words_.size())
+                return npos();
+            bits = words_[w];
+        }
+
+        return w * BITS + static_cast<size_t>(std::countr_zero(bits));
+    }
+
 //========================================================================
 // Values
 //
@@ -123,9 +285,9 @@ namespace nuno
         3, // floating_point -> double
         4, // boolean -> bool
         1, // date -> std::string
-        5, // string_array -> std::vector<typed_value>
-        5, // integer_array -> std::vector<typed_value>
-        5, // floating_point_array -> std::vector<typed_value>
+        5, // string_array -> typed_array
+        5, // integer_array -> typed_array
+        5, // floating_point_array -> typed_array
     };
 
     enum class type_ascription
@@ -150,21 +312,127 @@ namespace nuno
 
     struct typed_value;
 
+//------------------------------------------------------------------------
+// Array values
+//------------------------------------------------------------------------
+// typed_array holds the elements of an array value. Arrays whose
+// elements share one scalar type and the same bookkeeping, which is what
+// materialising a valid int[], float[] or str[] gives, are stored
+// compactly: integers and reals in a contiguous buffer, strings in one
+// blob with end offsets. Elements that differ, such as empty or invalid
+// ones, are kept whole in a sparse side table and hold a placeholder slot
+// in the buffer. Arrays that are mostly such elements are expanded
+// instead, with one typed_value per element. Elements that only differ
+// in their bookkeeping (origin, creation, edited), as editor-made ones
+// among authored ones do, stay in the buffer with a byte each to tell.
+//
+// Reading by index (type_at(), integer_at() ...) and through the buffers
+// needs no typed_value per element. Element references (operator[],
+// at(), iteration) of a compact array are served from typed_values built
+// on first use and kept with the array until it is next changed; building
+// them is safe under concurrent readers. The non-const references expand
+// the array for changes in place, after which compact() packs it again.
+// set(), push_back(), insert() and erase() keep a compact array compact.
+//------------------------------------------------------------------------
+
+    class typed_array
+    {
+    public:
+        using const_iterator = typed_value const*;
+        using iterator       = typed_value*;
+
+        typed_array() = default;
+        explicit typed_array(std::vector<typed_value> elements);   // compacted when the elements allow it
+
+        typed_array(typed_array const& other);
+        typed_array(typed_array&&) noexcept;
+        typed_array& operator=(typed_array const& other);
+        typed_array& operator=(typed_array&&) noexcept;
+        ~typed_array();
+
+        size_t size() const noexcept;
+        bool   empty() const noexcept;
+
+    //--Compact storage
+        bool   is_compact() const noexcept;
+        size_t aside_count() const noexcept;   // elements kept whole beside the buffer
+
+        // The buffer of a compact array of integers or reals, empty for any
+        // other array. Slots of elements kept aside hold 0.
+        std::span<int64_t const> integers() const noexcept;
+        std::span<double const>  reals() const noexcept;
+
+    //--Reading by index, without element references
+        value_type       type_at(size_t i) const noexcept;
+        value_type       held_type_at(size_t i) const noexcept;  // of the value itself, as held_type()
+        int64_t          integer_at(size_t i) const;    // requires type_at(i) == integer
+        double           real_at(size_t i) const;       // requires type_at(i) == floating_point
+        std::string_view string_at(size_t i) const;     // requires type_at(i) == string
+        typed_value      element(size_t i) const;       // a copy
+
+        bool any_invalid() const noexcept;
+        bool any_contaminated() const noexcept;
+
+    //--Element references
+        typed_value const& operator[](size_t i) const;
+        typed_value const& at(size_t i) const;
+        typed_value const& front() const;
+        typed_value const& back() const;
+        typed_value const* data() const;
+        const_iterator     begin() const;
+        const_iterator     end() const;
+
+        // These expand the array
+        typed_value& operator[](size_t i);
+        typed_value* data();
+        iterator     begin();
+        iterator     end();
+
+    //--Edits
+        void set(size_t i, typed_value element);
+        void push_back(typed_value element);
+        void insert(size_t pos, typed_value element);
+        void erase(size_t pos);
+        void clear();
+
+        // Packs an expanded array again where its elements allow it
+        void compact();
+
+        // Approximate heap footprint
+        size_t heap_bytes() const noexcept;
+
+    private:
+        struct storage;
+        std::unique_ptr<storage> s_;
+
+        std::vector<typed_value> const& elements_() const;
+        std::vector<typed_value>&       expand_();
+        storage&                        own_();
+
+        typed_value const* aside_at_(size_t i) const noexcept;
+        bool fits_(typed_value const& e) const noexcept;
+        void adopt_(typed_value const& e);
+        void write_slot_(size_t i, typed_value const& e, bool insert);
+        void erase_slot_(size_t i);
+        void drop_cache_() noexcept;
+        void settle_();
+    };
+
     using value = std::variant<
         std::monostate,
         std::string,
         int64_t,
         double,
         bool,
-        std::vector<typed_value>
+        typed_array
     >;
 
     struct typed_value
     {
         value               val;
-        value_type          type;
-        type_ascription     type_source;
-        value_locus         origin;
+        value_type          type          = value_type::unresolved;
+        type_ascription     type_source   = type_ascription::tacit;
+        value_locus         origin        = value_locus::key_value;
         semantic_state      semantic      = semantic_state::valid;
         contamination_state contamination = contamination_state::clean;
         creation_state      creation      = creation_state::authored;
@@ -194,11 +462,11 @@ namespace nuno
         if (std::holds_alternative<int64_t>(val)) return value_type::integer;
         if (std::holds_alternative<double>(val)) return value_type::floating_point;
         if (std::holds_alternative<bool>(val)) return value_type::boolean;
-        if (std::holds_alternative<std::vector<typed_value>>(val)) 
+        if (std::holds_alternative<typed_array>(val)) 
         {
-            auto const & vec = std::get<std::vector<typed_value>>(val);
-            if (!vec.empty())
-                switch (nuno::held_type(vec.front().val))
+            auto const & arr = std::get<typed_array>(val);
+            if (!arr.empty())
+                switch (arr.held_type_at(0))
                 {
                    case value_type::string: return value_type::string_array;
                    case value_type::integer: return value_type::integer_array;
@@ -224,10 +492,567 @@ namespace nuno
     //inline bool is_boolean(value_type type)         { return type == value_type::boolean; }
 
     inline bool is_numeric(const typed_value &value) { return std::holds_alternative<int64_t>(value.val) || std::holds_alternative<double>(value.val); }
-    inline bool is_array(const typed_value &value)   { return std::holds_alternative<std::vector<typed_value>>(value.val); }
+    inline bool is_array(const typed_value &value)   { return std::holds_alternative<typed_array>(value.val); }
     inline bool is_string(const typed_value &value)  { return std::holds_alternative<std::string>(value.val); }
     inline bool is_boolean(const typed_value &value) { return std::holds_alternative<bool>(value.val); }
 
+//------------------------------------------------------------------------
+// typed_array implementation
+//------------------------------------------------------------------------
+
+    struct typed_array::storage
+    {
+        // Compact form. Elements in the buffer are valid, clean, of
+        // type kind and share the bookkeeping below, unless marks holds
+        // their own.
+        bool                 compact     {true};
+        nuno::value_type     kind        {nuno::value_type::unresolved};
+        type_ascription      type_source {type_ascription::tacit};
+        value_locus          origin      {value_locus::array_element};
+        creation_state       creation    {creation_state::authored};
+        bool                 is_edited   {false};
+        size_t               count       {0};
+
+        std::vector<int64_t> integers;
+        std::vector<double>  reals;
+        std::string          text;       // strings end to end
+        std::vector<size_t>  ends;       // end of each string in text
+        std::vector<uint8_t> marks;      // bookkeeping by slot, once it differs; see pack_marks()
+
+        // Elements that do not fit the buffer, by index
+        std::vector<std::pair<size_t, typed_value>> aside;
+
+        // Expanded form
+        std::vector<typed_value> elements;
+
+        // Elements of a compact array built for reference access
+        mutable std::atomic<std::vector<typed_value>*> cache {nullptr};
+
+        storage() = default;
+        storage(storage const& o)
+            : compact(o.compact), kind(o.kind), type_source(o.type_source), origin(o.origin)
+            , creation(o.creation), is_edited(o.is_edited), count(o.count)
+            , integers(o.integers), reals(o.reals), text(o.text), ends(o.ends), marks(o.marks)
+            , aside(o.aside), elements(o.elements)
+        {
+        }
+        ~storage() { delete cache.load(std::memory_order_relaxed); }
+    };
+
+    namespace detail
+    {
+        // Whether the value held matches a scalar element type
+        inline bool holds_kind(value const& v, value_type kind) noexcept
+        {
+            switch (kind)
+            {
+                case value_type::integer:        return std::holds_alternative<int64_t>(v);
+                case value_type::floating_point: return std::holds_alternative<double>(v);
+                case value_type::string:         return std::holds_alternative<std::string>(v);
+                default:                         return false;
+            }
+        }
+
+        // The bookkeeping of an element in a byte, and back
+        inline uint8_t pack_marks(type_ascription source, value_locus origin, creation_state creation, bool edited) noexcept
+        {
+            return static_cast<uint8_t>(static_cast<unsigned>(source)
+                                      | static_cast<unsigned>(origin) << 1
+                                      | static_cast<unsigned>(creation) << 3
+                                      | static_cast<unsigned>(edited) << 4);
+        }
+
+        inline void unpack_marks(uint8_t m, typed_value& tv) noexcept
+        {
+            tv.type_source = static_cast<type_ascription>(m & 1);
+            tv.origin      = static_cast<value_locus>(m >> 1 & 3);
+            tv.creation    = static_cast<creation_state>(m >> 3 & 1);
+            tv.is_edited   = (m >> 4 & 1) != 0;
+        }
+    }
+
+    inline typed_array::typed_array(std::vector<typed_value> elements)
+        : s_(std::make_unique<storage>())
+    {
+        s_->compact = false;
+        s_->count   = elements.size();
+        s_->elements = std::move(elements);
+        compact();
+    }
+
+    inline typed_array::typed_array(typed_array const& other)
+        : s_(other.s_ ? std::make_unique<storage>(*other.s_) : nullptr)
+    {
+    }
+
+    inline typed_array::typed_array(typed_array&&) noexcept = default;
+    inline typed_array& typed_array::operator=(typed_array&&) noexcept = default;
+    inline typed_array::~typed_array() = default;
+
+    inline typed_array& typed_array::operator=(typed_array const& other)
+    {
+        if (this != &other)
+            s_ = other.s_ ? std::make_unique<storage>(*other.s_) : nullptr;
+        return *this;
+    }
+
+    inline size_t typed_array::size() const noexcept  { return s_ ? s_->count : 0; }
+    inline bool   typed_array::empty() const noexcept { return size() == 0; }
+
+    inline bool   typed_array::is_compact() const noexcept  { return !s_ || s_->compact; }
+    inline size_t typed_array::aside_count() const noexcept { return s_ && s_->compact ? s_->aside.size() : 0; }
+
+    inline std::span<int64_t const> typed_array::integers() const noexcept
+    {
+        if (s_ && s_->compact && s_->kind == value_type::integer)
+            return s_->integers;
+        return {};
+    }
+
+    inline std::span<double const> typed_array::reals() const noexcept
+    {
+        if (s_ && s_->compact && s_->kind == value_type::floating_point)
+            return s_->reals;
+        return {};
+    }
+
+    inline typed_value const* typed_array::aside_at_(size_t i) const noexcept
+    {
+        auto& aside = s_->aside;
+        if (aside.empty())
+            return nullptr;
+
+        auto it = std::ranges::lower_bound(aside, i, {}, &std::pair<size_t, typed_value>::first);
+        return it != aside.end() && it->first == i ? &it->second : nullptr;
+    }
+
+    inline value_type typed_array::type_at(size_t i) const noexcept
+    {
+        if (!s_->compact)
+            return s_->elements[i].type;
+        if (auto* a = aside_at_(i))
+            return a->type;
+        return s_->kind;
+    }
+
+    inline value_type typed_array::held_type_at(size_t i) const noexcept
+    {
+        if (!s_->compact)
+            return nuno::held_type(s_->elements[i].val);
+        if (auto* a = aside_at_(i))
+            return nuno::held_type(a->val);
+        return s_->kind;
+    }
+
+    inline int64_t typed_array::integer_at(size_t i) const
+    {
+        if (!s_->compact)
+            return std::get<int64_t>(s_->elements[i].val);
+        if (auto* a = aside_at_(i))
+            return std::get<int64_t>(a->val);
+        return s_->integers[i];
+    }
+
+    inline double typed_array::real_at(size_t i) const
+    {
+        if (!s_->compact)
+            return std::get<double>(s_->elements[i].val);
+        if (auto* a = aside_at_(i))
+            return std::get<double>(a->val);
+        return s_->reals[i];
+    }
+
+    inline std::string_view typed_array::string_at(size_t i) const
+    {
+        if (!s_->compact)
+            return std::get<std::string>(s_->elements[i].val);
+        if (auto* a = aside_at_(i))
+            return std::get<std::string>(a->val);
+
+        size_t start = i ? s_->ends[i - 1] : 0;
+        return std::string_view(s_->text).substr(start, s_->ends[i] - start);
+    }
+
+    inline typed_value typed_array::element(size_t i) const
+    {
+        if (!s_->compact)
+            return s_->elements[i];
+        if (auto* a = aside_at_(i))
+            return *a;
+
+        typed_value tv;
+        switch (s_->kind)
+        {
+            case value_type::integer:        tv.val = s_->integers[i]; break;
+            case value_type::floating_point: tv.val = s_->reals[i]; break;
+            default:                         tv.val = std::string(string_at(i)); break;
+        }
+        tv.type = s_->kind;
+        if (!s_->marks.empty())
+            detail::unpack_marks(s_->marks[i], tv);
+        else
+        {
+            tv.type_source = s_->type_source;
+            tv.origin      = s_->origin;
+            tv.creation    = s_->creation;
+            tv.is_edited   = s_->is_edited;
+        }
+        return tv;
+    }
+
+    inline bool typed_array::any_invalid() const noexcept
+    {
+        if (!s_)
+            return false;
+        if (s_->compact)
+            return std::ranges::any_of(s_->aside, [](auto const& a) { return a.second.semantic == semantic_state::invalid; });
+        return std::ranges::any_of(s_->elements, [](auto const& e) { return e.semantic == semantic_state::invalid; });
+    }
+
+    inline bool typed_array::any_contaminated() const noexcept
+    {
+        if (!s_)
+            return false;
+        if (s_->compact)
+            return std::ranges::any_of(s_->aside, [](auto const& a) { return a.second.contamination == contamination_state::contaminated; });
+        return std::ranges::any_of(s_->elements, [](auto const& e) { return e.contamination == contamination_state::contaminated; });
+    }
+
+//--Element references
+
+    inline std::vector<typed_value> const& typed_array::elements_() const
+    {
+        static const std::vector<typed_value> none;
+        if (!s_)
+            return none;
+        if (!s_->compact)
+            return s_->elements;
+
+        if (auto* built = s_->cache.load(std::memory_order_acquire))
+            return *built;
+
+        auto built = std::make_unique<std::vector<typed_value>>();
+        built->reserve(s_->count);
+        for (size_t i = 0; i < s_->count; ++i)
+            built->push_back(element(i));
+
+        // A reader that lost the race uses the winner's elements
+        std::vector<typed_value>* expected = nullptr;
+        if (s_->cache.compare_exchange_strong(expected, built.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+            return *built.release();
+        return *expected;
+    }
+
+    inline std::vector<typed_value>& typed_array::expand_()
+    {
+        auto& s = own_();
+        if (s.compact)
+        {
+            if (auto* built = s.cache.exchange(nullptr, std::memory_order_acq_rel))
+            {
+                s.elements = std::move(*built);
+                delete built;
+            }
+            else
+            {
+                s.elements.clear();
+                s.elements.reserve(s.count);
+                for (size_t i = 0; i < s.count; ++i)
+                    s.elements.push_back(element(i));
+            }
+
+            s.compact = false;
+            s.integers = {};
+            s.reals    = {};
+            s.text     = {};
+            s.ends     = {};
+            s.marks    = {};
+            s.aside    = {};
+        }
+        return s.elements;
+    }
+
+    inline typed_value const& typed_array::operator[](size_t i) const { return elements_()[i]; }
+    inline typed_value const& typed_array::at(size_t i) const         { return elements_().at(i); }
+    inline typed_value const& typed_array::front() const              { return elements_().front(); }
+    inline typed_value const& typed_array::back() const               { return elements_().back(); }
+    inline typed_value const* typed_array::data() const               { return elements_().data(); }
+    inline typed_array::const_iterator typed_array::begin() const     { return data(); }
+    inline typed_array::const_iterator typed_array::end() const       { return data() + size(); }
+
+    inline typed_value&          typed_array::operator[](size_t i) { return expand_()[i]; }
+    inline typed_value*          typed_array::data()               { return expand_().data(); }
+    inline typed_array::iterator typed_array::begin()              { return data(); }
+    inline typed_array::iterator typed_array::end()                { return data() + size(); }
+
+//--Edits
+
+    inline typed_array::storage& typed_array::own_()
+    {
+        if (!s_)
+            s_ = std::make_unique<storage>();
+        return *s_;
+    }
+
+    inline void typed_array::drop_cache_() noexcept
+    {
+        if (s_ && s_->cache.load(std::memory_order_relaxed))
+            delete s_->cache.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    // Whether e can live in the buffer; an array without a kind yet
+    // takes any valid, clean scalar
+    inline bool typed_array::fits_(typed_value const& e) const noexcept
+    {
+        if (e.semantic != semantic_state::valid || e.contamination != contamination_state::clean)
+            return false;
+
+        if (s_->kind == value_type::unresolved)
+            return detail::holds_kind(e.val, e.type);
+
+        return e.type == s_->kind && detail::holds_kind(e.val, s_->kind);
+    }
+
+    inline void typed_array::adopt_(typed_value const& e)
+    {
+        s_->kind        = e.type;
+        s_->type_source = e.type_source;
+        s_->origin      = e.origin;
+        s_->creation    = e.creation;
+        s_->is_edited   = e.is_edited;
+
+        // Slots taken so far are placeholders of elements kept aside
+        switch (s_->kind)
+        {
+            case value_type::integer:        s_->integers.assign(s_->count, 0); break;
+            case value_type::floating_point: s_->reals.assign(s_->count, 0.0); break;
+            default:                         s_->ends.assign(s_->count, 0); break;
+        }
+    }
+
+    // Writes e, or a placeholder when it is kept aside, into slot i.
+    // count is the number of slots before an insert.
+    inline void typed_array::write_slot_(size_t i, typed_value const& e, bool insert)
+    {
+        bool in_buffer = fits_(e);
+        if (in_buffer && s_->kind == value_type::unresolved)
+            adopt_(e);
+
+        // Marks are kept once an element's bookkeeping differs from the shared
+        auto shared = detail::pack_marks(s_->type_source, s_->origin, s_->creation, s_->is_edited);
+        auto mark   = in_buffer ? detail::pack_marks(e.type_source, e.origin, e.creation, e.is_edited) : shared;
+        if (s_->marks.empty() && mark != shared)
+            s_->marks.assign(s_->count + (insert ? 1 : 0), shared);
+        else if (!s_->marks.empty() && insert)
+            s_->marks.insert(s_->marks.begin() + i, shared);
+        if (!s_->marks.empty())
+            s_->marks[i] = mark;
+
+        switch (s_->kind)
+        {
+            case value_type::integer:
+            {
+                int64_t v = in_buffer ? std::get<int64_t>(e.val) : 0;
+                if (insert) s_->integers.insert(s_->integers.begin() + i, v);
+                else        s_->integers[i] = v;
+                break;
+            }
+            case value_type::floating_point:
+            {
+                double v = in_buffer ? std::get<double>(e.val) : 0.0;
+                if (insert) s_->reals.insert(s_->reals.begin() + i, v);
+                else        s_->reals[i] = v;
+                break;
+            }
+            case value_type::string:
+            {
+                std::string_view v = in_buffer ? std::string_view(std::get<std::string>(e.val)) : std::string_view{};
+                size_t start   = i ? s_->ends[i - 1] : 0;
+                size_t old_len = insert ? 0 : s_->ends[i] - start;
+
+                s_->text.replace(start, old_len, v);
+                if (insert)
+                    s_->ends.insert(s_->ends.begin() + i, 0);
+                s_->ends[i] = start + v.size();
+
+                // Later ends move by the change in length, modulo 2^n
+                size_t shift = v.size() - old_len;
+                for (size_t j = i + 1; j < s_->ends.size(); ++j)
+                    s_->ends[j] += shift;
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (!in_buffer)
+        {
+            auto it = std::ranges::lower_bound(s_->aside, i, {}, &std::pair<size_t, typed_value>::first);
+            s_->aside.insert(it, { i, e });
+        }
+    }
+
+    inline void typed_array::erase_slot_(size_t i)
+    {
+        switch (s_->kind)
+        {
+            case value_type::integer:
+                s_->integers.erase(s_->integers.begin() + i);
+                break;
+            case value_type::floating_point:
+                s_->reals.erase(s_->reals.begin() + i);
+                break;
+            case value_type::string:
+            {
+                size_t start = i ? s_->ends[i - 1] : 0;
+                size_t len   = s_->ends[i] - start;
+                s_->text.erase(start, len);
+                s_->ends.erase(s_->ends.begin() + i);
+                for (size_t j = i; j < s_->ends.size(); ++j)
+                    s_->ends[j] -= len;
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (!s_->marks.empty())
+            s_->marks.erase(s_->marks.begin() + i);
+
+        auto it = std::ranges::lower_bound(s_->aside, i, {}, &std::pair<size_t, typed_value>::first);
+        if (it != s_->aside.end() && it->first == i)
+            s_->aside.erase(it);
+    }
+
+    // A compact array that has become mostly irregular is expanded
+    inline void typed_array::settle_()
+    {
+        if (s_->compact && s_->aside.size() * 4 > s_->count)
+            expand_();
+    }
+
+    inline void typed_array::set(size_t i, typed_value element)
+    {
+        drop_cache_();
+        if (!s_->compact)
+        {
+            s_->elements[i] = std::move(element);
+            return;
+        }
+
+        auto it = std::ranges::lower_bound(s_->aside, i, {}, &std::pair<size_t, typed_value>::first);
+        if (it != s_->aside.end() && it->first == i)
+            s_->aside.erase(it);
+
+        write_slot_(i, element, false);
+        settle_();
+    }
+
+    inline void typed_array::push_back(typed_value element)
+    {
+        insert(size(), std::move(element));
+    }
+
+    inline void typed_array::insert(size_t pos, typed_value element)
+    {
+        auto& s = own_();
+        drop_cache_();
+        if (!s.compact)
+        {
+            s.elements.insert(s.elements.begin() + pos, std::move(element));
+            ++s.count;
+            return;
+        }
+
+        for (auto& a : s.aside)
+            if (a.first >= pos) ++a.first;
+
+        write_slot_(pos, element, true);
+        ++s.count;
+        settle_();
+    }
+
+    inline void typed_array::erase(size_t pos)
+    {
+        drop_cache_();
+        if (!s_->compact)
+            s_->elements.erase(s_->elements.begin() + pos);
+        else
+        {
+            erase_slot_(pos);
+            for (auto& a : s_->aside)
+                if (a.first > pos) --a.first;
+        }
+        --s_->count;
+    }
+
+    inline void typed_array::clear()
+    {
+        s_.reset();
+    }
+
+    inline void typed_array::compact()
+    {
+        if (!s_ || s_->compact)
+            return;
+
+        auto elements = std::move(s_->elements);
+        s_ = std::make_unique<storage>();
+
+        // Most elements must fit the buffer for packing to pay
+        size_t fitting = 0;
+        for (auto const& e : elements)
+        {
+            if (fits_(e))
+            {
+                if (s_->kind == value_type::unresolved)
+                    adopt_(e);
+                ++fitting;
+            }
+        }
+
+        if ((elements.size() - fitting) * 4 > elements.size())
+        {
+            s_ = std::make_unique<storage>();
+            s_->compact  = false;
+            s_->count    = elements.size();
+            s_->elements = std::move(elements);
+            return;
+        }
+
+        switch (s_->kind)
+        {
+            case value_type::integer:        s_->integers.reserve(elements.size()); break;
+            case value_type::floating_point: s_->reals.reserve(elements.size()); break;
+            default:                         s_->ends.reserve(elements.size()); break;
+        }
+
+        for (auto const& e : elements)
+        {
+            write_slot_(s_->count, e, true);
+            ++s_->count;
+        }
+    }
+
+    inline size_t typed_array::heap_bytes() const noexcept
+    {
+        if (!s_)
+            return 0;
+
+        size_t b = sizeof(storage)
+                 + s_->integers.capacity() * sizeof(int64_t)
+                 + s_->reals.capacity() * sizeof(double)
+                 + s_->text.capacity()
+                 + s_->ends.capacity() * sizeof(size_t)
+                 + s_->marks.capacity()
+                 + s_->aside.capacity() * sizeof(std::pair<size_t, typed_value>)
+                 + s_->elements.capacity() * sizeof(typed_value);
+
+        if (auto* built = s_->cache.load(std::memory_order_acquire))
+            b += built->capacity() * sizeof(typed_value);
+        return b;
+    }
+
 //========================================================================
 // Remaining data structures
 //========================================================================
@@ -293,6 +1118,113 @@ namespace nuno
         bool has_errors() const { return !errors.empty(); }
     };    
     
+//========================================================================
+// Hashing
+//========================================================================
+
+    namespace detail
+    {
+        // Local implementation of the XXH64 algorithm (Yann Collet, BSD).
+        // Used for load cache keys and reload span digests; not a
+        // cryptographic hash.
+        class xxh64
+        {
+        public:
+            static constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+            static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+            static constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+            static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+            static constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+            static uint64_t hash(const void* data, size_t len, uint64_t seed = 0) noexcept
+            {
+                auto const* p   = static_cast<const unsigned char*>(data);
+                auto const* end = p + len;
+                uint64_t h;
+
+                if (len >= 32)
+                {
+                    uint64_t v1 = seed + P1 + P2;
+                    uint64_t v2 = seed + P2;
+                    uint64_t v3 = seed;
+                    uint64_t v4 = seed - P1;
+
+                    auto const* limit = end - 32;
+                    do
+                    {
+                        v1 = round(v1, read64(p));      p += 8;
+                        v2 = round(v2, read64(p));      p += 8;
+                        v3 = round(v3, read64(p));      p += 8;
+                        v4 = round(v4, read64(p));      p += 8;
+                    }
+                    while (p <= limit);
+
+                    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+                    h = merge_round(h, v1);
+                    h = merge_round(h, v2);
+                    h = merge_round(h, v3);
+                    h = merge_round(h, v4);
+                }
+                else
+                    h = seed + P5;
+
+                h += static_cast<uint64_t>(len);
+
+                while (p + 8 <= end)
+                {
+                    h ^= round(0, read64(p));
+                    h  = rotl(h, 27) * P1 + P4;
+                    p += 8;
+                }
+
+                if (p + 4 <= end)
+                {
+                    h ^= static_cast<uint64_t>(read32(p)) * P1;
+                    h  = rotl(h, 23) * P2 + P3;
+                    p += 4;
+                }
+
+                while (p < end)
+                {
+                    h ^= static_cast<uint64_t>(*p) * P5;
+                    h  = rotl(h, 11) * P1;
+                    ++p;
+                }
+
+                h ^= h >> 33;
+                h *= P2;
+                h ^= h >> 29;
+                h *= P3;
+                h ^= h >> 32;
+                return h;
+            }
+
+            static uint64_t hash(std::string_view sv, uint64_t seed = 0) noexcept
+            {
+                return hash(sv.data(), sv.size(), seed);
+            }
+
+        private:
+            static uint64_t rotl(uint64_t x, int r) noexcept { return (x << r) | (x >> (64 - r)); }
+
+            static uint64_t round(uint64_t acc, uint64_t input) noexcept
+            {
+                acc += input * P2;
+                acc  = rotl(acc, 31);
+                return acc * P1;
+            }
+
+            static uint64_t merge_round(uint64_t acc, uint64_t val) noexcept
+            {
+                acc ^= round(0, val);
+                return acc * P1 + P4;
+            }
+
+            static uint64_t read64(const unsigned char* p) noexcept { uint64_t v; std::memcpy(&v, p, 8); return v; }
+            static uint32_t read32(const unsigned char* p) noexcept { uint32_t v; std::memcpy(&v, p, 4); return v; }
+        };
+    }
+
 //========================================================================
 // UTILITY FUNCTIONS
 //========================================================================
@@ -0,0 +1,805 @@
+// nuno_diff.hpp - A Readable Format (NUNO) - Structural diff
+// Version 0.3.0
+// Copyright 2025 Mikael Ueno A
+// Licenced as-is under the MIT licence.
+
+//========================================================================
+// Structural diff
+//
+// diff(from, to) lists what differs between two documents in terms of
+// categories, keys, tables and rows, so that a reload can act on what
+// changed only. Entities are matched by path:
+//
+//  - categories and keys by name within their parent category,
+//  - tables by position within their category, provided the columns
+//    (names and types) agree; otherwise the table is replaced,
+//  - rows by their first cell (row_node::_name()) within a matched
+//    table. Rows, or keys, sharing a name pair up in order.
+//
+// Keys and rows that are in both documents but out of order relative
+// to their siblings are reported as moved. The smallest such set is
+// found from the longest run of siblings that kept their order, so the
+// whole diff is O(n log n) in the size of the documents. Categories and
+// tables are not reported as moved.
+//
+// Only what a document writes out is compared: a category's items in
+// authored order, including those listed by its tables. An entity of
+// the first document that no list holds is reported as removed, so
+// that apply() drops it; one of the second document is ignored.
+//
+// Comments and paragraphs are not compared, and neither is where keys
+// sit relative to tables: keys are ordered among keys only.
+//
+// apply(editor, diff) patches the editor's document, the first
+// document of the diff or a fork of it, into the second. The diff
+// refers to entities of both documents by ID, so both must outlive it.
+//========================================================================
+
+#ifndef NUNO_DIFF_HPP
+#define NUNO_DIFF_HPP
+
+#include "nuno_document.hpp"
+#include "nuno_editor.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace nuno
+{
+    enum class change_kind
+    {
+        added,      // only in the second document
+        removed,    // only in the first document
+        modified,   // in both, with a different value, type or cells
+        moved       // in both, out of order among its siblings
+    };
+
+    // An entity of either document, empty where there is none
+    using diff_entity = std::variant<std::monostate, category_id, key_id, table_id, row_id>;
+
+    struct change
+    {
+        change_kind  kind;
+        diff_entity  from {};   // the entity in the first document
+        diff_entity  to {};     // the entity in the second document
+        std::string  path;      // dot-path, in the second document unless removed
+
+        // Placement of added and moved entities. The owner (category
+        // or table) and the anchor are entities of the first document;
+        // the anchor is a sibling that keeps its place. Without an
+        // anchor the entity goes last in its owner.
+        diff_entity  owner {};
+        diff_entity  anchor {};
+        bool         before_anchor {false};
+    };
+
+    struct document_diff
+    {
+        document const*     from {nullptr};
+        document const*     to   {nullptr};
+        std::vector<change> changes {};
+
+        bool empty() const noexcept { return changes.empty(); }
+        size_t size() const noexcept { return changes.size(); }
+        size_t count(change_kind kind) const noexcept;
+    };
+
+    document_diff diff(document const& from, document const& to);
+
+    // Compares the subtrees under one category of each document. With
+    // subcategories false only the categories' own keys and tables are
+    // compared.
+    document_diff diff(document const& from, category_id from_category,
+                       document const& to, category_id to_category, bool subcategories = true);
+
+    // Returns false if any change could not be applied
+    bool apply(editor& ed, document_diff const& d);
+
+//========================================================================
+// Implementation
+//========================================================================
+
+    namespace detail
+    {
+        inline bool same_value(value const& a, value const& b) noexcept
+        {
+            if (a.index() != b.index())
+                return false;
+
+            return std::visit([&b](auto const& x) -> bool
+            {
+                using T = std::decay_t<decltype(x)>;
+                auto const& y = std::get<T>(b);
+
+                if constexpr (std::is_same_v<T, typed_array>)
+                {
+                    if (x.size() != y.size())
+                        return false;
+
+                    // Scalars of the same type are compared in place
+                    for (size_t i = 0; i < x.size(); ++i)
+                    {
+                        auto type = x.type_at(i);
+                        bool same = false;
+
+                        if (type != y.type_at(i))
+                            same = same_value(x.element(i).val, y.element(i).val);
+                        else if (type == value_type::integer)
+                            same = x.integer_at(i) == y.integer_at(i);
+                        else if (type == value_type::floating_point)
+                            same = x.real_at(i) == y.real_at(i);
+                        else if (type == value_type::string)
+                            same = x.string_at(i) == y.string_at(i);
+                        else
+                            same = same_value(x.element(i).val, y.element(i).val);
+
+                        if (!same)
+                            return false;
+                    }
+                    return true;
+                }
+                else
+                    return x == y;
+            }, a);
+        }
+
+        inline std::string join_path(std::string const& path, std::string_view segment)
+        {
+            if (path.empty())
+                return std::string(segment);
+
+            std::string res;
+            res.reserve(path.size() + 1 + segment.size());
+            return res.append(path).append(1, '.').append(segment);
+        }
+
+        // Marks the longest subsequence of seq that is increasing
+        inline std::vector<bool> longest_increasing(std::vector<size_t> const& seq)
+        {
+            constexpr size_t none = static_cast<size_t>(-1);
+
+            std::vector<size_t> tails;                  // seq index ending the best run of each length
+            std::vector<size_t> prev(seq.size(), none);
+
+            for (size_t i = 0; i < seq.size(); ++i)
+            {
+                auto it = std::ranges::lower_bound(tails, seq[i], {}, [&seq](size_t t) { return seq[t]; });
+                if (it != tails.begin())
+                    prev[i] = *std::prev(it);
+
+                if (it == tails.end()) tails.push_back(i);
+                else                   *it = i;
+            }
+
+            std::vector<bool> res(seq.size(), false);
+            for (size_t i = tails.empty() ? none : tails.back(); i != none; i = prev[i])
+                res[i] = true;
+            return res;
+        }
+
+        // Pairs up two sibling sequences by key
+        struct sibling_match
+        {
+            static constexpr size_t none = static_cast<size_t>(-1);
+
+            std::vector<size_t> to_from;    // first-document index of each second-document item, or none
+            std::vector<bool>   matched;    // per first-document item
+            std::vector<bool>   stable;     // per second-document item: matched and in order
+        };
+
+        template<typename FromKey, typename ToKey>
+        sibling_match match_siblings(size_t from_n, size_t to_n, FromKey&& from_key, ToKey&& to_key)
+        {
+            sibling_match m;
+            m.to_from.assign(to_n, sibling_match::none);
+            m.matched.assign(from_n, false);
+            m.stable.assign(to_n, false);
+
+            // Filled back to front so that repeated keys pair up in order
+            std::unordered_map<std::string, std::vector<size_t>> pending;
+            pending.reserve(from_n);
+            for (size_t i = from_n; i-- > 0;)
+                pending[std::string(from_key(i))].push_back(i);
+
+            std::vector<size_t> order;      // first-document indices in second-document order
+            std::vector<size_t> order_pos;
+            for (size_t j = 0; j < to_n; ++j)
+            {
+                auto it = pending.find(std::string(to_key(j)));
+                if (it == pending.end() || it->second.empty())
+                    continue;
+
+                size_t i = it->second.back();
+                it->second.pop_back();
+
+                m.to_from[j] = i;
+                m.matched[i] = true;
+                order.push_back(i);
+                order_pos.push_back(j);
+            }
+
+            auto in_order = longest_increasing(order);
+            for (size_t k = 0; k < order.size(); ++k)
+                m.stable[order_pos[k]] = in_order[k];
+
+            return m;
+        }
+
+        class diff_builder
+        {
+        public:
+            diff_builder(document const& from, document const& to, std::vector<change>& out, bool descend = true)
+                : from_(from), to_(to), out_(out), descend_(descend)
+            {}
+
+            void category(document::category_view a, document::category_view b, std::string const& path);
+
+        private:
+            // The keys, tables and subcategories a category writes out,
+            // in authored order
+            struct authored
+            {
+                std::vector<key_id>      keys;
+                std::vector<table_id>    tables;
+                std::vector<category_id> children;
+            };
+
+            document const&      from_;
+            document const&      to_;
+            std::vector<change>& out_;
+            bool                 descend_;
+
+            void keys(authored const& a, authored const& b, category_id owner, std::string const& path);
+            void tables(authored const& a, authored const& b, category_id owner, std::string const& path);
+            void rows(document::table_view a, document::table_view b, std::string const& path);
+
+            static authored authored_items(document const& doc, document::category_view c);
+
+            // Reports the members of c that a lists nowhere as removed
+            template<typename Id, typename PathOf>
+            void unlisted(std::span<const Id> members, std::vector<Id> const& listed, category_id owner, PathOf&& path_of);
+            static bool same_columns(document::table_view a, document::table_view b);
+            static bool same_cells(document::table_row_view a, document::table_row_view b);
+
+            // Emits removed, then added, moved and modified changes in
+            // second-document order, anchored on the stable siblings.
+            template<typename Id, typename Owner, typename PathOf, typename Modified>
+            void emit(sibling_match const& m, std::span<const Id> a, std::span<const Id> b, Owner owner,
+                      PathOf&& path_of, Modified&& modified);
+        };
+
+        template<typename Id, typename Owner, typename PathOf, typename Modified>
+        void diff_builder::emit(sibling_match const& m, std::span<const Id> a, std::span<const Id> b, Owner owner,
+                                PathOf&& path_of, Modified&& modified)
+        {
+            for (size_t i = 0; i < a.size(); ++i)
+                if (!m.matched[i])
+                    out_.push_back({ .kind = change_kind::removed, .from = a[i], .path = path_of(false, i), .owner = owner });
+
+            // Items before the first stable sibling go in front of it
+            diff_entity first_stable;
+            for (size_t j = 0; j < b.size(); ++j)
+                if (m.stable[j]) { first_stable = a[m.to_from[j]]; break; }
+
+            diff_entity last_stable;
+            for (size_t j = 0; j < b.size(); ++j)
+            {
+                size_t i = m.to_from[j];
+
+                if (!m.stable[j])
+                {
+                    bool after = !std::holds_alternative<std::monostate>(last_stable);
+                    change c { .kind = i == sibling_match::none ? change_kind::added : change_kind::moved,
+                               .to = b[j], .path = path_of(true, j), .owner = owner,
+                               .anchor = after ? last_stable : first_stable,
+                               .before_anchor = !after && !std::holds_alternative<std::monostate>(first_stable) };
+                    if (i != sibling_match::none)
+                        c.from = a[i];
+                    out_.push_back(std::move(c));
+                }
+                else
+                    last_stable = a[i];
+
+                if (i != sibling_match::none && modified(i, j))
+                    out_.push_back({ .kind = change_kind::modified, .from = a[i], .to = b[j], .path = path_of(true, j) });
+            }
+        }
+
+        inline diff_builder::authored diff_builder::authored_items(document const& doc, document::category_view c)
+        {
+            authored out;
+            out.keys.reserve(c.keys_count());
+            out.tables.reserve(c.tables_count());
+            out.children.reserve(c.children_count());
+
+            // Items written after a table are listed by it
+            auto walk = [&](auto const& items, auto& self) -> void
+            {
+                for (auto const& item : items)
+                {
+                    if (auto const* k = std::get_if<key_id>(&item.id))
+                        out.keys.push_back(*k);
+                    else if (auto const* g = std::get_if<category_id>(&item.id))
+                        out.children.push_back(*g);
+                    else if (auto const* t = std::get_if<table_id>(&item.id))
+                    {
+                        out.tables.push_back(*t);
+                        if (auto tv = doc.table(*t))
+                            self(tv->node->ordered_items, self);
+                    }
+                }
+            };
+            walk(c.node->ordered_items, walk);
+            return out;
+        }
+
+        template<typename Id, typename PathOf>
+        void diff_builder::unlisted(std::span<const Id> members, std::vector<Id> const& listed, category_id owner, PathOf&& path_of)
+        {
+            if (listed.size() == members.size())
+                return;
+
+            std::unordered_set<typename Id::value_type> seen;
+            for (auto id : listed) seen.insert(id.val);
+            for (size_t n = 0; n < members.size(); ++n)
+                if (!seen.contains(members[n].val))
+                    out_.push_back({ .kind = change_kind::removed, .from = members[n], .path = path_of(n), .owner = owner });
+        }
+
+        inline void diff_builder::category(document::category_view a, document::category_view b, std::string const& path)
+        {
+            auto la = authored_items(from_, a), lb = authored_items(to_, b);
+            auto name_in = [](document const& doc, category_id id) { return doc.category(id)->name(); };
+
+            unlisted(a.keys(), la.keys, a.id(), [&](size_t n) { return join_path(path, from_.key(a.keys()[n])->name()); });
+            unlisted(a.tables(), la.tables, a.id(), [&](size_t n) { return join_path(path, "#" + std::to_string(n)); });
+            if (descend_)
+                unlisted(a.children(), la.children, a.id(), [&](size_t n) { return join_path(path, name_in(from_, a.children()[n])); });
+
+            keys(la, lb, a.id(), path);
+            tables(la, lb, a.id(), path);
+            if (!descend_)
+                return;
+
+            std::span<const category_id> ca = la.children, cb = lb.children;
+
+            auto m = match_siblings(ca.size(), cb.size(),
+                [&](size_t i) { return name_in(from_, ca[i]); },
+                [&](size_t j) { return name_in(to_, cb[j]); });
+
+            // Categories keep their place: matched ones are compared,
+            // the rest are added or removed whole.
+            for (size_t i = 0; i < ca.size(); ++i)
+                if (!m.matched[i])
+                    out_.push_back({ .kind = change_kind::removed, .from = ca[i],
+                                     .path = join_path(path, name_in(from_, ca[i])), .owner = a.id() });
+
+            for (size_t j = 0; j < cb.size(); ++j)
+            {
+                auto child_path = join_path(path, name_in(to_, cb[j]));
+                if (m.to_from[j] == sibling_match::none)
+                    out_.push_back({ .kind = change_kind::added, .to = cb[j], .path = std::move(child_path), .owner = a.id() });
+                else
+                    category(*from_.category(ca[m.to_from[j]]), *to_.category(cb[j]), child_path);
+            }
+        }
+
+        inline void diff_builder::keys(authored const& a, authored const& b, category_id owner, std::string const& path)
+        {
+            std::span<const key_id> ka = a.keys, kb = b.keys;
+            auto m = match_siblings(ka.size(), kb.size(),
+                [&](size_t i) { return from_.key(ka[i])->name(); },
+                [&](size_t j) { return to_.key(kb[j])->name(); });
+
+            emit(m, ka, kb, owner,
+                [&](bool in_to, size_t n) { return join_path(path, in_to ? to_.key(kb[n])->name() : from_.key(ka[n])->name()); },
+                [&](size_t i, size_t j)
+                {
+                    auto x = *from_.key(ka[i]), y = *to_.key(kb[j]);
+                    return x.node->type != y.node->type
+                        || x.value().type_source != y.value().type_source
+                        || !same_value(x.value().val, y.value().val);
+                });
+        }
+
+        inline bool diff_builder::same_columns(document::table_view a, document::table_view b)
+        {
+            if (a.column_count() != b.column_count())
+                return false;
+
+            for (size_t c = 0; c < a.column_count(); ++c)
+            {
+                auto x = *a.column(a.columns()[c]), y = *b.column(b.columns()[c]);
+                if (x.name() != y.name() || x.type() != y.type())
+                    return false;
+            }
+            return true;
+        }
+
+        inline bool diff_builder::same_cells(document::table_row_view a, document::table_row_view b)
+        {
+            return std::ranges::equal(a.cells(), b.cells(), [](auto const& x, auto const& y) { return same_value(x.val, y.val); });
+        }
+
+        inline void diff_builder::tables(authored const& a, authored const& b, category_id owner, std::string const& path)
+        {
+            std::span<const table_id> ta = a.tables, tb = b.tables;
+            auto table_path = [&](size_t n) { return join_path(path, "#" + std::to_string(n)); };
+
+            // Tables pair up by position while their columns agree
+            std::vector<bool> kept(std::min(ta.size(), tb.size()));
+            for (size_t n = 0; n < kept.size(); ++n)
+                kept[n] = same_columns(*from_.table(ta[n]), *to_.table(tb[n]));
+
+            for (size_t n = 0; n < ta.size(); ++n)
+                if (n >= kept.size() || !kept[n])
+                    out_.push_back({ .kind = change_kind::removed, .from = ta[n], .path = table_path(n), .owner = owner });
+
+            diff_entity last_kept, first_kept;
+            for (size_t n = 0; n < kept.size(); ++n)
+                if (kept[n]) { first_kept = ta[n]; break; }
+
+            for (size_t n = 0; n < tb.size(); ++n)
+            {
+                if (n < kept.size() && kept[n])
+                {
+                    last_kept = ta[n];
+                    rows(*from_.table(ta[n]), *to_.table(tb[n]), table_path(n));
+                    continue;
+                }
+
+                bool after = !std::holds_alternative<std::monostate>(last_kept);
+                out_.push_back({ .kind = change_kind::added, .to = tb[n], .path = table_path(n), .owner = owner,
+                                 .anchor = after ? last_kept : first_kept,
+                                 .before_anchor = !after && !std::holds_alternative<std::monostate>(first_kept) });
+            }
+        }
+
+        inline void diff_builder::rows(document::table_view a, document::table_view b, std::string const& path)
+        {
+            // Matching reads rows by position; flatten each sequence once
+            std::vector<row_id> ra(a.rows().begin(), a.rows().end());
+            std::vector<row_id> rb(b.rows().begin(), b.rows().end());
+            auto m = match_siblings(ra.size(), rb.size(),
+                [&](size_t i) { return from_.row(ra[i])->name(); },
+                [&](size_t j) { return to_.row(rb[j])->name(); });
+
+            emit(m, std::span<const row_id>(ra), std::span<const row_id>(rb), a.id(),
+                [&](bool in_to, size_t n) { return join_path(path, "-" + (in_to ? to_.row(rb[n]) : from_.row(ra[n]))->name() + "-"); },
+                [&](size_t i, size_t j) { return !same_cells(*from_.row(ra[i]), *to_.row(rb[j])); });
+        }
+
+        class diff_applier
+        {
+        public:
+            diff_applier(editor& ed, document const& to) : ed_(ed), to_(to) {}
+
+            bool apply(change const& c);
+
+        private:
+            editor&         ed_;
+            document const& to_;
+
+            // The document being edited, as it stands
+            document const& from() const noexcept { return ed_.doc_; }
+
+            // A run of entities placed against the same anchor in the
+            // same owner is chained: each one goes after the one placed
+            // before it.
+            diff_entity last_owner_;
+            diff_entity last_anchor_;
+            bool        last_before_ {false};
+            diff_entity last_placed_;
+
+            template<typename Id>
+            std::pair<Id, bool> placement(change const& c) const;
+
+            template<typename Id>
+            void placed(change const& c, Id id);
+
+            bool add_key(change const& c);
+            bool add_row(change const& c);
+            bool add_table(change const& c);
+            bool erase_category(category_id id);
+
+            key_id copy_key(category_id where, document::key_view k);
+            table_id copy_table(category_id where, document::table_view t);
+            void copy_category(category_id where, document::category_view cat);
+
+            static std::vector<value> cells_of(document::table_row_view r);
+            static std::vector<std::pair<std::string, std::optional<value_type>>> columns_of(document::table_view t);
+        };
+
+        template<typename Id>
+        std::pair<Id, bool> diff_applier::placement(change const& c) const
+        {
+            if (c.owner == last_owner_ && c.anchor == last_anchor_ && c.before_anchor == last_before_
+                && std::holds_alternative<Id>(last_placed_))
+                return { std::get<Id>(last_placed_), false };
+
+            if (auto const* id = std::get_if<Id>(&c.anchor))
+                return { *id, c.before_anchor };
+
+            return { invalid_id<typename Id::tag_type>(), false };
+        }
+
+        template<typename Id>
+        void diff_applier::placed(change const& c, Id id)
+        {
+            last_owner_  = c.owner;
+            last_anchor_ = c.anchor;
+            last_before_ = c.before_anchor;
+            last_placed_ = id;
+        }
+
+        inline std::vector<value> diff_applier::cells_of(document::table_row_view r)
+        {
+            std::vector<value> cells;
+            cells.reserve(r.cells().size());
+            for (auto const& cell : r.cells())
+                cells.push_back(cell.val);
+            return cells;
+        }
+
+        inline std::vector<std::pair<std::string, std::optional<value_type>>> diff_applier::columns_of(document::table_view t)
+        {
+            std::vector<std::pair<std::string, std::optional<value_type>>> cols;
+            for (auto id : t.columns())
+            {
+                auto const& col = t.column(id)->node->col;
+                cols.emplace_back(col.name, col.type_source == type_ascription::declared
+                                              ? std::optional<value_type>(col.type) : std::nullopt);
+            }
+            return cols;
+        }
+
+        inline bool diff_applier::apply(change const& c)
+        {
+            switch (c.kind)
+            {
+                case change_kind::removed:
+                    if (auto const* k = std::get_if<key_id>(&c.from))      return ed_.erase_key(*k);
+                    if (auto const* r = std::get_if<row_id>(&c.from))      return ed_.erase_row(*r);
+                    if (auto const* t = std::get_if<table_id>(&c.from))    return ed_.erase_table(*t);
+                    if (auto const* g = std::get_if<category_id>(&c.from)) return erase_category(*g);
+                    return false;
+
+                case change_kind::added:
+                    if (std::holds_alternative<key_id>(c.to))   return add_key(c);
+                    if (std::holds_alternative<row_id>(c.to))   return add_row(c);
+                    if (std::holds_alternative<table_id>(c.to)) return add_table(c);
+                    if (auto const* g = std::get_if<category_id>(&c.to))
+                    {
+                        auto id = ed_.append_category(std::get<category_id>(c.owner), to_.category(*g)->name());
+                        if (!valid(id)) return false;
+                        copy_category(id, *to_.category(*g));
+                        return true;
+                    }
+                    return false;
+
+                case change_kind::moved:
+                    if (auto const* k = std::get_if<key_id>(&c.from))
+                    {
+                        auto [anchor, before] = placement<key_id>(c);
+                        if (before) ed_.move_child_before(*k, anchor);
+                        else        ed_.move_child_after(*k, anchor);
+                        placed(c, *k);
+                        return true;
+                    }
+                    if (auto const* r = std::get_if<row_id>(&c.from))
+                    {
+                        auto [anchor, before] = placement<row_id>(c);
+                        if (before) ed_.move_row_before(*r, anchor);
+                        else        ed_.move_row_after(*r, anchor);
+                        placed(c, *r);
+                        return true;
+                    }
+                    return false;
+
+                case change_kind::modified:
+                    if (auto const* k = std::get_if<key_id>(&c.from))
+                    {
+                        auto target  = *to_.key(std::get<key_id>(c.to));
+                        auto current = from().key(*k);
+                        if (!current) return false;
+
+                        if (current->node->type != target.node->type || current->value().type_source != target.value().type_source)
+                            ed_.set_key_type(*k, target.node->type, target.value().type_source);
+                        ed_.set_key_value(*k, target.value().val);
+                        return true;
+                    }
+                    if (auto const* r = std::get_if<row_id>(&c.from))
+                    {
+                        auto target  = *to_.row(std::get<row_id>(c.to));
+                        auto current = from().row(*r);
+                        if (!current) return false;
+
+                        auto columns = current->table().columns();
+                        auto now     = current->cells();
+                        auto cells   = target.cells();
+                        for (size_t i = 0; i < cells.size() && i < columns.size(); ++i)
+                            if (i >= now.size() || !same_value(now[i].val, cells[i].val))
+                                ed_.set_cell_value(*r, columns[i], cells[i].val);
+                        return true;
+                    }
+                    return false;
+            }
+            return false;
+        }
+
+        inline bool diff_applier::add_key(change const& c)
+        {
+            auto k = *to_.key(std::get<key_id>(c.to));
+            bool untyped = k.value().type_source != type_ascription::declared;
+            auto [anchor, before] = placement<key_id>(c);
+
+            key_id id;
+            if (valid(anchor))
+            {
+                id = before ? ed_.insert_key_before(anchor, k.name(), k.value().val, untyped)
+                            : ed_.insert_key_after(anchor, k.name(), k.value().val, untyped);
+                if (valid(id) && k.node->type != from().key(id)->node->type)
+                    ed_.set_key_type(id, k.node->type, k.value().type_source);
+            }
+
+            // Anchors the editor cannot place against go last
+            if (!valid(id))
+                id = copy_key(std::get<category_id>(c.owner), k);
+
+            if (!valid(id)) return false;
+            placed(c, id);
+            return true;
+        }
+
+        inline bool diff_applier::add_row(change const& c)
+        {
+            auto r = *to_.row(std::get<row_id>(c.to));
+            auto [anchor, before] = placement<row_id>(c);
+
+            row_id id;
+            if (!valid(anchor))   id = ed_.append_row(std::get<table_id>(c.owner), cells_of(r));
+            else if (before)      id = ed_.insert_row_before(anchor, cells_of(r));
+            else                  id = ed_.insert_row_after(anchor, cells_of(r));
+
+            if (!valid(id)) return false;
+            placed(c, id);
+            return true;
+        }
+
+        inline bool diff_applier::add_table(change const& c)
+        {
+            auto t = *to_.table(std::get<table_id>(c.to));
+            auto [anchor, before] = placement<table_id>(c);
+
+            table_id id;
+            if (!valid(anchor))
+                id = copy_table(std::get<category_id>(c.owner), t);
+            else
+            {
+                id = before ? ed_.insert_table_before(anchor, columns_of(t))
+                            : ed_.insert_table_after(anchor, columns_of(t));
+                for (auto r : t.rows())
+                    ed_.append_row(id, cells_of(*to_.row(r)));
+            }
+
+            if (!valid(id)) return false;
+            placed(c, id);
+            return true;
+        }
+
+        inline key_id diff_applier::copy_key(category_id where, document::key_view k)
+        {
+            bool untyped = k.value().type_source != type_ascription::declared;
+            auto id = ed_.append_key(where, k.name(), k.value().val, untyped);
+
+            // A declared type the value does not satisfy is kept as is
+            if (valid(id) && k.node->type != from().key(id)->node->type)
+                ed_.set_key_type(id, k.node->type, k.value().type_source);
+            return id;
+        }
+
+        inline table_id diff_applier::copy_table(category_id where, document::table_view t)
+        {
+            auto id = ed_.append_table(where, columns_of(t));
+            if (valid(id))
+                for (auto r : t.rows())
+                    ed_.append_row(id, cells_of(*to_.row(r)));
+            return id;
+        }
+
+        inline void diff_applier::copy_category(category_id where, document::category_view cat)
+        {
+            for (auto k : cat.keys())
+                copy_key(where, *to_.key(k));
+            for (auto t : cat.tables())
+                copy_table(where, *to_.table(t));
+            for (auto child : cat.children())
+            {
+                auto src = *to_.category(child);
+                auto id = ed_.append_category(where, src.name());
+                if (valid(id))
+                    copy_category(id, src);
+            }
+        }
+
+        inline bool diff_applier::erase_category(category_id id)
+        {
+            // editor::erase_category only takes empty categories
+            auto cat = from().category(id);
+            if (!cat) return false;
+
+            auto const* node = cat->node;
+
+            auto children = node->children;
+            auto tables   = node->tables;
+            auto keys     = node->keys;
+            std::vector<comment_id>   comments;
+            std::vector<paragraph_id> paragraphs;
+            for (auto const& item : node->ordered_items)
+            {
+                if (auto const* cm = std::get_if<comment_id>(&item.id))   comments.push_back(*cm);
+                if (auto const* p  = std::get_if<paragraph_id>(&item.id)) paragraphs.push_back(*p);
+            }
+
+            for (auto child : children) erase_category(child);
+            for (auto t : tables)       ed_.erase_table(t);
+            for (auto k : keys)         ed_.erase_key(k);
+            for (auto cm : comments)    ed_.erase_comment(cm);
+            for (auto p : paragraphs)   ed_.erase_paragraph(p);
+
+            return ed_.erase_category(id);
+        }
+    }
+
+    inline size_t document_diff::count(change_kind kind) const noexcept
+    {
+        return static_cast<size_t>(std::ranges::count(changes, kind, &change::kind));
+    }
+
+    inline document_diff diff(document const& from, document const& to)
+    {
+        document_diff d { .from = &from, .to = &to };
+
+        auto a = from.root(), b = to.root();
+        if (a && b)
+            detail::diff_builder(from, to, d.changes).category(*a, *b, "");
+        return d;
+    }
+
+    inline document_diff diff(document const& from, category_id from_category,
+                              document const& to, category_id to_category, bool subcategories)
+    {
+        document_diff d { .from = &from, .to = &to };
+
+        auto a = from.category(from_category), b = to.category(to_category);
+        if (!a || !b)
+            return d;
+
+        // Paths start at the category's own path in the first document
+        std::string path;
+        for (auto c = a; c && !c->is_root(); c = c->parent())
+            path = path.empty() ? std::string(c->name()) : std::string(c->name()) + "." + path;
+
+        detail::diff_builder(from, to, d.changes, subcategories).category(*a, *b, path);
+        return d;
+    }
+
+    inline bool apply(editor& ed, document_diff const& d)
+    {
+        if (!d.to)
+            return d.empty();
+
+        editor::batch settle(ed);
+        detail::diff_applier applier(ed, *d.to);
+
+        bool ok = true;
+        for (auto const& c : d.changes)
+            ok = applier.apply(c) && ok;
+        return ok;
+    }
+}
+
+#endif
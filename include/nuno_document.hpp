@@ -8,14 +8,19 @@
 
 #include "nuno_parser.hpp"
 
+#include <array>
 #include <cassert>
+#include <deque>
 #include <functional>
 #include <iterator>
-#include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <ranges>
 #include <span>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 namespace nuno
 {
@@ -24,11 +29,325 @@ namespace nuno
         template<typename T> struct node_to_view;
     }
 
+//========================================================================
+// Node storage
+// ---------------------------
+// A sequence split into fixed-capacity chunks held by shared_ptr.
+// Copying a store shares every chunk; the first mutable access to a
+// shared chunk copies that chunk only. A chunk copy copies the nodes
+// themselves but not their member lists, which are shared separately
+// (see shared_value below).
+//
+// Mutable iterators only copy a chunk when they are dereferenced, so
+// searching through a non-const store unshares nothing. Elements do not
+// move when the store grows, only when their own chunk is inserted
+// into, erased from or split.
+//========================================================================
+
+    template<typename T>
+    class node_store
+    {
+        using chunk = std::vector<T>;
+
+    public:
+        static constexpr size_t CHUNK = 128;
+
+        template<bool Const>
+        class basic_iterator
+        {
+            using store_type = std::conditional_t<Const, node_store const, node_store>;
+
+        public:
+            using iterator_concept  = std::random_access_iterator_tag;
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using reference         = std::conditional_t<Const, T const&, T&>;
+            using pointer           = std::conditional_t<Const, T const*, T*>;
+
+            basic_iterator() = default;
+
+            // Mutable to const
+            template<bool C> requires (Const && !C)
+            basic_iterator(basic_iterator<C> const& it) noexcept
+                : store_(it.store_), c_(it.c_), o_(it.o_) {}
+
+            reference operator*() const
+            {
+                if constexpr (Const) return (*store_->chunks_[c_])[o_];
+                else                 return store_->writable(c_)[o_];
+            }
+            pointer operator->() const { return &**this; }
+            reference operator[](difference_type n) const { return *(*this + n); }
+
+            basic_iterator& operator++() noexcept
+            {
+                if (++o_ == store_->chunks_[c_]->size()) { ++c_; o_ = 0; }
+                return *this;
+            }
+            basic_iterator& operator--() noexcept
+            {
+                if (o_ == 0) o_ = store_->chunks_[--c_]->size();
+                --o_;
+                return *this;
+            }
+            basic_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+            basic_iterator operator--(int) noexcept { auto tmp = *this; --*this; return tmp; }
+
+            basic_iterator& operator+=(difference_type n) noexcept { return *this = store_->template at<Const>(position() + n); }
+            basic_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+            friend basic_iterator operator+(basic_iterator it, difference_type n) noexcept { return it += n; }
+            friend basic_iterator operator+(difference_type n, basic_iterator it) noexcept { return it += n; }
+            friend basic_iterator operator-(basic_iterator it, difference_type n) noexcept { return it -= n; }
+            friend difference_type operator-(basic_iterator const& a, basic_iterator const& b) noexcept
+            {
+                return static_cast<difference_type>(a.position()) - static_cast<difference_type>(b.position());
+            }
+
+            bool operator==(basic_iterator const& rhs) const noexcept { return c_ == rhs.c_ && o_ == rhs.o_; }
+            auto operator<=>(basic_iterator const& rhs) const noexcept
+            {
+                if (auto cmp = c_ <=> rhs.c_; cmp != 0) return cmp;
+                return o_ <=> rhs.o_;
+            }
+
+        private:
+            friend class node_store;
+            friend class basic_iterator<!Const>;
+
+            basic_iterator(store_type* store, size_t c, size_t o) noexcept : store_(store), c_(c), o_(o) {}
+
+            size_t position() const noexcept { return store_->start_of(c_) + o_; }
+
+            store_type* store_ {nullptr};
+            size_t      c_     {0};     // chunk; chunks_.size() at the end
+            size_t      o_     {0};     // offset within the chunk
+        };
+
+        using iterator       = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using value_type     = T;
+        using size_type      = size_t;
+
+        size_t size() const noexcept { return ends_.empty() ? 0 : ends_.back(); }
+        bool empty() const noexcept { return ends_.empty(); }
+
+        iterator       begin() noexcept       { return {this, 0, 0}; }
+        iterator       end() noexcept         { return {this, chunks_.size(), 0}; }
+        const_iterator begin() const noexcept { return {this, 0, 0}; }
+        const_iterator end() const noexcept   { return {this, chunks_.size(), 0}; }
+
+        T&       operator[](size_t i)       { return *at<false>(i); }
+        T const& operator[](size_t i) const { return *at<true>(i); }
+        T&       front()                    { return writable(0).front(); }
+        T const& front() const              { return chunks_.front()->front(); }
+        T&       back()                     { return writable(chunks_.size() - 1).back(); }
+        T const& back() const               { return chunks_.back()->back(); }
+
+        // The mutable iterator for a position found through a const search
+        iterator unconst(const_iterator it) noexcept { return {this, it.c_, it.o_}; }
+
+        void reserve(size_t n)
+        {
+            chunks_.reserve((n + CHUNK - 1) / CHUNK);
+            ends_.reserve((n + CHUNK - 1) / CHUNK);
+        }
+
+        void clear() noexcept { chunks_.clear(); ends_.clear(); }
+
+        void push_back(T const& value) { emplace_back(value); }
+        void push_back(T&& value)      { emplace_back(std::move(value)); }
+
+        template<typename... Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (chunks_.empty() || chunks_.back()->size() == CHUNK)
+            {
+                chunks_.push_back(make_chunk());
+                ends_.push_back(size());
+            }
+
+            auto& tail = writable(chunks_.size() - 1);
+            tail.emplace_back(std::forward<Args>(args)...);
+            ++ends_.back();
+            return tail.back();
+        }
+
+        iterator insert(const_iterator pos, T value);
+        iterator erase(const_iterator pos);
+
+        // Number of chunks this store shares with any other
+        size_t shared_chunks() const noexcept
+        {
+            return static_cast<size_t>(std::ranges::count_if(chunks_, [](auto const& c) { return c.use_count() > 1; }));
+        }
+
+    private:
+        std::vector<std::shared_ptr<chunk>> chunks_;
+        std::vector<size_t>                 ends_;     // running element count after each chunk
+
+        static std::shared_ptr<chunk> make_chunk()
+        {
+            auto c = std::make_shared<chunk>();
+            c->reserve(CHUNK);
+            return c;
+        }
+
+        size_t start_of(size_t c) const noexcept { return c == 0 ? 0 : ends_[c - 1]; }
+
+        chunk& writable(size_t c)
+        {
+            if (chunks_[c].use_count() > 1)
+            {
+                auto copy = make_chunk();
+                copy->insert(copy->end(), chunks_[c]->begin(), chunks_[c]->end());
+                chunks_[c] = std::move(copy);
+            }
+            return *chunks_[c];
+        }
+
+        template<bool Const>
+        auto at(size_t i) const noexcept
+        {
+            auto* self = const_cast<node_store*>(this);
+            using store_type = std::conditional_t<Const, node_store const, node_store>;
+
+            size_t c = static_cast<size_t>(std::ranges::upper_bound(ends_, i) - ends_.begin());
+            size_t o = c < chunks_.size() ? i - start_of(c) : 0;
+            return basic_iterator<Const>(static_cast<store_type*>(self), c, o);
+        }
+    };
+
+//========================================================================
+// Shared node members
+// ---------------------------
+// node_store copies a whole chunk when one of its nodes is edited. The
+// member lists of categories and tables can be far larger than the
+// nodes, so they are held through shared_value: copying one shares the
+// value, and the first edit through a copy copies that value alone. A
+// chunk copied for one node's edit therefore leaves the lists of every
+// node in it shared, and the edited node's lists are copied only if
+// the edit reaches them.
+//========================================================================
+
+    template<typename T>
+    class shared_value
+    {
+    public:
+        T const& operator*() const noexcept { return p_ ? *p_ : none(); }
+        T const* operator->() const noexcept { return &**this; }
+
+        // The value to edit, unshared (or made) first
+        T& edit()
+        {
+            if (!p_)
+                p_ = std::make_shared<T>();
+            else if (p_.use_count() > 1)
+                p_ = std::make_shared<T>(*p_);
+            return *p_;
+        }
+
+        void reset() noexcept { p_.reset(); }
+        bool shares_with(shared_value const& rhs) const noexcept { return p_ && p_ == rhs.p_; }
+
+    private:
+        std::shared_ptr<T> p_;
+
+        static T const& none() noexcept { static const T empty{}; return empty; }
+    };
+
+    // A std::vector behind a shared_value. Reads see a const contiguous
+    // range; edits go through the members below, or through edit() for
+    // anything else, and unshare first.
+    template<typename T>
+    class shared_list
+    {
+    public:
+        using value_type     = T;
+        using size_type      = size_t;
+        using const_iterator = T const*;
+        using iterator       = const_iterator;
+
+        size_t size() const noexcept     { return v_->size(); }
+        bool   empty() const noexcept    { return v_->empty(); }
+        size_t capacity() const noexcept { return v_->capacity(); }
+
+        T const* data() const noexcept        { return v_->data(); }
+        const_iterator begin() const noexcept { return data(); }
+        const_iterator end() const noexcept   { return data() + size(); }
+
+        T const& operator[](size_t i) const noexcept { return (*v_)[i]; }
+        T const& front() const noexcept { return v_->front(); }
+        T const& back() const noexcept  { return v_->back(); }
+
+        std::span<const T> span() const noexcept { return {data(), size()}; }
+
+        std::vector<T>& edit() { return v_.edit(); }
+
+        void reserve(size_t n) { edit().reserve(n); }
+        void clear() noexcept  { v_.reset(); }
+
+        void push_back(T const& value) { edit().push_back(value); }
+
+        template<typename... Args>
+        T& emplace_back(Args&&... args) { return edit().emplace_back(std::forward<Args>(args)...); }
+
+        template<typename It>
+        const_iterator insert(const_iterator pos, It first, It last)
+        {
+            auto at = pos - begin();
+            auto& v = edit();
+            v.insert(v.begin() + at, first, last);
+            return data() + at;
+        }
+
+        const_iterator insert(const_iterator pos, T const& value)
+        {
+            T copy = value;
+            return insert(pos, &copy, &copy + 1);
+        }
+
+        const_iterator erase(const_iterator first, const_iterator last)
+        {
+            auto from = first - begin();
+            auto to   = last - begin();
+            auto& v = edit();
+            v.erase(v.begin() + from, v.begin() + to);
+            return data() + from;
+        }
+
+        const_iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+        bool operator==(shared_list const& rhs) const { return *v_ == *rhs.v_; }
+        bool shares_with(shared_list const& rhs) const noexcept { return v_.shares_with(rhs.v_); }
+
+    private:
+        shared_value<std::vector<T>> v_;
+    };
+
+    // Makes a view of each ID or node of an underlying range as it is
+    // dereferenced. Defined after the views.
+    template<typename View, typename BaseIt>
+    class view_range;
+
+    namespace detail
+    {
+        // Iterator over the IDs a view's member list holds. Rows are kept
+        // in a row_sequence, specialised once that is defined.
+        template<typename Id>
+        struct id_iterator { using type = typename std::span<const Id>::iterator; };
+    }
+
+    namespace detail { class source_rebinder; }
+
     class document
     {
         friend struct materialiser;
         friend class serializer;
         friend class editor;   
+        friend struct document_image;
+        friend class detail::source_rebinder;
 
     //------------------------------------------------------------------------
     // Node base class
@@ -81,13 +400,28 @@ namespace nuno
         document() = default;
         ~document() = default;  // unique_ptr handles cleanup
         
-        // Non-copyable (parse_context is large)
+        // Non-copyable (parse_context is large), use fork()
         document(const document&) = delete;
         document& operator=(const document&) = delete;
         
         // Movable
         document(document&&) = default;
         document& operator=(document&&) = default;
+
+        // A new version of this document that shares its node storage
+        // and parser data. An edit to either copies the storage chunk
+        // holding each node it touches (CHUNK nodes, without their
+        // member lists) and each member list it changes, whole. Editing
+        // a key or row of a large category or table thus costs one
+        // chunk; inserting, erasing or moving one also copies that
+        // owner's lists. The undo journal is not carried over.
+        document fork() const;
+
+        // Bumped by every editor operation, and by undo and redo when
+        // they apply a step.
+        // Anything derived from the document (resolved queries, value
+        // pointers) is stale once the generation has moved on.
+        uint64_t generation() const noexcept { return generation_; }
         
     //------------------------------------------------------------------------
     // Category access
@@ -137,6 +471,44 @@ namespace nuno
 
         category_id create_root();
 
+    //------------------------------------------------------------------------
+    // Value lookup
+    //------------------------------------------------------------------------
+
+        // A key value or table cell holding a looked-up value. When the
+        // value is an array, element is the position of the match.
+        struct value_occurrence
+        {
+            key_id                key;      // valid for a key value
+            row_id                row;      // valid, with column, for a cell
+            column_id             column;
+            std::optional<size_t> element;
+
+            bool is_key() const noexcept  { return key.valid(); }
+            bool is_cell() const noexcept { return row.valid(); }
+            bool operator==(value_occurrence const&) const = default;
+        };
+
+        // Every key value, table cell and array element that holds the
+        // value, keys first and each in ID order. The held type must
+        // match: an integer finds neither reals nor strings spelling
+        // it. Booleans are not looked up.
+        std::vector<value_occurrence> find_value(std::string_view value) const;
+        std::vector<value_occurrence> find_value(double value) const;
+
+        template<detail::strictly_integral T>
+        std::vector<value_occurrence> find_value(T value) const { return find_value_(static_cast<int64_t>(value)); }
+
+        // Without the index, find_value() scans the document. With it,
+        // the first lookup builds an inverted index from values to
+        // occurrences, and the editor keeps it current: later lookups
+        // cost the size of the answer plus the keys and rows edited
+        // since the previous lookup. The index holds each distinct
+        // string once. It is not carried over by fork().
+        void enable_value_index();
+        void disable_value_index() noexcept;
+        bool value_index_enabled() const noexcept { return value_index_ != nullptr; }
+
     //------------------------------------------------------------------------
     // Contamination management
     //------------------------------------------------------------------------
@@ -163,6 +535,12 @@ namespace nuno
             return !contaminated_source_keys_.empty() || !contaminated_source_rows_.empty();
         }
 
+        // The keys and rows currently registered as contamination
+        // sources, in ID order. Cheap to walk without scanning the
+        // document.
+        id_bitset<key_id> const& contaminated_keys() const noexcept { return contaminated_source_keys_; }
+        id_bitset<row_id> const& contaminated_rows() const noexcept { return contaminated_source_rows_; }
+
     //------------------------------------------------------------------------
     // ID creation (monotonic guarantee)
     //------------------------------------------------------------------------
@@ -213,6 +591,8 @@ namespace nuno
         // Used to track the authored order of document entities 
         //----------------------------------------------------------
         struct source_item_ref;
+        class  ordered_item_list;
+        class  row_sequence;
 
         // Translate tag (ID) to client view type
         //----------------------------------------------------------
@@ -229,6 +609,24 @@ namespace nuno
         template<typename Tag>
         using view_for_t = typename view_for<Tag>::type;
 
+    //------------------------------------------------------------------------
+    // Lazy view ranges
+    //------------------------------------------------------------------------
+    // Views are made while a range is iterated, so walking one allocates
+    // nothing. Like views, ranges are invalidated by edits.
+
+        template<typename View, typename Node>
+        using node_range = view_range<View, typename node_store<Node>::const_iterator>;
+
+        template<typename Id>
+        using id_range = view_range<view_for_t<typename Id::tag_type>, typename detail::id_iterator<Id>::type>;
+
+        node_range<category_view, category_node> categories_range() const noexcept;
+        node_range<table_view, table_node>       tables_range() const noexcept;
+        node_range<column_view, column_node>     columns_range() const noexcept;
+        node_range<table_row_view, row_node>     rows_range() const noexcept;
+        node_range<key_view, key_node>           keys_range() const noexcept;
+
     private:
 
         // Used by materialiser and editor
@@ -270,10 +668,15 @@ namespace nuno
         {
             using NodeT = typename document::node_for<T>::type;
 
-            auto find_id = [id_](std::vector<NodeT> & nodes) -> NodeT *
+            auto find_id = [this, id_](node_store<NodeT> & nodes) -> NodeT *
             {
-                if (auto it = std::ranges::find_if(nodes, [id_](auto& item){return item._id() == id_;}); it != nodes.end())
+                if (auto it = find_node_by_id(nodes, id_); it != nodes.end())
+                {
+                    // Mutable access is where edits start
+                    if (journal_) journal_touch(*it);
+                    if (value_index_) value_index_touch(id_);
                     return &*it;
+                }
                 return nullptr;
             };
 
@@ -286,22 +689,46 @@ namespace nuno
             else if constexpr (std::is_same_v<T, paragraph_tag>)    { return find_id(paragraphs_); }
             else static_assert(false, "Illegal ID");
         };        
+
+        // Read-only counterpart of get_node(). Looking is not an edit,
+        // so neither the journal nor the value index is told.
+        template<typename T>
+        constexpr const typename document::node_for<T>::type* peek_node( ::nuno::id<T> id_ ) const noexcept
+        {
+            using NodeT = typename document::node_for<T>::type;
+
+            auto find_id = [this, id_](node_store<NodeT> const & nodes) -> const NodeT *
+            {
+                auto it = find_node_by_id(nodes, id_);
+                return it != nodes.end() ? &*it : nullptr;
+            };
+
+            if constexpr      (std::is_same_v<T, category_tag>)     { return find_id(categories_); }
+            else if constexpr (std::is_same_v<T, key_tag>)          { return find_id(keys_); }
+            else if constexpr (std::is_same_v<T, table_tag>)        { return find_id(tables_); }
+            else if constexpr (std::is_same_v<T, row_tag>)    { return find_id(rows_); }
+            else if constexpr (std::is_same_v<T, column_tag>) { return find_id(columns_); }
+            else if constexpr (std::is_same_v<T, comment_tag>)      { return find_id(comments_); }
+            else if constexpr (std::is_same_v<T, paragraph_tag>)    { return find_id(paragraphs_); }
+            else static_assert(false, "Illegal ID");
+        }
         
         // The source CST document from the parser
         //----------------------------------------------------------
-        std::unique_ptr<parse_context> source_context_;
+        // Shared, never edited, between forks of a document.
+        std::shared_ptr<const parse_context> source_context_;
 
         
         // The storage structures for the document data populated
         // by the materialiser or editor
         //----------------------------------------------------------
-        std::vector<category_node>   categories_;
-        std::vector<table_node>      tables_;
-        std::vector<column_node>     columns_;
-        std::vector<row_node>        rows_;
-        std::vector<key_node>        keys_;
-        std::vector<comment_node>    comments_;
-        std::vector<paragraph_node>  paragraphs_;
+        node_store<category_node>   categories_;
+        node_store<table_node>      tables_;
+        node_store<column_node>     columns_;
+        node_store<row_node>        rows_;
+        node_store<key_node>        keys_;
+        node_store<comment_node>    comments_;
+        node_store<paragraph_node>  paragraphs_;
 
         // These collect contamination sources. Only data positions 
         // (keys and rows) are sources of contamination. Categories
@@ -313,8 +740,8 @@ namespace nuno
         //
         // A document is clean if these containers are empty
         // contaminated if there is at lease one record in either. 
-        std::unordered_set<size_t>  contaminated_source_keys_;
-        std::unordered_set<size_t>  contaminated_source_rows_;
+        id_bitset<key_id>  contaminated_source_keys_;
+        id_bitset<row_id>  contaminated_source_rows_;
 
         // These imperatively set the clean state. Prefer
         // the request_clear_contamination method to allow 
@@ -322,31 +749,116 @@ namespace nuno
         void clear_key_contamination(key_id id);
         void clear_row_contamination(row_id id);        
 
+        // Unregisters a key or row that is about to be erased,
+        // whether or not it is clean.
+        void drop_contamination_source(clearable_node node);
+
+        // Source counting
+        //
+        // Every table and category counts the contamination sources
+        // beneath it. Registering or unregistering a source adjusts
+        // the counts along its owner chain and re-derives the flags
+        // there, so marking and clearing are O(depth) regardless of
+        // how much data the containers hold.
+        void count_source(table_id owner, bool added);
+        void count_source(category_id owner, bool added);
+        void refresh_contamination(table_node& t);
+        void refresh_contamination(category_node& c);
+
+        // Deferred contamination (see editor::batch)
+        //
+        // While deferred, source counts are still maintained but the
+        // containers whose counts changed are recorded instead of
+        // having their flags re-derived. resume_contamination()
+        // refreshes each recorded container once. As flags follow
+        // from the counts alone, the result matches applying the
+        // edits one by one.
+        size_t deferred_contamination_depth_ {0};
+        std::unordered_set<size_t> pending_tables_;
+        std::unordered_set<size_t> pending_categories_;
+
+        bool contamination_deferred() const noexcept { return deferred_contamination_depth_ > 0; }
+        void defer_contamination() noexcept { ++deferred_contamination_depth_; }
+        void resume_contamination();
+
+        // Undo/redo journal (see editor::enable_journal)
+        //
+        // Only active while the editor has a journal entry open. Node
+        // edits are captured by get_node(), which images a node the
+        // first time an entry reaches it; lookups that only read go
+        // through peek_node() and record nothing. Structural collections and
+        // node storage are edited through the helpers below so their
+        // changes are recorded as positions rather than copies.
+        class edit_journal;
+        std::unique_ptr<edit_journal> journal_;
+
+        template<typename N> void journal_touch(N& node);
+
+        // Edit generation (see generation())
+        //
+        // Bumped by the editor for every operation that may change the
+        // document, and by undo and redo when they apply a step. Forks
+        // start from the generation of their source.
+        uint64_t generation_ {0};
+
+        // Inverted value index (see enable_value_index)
+        //
+        // Every path that changes a key or row in place reaches it
+        // through get_node(), erase_node() or the journal, and those
+        // mark it for the index to re-read. Nodes created since the
+        // index last caught up are found from the ID counters.
+        class value_index;
+        std::unique_ptr<value_index> value_index_;
+
+        template<typename Tag> void value_index_touch(id<Tag> id);
+
+        using value_probe = std::variant<std::string_view, int64_t, double>;
+        std::vector<value_occurrence> find_value_(value_probe probe) const;
+
+        template<typename N>
+        node_store<N>& storage_for() noexcept;
+
+        template<typename Tag>
+        bool erase_node(id<Tag> id);
+
+        template<typename Id, typename N> void ids_insert(N& owner, size_t index, std::span<const Id> items);
+        template<typename Id, typename N> void ids_insert(N& owner, size_t index, Id item);
+        template<typename Id, typename N> void ids_push_back(N& owner, Id item);
+        template<typename Id, typename N> bool ids_erase(N& owner, Id item);
+        template<typename Id, typename N> void ids_move(N& owner, size_t from, size_t count, size_t to);
+
+        template<typename N> bool items_push_back(N& owner, source_item_ref item);
+        template<typename N> bool items_insert_before(N& owner, source_item_ref const& anchor, source_item_ref item);
+        template<typename N> bool items_insert_after(N& owner, source_item_ref const& anchor, source_item_ref item);
+        template<typename N> bool items_erase(N& owner, source_item_ref const& item);
+        template<typename N> bool items_move_before(N& owner, source_item_ref const& item, source_item_ref const& anchor);
+        template<typename N> bool items_move_after(N& owner, source_item_ref const& item, source_item_ref const& anchor);
+
+        template<typename N, typename Op>
+        bool items_edit(N& owner, source_item_ref const& item, Op&& op);
+
         bool row_is_valid(document::row_node const& r);
         bool table_is_valid(document::table_node const& t);
 
         template<typename T>
-        typename std::vector<T>::iterator 
-        find_node_by_id(std::vector<T> & cont, typename T::id_type id) noexcept;
+        typename node_store<T>::iterator 
+        find_node_by_id(node_store<T> & cont, typename T::id_type id) noexcept;
 
         template<typename T>
-        typename std::vector<T>::const_iterator 
-        find_node_by_id(std::vector<T> const & cont, typename T::id_type id) const noexcept;
+        typename node_store<T>::const_iterator 
+        find_node_by_id(node_store<T> const & cont, typename T::id_type id) const noexcept;
 
         template<typename T>
-        typename std::vector<T>::const_iterator 
-        find_node_by_name(std::vector<T> const & cont, std::string_view name) const noexcept;
+        typename node_store<T>::const_iterator 
+        find_node_by_name(node_store<T> const & cont, std::string_view name) const noexcept;
 
         template<typename T>
         std::optional<typename node_to_view<T>::view_type>
-            to_view(std::vector<T> const & cont, typename std::vector<T>::const_iterator it) const noexcept; 
+            to_view(node_store<T> const & cont, typename node_store<T>::const_iterator it) const noexcept; 
 
         bool key_is_clean(const key_node& k) const;
         bool row_is_clean(const row_node& r) const;
-        bool table_is_clean(const table_node& t) const;
-        bool category_is_clean(const category_node& c) const;
-        void propagate_contamination_up_category_chain(category_id id);
-        void try_clear_category_contamination(category_id id);
+
     };
 
 
@@ -379,6 +891,296 @@ namespace nuno
             }
         };
 
+        // Authored order of the items owned by a category or table.
+        //
+        // Items are kept in a doubly linked list threaded through a slot
+        // pool, so positional insert, erase and move are O(1) once the
+        // anchor is located. Locating an item goes through a hash index
+        // that is built the first time the list outgrows a linear scan.
+        // Iteration walks the links and stays linear in document order.
+        //
+        // Items are unique within a list. Inserting an item that is
+        // already present, or relative to an anchor that is not, fails.
+        class document::ordered_item_list
+        {
+            // The list proper; ordered_item_list shares it between copies
+            // and copies it on the first edit through a shared copy.
+            class body
+            {
+                struct slot
+                {
+                    source_item_ref item;
+                    size_t          prev;
+                    size_t          next;   // doubles as the free list link
+                };
+
+            public:
+                class const_iterator
+                {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type        = source_item_ref;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = const source_item_ref*;
+                    using reference         = const source_item_ref&;
+
+                    const_iterator() = default;
+
+                    reference operator*() const noexcept { return list_->slots_[pos_].item; }
+                    pointer operator->() const noexcept { return &list_->slots_[pos_].item; }
+
+                    const_iterator& operator++() noexcept { pos_ = list_->slots_[pos_].next; return *this; }
+                    const_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+                    bool operator==(const_iterator const& rhs) const noexcept { return pos_ == rhs.pos_; }
+
+                private:
+                    friend class body;
+                    const_iterator(const body* list, size_t pos) : list_(list), pos_(pos) {}
+
+                    const body* list_ {nullptr};
+                    size_t                   pos_  {npos()};
+                };
+
+                using iterator   = const_iterator;
+                using value_type = source_item_ref;
+
+                size_t size() const noexcept { return size_; }
+                bool empty() const noexcept { return size_ == 0; }
+
+                const_iterator begin() const noexcept { return {this, head_}; }
+                const_iterator end() const noexcept { return {this, npos()}; }
+
+                source_item_ref const& front() const noexcept { assert(head_ != npos()); return slots_[head_].item; }
+                source_item_ref const& back() const noexcept { assert(tail_ != npos()); return slots_[tail_].item; }
+
+                const_iterator find(source_item_ref const& item) const noexcept { return {this, locate(item)}; }
+                bool contains(source_item_ref const& item) const noexcept { return locate(item) != npos(); }
+
+                void reserve(size_t n) { slots_.reserve(n); if (indexed_) index_.reserve(n); }
+                void clear() noexcept;
+
+                bool push_back(source_item_ref item);
+                bool push_front(source_item_ref item);
+                bool insert_before(source_item_ref const& anchor, source_item_ref item);
+                bool insert_after(source_item_ref const& anchor, source_item_ref item);
+                bool erase(source_item_ref const& item);
+
+                // Reorders an item already in the list. Moving an item
+                // relative to itself is a successful no-op.
+                bool move_before(source_item_ref const& item, source_item_ref const& anchor);
+                bool move_after(source_item_ref const& item, source_item_ref const& anchor);
+
+            private:
+                // Short lists (the common case for categories) are cheaper
+                // to scan than to hash.
+                static constexpr size_t INDEX_THRESHOLD = 16;
+
+                std::vector<slot>                    slots_;
+                std::unordered_map<uint64_t, size_t> index_;
+                size_t head_    {npos()};
+                size_t tail_    {npos()};
+                size_t free_    {npos()};
+                size_t size_    {0};
+                bool   indexed_ {false};
+
+                static uint64_t key_of(source_item_ref const& item) noexcept;
+
+                size_t locate(source_item_ref const& item) const noexcept;
+                size_t allocate(source_item_ref item);
+                void   release(size_t s) noexcept;
+                void   link_before(size_t s, size_t next) noexcept;  // next == npos appends
+                void   unlink(size_t s) noexcept;
+                bool   insert_new(source_item_ref item, size_t next);
+            };
+
+        public:
+            using const_iterator = body::const_iterator;
+            using iterator       = const_iterator;
+            using value_type     = source_item_ref;
+
+            size_t size() const noexcept { return b_->size(); }
+            bool empty() const noexcept { return b_->empty(); }
+
+            const_iterator begin() const noexcept { return b_->begin(); }
+            const_iterator end() const noexcept { return b_->end(); }
+
+            source_item_ref const& front() const noexcept { return b_->front(); }
+            source_item_ref const& back() const noexcept { return b_->back(); }
+
+            const_iterator find(source_item_ref const& item) const noexcept { return b_->find(item); }
+            bool contains(source_item_ref const& item) const noexcept { return b_->contains(item); }
+
+            void reserve(size_t n) { b_.edit().reserve(n); }
+            void clear() noexcept { b_.reset(); }
+
+            bool push_back(source_item_ref item) { return b_.edit().push_back(std::move(item)); }
+            bool push_front(source_item_ref item) { return b_.edit().push_front(std::move(item)); }
+            bool insert_before(source_item_ref const& anchor, source_item_ref item) { return b_.edit().insert_before(anchor, std::move(item)); }
+            bool insert_after(source_item_ref const& anchor, source_item_ref item) { return b_.edit().insert_after(anchor, std::move(item)); }
+            bool erase(source_item_ref const& item) { return contains(item) && b_.edit().erase(item); }
+
+            // Reorders an item already in the list. Moving an item
+            // relative to itself is a successful no-op.
+            bool move_before(source_item_ref const& item, source_item_ref const& anchor) { return b_.edit().move_before(item, anchor); }
+            bool move_after(source_item_ref const& item, source_item_ref const& anchor) { return b_.edit().move_after(item, anchor); }
+
+        private:
+            shared_value<body> b_;
+        };
+
+        // Semantic order of the rows of a table.
+        //
+        // An implicit treap threaded through a slot pool: each slot holds
+        // a row ID and the size of its subtree, so the row at a position,
+        // the position of a row, and inserting, erasing or moving a block
+        // of rows are all O(log n). Rows are located through a hash index
+        // once the sequence outgrows a linear scan, as ordered_item_list
+        // does. Iteration follows the links and stays linear.
+        class document::row_sequence
+        {
+            // Shared between copies as ordered_item_list's body is
+            class body
+            {
+                using link = uint32_t;
+                static constexpr link nil = static_cast<link>(-1);
+
+                struct slot
+                {
+                    row_id id;
+                    link   parent;
+                    link   left;    // doubles as the free list link
+                    link   right;
+                    link   size;    // of the subtree; 0 marks a free slot
+                };
+
+            public:
+                class const_iterator
+                {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type        = row_id;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = const row_id*;
+                    using reference         = const row_id&;
+
+                    const_iterator() = default;
+
+                    reference operator*() const noexcept { return seq_->slots_[pos_].id; }
+                    pointer operator->() const noexcept { return &seq_->slots_[pos_].id; }
+
+                    const_iterator& operator++() noexcept { pos_ = seq_->successor(pos_); return *this; }
+                    const_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+                    bool operator==(const_iterator const& rhs) const noexcept { return pos_ == rhs.pos_; }
+
+                private:
+                    friend class body;
+                    const_iterator(const body* seq, link pos) : seq_(seq), pos_(pos) {}
+
+                    const body* seq_ {nullptr};
+                    link                pos_ {nil};
+                };
+
+                using iterator   = const_iterator;
+                using value_type = row_id;
+
+                size_t size() const noexcept { return size_of(root_); }
+                bool empty() const noexcept { return root_ == nil; }
+
+                const_iterator begin() const noexcept { return {this, root_ == nil ? nil : leftmost(root_)}; }
+                const_iterator end() const noexcept { return {this, nil}; }
+
+                row_id front() const noexcept { assert(root_ != nil); return slots_[leftmost(root_)].id; }
+                row_id back() const noexcept { assert(root_ != nil); return slots_[rightmost(root_)].id; }
+
+                row_id operator[](size_t i) const noexcept;
+
+                // Position of the row, or npos() if it is not in the sequence
+                size_t position(row_id id) const noexcept;
+                bool contains(row_id id) const noexcept { return locate(id) != nil; }
+
+                size_t capacity() const noexcept { return slots_.capacity(); }
+                void reserve(size_t n) { slots_.reserve(n); if (indexed_) index_.reserve(n); }
+                void clear() noexcept;
+
+                void push_back(row_id id) { insert(size(), std::span<const row_id>(&id, 1)); }
+                void insert(size_t index, std::span<const row_id> ids);
+                void erase(size_t index, size_t count = 1);
+
+                // Moves the block [from, from + count) so it starts at `to` in
+                // the sequence as it reads after the block is taken out.
+                void move(size_t from, size_t count, size_t to);
+
+                size_t heap_bytes() const noexcept;
+
+            private:
+                static constexpr size_t INDEX_THRESHOLD = 16;
+
+                std::vector<slot>                  slots_;
+                std::unordered_map<uint64_t, link> index_;
+                link   root_    {nil};
+                link   free_    {nil};
+                link   live_    {0};
+                bool   indexed_ {false};
+
+                link size_of(link s) const noexcept { return s == nil ? 0 : slots_[s].size; }
+                static uint64_t priority(link s) noexcept;
+
+                link leftmost(link s) const noexcept;
+                link rightmost(link s) const noexcept;
+                link successor(link s) const noexcept;
+                link locate(row_id id) const noexcept;
+                link allocate(row_id id);
+                void release_tree(link s) noexcept;
+                void adopt(link s) noexcept;    // recounts s and parents its children
+                void orphan(link s) noexcept { if (s != nil) slots_[s].parent = nil; }
+
+                std::pair<link, link> split(link t, size_t k) noexcept;  // first k rows, the rest
+                link merge(link a, link b) noexcept;
+            };
+
+        public:
+            using const_iterator = body::const_iterator;
+            using iterator       = const_iterator;
+            using value_type     = row_id;
+
+            size_t size() const noexcept { return b_->size(); }
+            bool empty() const noexcept { return b_->empty(); }
+
+            const_iterator begin() const noexcept { return b_->begin(); }
+            const_iterator end() const noexcept { return b_->end(); }
+
+            row_id front() const noexcept { return b_->front(); }
+            row_id back() const noexcept { return b_->back(); }
+
+            row_id operator[](size_t i) const noexcept { return (*b_)[i]; }
+
+            // Position of the row, or npos() if it is not in the sequence
+            size_t position(row_id id) const noexcept { return b_->position(id); }
+            bool contains(row_id id) const noexcept { return b_->contains(id); }
+
+            size_t capacity() const noexcept { return b_->capacity(); }
+            void reserve(size_t n) { b_.edit().reserve(n); }
+            void clear() noexcept { b_.reset(); }
+
+            void push_back(row_id id) { insert(size(), std::span<const row_id>(&id, 1)); }
+            void insert(size_t index, std::span<const row_id> ids) { if (!ids.empty()) b_.edit().insert(index, ids); }
+            void erase(size_t index, size_t count = 1) { if (count != 0) b_.edit().erase(index, count); }
+
+            // Moves the block [from, from + count) so it starts at `to` in
+            // the sequence as it reads after the block is taken out.
+            void move(size_t from, size_t count, size_t to) { if (count != 0 && from != to) b_.edit().move(from, count, to); }
+
+            size_t heap_bytes() const noexcept { return b_->heap_bytes(); }
+
+        private:
+            shared_value<body> b_;
+        };
+
+        template<>
+        struct detail::id_iterator<row_id> { using type = document::row_sequence::const_iterator; };
+
         struct document::category_node : document::node<false, true>
         {
             typedef category_id id_type;
@@ -388,10 +1190,13 @@ namespace nuno
             category_id                  id;
             std::string                  name;
             category_id                  parent;
-            std::vector<category_id>     children;
-            std::vector<table_id>        tables;
-            std::vector<key_id>          keys;
-            std::vector<source_item_ref> ordered_items;
+            shared_list<category_id>     children;
+            shared_list<table_id>        tables;
+            shared_list<key_id>          keys;
+            ordered_item_list            ordered_items;
+
+            // Contamination sources (keys and rows) anywhere beneath
+            size_t                       contaminated_sources {0};
 
             // Authorship metadata, instead of source_event_index:
             std::optional<size_t>        source_event_index_open;   // Category open event
@@ -406,9 +1211,10 @@ namespace nuno
             
             table_id                     id;
             category_id                  owner;
-            std::vector<column_id>       columns;
-            std::vector<row_id>    rows;          // semantic collection (all rows)
-            std::vector<source_item_ref> ordered_items; // authored order (rows + comments + paragraphs + subcategories)
+            shared_list<column_id>       columns;
+            row_sequence           rows;          // semantic collection (all rows)
+            ordered_item_list      ordered_items; // authored order (rows + comments + paragraphs + subcategories)
+            size_t                 contaminated_sources {0}; // rows registered as sources
         };
 
         struct document::column_node : document::node<true, false>
@@ -474,12 +1280,216 @@ namespace nuno
             category_id  owner {invalid_id<category_tag>()} ;
         };    
 
-//========================================================================
-// Views
-//========================================================================
+        // Journal of editor mutations for undo and redo.
+        //
+        // Each entry holds the records of one editor operation (or one
+        // batch). A record stores the state on the other side of the
+        // change, and applying it swaps that state with the document,
+        // so the same record serves undo and, once applied, redo.
+        // Records are deltas: a before-image of a leaf node, only the
+        // scalar header of a category or table, the moved positions of
+        // collection items, or the whole node when it appears or goes.
+        // The cost of an undo or redo follows the size of the edit,
+        // not of the document.
+        //
+        // Nodes created inside an entry are not imaged while it is
+        // open; a single presence record per node is added on close.
+        class document::edit_journal
+        {
+        public:
+            // Where an item sits in an ordered_item_list
+            struct position
+            {
+                bool                           present {false};
+                std::optional<source_item_ref> next;    // nullopt at the end
+            };
 
-    struct document::category_view
-    {
+            explicit edit_journal(size_t max_bytes) noexcept : max_bytes_(max_bytes) {}
+
+            bool recording() const noexcept { return depth_ > 0 && !replaying_; }
+
+            void open(document const& doc);
+            void close(document& doc);
+            void discard(document& doc);   // closes and reverts the entry
+
+            bool undo(document& doc);
+            bool redo(document& doc);
+
+            size_t undo_steps() const noexcept { return undo_.size(); }
+            size_t redo_steps() const noexcept { return redo_.size(); }
+            size_t bytes() const noexcept { return bytes_; }
+            size_t max_bytes() const noexcept { return max_bytes_; }
+
+            template<typename N> void touch(document& doc, N& node);
+            template<typename N> void erased(document& doc, N&& node);
+
+            // Positions are before and after the edit; nullopt or not
+            // present means outside the list.
+            template<typename N, typename Id>
+            void ids_changed(N const& owner, std::vector<Id> items, std::optional<size_t> before, std::optional<size_t> after);
+
+            template<typename N>
+            void items_changed(N const& owner, source_item_ref item, position before, position after);
+
+            template<typename Id>
+            bool created_in_entry(Id id) const noexcept;
+
+        private:
+            template<typename N>
+            struct node_record
+            {
+                typename N::id_type id;
+                std::optional<N>    image {};           // nullopt: absent on the other side
+                bool                source      {false}; // contamination source on the other side
+                bool                header_only {false}; // category/table without collections
+            };
+
+            template<typename N, typename Id>
+            struct ids_record
+            {
+                typename N::id_type   owner;
+                std::vector<Id>       items;            // contiguous block
+                std::optional<size_t> from;             // nullopt: not in the list
+                std::optional<size_t> to;
+            };
+
+            template<typename N>
+            struct items_record
+            {
+                typename N::id_type owner;
+                source_item_ref     item;
+                position            from;
+                position            to;
+            };
+
+            using record = std::variant<
+                node_record<category_node>,
+                node_record<table_node>,
+                node_record<column_node>,
+                node_record<row_node>,
+                node_record<key_node>,
+                node_record<comment_node>,
+                node_record<paragraph_node>,
+                ids_record<category_node, category_id>,
+                ids_record<category_node, table_id>,
+                ids_record<category_node, key_id>,
+                ids_record<table_node, column_id>,
+                ids_record<table_node, row_id>,
+                items_record<category_node>,
+                items_record<table_node>
+            >;
+
+            struct entry
+            {
+                std::vector<record> records;
+                size_t              bytes {0};
+            };
+
+            size_t              max_bytes_;
+            size_t              bytes_     {0};
+            size_t              depth_     {0};
+            bool                replaying_ {false};
+            entry               open_;
+            std::deque<entry>   undo_;
+            std::deque<entry>   redo_;
+
+            // Per entry: first ID of each kind created inside it, and
+            // the nodes already imaged.
+            std::array<size_t, 7>      first_new_ {};
+            std::unordered_set<size_t> touched_;
+
+            template<typename N> static constexpr size_t kind_of() noexcept;
+            template<typename N> static size_t bytes_of(N const& node) noexcept;
+            static size_t bytes_of(record const& r) noexcept;
+
+            void push(record r);
+            bool seal(document& doc);
+            void apply(document& doc, entry& e, bool reverse);
+
+            template<typename N> void apply(document& doc, node_record<N>& r);
+            template<typename N, typename Id> void apply(document& doc, ids_record<N, Id>& r);
+            template<typename N> void apply(document& doc, items_record<N>& r);
+
+            template<typename N> void add_created(document& doc);
+            template<typename N> static void swap_collections(N& a, N& b) noexcept;
+        };
+
+        // Inverted index from scalar values to the keys and cells that
+        // hold them.
+        //
+        // Built on the first lookup, then brought up to date by each
+        // later lookup, which re-reads only the keys and rows marked
+        // since and those created above the previous ID counters.
+        //
+        // Postings are not removed when their node changes. Each node
+        // has a version, bumped when it is re-read, and the postings of
+        // older versions are dropped by the lookups that come across
+        // them. Once stale postings outnumber live ones the index is
+        // rebuilt. Lookups lock, so concurrent readers may share it.
+        class document::value_index
+        {
+        public:
+            // A scalar within a key (cell is no_cell) or a row
+            struct posting
+            {
+                size_t   node;
+                uint32_t cell;
+                uint32_t element;   // no_element unless inside an array
+                uint32_t version;
+            };
+
+            static constexpr uint32_t no_cell    = ~uint32_t{0};
+            static constexpr uint32_t no_element = ~uint32_t{0};
+
+            void touch(key_id id) { dirty_keys_.insert(id); }
+            void touch(row_id id) { dirty_rows_.insert(id); }
+
+            std::vector<posting> find(document const& doc, value_probe const& probe);
+
+            // Calls fn(probe, posting) for each scalar held by a node
+            template<typename N, typename Fn>
+            static void for_each_scalar(N const& node, Fn&& fn);
+
+        private:
+            struct node_state
+            {
+                uint32_t version  {0};
+                uint32_t postings {0};
+            };
+
+            std::mutex              mutex_;
+            bool                    built_ {false};
+            key_id                  key_watermark_ {0};
+            row_id                  row_watermark_ {0};
+            id_bitset<key_id>       dirty_keys_;
+            id_bitset<row_id>       dirty_rows_;
+            std::vector<node_state> key_states_;   // by ID
+            std::vector<node_state> row_states_;
+            size_t                  live_  {0};
+            size_t                  stale_ {0};
+
+            std::deque<std::string>                                    strings_;  // interned
+            std::unordered_map<std::string_view, std::vector<posting>> by_string_;
+            std::unordered_map<int64_t, std::vector<posting>>          by_integer_;
+            std::unordered_map<uint64_t, std::vector<posting>>         by_real_;  // bit patterns
+
+            static uint64_t real_key(double v) noexcept { return std::bit_cast<uint64_t>(v == 0.0 ? 0.0 : v); }
+
+            void build(document const& doc);
+            void refresh(document const& doc);
+            template<typename N> void index(N const* node, size_t id, node_state& state);
+            template<typename N> void reindex(document const& doc, size_t id, std::vector<node_state>& states);
+
+            node_state& state_of(posting const& p) { return p.cell == no_cell ? key_states_[p.node] : row_states_[p.node]; }
+            std::vector<posting>* postings_for(value_probe const& probe, bool create);
+        };
+
+//========================================================================
+// Views
+//========================================================================
+
+    struct document::category_view
+    {
         const document* doc;
         const category_node* node;
 
@@ -491,6 +1501,10 @@ namespace nuno
         std::span<const table_id> tables() const noexcept { return node->tables; }
         std::span<const key_id> keys() const noexcept { return node->keys;}
 
+        id_range<category_id> children_range() const noexcept;
+        id_range<table_id> tables_range() const noexcept;
+        id_range<key_id> keys_range() const noexcept;
+
         std::optional<category_view> parent() const noexcept;
         std::optional<category_view> child(std::string_view name) const noexcept;
         std::optional<key_view> key(std::string_view name) const noexcept;
@@ -512,7 +1526,10 @@ namespace nuno
         category_view owner() const noexcept;
 
         std::span<const column_id> columns() const noexcept { return node->columns; }
-        std::span<const row_id> rows() const noexcept { return node->rows; }
+        row_sequence const& rows() const noexcept { return node->rows; }
+
+        id_range<column_id> columns_range() const noexcept;
+        id_range<row_id> rows_range() const noexcept;
 
         size_t column_count() const noexcept { return node->columns.size(); }
         size_t row_count() const noexcept { return node->rows.size(); }
@@ -583,367 +1600,1705 @@ namespace nuno
 
 
 //========================================================================
-// document member implementations
+// View ranges
 //========================================================================
 
-    inline category_id document::create_root()
+    namespace detail
     {
-        if (categories_.empty())
+        template<typename View, typename Node>
+        View make_view(document const* doc, Node const& n) noexcept { return View{doc, &n}; }
+
+        template<typename View> View make_view(document const* doc, category_id id) noexcept { return *doc->category(id); }
+        template<typename View> View make_view(document const* doc, table_id id) noexcept    { return *doc->table(id); }
+        template<typename View> View make_view(document const* doc, column_id id) noexcept   { return *doc->column(id); }
+        template<typename View> View make_view(document const* doc, row_id id) noexcept      { return *doc->row(id); }
+        template<typename View> View make_view(document const* doc, key_id id) noexcept      { return *doc->key(id); }
+    }
+
+    template<typename View, typename BaseIt>
+    class view_range : public std::ranges::view_interface<view_range<View, BaseIt>>
+    {
+    public:
+        class iterator
         {
-            category_node root;
-            root.id     = category_id{0};
-            root.name   = detail::ROOT_CATEGORY_NAME.data();
-            root.parent = invalid_id<category_tag>();
+        public:
+            using iterator_concept  = std::forward_iterator_tag;
+            using iterator_category = std::input_iterator_tag;  // yields views by value
+            using value_type        = View;
+            using difference_type   = std::ptrdiff_t;
+
+            iterator() = default;
+            iterator(document const* doc, BaseIt it) noexcept : doc_(doc), it_(it) {}
+
+            View operator*() const noexcept { return detail::make_view<View>(doc_, *it_); }
+
+            iterator& operator++() noexcept { ++it_; return *this; }
+            iterator operator++(int) noexcept { auto tmp = *this; ++it_; return tmp; }
+
+            bool operator==(iterator const& rhs) const noexcept { return it_ == rhs.it_; }
+
+        private:
+            document const* doc_ {nullptr};
+            BaseIt          it_ {};
+        };
+
+        view_range() = default;
+        view_range(document const* doc, BaseIt first, BaseIt last) noexcept
+            : doc_(doc), first_(first), last_(last)
+        {}
+
+        iterator begin() const noexcept { return {doc_, first_}; }
+        iterator end() const noexcept   { return {doc_, last_}; }
+        size_t size() const noexcept    { return static_cast<size_t>(last_ - first_); }
+
+    private:
+        document const* doc_ {nullptr};
+        BaseIt          first_ {};
+        BaseIt          last_ {};
+    };
+
+//========================================================================
+// node_store
+//========================================================================
+
+    template<typename T>
+    typename node_store<T>::iterator node_store<T>::insert(const_iterator pos, T value)
+    {
+        if (pos == end())
+        {
+            emplace_back(std::move(value));
+            return {this, chunks_.size() - 1, chunks_.back()->size() - 1};
+        }
+
+        size_t c = pos.c_, o = pos.o_;
+        auto& target = writable(c);
+        target.insert(target.begin() + static_cast<std::ptrdiff_t>(o), std::move(value));
+        for (size_t i = c; i < ends_.size(); ++i)
+            ++ends_[i];
+
+        if (target.size() > CHUNK)
+        {
+            // Split in halves so that neighbours keep room to grow
+            size_t half = target.size() / 2;
+            auto upper = make_chunk();
+            upper->insert(upper->end(), std::make_move_iterator(target.begin() + static_cast<std::ptrdiff_t>(half)), std::make_move_iterator(target.end()));
+            target.erase(target.begin() + static_cast<std::ptrdiff_t>(half), target.end());
+
+            chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(c) + 1, std::move(upper));
+            ends_.insert(ends_.begin() + static_cast<std::ptrdiff_t>(c), start_of(c) + half);
+
+            if (o >= half) { ++c; o -= half; }
+        }
+
+        return {this, c, o};
+    }
+
+    template<typename T>
+    typename node_store<T>::iterator node_store<T>::erase(const_iterator pos)
+    {
+        size_t c = pos.c_, o = pos.o_;
+        auto& target = writable(c);
+        target.erase(target.begin() + static_cast<std::ptrdiff_t>(o));
+        for (size_t i = c; i < ends_.size(); ++i)
+            --ends_[i];
+
+        if (target.empty())
+        {
+            chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(c));
+            ends_.erase(ends_.begin() + static_cast<std::ptrdiff_t>(c));
+            return {this, c, 0};
+        }
+
+        if (o == target.size()) { ++c; o = 0; }
+        return {this, c, o};
+    }
+
+//========================================================================
+// ordered_item_list
+//========================================================================
+
+    inline uint64_t document::ordered_item_list::body::key_of(source_item_ref const& item) noexcept
+    {
+        uint64_t val = std::visit([](auto const& v) -> uint64_t
+        {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, category_close_marker>)
+                return v.which.val;
+            else
+                return v.val;
+        }, item.id);
+
+        // IDs are far below 2^56; the alternative lives in the top byte.
+        return (static_cast<uint64_t>(item.id.index()) << 56) ^ val;
+    }
+
+    inline size_t document::ordered_item_list::body::locate(source_item_ref const& item) const noexcept
+    {
+        if (indexed_)
+        {
+            auto it = index_.find(key_of(item));
+            return it == index_.end() ? npos() : it->second;
+        }
+
+        for (size_t s = head_; s != npos(); s = slots_[s].next)
+            if (slots_[s].item == item)
+                return s;
+
+        return npos();
+    }
+
+    inline size_t document::ordered_item_list::body::allocate(source_item_ref item)
+    {
+        size_t s;
+        if (free_ != npos())
+        {
+            s = free_;
+            free_ = slots_[s].next;
+            slots_[s].item = std::move(item);
+        }
+        else
+        {
+            s = slots_.size();
+            slots_.push_back({std::move(item), npos(), npos()});
+        }
+
+        ++size_;
+
+        if (indexed_)
+            index_.emplace(key_of(slots_[s].item), s);
+        else if (size_ > INDEX_THRESHOLD)
+        {
+            index_.reserve(slots_.capacity());
+            for (size_t i = head_; i != npos(); i = slots_[i].next)
+                index_.emplace(key_of(slots_[i].item), i);
+            index_.emplace(key_of(slots_[s].item), s);
+            indexed_ = true;
+        }
+
+        return s;
+    }
+
+    inline void document::ordered_item_list::body::release(size_t s) noexcept
+    {
+        if (indexed_)
+            index_.erase(key_of(slots_[s].item));
+
+        slots_[s].prev = npos();
+        slots_[s].next = free_;
+        free_ = s;
+        --size_;
+    }
+
+    inline void document::ordered_item_list::body::link_before(size_t s, size_t next) noexcept
+    {
+        size_t prev = next == npos() ? tail_ : slots_[next].prev;
+
+        slots_[s].prev = prev;
+        slots_[s].next = next;
+
+        if (prev == npos()) head_ = s; else slots_[prev].next = s;
+        if (next == npos()) tail_ = s; else slots_[next].prev = s;
+    }
+
+    inline void document::ordered_item_list::body::unlink(size_t s) noexcept
+    {
+        size_t prev = slots_[s].prev;
+        size_t next = slots_[s].next;
+
+        if (prev == npos()) head_ = next; else slots_[prev].next = next;
+        if (next == npos()) tail_ = prev; else slots_[next].prev = prev;
+    }
+
+    inline bool document::ordered_item_list::body::insert_new(source_item_ref item, size_t next)
+    {
+        if (contains(item))
+            return false;
+
+        link_before(allocate(std::move(item)), next);
+        return true;
+    }
+
+    inline void document::ordered_item_list::body::clear() noexcept
+    {
+        slots_.clear();
+        index_.clear();
+        head_ = tail_ = free_ = npos();
+        size_ = 0;
+        indexed_ = false;
+    }
+
+    inline bool document::ordered_item_list::body::push_back(source_item_ref item)
+    {
+        return insert_new(std::move(item), npos());
+    }
+
+    inline bool document::ordered_item_list::body::push_front(source_item_ref item)
+    {
+        return insert_new(std::move(item), head_);
+    }
+
+    inline bool document::ordered_item_list::body::insert_before(source_item_ref const& anchor, source_item_ref item)
+    {
+        size_t a = locate(anchor);
+        if (a == npos()) return false;
+        return insert_new(std::move(item), a);
+    }
+
+    inline bool document::ordered_item_list::body::insert_after(source_item_ref const& anchor, source_item_ref item)
+    {
+        size_t a = locate(anchor);
+        if (a == npos()) return false;
+        return insert_new(std::move(item), slots_[a].next);
+    }
+
+    inline bool document::ordered_item_list::body::erase(source_item_ref const& item)
+    {
+        size_t s = locate(item);
+        if (s == npos()) return false;
+
+        unlink(s);
+        release(s);
+        return true;
+    }
+
+    inline bool document::ordered_item_list::body::move_before(source_item_ref const& item, source_item_ref const& anchor)
+    {
+        size_t s = locate(item);
+        size_t a = locate(anchor);
+        if (s == npos() || a == npos()) return false;
+        if (s == a) return true;
+
+        unlink(s);
+        link_before(s, a);
+        return true;
+    }
+
+    inline bool document::ordered_item_list::body::move_after(source_item_ref const& item, source_item_ref const& anchor)
+    {
+        size_t s = locate(item);
+        size_t a = locate(anchor);
+        if (s == npos() || a == npos()) return false;
+        if (s == a) return true;
+
+        unlink(s);
+        link_before(s, slots_[a].next);
+        return true;
+    }
+
+//========================================================================
+// row_sequence
+//========================================================================
+
+    inline uint64_t document::row_sequence::body::priority(link s) noexcept
+    {
+        // splitmix64 of the slot: fixed per slot, but scattered enough
+        // to keep the treap balanced whatever order rows arrive in
+        uint64_t z = static_cast<uint64_t>(s) + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    inline document::row_sequence::body::link document::row_sequence::body::leftmost(link s) const noexcept
+    {
+        while (slots_[s].left != nil) s = slots_[s].left;
+        return s;
+    }
+
+    inline document::row_sequence::body::link document::row_sequence::body::rightmost(link s) const noexcept
+    {
+        while (slots_[s].right != nil) s = slots_[s].right;
+        return s;
+    }
+
+    inline document::row_sequence::body::link document::row_sequence::body::successor(link s) const noexcept
+    {
+        if (slots_[s].right != nil)
+            return leftmost(slots_[s].right);
+
+        link p = slots_[s].parent;
+        while (p != nil && slots_[p].right == s)
+        {
+            s = p;
+            p = slots_[p].parent;
+        }
+        return p;
+    }
+
+    inline document::row_sequence::body::link document::row_sequence::body::locate(row_id id) const noexcept
+    {
+        if (indexed_)
+        {
+            auto it = index_.find(id.val);
+            return it == index_.end() ? nil : it->second;
+        }
+
+        for (size_t s = 0; s < slots_.size(); ++s)
+            if (slots_[s].size != 0 && slots_[s].id == id)
+                return static_cast<link>(s);
+
+        return nil;
+    }
+
+    inline document::row_sequence::body::link document::row_sequence::body::allocate(row_id id)
+    {
+        link s;
+        if (free_ != nil)
+        {
+            s = free_;
+            free_ = slots_[s].left;
+            slots_[s] = {id, nil, nil, nil, 1};
+        }
+        else
+        {
+            s = static_cast<link>(slots_.size());
+            slots_.push_back({id, nil, nil, nil, 1});
+        }
+
+        ++live_;
+
+        if (indexed_)
+            index_.emplace(id.val, s);
+        else if (live_ > INDEX_THRESHOLD)
+        {
+            index_.reserve(slots_.capacity());
+            for (size_t i = 0; i < slots_.size(); ++i)
+                if (slots_[i].size != 0)
+                    index_.emplace(slots_[i].id.val, static_cast<link>(i));
+            indexed_ = true;
+        }
+
+        return s;
+    }
+
+    // Frees every slot of the subtree rooted at s
+    inline void document::row_sequence::body::release_tree(link s) noexcept
+    {
+        while (s != nil)
+        {
+            // Rotate left children up until s has none, then free s
+            if (link l = slots_[s].left; l != nil)
+            {
+                slots_[s].left = slots_[l].right;
+                slots_[l].right = s;
+                s = l;
+                continue;
+            }
+
+            link next = slots_[s].right;
+            if (indexed_)
+                index_.erase(slots_[s].id.val);
+
+            slots_[s] = {slots_[s].id, nil, free_, nil, 0};
+            free_ = s;
+            --live_;
+            s = next;
+        }
+    }
+
+    inline void document::row_sequence::body::adopt(link s) noexcept
+    {
+        auto& n = slots_[s];
+        n.size = 1 + size_of(n.left) + size_of(n.right);
+        if (n.left  != nil) slots_[n.left].parent  = s;
+        if (n.right != nil) slots_[n.right].parent = s;
+    }
+
+    inline std::pair<document::row_sequence::body::link, document::row_sequence::body::link>
+    document::row_sequence::body::split(link t, size_t k) noexcept
+    {
+        if (t == nil)
+            return {nil, nil};
+
+        if (size_of(slots_[t].left) >= k)
+        {
+            auto [a, b] = split(slots_[t].left, k);
+            slots_[t].left = b;
+            adopt(t);
+            orphan(a);
+            orphan(t);
+            return {a, t};
+        }
+
+        auto [a, b] = split(slots_[t].right, k - size_of(slots_[t].left) - 1);
+        slots_[t].right = a;
+        adopt(t);
+        orphan(t);
+        orphan(b);
+        return {t, b};
+    }
+
+    inline document::row_sequence::body::link document::row_sequence::body::merge(link a, link b) noexcept
+    {
+        if (a == nil) return b;
+        if (b == nil) return a;
+
+        if (priority(a) > priority(b))
+        {
+            slots_[a].right = merge(slots_[a].right, b);
+            adopt(a);
+            return a;
+        }
+
+        slots_[b].left = merge(a, slots_[b].left);
+        adopt(b);
+        return b;
+    }
+
+    inline row_id document::row_sequence::body::operator[](size_t i) const noexcept
+    {
+        assert(i < size());
+
+        link t = root_;
+        for (;;)
+        {
+            size_t l = size_of(slots_[t].left);
+            if (i < l)
+                t = slots_[t].left;
+            else if (i == l)
+                return slots_[t].id;
+            else
+            {
+                i -= l + 1;
+                t = slots_[t].right;
+            }
+        }
+    }
+
+    inline size_t document::row_sequence::body::position(row_id id) const noexcept
+    {
+        link s = locate(id);
+        if (s == nil)
+            return npos();
+
+        size_t pos = size_of(slots_[s].left);
+        for (link p = slots_[s].parent; p != nil; s = p, p = slots_[p].parent)
+            if (slots_[p].right == s)
+                pos += size_of(slots_[p].left) + 1;
+
+        return pos;
+    }
+
+    inline void document::row_sequence::body::clear() noexcept
+    {
+        slots_.clear();
+        index_.clear();
+        root_ = free_ = nil;
+        live_ = 0;
+        indexed_ = false;
+    }
+
+    inline void document::row_sequence::body::insert(size_t index, std::span<const row_id> ids)
+    {
+        if (ids.empty())
+            return;
+
+        link block = nil;
+        for (auto id : ids)
+            block = merge(block, allocate(id));
+
+        auto [a, b] = split(root_, std::min(index, size()));
+        root_ = merge(merge(a, block), b);
+        orphan(root_);
+    }
+
+    inline void document::row_sequence::body::erase(size_t index, size_t count)
+    {
+        auto [a, rest] = split(root_, index);
+        auto [mid, b]  = split(rest, count);
+        release_tree(mid);
+        root_ = merge(a, b);
+        orphan(root_);
+    }
+
+    inline void document::row_sequence::body::move(size_t from, size_t count, size_t to)
+    {
+        if (count == 0 || from == to)
+            return;
+
+        auto [a, rest] = split(root_, from);
+        auto [mid, b]  = split(rest, count);
+        auto [c, d]    = split(merge(a, b), to);
+        root_ = merge(merge(c, mid), d);
+        orphan(root_);
+    }
+
+    inline size_t document::row_sequence::body::heap_bytes() const noexcept
+    {
+        return slots_.capacity() * sizeof(slot)
+             + index_.size() * (sizeof(std::pair<const uint64_t, link>) + 2 * sizeof(void*))
+             + index_.bucket_count() * sizeof(void*);
+    }
+
+//========================================================================
+// document member implementations
+//========================================================================
+
+    inline category_id document::create_root()
+    {
+        if (categories_.empty())
+        {
+            category_node root;
+            root.id     = category_id{0};
+            root.name   = detail::ROOT_CATEGORY_NAME.data();
+            root.parent = invalid_id<category_tag>();
+
+            categories_.push_back(std::move(root));
+        }
+        assert (categories_.front().id == category_id{0});        
+        return category_id{0};
+    }    
+
+    inline category_id document::create_category( std::string_view name, category_id parent )
+    {
+        if (auto pcat = get_node(parent))
+        {
+            if (auto dup = category(name))
+                if (dup->parent()->id() == parent)
+                    return invalid_id<category_tag>();
+
+            auto id = create_category_id();
+            category_node node;
+            node.id     = id;
+            node.name   = std::string(name);
+            node.parent = parent;
+
+            categories_.push_back(std::move(node));
+
+            auto it = find_node_by_id(categories_, parent);
+            if (it != categories_.end())
+                it->children.push_back(id);
+
+            return id;            
+        }
+
+        return invalid_id<category_tag>();
+    }
+
+    inline category_id document::create_category( category_id id, std::string_view name, category_id parent )
+    {
+        // Only root have the ID 0 or an invalid parent ID. Either of
+        // these being explicitly set is interpreted as an attempt to
+        // create the root category.
+        if (id == category_id{0} || parent == invalid_id<category_tag>())
+        {
+            if (categories_.empty())
+                return create_root();
+
+            return invalid_id<category_tag>();
+        }
+
+        category_node node;
+        node.id     = id;
+        node.name   = std::string(name);
+        node.parent = parent;
+
+        categories_.push_back(std::move(node));
+
+        auto it = find_node_by_id(categories_, parent);
+        if (it != categories_.end())
+            it->children.push_back(id);
+
+        return id;
+    }
+
+    inline document document::fork() const
+    {
+        document copy;
+        copy.source_context_ = source_context_;
+
+        copy.categories_ = categories_;
+        copy.tables_     = tables_;
+        copy.columns_    = columns_;
+        copy.rows_       = rows_;
+        copy.keys_       = keys_;
+        copy.comments_   = comments_;
+        copy.paragraphs_ = paragraphs_;
+
+        copy.next_category_id_  = next_category_id_;
+        copy.next_key_id_       = next_key_id_;
+        copy.next_comment_id_   = next_comment_id_;
+        copy.next_paragraph_id_ = next_paragraph_id_;
+        copy.next_table_id_     = next_table_id_;
+        copy.next_row_id_       = next_row_id_;
+        copy.next_column_id_    = next_column_id_;
+
+        copy.contaminated_source_keys_ = contaminated_source_keys_;
+        copy.contaminated_source_rows_ = contaminated_source_rows_;
+        copy.request_clear_fn          = request_clear_fn;
+        copy.generation_               = generation_;
+        return copy;
+    }
+
+    inline comment_id document::create_comment(std::string text)
+    {
+        comment_id cid = create_comment_id();
+        comments_.push_back({.id = cid, .text = text});
+        return cid;
+    }
+
+    inline paragraph_id document::create_paragraph(std::string text)
+    {
+        paragraph_id pid = create_paragraph_id();
+        paragraphs_.push_back({.id = pid, .text = text});
+        return pid;
+    }
+
+    inline void document::mark_key_contaminated(key_id id)
+    {
+        if (contaminated_source_keys_.contains(id))
+            return;
+
+        auto* kn = get_node(id);
+        if (!kn) return;
+        
+        // Mark key and value as contaminated
+        kn->contamination = contamination_state::contaminated;
+        kn->value.contamination = contamination_state::contaminated;
+        
+        // Register as source and count it upward
+        contaminated_source_keys_.insert(id);
+        count_source(kn->owner, true);
+    }
+
+    inline void document::mark_row_contaminated(row_id id)
+    {
+        auto* rn = get_node(id);
+        if (!rn) return;
+        
+        // Mark row as contaminated
+        rn->contamination = contamination_state::contaminated;
+        
+        // Register as source and count it upward
+        if (contaminated_source_rows_.insert(id))
+            count_source(rn->table, true);
+    }
+
+    inline void document::count_source(table_id owner, bool added)
+    {
+        auto* tbl = get_node(owner);
+        if (!tbl) return;
+
+        if (added)
+            ++tbl->contaminated_sources;
+        else if (tbl->contaminated_sources > 0)
+            --tbl->contaminated_sources;
+
+        if (contamination_deferred())
+            pending_tables_.insert(static_cast<size_t>(owner));
+        else
+            refresh_contamination(*tbl);
+
+        count_source(tbl->owner, added);
+    }
+
+    inline void document::count_source(category_id owner, bool added)
+    {
+        for (auto* cat = get_node(owner); cat; cat = get_node(cat->parent))
+        {
+            if (added)
+                ++cat->contaminated_sources;
+            else if (cat->contaminated_sources > 0)
+                --cat->contaminated_sources;
+
+            if (contamination_deferred())
+                pending_categories_.insert(static_cast<size_t>(cat->id));
+            else
+                refresh_contamination(*cat);
+        }
+    }
+
+    inline void document::refresh_contamination(table_node& t)
+    {
+        // Invalid column declarations are local facts, not sources (see
+        // docs/invariants.md), so a table follows its rows alone
+        t.contamination = t.contaminated_sources > 0
+            ? contamination_state::contaminated
+            : contamination_state::clean;
+    }
+
+    inline void document::refresh_contamination(category_node& c)
+    {
+        c.contamination = c.contaminated_sources > 0
+            ? contamination_state::contaminated
+            : contamination_state::clean;
+    }
+
+    inline bool document::key_is_clean(const key_node& k) const
+    {
+        if (k.semantic != semantic_state::valid)
+            return false;
+
+        if (k.value.contamination == contamination_state::contaminated)
+            return false;
+        
+        if (k.value.semantic == semantic_state::invalid)
+            return false;
+        
+        // Check array elements
+        if (is_array(k.value))
+        {
+            auto const& arr = std::get<typed_array>(k.value.val);
+            if (arr.any_invalid() || arr.any_contaminated())
+                return false;
+        }
+        
+        return true;
+    }
+
+    inline bool document::row_is_clean(const row_node& r) const
+    {
+        if (r.semantic != semantic_state::valid)
+            return false;
+        
+        for (auto& cell : r.cells)
+        {
+            if (cell.semantic == semantic_state::invalid ||
+                cell.contamination == contamination_state::contaminated)
+                return false;
+            
+            // Check array cells
+            if (is_array(cell))
+            {
+                auto const& arr = std::get<typed_array>(cell.val);
+                if (arr.any_invalid() || arr.any_contaminated())
+                    return false;
+            }
+        }
+        
+        return true;
+    }
+
+    inline bool document::request_clear_contamination(clearable_node node)
+    {
+        // Step 1: Validate node is actually clean
+        bool is_clean = std::visit([this](auto id) -> bool 
+        {
+            using T = decltype(id);
+            if constexpr (std::is_same_v<T, key_id>) 
+            {
+                auto* kn = peek_node(id);
+                return kn && key_is_clean(*kn);
+            } 
+            else 
+            {
+                auto* rn = peek_node(id);
+                return rn && row_is_clean(*rn);
+            }
+        }, node);
+        
+        if (!is_clean)
+            return false;
+        
+        // Step 2: Ask permission
+        if (!request_clear_fn(node))
+            return false;
+        
+        // Step 3: Perform clearing
+        std::visit([this](auto id) 
+        {
+            using T = decltype(id);
+            if constexpr (std::is_same_v<T, key_id>)
+                clear_key_contamination(id);
+            else
+                clear_row_contamination(id);
+        }, node);
+        
+        return true;
+    }
+
+    inline void document::clear_key_contamination(key_id id)
+    {
+        auto* kn = get_node(id);
+        if (!kn) return;
+        
+        // Only clear if actually clean
+        if (!key_is_clean(*kn))
+            return;
+        
+        // Clear flags
+        kn->contamination = contamination_state::clean;
+        kn->value.contamination = contamination_state::clean;
+        
+        // Unregister as source
+        if (contaminated_source_keys_.erase(id))
+            count_source(kn->owner, false);
+    }
+
+    inline void document::clear_row_contamination(row_id id)
+    {
+        auto* rn = get_node(id);
+        if (!rn) return;
+        
+        if (!row_is_clean(*rn))
+            return;
+        
+        rn->contamination = contamination_state::clean;
+
+        if (contaminated_source_rows_.erase(id))
+            count_source(rn->table, false);
+    }
+
+    inline void document::drop_contamination_source(clearable_node node)
+    {
+        std::visit([this](auto id)
+        {
+            auto* n = get_node(id);
+            if (!n) return;
+
+            using T = decltype(id);
+            if constexpr (std::is_same_v<T, key_id>)
+            {
+                if (contaminated_source_keys_.erase(id))
+                    count_source(n->owner, false);
+            }
+            else
+            {
+                if (contaminated_source_rows_.erase(id))
+                    count_source(n->table, false);
+            }
+        }, node);
+    }
+
+    inline void document::resume_contamination()
+    {
+        if (deferred_contamination_depth_ == 0 || --deferred_contamination_depth_ > 0)
+            return;
+
+        for (auto id : pending_tables_)
+            if (auto* tbl = get_node(table_id{id}))
+                refresh_contamination(*tbl);
+
+        for (auto id : pending_categories_)
+            if (auto* cat = get_node(category_id{id}))
+                refresh_contamination(*cat);
+
+        pending_tables_.clear();
+        pending_categories_.clear();
+    }
+
+//========================================================================
+// edit_journal
+//========================================================================
+
+    template<typename N>
+    constexpr size_t document::edit_journal::kind_of() noexcept
+    {
+        if constexpr      (std::is_same_v<N, category_node>)  return 0;
+        else if constexpr (std::is_same_v<N, table_node>)     return 1;
+        else if constexpr (std::is_same_v<N, column_node>)    return 2;
+        else if constexpr (std::is_same_v<N, row_node>)       return 3;
+        else if constexpr (std::is_same_v<N, key_node>)       return 4;
+        else if constexpr (std::is_same_v<N, comment_node>)   return 5;
+        else if constexpr (std::is_same_v<N, paragraph_node>) return 6;
+        else static_assert(sizeof(N) == 0, "Illegal node");
+    }
+
+    template<typename Id>
+    bool document::edit_journal::created_in_entry(Id id) const noexcept
+    {
+        return id.val >= first_new_[kind_of<node_for_t<typename Id::tag_type>>()];
+    }
+
+    // Approximate heap footprint, used to hold the journal to its cap
+    template<typename N>
+    size_t document::edit_journal::bytes_of(N const& node) noexcept
+    {
+        auto value_bytes = [](typed_value const& tv)
+        {
+            size_t b = sizeof(typed_value);
+            if (auto* s = std::get_if<std::string>(&tv.val)) b += s->capacity();
+            if (auto* a = std::get_if<typed_array>(&tv.val)) b += a->heap_bytes();
+            return b;
+        };
+
+        size_t b = sizeof(N);
+        if constexpr (std::is_same_v<N, category_node>)
+            b += node.name.capacity() + (node.children.capacity() + node.tables.capacity() + node.keys.capacity()) * sizeof(size_t)
+               + node.ordered_items.size() * 4 * sizeof(size_t);
+        else if constexpr (std::is_same_v<N, table_node>)
+            b += node.columns.capacity() * sizeof(size_t) + node.rows.heap_bytes() + node.ordered_items.size() * 4 * sizeof(size_t);
+        else if constexpr (std::is_same_v<N, column_node>)
+            b += node.col.name.capacity();
+        else if constexpr (std::is_same_v<N, row_node>)
+            for (auto const& c : node.cells) b += value_bytes(c);
+        else if constexpr (std::is_same_v<N, key_node>)
+            b += node.name.capacity() + value_bytes(node.value);
+        else
+            b += node.text.capacity();
+        return b;
+    }
+
+    inline size_t document::edit_journal::bytes_of(record const& r) noexcept
+    {
+        return std::visit([](auto const& rec) -> size_t
+        {
+            size_t b = sizeof(record);
+            if constexpr (requires { rec.image; })
+            {
+                if (rec.image) b += bytes_of(*rec.image);
+            }
+            else if constexpr (requires { rec.items.capacity(); })
+                b += rec.items.capacity() * sizeof(typename decltype(rec.items)::value_type);
+            return b;
+        }, r);
+    }
+
+    inline void document::edit_journal::push(record r)
+    {
+        open_.bytes += bytes_of(r);
+        open_.records.push_back(std::move(r));
+    }
+
+    inline void document::edit_journal::open(document const& doc)
+    {
+        if (depth_++ > 0)
+            return;
+
+        first_new_ = {
+            doc.next_category_id_.val, doc.next_table_id_.val, doc.next_column_id_.val, doc.next_row_id_.val,
+            doc.next_key_id_.val, doc.next_comment_id_.val, doc.next_paragraph_id_.val
+        };
+    }
+
+    template<typename N>
+    void document::edit_journal::add_created(document& doc)
+    {
+        // Storage is ordered by ID and new nodes are appended, so the
+        // nodes created in this entry form the tail.
+        auto& storage = doc.storage_for<N>();
+        size_t first = storage.size();
+        while (first > 0 && storage[first - 1]._id().val >= first_new_[kind_of<N>()])
+            --first;
+
+        for (size_t i = first; i < storage.size(); ++i)
+            push(node_record<N>{ .id = storage[i]._id() });
+    }
+
+    // Ends the outermost entry; false while an enclosing one is open
+    inline bool document::edit_journal::seal(document& doc)
+    {
+        if (depth_ == 0 || --depth_ > 0)
+            return false;
+
+        add_created<category_node>(doc);
+        add_created<table_node>(doc);
+        add_created<column_node>(doc);
+        add_created<row_node>(doc);
+        add_created<key_node>(doc);
+        add_created<comment_node>(doc);
+        add_created<paragraph_node>(doc);
+
+        touched_.clear();
+        return true;
+    }
+
+    inline void document::edit_journal::close(document& doc)
+    {
+        if (!seal(doc) || open_.records.empty())
+            return;
+
+        // A new edit forks history
+        for (auto const& e : redo_) bytes_ -= e.bytes;
+        redo_.clear();
+
+        bytes_ += open_.bytes;
+        undo_.push_back(std::move(open_));
+        open_ = {};
+
+        while (bytes_ > max_bytes_ && !undo_.empty())
+        {
+            bytes_ -= undo_.front().bytes;
+            undo_.pop_front();
+        }
+    }
+
+    template<typename N>
+    void document::edit_journal::touch(document& doc, N& node)
+    {
+        if (!recording() || created_in_entry(node._id()))
+            return;
+
+        if (!touched_.insert((kind_of<N>() << 56) ^ node._id().val).second)
+            return;
+
+        node_record<N> r{ .id = node._id() };
+
+        if constexpr (std::is_same_v<N, category_node> || std::is_same_v<N, table_node>)
+        {
+            // Collections are journaled by position; image the header
+            N hold;
+            swap_collections(hold, node);
+            r.image = node;
+            swap_collections(hold, node);
+            r.header_only = true;
+        }
+        else
+        {
+            r.image = node;
+            if constexpr (std::is_same_v<N, key_node>)
+                r.source = doc.contaminated_source_keys_.contains(r.id);
+            else if constexpr (std::is_same_v<N, row_node>)
+                r.source = doc.contaminated_source_rows_.contains(r.id);
+        }
+
+        push(std::move(r));
+    }
+
+    template<typename N>
+    void document::edit_journal::erased(document& doc, N&& node)
+    {
+        if (!recording() || created_in_entry(node._id()))
+            return;
+
+        node_record<N> r{ .id = node._id() };
+        if constexpr (std::is_same_v<N, key_node>)
+            r.source = doc.contaminated_source_keys_.contains(r.id);
+        else if constexpr (std::is_same_v<N, row_node>)
+            r.source = doc.contaminated_source_rows_.contains(r.id);
+
+        r.image = std::move(node);
+        push(std::move(r));
+    }
+
+    template<typename N, typename Id>
+    void document::edit_journal::ids_changed(N const& owner, std::vector<Id> items, std::optional<size_t> before, std::optional<size_t> after)
+    {
+        if (!recording() || created_in_entry(owner._id()))
+            return;
+
+        // Stored as the move that undoes the edit
+        push(ids_record<N, Id>{ owner._id(), std::move(items), after, before });
+    }
+
+    template<typename N>
+    void document::edit_journal::items_changed(N const& owner, source_item_ref item, position before, position after)
+    {
+        if (!recording() || created_in_entry(owner._id()))
+            return;
+
+        // Stored as the move that undoes the edit
+        push(items_record<N>{ owner._id(), std::move(item), std::move(after), std::move(before) });
+    }
+
+    template<typename N>
+    void document::edit_journal::swap_collections(N& a, N& b) noexcept
+    {
+        if constexpr (std::is_same_v<N, category_node>)
+        {
+            std::swap(a.children, b.children);
+            std::swap(a.tables, b.tables);
+            std::swap(a.keys, b.keys);
+            std::swap(a.ordered_items, b.ordered_items);
+        }
+        else if constexpr (std::is_same_v<N, table_node>)
+        {
+            std::swap(a.columns, b.columns);
+            std::swap(a.rows, b.rows);
+            std::swap(a.ordered_items, b.ordered_items);
+        }
+    }
+
+    template<typename N>
+    void document::edit_journal::apply(document& doc, node_record<N>& r)
+    {
+        auto& storage = doc.storage_for<N>();
+        auto it = doc.find_node_by_id(storage, r.id);
+        bool present = it != storage.end();
+        if (!present)
+            it = storage.unconst(std::ranges::lower_bound(std::as_const(storage), r.id, {}, [](auto const& n) { return n._id(); }));
+
+        if (r.header_only)
+        {
+            if (!present || !r.image) return;
+
+            // Swap everything, then hand the collections back
+            std::swap(*it, *r.image);
+            swap_collections(*it, *r.image);
+            return;
+        }
+
+        if (present && r.image)
+            std::swap(*it, *r.image);
+        else if (present)
+        {
+            r.image = std::move(*it);
+            storage.erase(it);
+        }
+        else if (r.image)
+        {
+            storage.insert(it, std::move(*r.image));
+            r.image.reset();
+        }
+
+        auto swap_source = [&r](auto& sources)
+        {
+            bool now = sources.contains(r.id);
+            if (r.source) sources.insert(r.id); else sources.erase(r.id);
+            r.source = now;
+        };
+        if constexpr (std::is_same_v<N, key_node>) swap_source(doc.contaminated_source_keys_);
+        if constexpr (std::is_same_v<N, row_node>) swap_source(doc.contaminated_source_rows_);
+        if (doc.value_index_) doc.value_index_touch(r.id);
+    }
+
+    namespace detail
+    {
+        template<typename Id, typename N>
+        auto& id_list(N& owner) noexcept
+        {
+            if constexpr      (std::is_same_v<Id, category_id>) return owner.children;
+            else if constexpr (std::is_same_v<Id, table_id>)    return owner.tables;
+            else if constexpr (std::is_same_v<Id, key_id>)      return owner.keys;
+            else if constexpr (std::is_same_v<Id, column_id>)   return owner.columns;
+            else                                                return owner.rows;
+        }
+
+        // Positional edits shared by the plain ID lists and row_sequence
+
+        template<typename Id>
+        void ids_insert_at(shared_list<Id>& list, size_t index, std::span<const Id> items)
+        {
+            list.insert(list.begin() + index, items.begin(), items.end());
+        }
+
+        inline void ids_insert_at(document::row_sequence& list, size_t index, std::span<const row_id> items)
+        {
+            list.insert(index, items);
+        }
+
+        template<typename Id>
+        void ids_erase_at(shared_list<Id>& list, size_t index, size_t count)
+        {
+            list.erase(list.begin() + index, list.begin() + index + count);
+        }
+
+        inline void ids_erase_at(document::row_sequence& list, size_t index, size_t count)
+        {
+            list.erase(index, count);
+        }
+
+        template<typename Id>
+        size_t ids_find(shared_list<Id> const& list, Id item) noexcept
+        {
+            auto it = std::ranges::find(list, item);
+            return it == list.end() ? npos() : static_cast<size_t>(it - list.begin());
+        }
+
+        inline size_t ids_find(document::row_sequence const& list, row_id item) noexcept
+        {
+            return list.position(item);
+        }
+    }
+
+    template<typename N, typename Id>
+    void document::edit_journal::apply(document& doc, ids_record<N, Id>& r)
+    {
+        auto* owner = &*doc.find_node_by_id(doc.storage_for<N>(), r.owner);
+        auto& list = detail::id_list<Id>(*owner);
+
+        if (r.from)
+            detail::ids_erase_at(list, *r.from, r.items.size());
+        if (r.to)
+            detail::ids_insert_at(list, *r.to, std::span<const Id>(r.items));
+
+        std::swap(r.from, r.to);
+    }
+
+    template<typename N>
+    void document::edit_journal::apply(document& doc, items_record<N>& r)
+    {
+        auto& list = doc.find_node_by_id(doc.storage_for<N>(), r.owner)->ordered_items;
+
+        if (r.from.present)
+            list.erase(r.item);
+        if (r.to.present)
+        {
+            if (r.to.next) list.insert_before(*r.to.next, r.item);
+            else           list.push_back(r.item);
+        }
+
+        std::swap(r.from, r.to);
+    }
+
+    inline void document::edit_journal::apply(document& doc, entry& e, bool reverse)
+    {
+        replaying_ = true;
+
+        auto run = [&](record& r) { std::visit([&](auto& rec) { apply(doc, rec); }, r); };
+        if (reverse)
+            for (auto it = e.records.rbegin(); it != e.records.rend(); ++it) run(*it);
+        else
+            for (auto& r : e.records) run(r);
+
+        replaying_ = false;
+    }
+
+    inline void document::edit_journal::discard(document& doc)
+    {
+        if (!seal(doc))
+            return;
+
+        apply(doc, open_, true);
+        open_ = {};
+    }
+
+    inline bool document::edit_journal::undo(document& doc)
+    {
+        if (depth_ > 0 || undo_.empty())
+            return false;
+
+        apply(doc, undo_.back(), true);
+        redo_.push_back(std::move(undo_.back()));
+        undo_.pop_back();
+        return true;
+    }
+
+    inline bool document::edit_journal::redo(document& doc)
+    {
+        if (depth_ > 0 || redo_.empty())
+            return false;
+
+        apply(doc, redo_.back(), false);
+        undo_.push_back(std::move(redo_.back()));
+        redo_.pop_back();
+        return true;
+    }
+
+//========================================================================
+// value_index
+//========================================================================
+
+    template<typename N, typename Fn>
+    void document::value_index::for_each_scalar(N const& node, Fn&& fn)
+    {
+        auto visit = [&fn](typed_value const& tv, uint32_t cell, uint32_t element)
+        {
+            if (auto s = std::get_if<std::string>(&tv.val))
+                fn(value_probe{std::string_view(*s)}, posting{0, cell, element, 0});
+            else if (auto i = std::get_if<int64_t>(&tv.val))
+                fn(value_probe{*i}, posting{0, cell, element, 0});
+            else if (auto d = std::get_if<double>(&tv.val); d && *d == *d)  // NaN equals nothing
+                fn(value_probe{*d}, posting{0, cell, element, 0});
+        };
+
+        // Array elements are read in place, compact or not
+        auto visit_value = [&visit, &fn](typed_value const& tv, uint32_t cell)
+        {
+            if (auto arr = std::get_if<typed_array>(&tv.val))
+            {
+                for (uint32_t e = 0; e < arr->size(); ++e)
+                {
+                    switch (arr->type_at(e))
+                    {
+                        case value_type::string:
+                            fn(value_probe{arr->string_at(e)}, posting{0, cell, e, 0});
+                            break;
+                        case value_type::integer:
+                            fn(value_probe{arr->integer_at(e)}, posting{0, cell, e, 0});
+                            break;
+                        case value_type::floating_point:
+                            if (double d = arr->real_at(e); d == d)
+                                fn(value_probe{d}, posting{0, cell, e, 0});
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+            else
+                visit(tv, cell, no_element);
+        };
+
+        if constexpr (std::is_same_v<N, key_node>)
+            visit_value(node.value, no_cell);
+        else
+            for (uint32_t c = 0; c < node.cells.size(); ++c)
+                visit_value(node.cells[c], c);
+    }
+
+    inline std::vector<document::value_index::posting>*
+    document::value_index::postings_for(value_probe const& probe, bool create)
+    {
+        auto lookup = [create](auto& map, auto const& key) -> std::vector<posting>*
+        {
+            if (create) return &map[key];
+            auto it = map.find(key);
+            return it == map.end() ? nullptr : &it->second;
+        };
 
-            categories_.push_back(std::move(root));
+        if (auto s = std::get_if<std::string_view>(&probe))
+        {
+            auto it = by_string_.find(*s);
+            if (it != by_string_.end()) return &it->second;
+            if (!create) return nullptr;
+            return &by_string_[strings_.emplace_back(*s)];
         }
-        assert (categories_.front().id == category_id{0});        
-        return category_id{0};
-    }    
+        if (auto i = std::get_if<int64_t>(&probe))
+            return lookup(by_integer_, *i);
+        return lookup(by_real_, real_key(std::get<double>(probe)));
+    }
 
-    inline category_id document::create_category( std::string_view name, category_id parent )
+    template<typename N>
+    void document::value_index::index(N const* node, size_t id, node_state& state)
     {
-        if (auto pcat = get_node(parent))
-        {
-            if (auto dup = category(name))
-                if (dup->parent()->id() == parent)
-                    return invalid_id<category_tag>();
+        if (!node)
+            return;
 
-            auto id = create_category_id();
-            category_node node;
-            node.id     = id;
-            node.name   = std::string(name);
-            node.parent = parent;
+        for_each_scalar(*node, [&](value_probe const& probe, posting p)
+        {
+            p.node = id;
+            p.version = state.version;
+            postings_for(probe, true)->push_back(p);
+            ++state.postings;
+        });
+        live_ += state.postings;
+    }
 
-            categories_.push_back(std::move(node));
+    template<typename N>
+    void document::value_index::reindex(document const& doc, size_t id, std::vector<node_state>& states)
+    {
+        auto& state = states[id];
+        live_  -= state.postings;
+        stale_ += state.postings;
+        state.postings = 0;
+        ++state.version;
 
-            auto it = std::ranges::find_if(categories_, [parent](category_node const & cn){return cn.id == parent;});
-            if (it != categories_.end())
-                it->children.push_back(id);
+        auto const& storage = [&doc]() -> node_store<N> const&
+        {
+            if constexpr (std::is_same_v<N, key_node>) return doc.keys_;
+            else                                      return doc.rows_;
+        }();
+        auto it = doc.find_node_by_id(storage, typename N::id_type{id});
+        index(it != storage.end() ? &*it : nullptr, id, state);
+    }
 
-            return id;            
-        }
+    inline void document::value_index::build(document const& doc)
+    {
+        strings_.clear();
+        by_string_.clear();
+        by_integer_.clear();
+        by_real_.clear();
+        dirty_keys_.clear();
+        dirty_rows_.clear();
+
+        key_states_.assign(doc.next_key_id_, {});
+        row_states_.assign(doc.next_row_id_, {});
+        live_ = stale_ = 0;
+
+        for (auto const& k : doc.keys_)
+            index(&k, k.id, key_states_[k.id]);
+        for (auto const& r : doc.rows_)
+            index(&r, r.id, row_states_[r.id]);
+
+        key_watermark_ = doc.next_key_id_;
+        row_watermark_ = doc.next_row_id_;
+        built_ = true;
+    }
 
-        return invalid_id<category_tag>();
+    inline void document::value_index::refresh(document const& doc)
+    {
+        key_states_.resize(doc.next_key_id_);
+        row_states_.resize(doc.next_row_id_);
+
+        for (auto id : dirty_keys_)
+            reindex<key_node>(doc, id, key_states_);
+        for (auto id = key_watermark_; id < doc.next_key_id_; ++id)
+            if (!dirty_keys_.contains(id))
+                reindex<key_node>(doc, id, key_states_);
+
+        for (auto id : dirty_rows_)
+            reindex<row_node>(doc, id, row_states_);
+        for (auto id = row_watermark_; id < doc.next_row_id_; ++id)
+            if (!dirty_rows_.contains(id))
+                reindex<row_node>(doc, id, row_states_);
+
+        dirty_keys_.clear();
+        dirty_rows_.clear();
+        key_watermark_ = doc.next_key_id_;
+        row_watermark_ = doc.next_row_id_;
     }
 
-    inline category_id document::create_category( category_id id, std::string_view name, category_id parent )
+    inline std::vector<document::value_index::posting>
+    document::value_index::find(document const& doc, value_probe const& probe)
     {
-        // Only root have the ID 0 or an invalid parent ID. Either of
-        // these being explicitly set is interpreted as an attempt to
-        // create the root category.
-        if (id == category_id{0} || parent == invalid_id<category_tag>())
-        {
-            if (categories_.empty())
-                return create_root();
+        std::lock_guard lock(mutex_);
 
-            return invalid_id<category_tag>();
-        }
+        if (built_ && stale_ <= live_)
+            refresh(doc);
+        else
+            build(doc);
 
-        category_node node;
-        node.id     = id;
-        node.name   = std::string(name);
-        node.parent = parent;
+        auto* list = postings_for(probe, false);
+        if (!list)
+            return {};
 
-        categories_.push_back(std::move(node));
+        std::erase_if(*list, [this](posting const& p)
+        {
+            bool old = p.version != state_of(p).version;
+            if (old) --stale_;
+            return old;
+        });
+        return *list;
+    }
 
-        auto it = std::ranges::find_if(categories_, [parent](category_node const & cn){return cn.id == parent;});
-        if (it != categories_.end())
-            it->children.push_back(id);
+    template<typename Tag>
+    void document::value_index_touch(id<Tag> id)
+    {
+        if constexpr (std::is_same_v<Tag, key_tag> || std::is_same_v<Tag, row_tag>)
+            value_index_->touch(id);
+    }
 
-        return id;
+    inline void document::enable_value_index()
+    {
+        if (!value_index_)
+            value_index_ = std::make_unique<value_index>();
     }
 
-    inline comment_id document::create_comment(std::string text)
+    inline void document::disable_value_index() noexcept
     {
-        comment_id cid{comments_.size()};
-        comments_.push_back({.id = cid, .text = text});
-        return cid;
+        value_index_.reset();
     }
 
-    inline paragraph_id document::create_paragraph(std::string text)
+    inline std::vector<document::value_occurrence> document::find_value(std::string_view value) const
     {
-        paragraph_id pid{paragraphs_.size()};
-        paragraphs_.push_back({.id = pid, .text = text});
-        return pid;
+        return find_value_(value);
     }
 
-    inline void document::mark_key_contaminated(key_id id)
+    inline std::vector<document::value_occurrence> document::find_value(double value) const
     {
-        if (contaminated_source_keys_.contains(static_cast<size_t>(id)))
-            return;
+        return find_value_(value);
+    }
 
-        auto* kn = get_node(id);
-        if (!kn) return;
-        
-        // Mark key and value as contaminated
-        kn->contamination = contamination_state::contaminated;
-        kn->value.contamination = contamination_state::contaminated;
-        
-        // Register as source
-        contaminated_source_keys_.insert(static_cast<size_t>(id));
-        
-        // Propagate flags upward (but don't register containers)
-        if (kn->owner != invalid_id<category_tag>())
+    inline std::vector<document::value_occurrence> document::find_value_(value_probe probe) const
+    {
+        using posting = value_index::posting;
+        std::vector<posting> found;
+
+        if (value_index_)
+            found = value_index_->find(*this, probe);
+        else
         {
-            auto* cat = get_node(kn->owner);
-            if (cat)
+            auto scan = [&](auto const& storage)
             {
-                cat->contamination = contamination_state::contaminated;
-                propagate_contamination_up_category_chain(kn->owner);
-            }
+                for (auto const& node : storage)
+                    value_index::for_each_scalar(node, [&](value_probe const& v, posting p)
+                    {
+                        if (v != probe) return;
+                        p.node = node._id();
+                        found.push_back(p);
+                    });
+            };
+            scan(keys_);
+            scan(rows_);
         }
-    }
 
-    inline void document::mark_row_contaminated(row_id id)
-    {
-        auto* rn = get_node(id);
-        if (!rn) return;
-        
-        // Mark row as contaminated
-        rn->contamination = contamination_state::contaminated;
-        
-        // Register as source
-        contaminated_source_rows_.insert(static_cast<size_t>(id));
-        
-        // Propagate to table
-        auto* tbl = get_node(rn->table);
-        if (tbl)
+        // Keys first, then cells, each in ID order
+        std::ranges::sort(found, {}, [](posting const& p)
         {
-            tbl->contamination = contamination_state::contaminated;
-            
-            // Propagate to owning category
-            auto* cat = get_node(tbl->owner);
-            if (cat)
+            return std::tuple(p.cell != value_index::no_cell, p.node, p.cell, p.element);
+        });
+
+        std::vector<value_occurrence> out;
+        out.reserve(found.size());
+
+        for (auto const& p : found)
+        {
+            value_occurrence occ;
+            if (p.element != value_index::no_element)
+                occ.element = p.element;
+
+            if (p.cell == value_index::no_cell)
+                occ.key = key_id{p.node};
+            else
             {
-                cat->contamination = contamination_state::contaminated;
-                propagate_contamination_up_category_chain(tbl->owner);
+                occ.row = row_id{p.node};
+                auto r  = find_node_by_id(rows_, occ.row);
+                auto t  = r != rows_.end() ? find_node_by_id(tables_, r->table) : tables_.end();
+                if (t != tables_.end() && p.cell < t->columns.size())
+                    occ.column = t->columns[p.cell];
             }
+            out.push_back(occ);
         }
+        return out;
     }
 
-    inline void document::propagate_contamination_up_category_chain(category_id id)
+//========================================================================
+// Journaled structural edits
+//========================================================================
+
+    template<typename N>
+    void document::journal_touch(N& node)
     {
-        auto* cat = get_node(id);
-        if (!cat) return;
+        journal_->touch(*this, node);
+    }
 
-        auto parent_id = cat->parent;
-        if (parent_id == invalid_id<category_tag>())
-            return;
+    template<typename N>
+    node_store<N>& document::storage_for() noexcept
+    {
+        if constexpr      (std::is_same_v<N, category_node>)  return categories_;
+        else if constexpr (std::is_same_v<N, table_node>)     return tables_;
+        else if constexpr (std::is_same_v<N, column_node>)    return columns_;
+        else if constexpr (std::is_same_v<N, row_node>)       return rows_;
+        else if constexpr (std::is_same_v<N, key_node>)       return keys_;
+        else if constexpr (std::is_same_v<N, comment_node>)   return comments_;
+        else if constexpr (std::is_same_v<N, paragraph_node>) return paragraphs_;
+        else static_assert(sizeof(N) == 0, "Illegal node");
+    }
 
-        auto* parent = get_node(parent_id);
-        if (!parent) return;
+    template<typename Tag>
+    bool document::erase_node(id<Tag> id)
+    {
+        auto& storage = storage_for<node_for_t<Tag>>();
+        auto it = find_node_by_id(storage, id);
+        if (it == storage.end())
+            return false;
 
-        if (parent->contamination == contamination_state::contaminated)
-            return;
+        if (journal_)
+            journal_->erased(*this, std::move(*it));
+        if (value_index_)
+            value_index_touch(id);
 
-        parent->contamination = contamination_state::contaminated;
-        propagate_contamination_up_category_chain(parent_id);
+        storage.erase(it);
+        return true;
     }
 
-    inline bool document::key_is_clean(const key_node& k) const
+    template<typename Id, typename N>
+    void document::ids_insert(N& owner, size_t index, std::span<const Id> items)
     {
-        if (k.semantic != semantic_state::valid)
-            return false;
+        auto& list = detail::id_list<Id>(owner);
+        index = std::min(index, list.size());
+        detail::ids_insert_at(list, index, items);
 
-        if (k.value.contamination == contamination_state::contaminated)
-            return false;
-        
-        if (k.value.semantic == semantic_state::invalid)
-            return false;
-        
-        // Check array elements
-        if (is_array(k.value))
-        {
-            auto& arr = std::get<std::vector<typed_value>>(k.value.val);
-            for (auto& elem : arr)
-            {
-                if (elem.semantic == semantic_state::invalid ||
-                    elem.contamination == contamination_state::contaminated)
-                    return false;
-            }
-        }
-        
-        return true;
+        if (journal_)
+            journal_->ids_changed(owner, std::vector<Id>(items.begin(), items.end()), std::nullopt, index);
     }
 
-    inline bool document::row_is_clean(const row_node& r) const
+    template<typename Id, typename N>
+    void document::ids_push_back(N& owner, Id item)
     {
-        if (r.semantic != semantic_state::valid)
-            return false;
-        
-        for (auto& cell : r.cells)
-        {
-            if (cell.semantic == semantic_state::invalid ||
-                cell.contamination == contamination_state::contaminated)
-                return false;
-            
-            // Check array cells
-            if (is_array(cell))
-            {
-                auto& arr = std::get<std::vector<typed_value>>(cell.val);
-                for (auto& elem : arr)
-                {
-                    if (elem.semantic == semantic_state::invalid ||
-                        elem.contamination == contamination_state::contaminated)
-                        return false;
-                }
-            }
-        }
-        
-        return true;
+        ids_insert<Id>(owner, detail::id_list<Id>(owner).size(), std::span<const Id>(&item, 1));
     }
 
-    inline bool document::table_is_clean(const table_node& t) const
+    template<typename Id, typename N>
+    void document::ids_insert(N& owner, size_t index, Id item)
     {
-        if (t.semantic != semantic_state::valid)
-            return false;
-        
-        // Check all columns
-        for (auto col_id : t.columns)
-        {
-            auto it = find_node_by_id(columns_, col_id);
-            if (it != columns_.end() && it->col.semantic != semantic_state::valid)
-                return false;
-        }
-        
-        // Check all rows
-        for (auto row_id : t.rows)
-        {
-            auto it = find_node_by_id(rows_, row_id);
-            if (it != rows_.end() && !row_is_clean(*it))
-                return false;
-        }
-        
-        return true;
+        ids_insert<Id>(owner, index, std::span<const Id>(&item, 1));
     }
 
-    inline bool document::category_is_clean(const category_node& c) const
+    // Erases every occurrence of the item
+    template<typename Id, typename N>
+    bool document::ids_erase(N& owner, Id item)
     {
-        if (c.semantic != semantic_state::valid)
-            return false;
-        
-        // Check all keys
-        for (auto kid : c.keys)
+        auto& list = detail::id_list<Id>(owner);
+        bool erased = false;
+
+        for (size_t index = detail::ids_find(list, item); index != npos(); index = detail::ids_find(list, item))
         {
-            auto it = find_node_by_id(keys_, kid);
-            if (it != keys_.end() && !key_is_clean(*it))
-                return false;
+            detail::ids_erase_at(list, index, 1);
+            erased = true;
+
+            if (journal_)
+                journal_->ids_changed(owner, std::vector<Id>{item}, index, std::nullopt);
         }
-        
-        // Check all tables
-        for (auto tid : c.tables)
+        return erased;
+    }
+
+    // Moves the block [from, from + count) so it starts at `to` in
+    // the list as it reads after the block is taken out.
+    template<typename Id, typename N>
+    void document::ids_move(N& owner, size_t from, size_t count, size_t to)
+    {
+        auto& list = detail::id_list<Id>(owner);
+        if (count == 0 || from == to)
+            return;
+
+        if constexpr (std::is_same_v<Id, row_id>)
+            list.move(from, count, to);
+        else
         {
-            auto it = find_node_by_id(tables_, tid);
-            if (it != tables_.end() && !table_is_clean(*it))
-                return false;
+            auto& ids  = list.edit();
+            auto first = ids.begin() + from;
+            auto last  = first + count;
+            if (to < from)
+                std::rotate(ids.begin() + to, first, last);
+            else
+                std::rotate(first, last, last + (to - from));
         }
-        
-        // Check all subcategories
-        for (auto cid : c.children)
+
+        if (journal_)
         {
-            auto it = find_node_by_id(categories_, cid);
-            if (it != categories_.end() && 
-                it->contamination == contamination_state::contaminated)
-                return false;
+            std::vector<Id> moved;
+            moved.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+                moved.push_back(list[to + i]);
+            journal_->ids_changed(owner, std::move(moved), from, to);
         }
-        
-        return true;
     }
 
-    inline bool document::request_clear_contamination(clearable_node node)
+    template<typename N, typename Op>
+    bool document::items_edit(N& owner, source_item_ref const& item, Op&& op)
     {
-        // Step 1: Validate node is actually clean
-        bool is_clean = std::visit([this](auto id) -> bool 
+        auto& list = owner.ordered_items;
+
+        auto where = [&list](source_item_ref const& ref)
         {
-            using T = decltype(id);
-            if constexpr (std::is_same_v<T, key_id>) 
-            {
-                auto* kn = get_node(id);
-                return kn && key_is_clean(*kn);
-            } 
-            else 
-            {
-                auto* rn = get_node(id);
-                return rn && row_is_clean(*rn);
-            }
-        }, node);
-        
-        if (!is_clean)
-            return false;
-        
-        // Step 2: Ask permission
-        if (!request_clear_fn(node))
+            edit_journal::position pos;
+            auto it = list.find(ref);
+            if (it == list.end())
+                return pos;
+
+            pos.present = true;
+            if (++it != list.end())
+                pos.next = *it;
+            return pos;
+        };
+
+        bool recording = journal_ && journal_->recording();
+        auto from = recording ? where(item) : edit_journal::position{};
+
+        if (!op(list))
             return false;
-        
-        // Step 3: Perform clearing
-        std::visit([this](auto id) 
-        {
-            using T = decltype(id);
-            if constexpr (std::is_same_v<T, key_id>)
-                clear_key_contamination(id);
-            else
-                clear_row_contamination(id);
-        }, node);
-        
+
+        if (recording)
+            journal_->items_changed(owner, item, std::move(from), where(item));
         return true;
     }
 
-    inline void document::clear_key_contamination(key_id id)
+    template<typename N>
+    bool document::items_push_back(N& owner, source_item_ref item)
     {
-        auto* kn = get_node(id);
-        if (!kn) return;
-        
-        // Only clear if actually clean
-        if (!key_is_clean(*kn))
-            return;
-        
-        // Clear flags
-        kn->contamination = contamination_state::clean;
-        kn->value.contamination = contamination_state::clean;
-        
-        // Unregister as source
-        contaminated_source_keys_.erase(static_cast<size_t>(id));
-        
-        // Try to clear parent category
-        if (kn->owner != invalid_id<category_tag>())
-            try_clear_category_contamination(kn->owner);
+        return items_edit(owner, item, [&](auto& l) { return l.push_back(item); });
     }
 
-    inline void document::clear_row_contamination(row_id id)
+    template<typename N>
+    bool document::items_insert_before(N& owner, source_item_ref const& anchor, source_item_ref item)
     {
-        auto* rn = get_node(id);
-        if (!rn) return;
-        
-        if (!row_is_clean(*rn))
-            return;
-        
-        rn->contamination = contamination_state::clean;
-        contaminated_source_rows_.erase(static_cast<size_t>(id));
-        
-        auto* tbl = get_node(rn->table);
-        if (!tbl) return;
+        return items_edit(owner, item, [&](auto& l) { return l.insert_before(anchor, item); });
+    }
 
-        if (table_is_clean(*tbl))
-        {
-            tbl->contamination = contamination_state::clean;
-            try_clear_category_contamination(tbl->owner);
-        }
+    template<typename N>
+    bool document::items_insert_after(N& owner, source_item_ref const& anchor, source_item_ref item)
+    {
+        return items_edit(owner, item, [&](auto& l) { return l.insert_after(anchor, item); });
     }
 
-    inline void document::try_clear_category_contamination(category_id id)
+    template<typename N>
+    bool document::items_erase(N& owner, source_item_ref const& item)
     {
-        auto* cat = get_node(id);
-        if (!cat) return;
-        
-        if (!category_is_clean(*cat))
-            return;
-        
-        cat->contamination = contamination_state::clean;
-        
-        // Continue up to parent
-        if (cat->parent != invalid_id<category_tag>())
-            try_clear_category_contamination(cat->parent);
+        return items_edit(owner, item, [&](auto& l) { return l.erase(item); });
+    }
+
+    template<typename N>
+    bool document::items_move_before(N& owner, source_item_ref const& item, source_item_ref const& anchor)
+    {
+        return items_edit(owner, item, [&](auto& l) { return l.move_before(item, anchor); });
+    }
+
+    template<typename N>
+    bool document::items_move_after(N& owner, source_item_ref const& item, source_item_ref const& anchor)
+    {
+        return items_edit(owner, item, [&](auto& l) { return l.move_after(item, anchor); });
     }
 
     inline std::optional<document::category_view>
@@ -974,7 +3329,7 @@ namespace nuno
 
     template<typename T>
     std::optional<typename node_to_view<T>::view_type>
-    document::to_view(std::vector<T> const & cont, typename std::vector<T>::const_iterator it) const noexcept
+    document::to_view(node_store<T> const & cont, typename node_store<T>::const_iterator it) const noexcept
     {
         if (it != cont.end())
            return typename node_to_view<T>::view_type{this, &*it};        
@@ -982,8 +3337,8 @@ namespace nuno
     }
 
     template<typename T>
-    typename std::vector<T>::const_iterator
-    document::find_node_by_name(std::vector<T> const & cont, std::string_view name) const noexcept
+    typename node_store<T>::const_iterator
+    document::find_node_by_name(node_store<T> const & cont, std::string_view name) const noexcept
     {
         return std::ranges::find_if(cont, [&name](auto const & node) {
             return node._name() == name;
@@ -1051,21 +3406,22 @@ namespace nuno
     }
 
     template<typename T>
-    typename std::vector<T>::iterator
-    document::find_node_by_id(std::vector<T> & cont, typename T::id_type id) noexcept
+    typename node_store<T>::iterator
+    document::find_node_by_id(node_store<T> & cont, typename T::id_type id) noexcept
     {
-        return std::ranges::find_if(cont, [id](auto const & node) {
-            return node._id() == id;
-        });
+        // Search through the const store so that finding a node does
+        // not unshare the chunks on the way to it.
+        return cont.unconst(std::as_const(*this).find_node_by_id(std::as_const(cont), id));
     }
 
     template<typename T>
-    typename std::vector<T>::const_iterator
-    document::find_node_by_id(std::vector<T> const & cont, typename T::id_type id) const noexcept
+    typename node_store<T>::const_iterator
+    document::find_node_by_id(node_store<T> const & cont, typename T::id_type id) const noexcept
     {
-        return std::ranges::find_if(cont, [id](auto const & node) {
-            return node._id() == id;
-        });
+        // Node storage is kept sorted by ID: IDs are handed out in
+        // increasing order and new nodes are appended.
+        auto it = std::ranges::lower_bound(cont, id, {}, [](auto const & node) { return node._id(); });
+        return it != cont.end() && it->_id() == id ? it : cont.end();
     }
 
     inline std::optional<document::category_view>
@@ -1112,7 +3468,7 @@ namespace nuno
     size_t document::key_view::indices() const noexcept 
     { 
         if (is_array())
-            return std::get<std::vector<typed_value>>(node->value.val).size();
+            return std::get<typed_array>(node->value.val).size();
         return 0;
     }
 
@@ -1161,7 +3517,7 @@ namespace nuno
     namespace 
     {
         template<typename View, typename T2>
-        std::vector<View> collect_views(document const * doc_ptr, std::vector<T2> const & cont)
+        std::vector<View> collect_views(document const * doc_ptr, node_store<T2> const & cont)
         {
             std::vector<View> res;
             for (auto const & c : cont)
@@ -1176,6 +3532,27 @@ namespace nuno
     std::vector<document::table_row_view> document::rows()       const noexcept { return collect_views<table_row_view>(this, rows_); }
     std::vector<document::key_view>       document::keys()       const noexcept { return collect_views<key_view>(this, keys_); }
 
+    document::node_range<document::category_view, document::category_node>
+    document::categories_range() const noexcept { return {this, categories_.begin(), categories_.end()}; }
+
+    document::node_range<document::table_view, document::table_node>
+    document::tables_range() const noexcept { return {this, tables_.begin(), tables_.end()}; }
+
+    document::node_range<document::column_view, document::column_node>
+    document::columns_range() const noexcept { return {this, columns_.begin(), columns_.end()}; }
+
+    document::node_range<document::table_row_view, document::row_node>
+    document::rows_range() const noexcept { return {this, rows_.begin(), rows_.end()}; }
+
+    document::node_range<document::key_view, document::key_node>
+    document::keys_range() const noexcept { return {this, keys_.begin(), keys_.end()}; }
+
+    document::id_range<category_id> document::category_view::children_range() const noexcept { return {doc, children().begin(), children().end()}; }
+    document::id_range<table_id>    document::category_view::tables_range() const noexcept   { return {doc, tables().begin(), tables().end()}; }
+    document::id_range<key_id>      document::category_view::keys_range() const noexcept     { return {doc, keys().begin(), keys().end()}; }
+    document::id_range<column_id>   document::table_view::columns_range() const noexcept     { return {doc, columns().begin(), columns().end()}; }
+    document::id_range<row_id>      document::table_view::rows_range() const noexcept        { return {doc, rows().begin(), rows().end()}; }
+
 } // namespace nuno
 
 #endif // NUNO_DOCUMENT_HPP
@@ -8,18 +8,61 @@
 
 #include "nuno_document.hpp"
 
+#include <exception>
+#include <utility>
+
 namespace nuno
 {
     // Convenience method
     document create_document();
 
+    namespace detail { class diff_applier; }
+
     class editor
     {
+        // Reads the document being edited while replaying a diff
+        friend class detail::diff_applier;
+
     public:
         explicit editor(document& doc) noexcept
             : doc_(doc)
         {}
 
+    //============================================================
+    // Batch edits
+    //============================================================
+
+        // Defers contamination propagation for the edits made while
+        // the batch is open. Edits apply immediately, as do the flags
+        // and source registration of the keys and rows they touch,
+        // and the source counts of their tables and categories. The
+        // flags of those containers are refreshed once when the batch
+        // closes, with the same result as propagating edit by edit.
+        //
+        // Until then, table and category contamination flags may be
+        // stale. Batches nest; only the outermost one settles. With
+        // the journal enabled, a batch is undone as a single step,
+        // and an outermost batch left by an exception reverts its
+        // edits instead of keeping them.
+        class batch
+        {
+        public:
+            explicit batch(editor& ed) noexcept;
+            ~batch();
+
+            batch(batch const&) = delete;
+            batch& operator=(batch const&) = delete;
+
+            // Settles early. Later edits propagate as usual.
+            void commit();
+
+        private:
+            document* doc_;
+            int       exceptions_;  // in flight when the batch opened
+
+            void rollback();
+        };
+
     //============================================================
     // Categories
     //============================================================
@@ -103,6 +146,36 @@ namespace nuno
         template<typename Tag> row_id insert_row_before(id<Tag> anchor, std::vector<value> cells);
         template<typename Tag> row_id insert_row_after(id<Tag> anchor, std::vector<value> cells);
 
+    // Bulk rows
+    //----------------------------
+        // One column of cells for columnar bulk insertion, one element
+        // per row. Columns shorter than the longest are padded with
+        // empty cells.
+        typedef std::variant<
+            std::span<const int64_t>,
+            std::span<const double>,
+            std::span<const bool>,
+            std::span<const std::string>,
+            std::span<const value>
+        > column_cells;
+
+        // Bulk variants take either a flat row-major buffer (column
+        // count cells per row, the last row padded if short) or one
+        // column_cells per table column. Storage is reserved once,
+        // cells are checked column by column against the declared
+        // type, and contamination is propagated once for the block.
+        //
+        // New rows get consecutive IDs. The first is returned, or an
+        // invalid ID if the table or anchor is missing or there is
+        // nothing to insert.
+        row_id append_rows( table_id table, std::span<const value> cells );
+        row_id append_rows( table_id table, std::span<const column_cells> columns );
+
+        row_id insert_rows_before( row_id anchor, std::span<const value> cells );
+        row_id insert_rows_before( row_id anchor, std::span<const column_cells> columns );
+        row_id insert_rows_after( row_id anchor, std::span<const value> cells );
+        row_id insert_rows_after( row_id anchor, std::span<const column_cells> columns );
+
     // Columns
     //----------------------------        
         bool erase_column(column_id id);
@@ -158,6 +231,7 @@ namespace nuno
         typename document::node_for<Tag>::type* 
         _unsafe_access_internal_document_container( id<Tag> id_ )
         {
+            ++doc_.generation_; // the node may be changed through the pointer
             return doc_.get_node(id_);
         }
 
@@ -170,6 +244,30 @@ namespace nuno
         void move_row_before( row_id row, row_id anchor );
         void move_row_after( row_id row, row_id anchor );
 
+    //============================================================
+    // Undo / redo
+    //============================================================
+
+        // Opt-in journal of editor operations. Each public mutation,
+        // or each outermost batch, becomes one undo step recorded as
+        // compact deltas, so undo and redo cost about as much as the
+        // edit did. max_bytes bounds the journal (approximately);
+        // the oldest steps are dropped first. The journal lives with
+        // the document, so editors on the same document share it.
+        //
+        // Only edits made through an editor are recorded. Editing the
+        // document by other means while journaling leaves earlier
+        // steps unsafe to undo.
+        void enable_journal( size_t max_bytes = size_t{64} << 20 );
+        void disable_journal();
+        bool journal_enabled() const noexcept;
+
+        // Both fail inside an open batch or with nothing to apply.
+        bool undo();
+        bool redo();
+        bool can_undo() const noexcept;
+        bool can_redo() const noexcept;
+
     private:
 
         document& doc_;
@@ -180,8 +278,44 @@ namespace nuno
 
         enum class insert_direction { before, after };
 
+        // Groups the changes of one public operation into a journal
+        // entry. Nested operations join the outermost entry. Every
+        // public operation opens one, so it also bumps the generation.
+        struct journal_scope
+        {
+            explicit journal_scope(document& doc) : doc_(doc)
+            {
+                ++doc_.generation_;
+                if (doc_.journal_) doc_.journal_->open(doc_);
+            }
+            ~journal_scope() { if (doc_.journal_) doc_.journal_->close(doc_); }
+
+            journal_scope(journal_scope const&) = delete;
+            journal_scope& operator=(journal_scope const&) = delete;
+
+            document& doc_;
+        };
+
+        // Resolves the category whose items include the anchor
         template<typename Tag>
-        document::source_item_ref const* locate_anchor(id<Tag> anchor) const noexcept;
+        category_id locate_anchor(id<Tag> anchor) noexcept;
+
+        // Items written after a table are listed by that table rather
+        // than by its category. Calls fn with the node whose
+        // ordered_items holds the item, the category or one of its
+        // tables, and returns its result; false if neither holds it.
+        template<typename Fn>
+        bool with_item_holder(category_id where, document::source_item_ref const& item, Fn&& fn);
+
+        // Lists an item after last, the table's last row before it,
+        // ahead of any items the table lists as written after it.
+        // Rows are listed so, and so is an item placed after a table.
+        void list_after_rows(document::table_node& tbl, std::optional<row_id> last, document::source_item_ref item);
+        void list_after_table(table_id table, document::source_item_ref item);
+
+        // Moves a table placed among the category's items to the same
+        // place in its table list, which #n selectors index
+        void settle_table_order(category_id where, table_id table);
 
         // Convert raw value to typed_value with validation
         typed_value make_array_element( value val, value_type expected_type, value_locus origin);
@@ -196,8 +330,25 @@ namespace nuno
         template<typename Tag>
         row_id insert_row_impl( id<Tag> anchor, std::vector<value> cells, insert_direction dir);
 
-        template<typename EntityId, typename NodeType>
-        bool erase_category_child( EntityId id, std::vector<NodeType>& storage);
+        // Sets the bookkeeping of a new table cell from its held value
+        // and the column's declared type. Returns false on a mismatch.
+        static bool init_table_cell( typed_value& tv, value_type declared_type );
+
+        // Appends count empty rows; fill(first_row_index, column_types)
+        // then populates doc_.rows_ from first_row_index onwards.
+        template<typename Fill>
+        row_id append_rows_impl( table_id table, size_t count, Fill&& fill );
+
+        template<typename Source>
+        row_id insert_rows_impl( row_id anchor, Source source, insert_direction dir );
+
+        template<typename EntityId>
+        bool erase_category_child( EntityId id );
+
+        // Takes an item from the list that holds it and lists it again
+        // through place()
+        template<typename EntityId, typename Place>
+        bool relist( category_id where, EntityId item, Place&& place );
 
         category_id  create_category_node_only( category_id parent, std::string_view name);
         key_id       create_key_node_only( category_id where, std::string_view name, value v, bool untyped);
@@ -215,7 +366,9 @@ namespace nuno
         EntityId insert_category_child_after_impl( id<Tag> anchor, CreateFn&& create_fn);
 
         template<typename EntityId, typename AnchorTag>
-        bool move_before(EntityId item, id<AnchorTag> anchor);   
+        bool move_child_impl(EntityId item, id<AnchorTag> anchor, insert_direction dir);
+
+        bool move_row_impl(row_id row, row_id anchor, insert_direction dir);
     };
 
 //================================================================================================================
@@ -224,25 +377,195 @@ namespace nuno
 //
 //================================================================================================================
 
+//========================================================
+// Batch edits
+//========================================================
+
+    inline editor::batch::batch(editor& ed) noexcept
+        : doc_(&ed.doc_)
+        , exceptions_(std::uncaught_exceptions())
+    {
+        if (doc_->journal_) doc_->journal_->open(*doc_);
+        doc_->defer_contamination();
+    }
+
+    inline editor::batch::~batch()
+    {
+        try
+        {
+            if (std::uncaught_exceptions() > exceptions_)
+                rollback();
+            else
+                commit();
+        }
+        catch (...)
+        {
+            // Nothing may leave a destructor. Container flags stay as
+            // settled so far.
+        }
+    }
+
+    inline void editor::batch::commit()
+    {
+        if (!doc_) return;
+        doc_->resume_contamination();
+        if (doc_->journal_) doc_->journal_->close(*doc_);
+        doc_ = nullptr;
+    }
+
+    inline void editor::batch::rollback()
+    {
+        if (!doc_) return;
+        auto* doc = std::exchange(doc_, nullptr);
+
+        // Settle first: the journal restores the flags and counts the
+        // containers had before the batch along with everything else
+        doc->resume_contamination();
+        if (doc->journal_) doc->journal_->discard(*doc);
+        ++doc->generation_;
+    }
+
+//========================================================
+// Undo / redo
+//========================================================
+
+    inline void editor::enable_journal(size_t max_bytes)
+    {
+        if (!doc_.journal_)
+            doc_.journal_ = std::make_unique<document::edit_journal>(max_bytes);
+    }
+
+    inline void editor::disable_journal()
+    {
+        doc_.journal_.reset();
+    }
+
+    inline bool editor::journal_enabled() const noexcept
+    {
+        return doc_.journal_ != nullptr;
+    }
+
+    inline bool editor::undo()
+    {
+        if (!doc_.journal_ || !doc_.journal_->undo(doc_))
+            return false;
+
+        ++doc_.generation_;
+        return true;
+    }
+
+    inline bool editor::redo()
+    {
+        if (!doc_.journal_ || !doc_.journal_->redo(doc_))
+            return false;
+
+        ++doc_.generation_;
+        return true;
+    }
+
+    inline bool editor::can_undo() const noexcept
+    {
+        return doc_.journal_ && doc_.journal_->undo_steps() > 0;
+    }
+
+    inline bool editor::can_redo() const noexcept
+    {
+        return doc_.journal_ && doc_.journal_->redo_steps() > 0;
+    }
+
 //========================================================
 // Internal helpers; not exposed for clients
 //========================================================
 
     template<typename Tag>
-    document::source_item_ref const*
-    editor::locate_anchor(id<Tag> anchor) const noexcept
+    category_id
+    editor::locate_anchor(id<Tag> anchor) noexcept
     {
-        // Anchor must exist in some category ordered_items
-        for (auto& cat : doc_.categories_)
+        // Anchor must exist in its owning category's ordered_items
+        auto* anchor_node = doc_.peek_node(anchor);
+        if (!anchor_node) return invalid_id<category_tag>();
+
+        category_id where;
+        if constexpr (std::is_same_v<Tag, category_tag>)
+            where = anchor_node->parent;
+        else
+            where = anchor_node->owner;
+
+        if (!with_item_holder(where, {anchor}, [](auto&) { return true; }))
+            return invalid_id<category_tag>();
+
+        return where;
+    }
+
+    template<typename Fn>
+    bool editor::with_item_holder(category_id where, document::source_item_ref const& item, Fn&& fn)
+    {
+        auto* cat = doc_.peek_node(where);
+        if (!cat) return false;
+
+        if (cat->ordered_items.contains(item))
+            return fn(*doc_.get_node(where));
+
+        for (auto tid : cat->tables)
+        {
+            auto* tbl = doc_.peek_node(tid);
+            if (tbl && tbl->ordered_items.contains(item))
+                return fn(*doc_.get_node(tid));
+        }
+        return false;
+    }
+
+    inline void editor::list_after_rows(document::table_node& tbl, std::optional<row_id> last, document::source_item_ref item)
+    {
+        auto const& items = tbl.ordered_items;
+        bool trailing = last ? !(items.back() == document::source_item_ref{*last})
+                             : !items.empty();
+
+        if (!trailing)
+            doc_.items_push_back(tbl, std::move(item));
+        else if (last)
+            doc_.items_insert_after(tbl, {*last}, std::move(item));
+        else
+            doc_.items_insert_before(tbl, items.front(), std::move(item));
+    }
+
+    inline void editor::list_after_table(table_id table, document::source_item_ref item)
+    {
+        auto* tbl = doc_.get_node(table);
+        std::optional<row_id> last;
+        if (!tbl->rows.empty())
+            last = tbl->rows.back();
+        list_after_rows(*tbl, last, std::move(item));
+    }
+
+    inline void editor::settle_table_order(category_id where, table_id table)
+    {
+        auto* cat = doc_.peek_node(where);
+        if (!cat) return;
+
+        // Tables written after a table are listed by it
+        size_t at = 0;
+        auto walk = [&](auto const& items, auto& self) -> bool
         {
-            for (auto& item : cat.ordered_items)
+            for (auto const& item : items)
             {
-                if (std::holds_alternative<id<Tag>>(item.id) &&
-                    std::get<id<Tag>>(item.id) == anchor)
-                    return &item;
+                auto const* t = std::get_if<table_id>(&item.id);
+                if (!t) continue;
+                if (*t == table) return true;
+                ++at;
+
+                auto* tbl = doc_.peek_node(*t);
+                if (tbl && self(tbl->ordered_items, self)) return true;
             }
-        }
-        return nullptr;
+            return false;
+        };
+        if (!walk(cat->ordered_items, walk))
+            return;
+
+        auto const& tables = cat->tables;
+        size_t from = static_cast<size_t>(std::ranges::find(tables, table) - tables.begin());
+        if (from < tables.size() && from != at)
+            doc_.ids_move<table_id>(*doc_.get_node(where), from, 1, at);
     }
 
     inline typed_value editor::make_array_element(
@@ -298,23 +621,18 @@ namespace nuno
         id<Tag> anchor,
         CreateFn&& create_fn)
     {
-        auto* ref = locate_anchor(anchor);
-        if (!ref) return invalid_id<typename EntityId::tag_type>();
-
-        auto* anchor_node = doc_.get_node(anchor);
-        if (!anchor_node) return invalid_id<typename EntityId::tag_type>();
-
-        category_id where = anchor_node->owner;
+        category_id where = locate_anchor(anchor);
+        if (!valid(where)) return invalid_id<typename EntityId::tag_type>();
 
         // Create node without touching ordered_items
         EntityId id = std::invoke(std::forward<CreateFn>(create_fn), where);
         if (!valid(id)) return id;
 
-        auto* cat = doc_.get_node(where);
-        auto it = std::ranges::find(cat->ordered_items, *ref);
-
         // Insert ONCE at correct position
-        cat->ordered_items.insert(it, {id});
+        with_item_holder(where, {anchor}, [&](auto& holder) { return doc_.items_insert_before(holder, {anchor}, {id}); });
+
+        if constexpr (std::is_same_v<EntityId, table_id>)
+            settle_table_order(where, id);
 
         return id;
     }
@@ -324,73 +642,132 @@ namespace nuno
         id<Tag> anchor,
         CreateFn&& create_fn)
     {
-        auto* ref = locate_anchor(anchor);
-        if (!ref) return invalid_id<typename EntityId::tag_type>();
-
-        auto* anchor_node = doc_.get_node(anchor);
-        if (!anchor_node) return invalid_id<typename EntityId::tag_type>();
-
-        category_id where = anchor_node->owner;
+        category_id where = locate_anchor(anchor);
+        if (!valid(where)) return invalid_id<typename EntityId::tag_type>();
 
         // Create node without touching ordered_items
         EntityId id = std::invoke(std::forward<CreateFn>(create_fn), where);
         if (!valid(id)) return id;
 
-        auto* cat = doc_.get_node(where);
-        auto it = std::ranges::find(cat->ordered_items, *ref);
-        
-        if (it != cat->ordered_items.end()) ++it;
+        // Insert ONCE at correct position. What follows a table in the
+        // source is listed by it.
+        if constexpr (std::is_same_v<Tag, table_tag>)
+            list_after_table(anchor, {id});
+        else
+            with_item_holder(where, {anchor}, [&](auto& holder) { return doc_.items_insert_after(holder, {anchor}, {id}); });
 
-        // Insert ONCE at correct position
-        cat->ordered_items.insert(it, {id});
+        if constexpr (std::is_same_v<EntityId, table_id>)
+            settle_table_order(where, id);
 
         return id;
     }
 
     template<typename EntityId, typename AnchorTag>
-    bool editor::move_before(EntityId item, id<AnchorTag> anchor)
+    bool editor::move_child_impl(EntityId item, id<AnchorTag> anchor, insert_direction dir)
     {
         // 1. Verify item and anchor exist
-        auto* item_node = doc_.get_node(item);
-        auto* anchor_node = doc_.get_node(anchor);
+        auto* item_node = doc_.peek_node(item);
+        auto* anchor_node = doc_.peek_node(anchor);
         if (!item_node || !anchor_node) return false;
         
         // 2. Verify both in same category
         if (item_node->owner != anchor_node->owner) return false;
         
-        auto* cat = doc_.get_node(item_node->owner);
-        if (!cat) return false;
-        
-        // 3. Find both in ordered_items
-        auto item_it = std::ranges::find(
-            cat->ordered_items,
-            document::source_item_ref{item}
-        );
-        
-        auto anchor_it = std::ranges::find(
-            cat->ordered_items,
-            document::source_item_ref{anchor}
-        );
-        
-        if (item_it == cat->ordered_items.end() || 
-            anchor_it == cat->ordered_items.end()) 
+        // 3. Relink in ordered_items. The item and anchor may be listed
+        //    by different nodes (see with_item_holder); the item then
+        //    leaves its list for the anchor's. Tables carry the items
+        //    they list, so they only move within the list that holds them.
+        category_id where = item_node->owner;
+
+        if constexpr (std::is_same_v<AnchorTag, table_tag> && !std::is_same_v<EntityId, table_id>)
+        {
+            // What follows a table in the source is listed by it
+            if (dir == insert_direction::after)
+                return relist(where, item, [&] { list_after_table(anchor, {item}); return true; });
+        }
+
+        bool moved = with_item_holder(where, {anchor}, [&](auto& holder)
+        {
+            if (holder.ordered_items.contains({item}))
+                return dir == insert_direction::before
+                    ? doc_.items_move_before(holder, {item}, {anchor})
+                    : doc_.items_move_after(holder, {item}, {anchor});
+
+            if constexpr (std::is_same_v<EntityId, table_id>)
+                return false;
+            else
+                return relist(where, item, [&]
+                {
+                    return dir == insert_direction::before
+                        ? doc_.items_insert_before(holder, {anchor}, {item})
+                        : doc_.items_insert_after(holder, {anchor}, {item});
+                });
+        });
+
+        if constexpr (std::is_same_v<EntityId, table_id>)
+            if (moved) settle_table_order(where, item);
+
+        return moved;
+    }
+
+    template<typename EntityId, typename Place>
+    bool editor::relist(category_id where, EntityId item, Place&& place)
+    {
+        if (!with_item_holder(where, {item}, [&](auto& from) { return doc_.items_erase(from, {item}); }))
             return false;
-        
-        // 4. Remove from current position
-        auto item_ref = *item_it;
-        cat->ordered_items.erase(item_it);
-        
-        // 5. Re-find anchor (iterator invalidated)
-        anchor_it = std::ranges::find(
-            cat->ordered_items,
-            document::source_item_ref{anchor}
-        );
-        
-        // 6. Insert before anchor
-        cat->ordered_items.insert(anchor_it, item_ref);
-        
+        return place();
+    }
+
+    inline bool editor::move_row_impl(row_id row, row_id anchor, insert_direction dir)
+    {
+        auto* rn = doc_.peek_node(row);
+        auto* an = doc_.peek_node(anchor);
+        if (!rn || !an || rn->table != an->table) return false;
+
+        auto* tbl = doc_.get_node(rn->table);
+        if (!tbl) return false;
+
+        bool moved = dir == insert_direction::before
+            ? doc_.items_move_before(*tbl, {row}, {anchor})
+            : doc_.items_move_after(*tbl, {row}, {anchor});
+
+        if (!moved || row == anchor) return moved;
+
+        // Keep the semantic collection in authored order. Both lookups
+        // and the move are O(log n) in the row_sequence.
+        size_t from = tbl->rows.position(row);
+        size_t to   = tbl->rows.position(anchor);
+        if (to > from) --to;
+        if (dir == insert_direction::after) ++to;
+
+        doc_.ids_move<row_id>(*tbl, from, 1, to);
+
         return true;
-    }        
+    }
+
+    inline void editor::move_child_before(category_anchor which, category_anchor anchor)
+    {
+        journal_scope scope(doc_);
+        std::visit([this](auto item, auto anch) { move_child_impl(item, anch, insert_direction::before); }, which, anchor);
+    }
+
+    inline void editor::move_child_after(category_anchor which, category_anchor anchor)
+    {
+        journal_scope scope(doc_);
+        std::visit([this](auto item, auto anch) { move_child_impl(item, anch, insert_direction::after); }, which, anchor);
+    }
+
+    inline void editor::move_row_before(row_id row, row_id anchor)
+    {
+        journal_scope scope(doc_);
+        move_row_impl(row, anchor, insert_direction::before);
+    }
+
+    inline void editor::move_row_after(row_id row, row_id anchor)
+    {
+        journal_scope scope(doc_);
+        move_row_impl(row, anchor, insert_direction::after);
+    }
 
     void editor::update_array_and_check(
         typed_value& target_array,
@@ -401,18 +778,9 @@ namespace nuno
     {
         if (!is_array(target_array)) return;
         
-        auto& arr = std::get<std::vector<typed_value>>(target_array.val);
+        auto const& arr = std::get<typed_array>(target_array.val);
         
-        bool has_invalid = false;
-        for (auto& elem : arr)
-        {
-            if (elem.semantic == semantic_state::invalid ||
-                elem.contamination == contamination_state::contaminated)
-            {
-                has_invalid = true;
-                break;
-            }
-        }
+        bool has_invalid = arr.any_invalid() || arr.any_contaminated();
         
         if (has_invalid)
         {
@@ -426,27 +794,17 @@ namespace nuno
         }
     }
 
-    template<typename EntityId, typename NodeType>
-    bool editor::erase_category_child(
-        EntityId id,
-        std::vector<NodeType>& storage)
+    template<typename EntityId>
+    bool editor::erase_category_child(EntityId id)
     {
-        auto* node = doc_.get_node(id);
+        auto* node = doc_.peek_node(id);
         if (!node) return false;
 
         auto* cat = doc_.get_node(node->owner);
         if (!cat) return false;
 
-        std::erase_if(cat->ordered_items, [&](auto const& r) {
-            return std::holds_alternative<EntityId>(r.id)
-                && std::get<EntityId>(r.id) == id;
-        });
-
-        storage.erase(
-            std::ranges::find_if(storage, [&](auto const& n) {
-                return n.id == id;
-            })
-        );
+        with_item_holder(node->owner, {id}, [&](auto& holder) { return doc_.items_erase(holder, {id}); });
+        doc_.erase_node(id);
 
         return true;
     }
@@ -483,7 +841,7 @@ namespace nuno
         kn.value.creation      = creation_state::generated;
 
         doc_.keys_.push_back(std::move(kn));
-        cat->keys.push_back(id);
+        doc_.ids_push_back(*cat, id);
 
         return id;
     }
@@ -492,7 +850,7 @@ namespace nuno
         category_id where,
         std::string_view text)
     {
-        auto* cat = doc_.get_node(where);
+        auto* cat = doc_.peek_node(where);
         if (!cat) return invalid_id<comment_tag>();
 
         comment_id id = doc_.create_comment_id();
@@ -513,7 +871,7 @@ namespace nuno
         category_id where,
         std::string_view text)
     {
-        auto* cat = doc_.get_node(where);
+        auto* cat = doc_.peek_node(where);
         if (!cat) return invalid_id<paragraph_tag>();
 
         paragraph_id id = doc_.create_paragraph_id();
@@ -562,7 +920,7 @@ namespace nuno
         }
 
         doc_.tables_.push_back(std::move(tbl));
-        cat->tables.push_back(tid);
+        doc_.ids_push_back(*cat, tid);
         // Note: Does NOT add to ordered_items
         
         return tid;
@@ -644,7 +1002,7 @@ namespace nuno
         category_id parent,
         std::string_view name)
     {
-        auto* parent_node = doc_.get_node(parent);
+        auto* parent_node = doc_.peek_node(parent);
         if (!parent_node) return invalid_id<category_tag>();
 
         category_id id = doc_.create_category_id();
@@ -659,8 +1017,7 @@ namespace nuno
         doc_.categories_.push_back(std::move(cn));
         
         // Re-acquire parent pointer after vector modification
-        parent_node = doc_.get_node(parent);
-        parent_node->children.push_back(id);
+        doc_.ids_push_back(*doc_.get_node(parent), id);
 
         return id;
     }
@@ -669,11 +1026,12 @@ namespace nuno
         category_id parent,
         std::string_view name)
     {
+        journal_scope scope(doc_);
         category_id id = create_category_node_only(parent, name);
         if (!valid(id)) return id;
 
         auto* parent_node = doc_.get_node(parent);
-        parent_node->ordered_items.push_back(document::source_item_ref{id});
+        doc_.items_push_back(*parent_node, {id});
 
         return id;
     }
@@ -683,6 +1041,7 @@ namespace nuno
         id<Tag> anchor,
         std::string_view name)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<category_id>(
             anchor,
             [this, name](category_id parent) {
@@ -696,6 +1055,7 @@ namespace nuno
         id<Tag> anchor,
         std::string_view name)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<category_id>(
             anchor,
             [this, name](category_id parent) {
@@ -706,7 +1066,8 @@ namespace nuno
 
     inline bool editor::erase_category(category_id id)
     {
-        auto* cn = doc_.get_node(id);
+        journal_scope scope(doc_);
+        auto* cn = doc_.peek_node(id);
         if (!cn) return false;
 
         // Cannot erase root category
@@ -731,21 +1092,18 @@ namespace nuno
         }
 
         // Remove from parent's children list
-        std::erase(parent->children, id);
+        doc_.ids_erase(*parent, id);
 
-        // Remove from parent's ordered_items
-        std::erase_if(parent->ordered_items, [&](auto const& r) {
-            return std::holds_alternative<category_id>(r.id)
-                && std::get<category_id>(r.id) == id;
-        });
+        // Remove from the parent's items, along with the close marker
+        // if the source closed the category explicitly. Markers match
+        // on the category alone, so the form is a placeholder.
+        category_id where = cn->parent;
+        document::source_item_ref marker {document::category_close_marker{id, document::category_close_form::shorthand}};
+        with_item_holder(where, {id}, [&](auto& holder) { return doc_.items_erase(holder, {id}); });
+        with_item_holder(where, marker, [&](auto& holder) { return doc_.items_erase(holder, marker); });
 
         // Remove from document storage
-        auto& categories = doc_.categories_;
-        categories.erase(
-            std::ranges::find_if(categories, [&](auto const& c) {
-                return c.id == id;
-            })
-        );
+        doc_.erase_node(id);
 
         return true;
     }
@@ -756,6 +1114,7 @@ namespace nuno
 
     inline void editor::set_array_element(key_id key, size_t index, value val)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(key);
         if (!kn) return;
         
@@ -764,7 +1123,7 @@ namespace nuno
         if (!is_array(tv))
             return;
         
-        auto& arr = std::get<std::vector<typed_value>>(tv.val);
+        auto& arr = std::get<typed_array>(tv.val);
         
         if (index >= arr.size())
             return; // Or throw?
@@ -777,17 +1136,10 @@ namespace nuno
         );
         
         // Replace
-        arr[index] = std::move(elem);
+        arr.set(index, std::move(elem));
         
         // Re-evaluate contamination
-        bool has_invalid = false;
-        for (auto& e : arr) 
-        {
-            if (e.semantic == semantic_state::invalid) {
-                has_invalid = true;
-                break;
-            }
-        }
+        bool has_invalid = arr.any_invalid();
         
         if (has_invalid) 
         {
@@ -806,6 +1158,7 @@ namespace nuno
 
     inline void editor::append_array_element(key_id key, value val)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(key);
         if (!kn) return;
         
@@ -816,7 +1169,7 @@ namespace nuno
             return; // Or throw? Design decision
         
         // Get array reference
-        auto& arr = std::get<std::vector<typed_value>>(tv.val);
+        auto& arr = std::get<typed_array>(tv.val);
         
         // Create new element
         typed_value elem = make_array_element(
@@ -824,12 +1177,13 @@ namespace nuno
             tv.type,
             value_locus::key_value
         );
+        bool invalid = elem.semantic == semantic_state::invalid;
         
         // Append
         arr.push_back(std::move(elem));
         
         // Check if new element is invalid
-        if (arr.back().semantic == semantic_state::invalid) {
+        if (invalid) {
             tv.contamination = contamination_state::contaminated;
             kn->contamination = contamination_state::contaminated;
             doc_.mark_key_contaminated(key);
@@ -840,6 +1194,7 @@ namespace nuno
 
     inline void editor::set_array_elements(key_id key, std::vector<value> vals)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(key);
         if (!kn) return;
         
@@ -867,7 +1222,7 @@ namespace nuno
         }
         
         // Replace entire array
-        tv.val = std::move(new_arr);
+        tv.val = typed_array(std::move(new_arr));
         
         // Update contamination
         if (has_invalid) 
@@ -887,6 +1242,7 @@ namespace nuno
 
     inline void editor::erase_array_element(key_id key, size_t index)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(key);
         if (!kn) return;
         
@@ -895,24 +1251,16 @@ namespace nuno
         if (!is_array(tv))
             return;
         
-        auto& arr = std::get<std::vector<typed_value>>(tv.val);
+        auto& arr = std::get<typed_array>(tv.val);
         
         if (index >= arr.size())
             return;
         
         // Remove element
-        arr.erase(arr.begin() + index);
+        arr.erase(index);
         
         // Re-evaluate contamination (might clear if removed element was the problem)
-        bool has_invalid = false;
-        for (auto& e : arr) 
-        {
-            if (e.semantic == semantic_state::invalid) 
-            {
-                has_invalid = true;
-                break;
-            }
-        }
+        bool has_invalid = arr.any_invalid();
         
         if (has_invalid) 
         {
@@ -939,11 +1287,12 @@ namespace nuno
         value v,
         bool untyped)
     {
+        journal_scope scope(doc_);
         key_id id = create_key_node_only(where, name, std::move(v), untyped);
         if (!valid(id)) return id;
 
         auto* cat = doc_.get_node(where);
-        cat->ordered_items.push_back(document::source_item_ref{id});
+        doc_.items_push_back(*cat, {id});
         return id;
     }
 
@@ -954,16 +1303,12 @@ namespace nuno
         value v,
         bool untyped)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<key_id>(
             anchor,
             [this, name, val = std::move(v), untyped](category_id where) mutable {
-                key_id id = create_key_node_only(where, name, std::move(val), untyped);
-                if (!valid(id)) return id;
-                
-                auto* cat = doc_.get_node(where);
-                cat->keys.push_back(id);  // Keys need this extra step
-                
-                return id;
+                // create_key_node_only() has registered the key already
+                return create_key_node_only(where, name, std::move(val), untyped);
             }
         );
     }
@@ -975,16 +1320,12 @@ namespace nuno
         value v,
         bool untyped)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<key_id>(
             anchor,
             [this, name, val = std::move(v), untyped](category_id where) mutable {
-                key_id id = create_key_node_only(where, name, std::move(val), untyped);
-                if (!valid(id)) return id;
-                
-                auto* cat = doc_.get_node(where);
-                cat->keys.push_back(id);  // Keys need this extra step
-                
-                return id;
+                // create_key_node_only() has registered the key already
+                return create_key_node_only(where, name, std::move(val), untyped);
             }
         );
     }
@@ -995,6 +1336,7 @@ namespace nuno
         std::vector<value> arr,
         bool untyped)
     {
+        journal_scope scope(doc_);
         auto* cat = doc_.get_node(where);
         if (!cat)
             return invalid_id<key_tag>();
@@ -1049,7 +1391,7 @@ namespace nuno
         }
 
         // Set up key value
-        kn.value.val           = std::move(typed_arr);
+        kn.value.val           = typed_array(std::move(typed_arr));
         kn.value.type          = array_type;
         kn.value.type_source   = kn.type_source;
         kn.value.origin        = value_locus::key_value;
@@ -1067,8 +1409,8 @@ namespace nuno
         }
 
         doc_.keys_.push_back(std::move(kn));
-        cat->keys.push_back(id);
-        cat->ordered_items.push_back(document::source_item_ref{id});
+        doc_.ids_push_back(*cat, id);
+        doc_.items_push_back(*cat, {id});
 
         return id;
     }
@@ -1080,6 +1422,7 @@ namespace nuno
         std::vector<value> arr,
         bool untyped)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<key_id>(
             anchor,
             [this, name, array = std::move(arr), untyped](category_id where) mutable {
@@ -1137,7 +1480,7 @@ namespace nuno
                 }
 
                 // Set up key value
-                kn.value.val           = std::move(typed_arr);
+                kn.value.val           = typed_array(std::move(typed_arr));
                 kn.value.type          = array_type;
                 kn.value.type_source   = kn.type_source;
                 kn.value.origin        = value_locus::key_value;
@@ -1154,7 +1497,7 @@ namespace nuno
                 }
 
                 doc_.keys_.push_back(std::move(kn));
-                cat->keys.push_back(id);
+                doc_.ids_push_back(*cat, id);
                 
                 return id;
             }
@@ -1168,6 +1511,7 @@ namespace nuno
         std::vector<value> arr,
         bool untyped)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<key_id>(
             anchor,
             [this, name, array = std::move(arr), untyped](category_id where) mutable {
@@ -1219,7 +1563,7 @@ namespace nuno
                     typed_arr.push_back(std::move(elem));
                 }
 
-                kn.value.val           = std::move(typed_arr);
+                kn.value.val           = typed_array(std::move(typed_arr));
                 kn.value.type          = array_type;
                 kn.value.type_source   = kn.type_source;
                 kn.value.origin        = value_locus::key_value;
@@ -1236,7 +1580,7 @@ namespace nuno
                 }
 
                 doc_.keys_.push_back(std::move(kn));
-                cat->keys.push_back(id);
+                doc_.ids_push_back(*cat, id);
                 
                 return id;
             }
@@ -1245,30 +1589,24 @@ namespace nuno
 
     bool editor::erase_key(key_id id)
     {
-        auto* kn = doc_.get_node(id);
+        journal_scope scope(doc_);
+        auto* kn = doc_.peek_node(id);
         if (!kn) return false;
 
         auto* cat = doc_.get_node(kn->owner);
         if (!cat) return false;
 
         // Remove contamination source if present
-        doc_.request_clear_contamination(id);
+        doc_.drop_contamination_source(id);
 
         // ordered_items
-        std::erase_if(cat->ordered_items, [&](auto const& r)
-        {
-            return std::holds_alternative<key_id>(r.id)
-                && std::get<key_id>(r.id) == id;
-        });
+        with_item_holder(kn->owner, {id}, [&](auto& holder) { return doc_.items_erase(holder, {id}); });
 
         // category key list
-        std::erase_if(cat->keys, [&](auto const& kid) {return kid == id;});
+        doc_.ids_erase(*cat, id);
 
         // key storage
-        auto& keys = doc_.keys_;
-        keys.erase(
-            std::ranges::find_if(keys, [&](auto const& k){return k.id == id;})
-        );
+        doc_.erase_node(id);
 
         return true;
     }
@@ -1276,6 +1614,7 @@ namespace nuno
 
     inline void editor::set_key_value(key_id key, value val)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(key);
         if (!kn) return;
         
@@ -1314,6 +1653,7 @@ namespace nuno
 
     inline void editor::set_key_value(key_id key, std::vector<value> arr)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(key);
         if (!kn) return;
 
@@ -1365,7 +1705,7 @@ namespace nuno
         }
 
         // Replace value
-        tv.val           = std::move(typed_arr);
+        tv.val           = typed_array(std::move(typed_arr));
         tv.type          = array_type;
         tv.type_source   = kn->type_source;
         tv.origin        = value_locus::key_value;
@@ -1408,14 +1748,15 @@ namespace nuno
         column_id col,
         value val)
     {
+        journal_scope scope(doc_);
         auto* rn = doc_.get_node(row);
         if (!rn) return;
         
-        auto* tbl = doc_.get_node(rn->table);
+        auto* tbl = doc_.peek_node(rn->table);
         if (!tbl) return;
         
         // Find column to determine expected type
-        auto* cn = doc_.get_node(col);
+        auto* cn = doc_.peek_node(col);
         if (!cn) return;
         
         auto col_it = std::ranges::find(tbl->columns, col);
@@ -1428,7 +1769,7 @@ namespace nuno
         
         if (!is_array(cell)) return;
         
-        auto& arr = std::get<std::vector<typed_value>>(cell.val);
+        auto& arr = std::get<typed_array>(cell.val);
         
         // Create element with validation
         typed_value elem = make_array_element(
@@ -1457,10 +1798,11 @@ namespace nuno
         size_t index,
         value val)
     {
+        journal_scope scope(doc_);
         auto* rn = doc_.get_node(row);
         if (!rn) return;
         
-        auto* tbl = doc_.get_node(rn->table);
+        auto* tbl = doc_.peek_node(rn->table);
         if (!tbl) return;
         
         auto col_it = std::ranges::find(tbl->columns, col);
@@ -1472,7 +1814,7 @@ namespace nuno
         auto& cell = rn->cells[col_idx];
         if (!is_array(cell)) return;
         
-        auto& arr = std::get<std::vector<typed_value>>(cell.val);
+        auto& arr = std::get<typed_array>(cell.val);
         if (index >= arr.size()) return;
         
         // Create replacement element
@@ -1482,7 +1824,7 @@ namespace nuno
             value_locus::table_cell
         );
         
-        arr[index] = std::move(elem);
+        arr.set(index, std::move(elem));
         
         // Re-evaluate contamination
         update_array_and_check(
@@ -1501,10 +1843,11 @@ namespace nuno
         column_id col,
         std::vector<value> vals)
     {
+        journal_scope scope(doc_);
         auto* rn = doc_.get_node(row);
         if (!rn) return;
         
-        auto* tbl = doc_.get_node(rn->table);
+        auto* tbl = doc_.peek_node(rn->table);
         if (!tbl) return;
         
         auto col_it = std::ranges::find(tbl->columns, col);
@@ -1531,7 +1874,7 @@ namespace nuno
         }
         
         // Replace entire array
-        cell.val = std::move(new_arr);
+        cell.val = typed_array(std::move(new_arr));
         
         // Re-evaluate contamination
         update_array_and_check(
@@ -1550,10 +1893,11 @@ namespace nuno
         column_id col,
         size_t index)
     {
+        journal_scope scope(doc_);
         auto* rn = doc_.get_node(row);
         if (!rn) return;
         
-        auto* tbl = doc_.get_node(rn->table);
+        auto* tbl = doc_.peek_node(rn->table);
         if (!tbl) return;
         
         auto col_it = std::ranges::find(tbl->columns, col);
@@ -1565,10 +1909,10 @@ namespace nuno
         auto& cell = rn->cells[col_idx];
         if (!is_array(cell)) return;
         
-        auto& arr = std::get<std::vector<typed_value>>(cell.val);
+        auto& arr = std::get<typed_array>(cell.val);
         if (index >= arr.size()) return;
         
-        arr.erase(arr.begin() + index);
+        arr.erase(index);
         
         // Re-evaluate contamination (might clear if removed element was invalid)
         update_array_and_check(
@@ -1590,6 +1934,7 @@ namespace nuno
         table_id table,
         std::vector<value> cells)
     {
+        journal_scope scope(doc_);
         auto* tbl = doc_.get_node(table);
         if (!tbl) 
             return invalid_id<row_tag>();
@@ -1607,7 +1952,7 @@ namespace nuno
 
         for (size_t i = 0; i < tbl->columns.size(); ++i)
         {
-            auto* col = doc_.get_node(tbl->columns[i]);
+            auto* col = doc_.peek_node(tbl->columns[i]);
             if (!col)
                 return invalid_id<row_tag>(); // structural corruption
 
@@ -1618,54 +1963,254 @@ namespace nuno
             else
                 tv.val = value{}; // default/empty
 
-            tv.origin   = value_locus::table_cell;
-            tv.creation = creation_state::generated;
-            tv.is_edited = false;
+            if (!init_table_cell(tv, col->_type()))
+                row_has_invalid = true;
+
+            rn.cells.push_back(std::move(tv));
+        }
+
+        rn.contamination = contamination_state::clean;
+
+        std::optional<row_id> last;
+        if (!tbl->rows.empty())
+            last = tbl->rows.back();
+
+        doc_.rows_.push_back(std::move(rn));
+        doc_.ids_push_back(*tbl, id);
+        list_after_rows(*tbl, last, {id});
+
+        // The node must be in storage before it can be registered
+        if (row_has_invalid)
+            doc_.mark_row_contaminated(id);
+
+        return id;
+    }
+
+    inline bool editor::init_table_cell(typed_value& tv, value_type declared_type)
+    {
+        tv.origin        = value_locus::table_cell;
+        tv.creation      = creation_state::generated;
+        tv.is_edited     = false;
+        tv.contamination = contamination_state::clean;
+        tv.type          = tv.held_type();
+
+        if (declared_type == value_type::unresolved)
+        {
+            tv.semantic    = semantic_state::valid;
+            tv.type_source = type_ascription::tacit;
+            return true;
+        }
+
+        if (tv.type != declared_type)
+        {
+            tv.semantic    = semantic_state::invalid;
+            tv.type_source = type_ascription::tacit;
+            return false;
+        }
+
+        tv.semantic    = semantic_state::valid;
+        tv.type_source = type_ascription::declared;
+        return true;
+    }
+
+    template<typename Fill>
+    row_id editor::append_rows_impl(table_id table, size_t count, Fill&& fill)
+    {
+        auto* tbl = doc_.get_node(table);
+        if (!tbl || count == 0 || tbl->columns.empty())
+            return invalid_id<row_tag>();
+
+        // Resolve column types once for the whole block
+        std::vector<value_type> types;
+        types.reserve(tbl->columns.size());
+        for (auto cid : tbl->columns)
+        {
+            auto* col = doc_.peek_node(cid);
+            if (!col)
+                return invalid_id<row_tag>(); // structural corruption
+            types.push_back(col->_type());
+        }
+
+        auto grow = [count](auto& vec)
+        {
+            size_t need = vec.size() + count;
+            if (vec.capacity() < need)
+                vec.reserve(std::max(need, vec.capacity() * 2));
+        };
+
+        doc_.rows_.reserve(doc_.rows_.size() + count);
+        grow(tbl->rows);
+        tbl->ordered_items.reserve(tbl->ordered_items.size() + count);
+
+        size_t first_index = doc_.rows_.size();
+        row_id first = doc_.next_row_id_;
+
+        std::vector<row_id> ids;
+        ids.reserve(count);
+
+        std::optional<row_id> last;
+        if (!tbl->rows.empty())
+            last = tbl->rows.back();
+
+        for (size_t r = 0; r < count; ++r)
+        {
+            document::row_node rn;
+            rn.id    = doc_.create_row_id();
+            rn.table = table;
+            rn.owner = tbl->owner;
+            rn.contamination = contamination_state::clean;
+            rn.cells.resize(types.size());
+
+            ids.push_back(rn.id);
+            list_after_rows(*tbl, last, {rn.id});
+            last = rn.id;
+            doc_.rows_.push_back(std::move(rn));
+        }
+
+        doc_.ids_insert(*tbl, tbl->rows.size(), std::span<const row_id>(ids));
+
+        fill(first_index, std::span<const value_type>(types));
+
+        // Register invalid rows directly and refresh the table and its
+        // category chain once for the whole block.
+        batch settle(*this);
 
-            value_type declared_type = col->_type();
+        for (size_t i = first_index; i < doc_.rows_.size(); ++i)
+        {
+            auto& rn = doc_.rows_[i];
+            bool invalid = std::ranges::any_of(rn.cells, [](auto const& c) { return c.semantic == semantic_state::invalid; });
+            if (!invalid) continue;
+
+            rn.contamination = contamination_state::contaminated;
+            if (doc_.contaminated_source_rows_.insert(rn.id))
+                doc_.count_source(table, true);
+        }
+
+        return first;
+    }
+
+    inline row_id editor::append_rows(table_id table, std::span<const value> cells)
+    {
+        journal_scope scope(doc_);
+        auto* tbl = doc_.peek_node(table);
+        if (!tbl || tbl->columns.empty())
+            return invalid_id<row_tag>();
 
-            tv.type = tv.held_type();
+        size_t cols  = tbl->columns.size();
+        size_t count = (cells.size() + cols - 1) / cols;
 
-            if (declared_type != value_type::unresolved)
+        return append_rows_impl(table, count, [&](size_t first, std::span<const value_type> types)
+        {
+            for (size_t r = 0; r < count; ++r)
             {
-                if (tv.type != declared_type)
+                auto& row = doc_.rows_[first + r].cells;
+                for (size_t c = 0; c < cols; ++c)
                 {
-                    tv.semantic = semantic_state::invalid;
-                    tv.type_source = type_ascription::tacit;
-                    row_has_invalid = true;
-                }
-                else
-                {
-                    tv.semantic = semantic_state::valid;
-                    tv.type_source = type_ascription::declared;
+                    size_t i = r * cols + c;
+                    if (i < cells.size())
+                        row[c].val = cells[i];
+                    init_table_cell(row[c], types[c]);
                 }
             }
-            else
+        });
+    }
+
+    inline row_id editor::append_rows(table_id table, std::span<const column_cells> columns)
+    {
+        journal_scope scope(doc_);
+        auto* tbl = doc_.peek_node(table);
+        if (!tbl)
+            return invalid_id<row_tag>();
+
+        size_t count = 0;
+        for (auto const& col : columns)
+            count = std::max(count, std::visit([](auto s) { return s.size(); }, col));
+
+        return append_rows_impl(table, count, [&](size_t first, std::span<const value_type> types)
+        {
+            for (size_t c = 0; c < types.size(); ++c)
             {
-                tv.semantic = semantic_state::valid;
-                tv.type_source = type_ascription::tacit;
+                // One visit per column; the row loop is monomorphic
+                auto fill_column = [&](auto src)
+                {
+                    for (size_t r = 0; r < count; ++r)
+                    {
+                        auto& cell = doc_.rows_[first + r].cells[c];
+                        if (r < src.size())
+                            cell.val = value(src[r]);
+                        init_table_cell(cell, types[c]);
+                    }
+                };
+
+                if (c < columns.size())
+                    std::visit(fill_column, columns[c]);
+                else
+                    fill_column(std::span<const value>{});
             }
+        });
+    }
 
-            tv.contamination = contamination_state::clean;
+    template<typename Source>
+    row_id editor::insert_rows_impl(row_id anchor, Source source, insert_direction dir)
+    {
+        auto* an = doc_.peek_node(anchor);
+        if (!an) return invalid_id<row_tag>();
 
-            rn.cells.push_back(std::move(tv));
-        }
+        table_id table = an->table;
+        auto* tbl = doc_.get_node(table);
+        if (!tbl) return invalid_id<row_tag>();
 
-        if (row_has_invalid)
-        {
-            rn.contamination = contamination_state::contaminated;
-            doc_.mark_row_contaminated(id);
-        }
-        else
+        size_t before = tbl->rows.size();
+
+        row_id first = append_rows(table, source);
+        if (!valid(first)) return first;
+
+        // Relink the appended block next to the anchor, keeping its order.
+        // Appended rows have consecutive IDs.
+        size_t count = tbl->rows.size() - before;
+        document::source_item_ref at{anchor};
+        for (size_t i = 0; i < count; ++i)
         {
-            rn.contamination = contamination_state::clean;
+            row_id rid{first.val + i};
+            if (dir == insert_direction::before)
+                doc_.items_move_before(*tbl, {rid}, {anchor});
+            else
+            {
+                doc_.items_move_after(*tbl, {rid}, at);
+                at = {rid};
+            }
         }
 
-        doc_.rows_.push_back(std::move(rn));
-        tbl->rows.push_back(id);
-        tbl->ordered_items.push_back({id});
+        // Splice the block into the semantic collection in one move
+        size_t pos = tbl->rows.position(anchor);
+        if (dir == insert_direction::after) ++pos;
+        doc_.ids_move<row_id>(*tbl, before, count, pos);
 
-        return id;
+        return first;
+    }
+
+    inline row_id editor::insert_rows_before(row_id anchor, std::span<const value> cells)
+    {
+        journal_scope scope(doc_);
+        return insert_rows_impl(anchor, cells, insert_direction::before);
+    }
+
+    inline row_id editor::insert_rows_before(row_id anchor, std::span<const column_cells> columns)
+    {
+        journal_scope scope(doc_);
+        return insert_rows_impl(anchor, columns, insert_direction::before);
+    }
+
+    inline row_id editor::insert_rows_after(row_id anchor, std::span<const value> cells)
+    {
+        journal_scope scope(doc_);
+        return insert_rows_impl(anchor, cells, insert_direction::after);
+    }
+
+    inline row_id editor::insert_rows_after(row_id anchor, std::span<const column_cells> columns)
+    {
+        journal_scope scope(doc_);
+        return insert_rows_impl(anchor, columns, insert_direction::after);
     }
 
     template<typename Tag>
@@ -1677,40 +2222,18 @@ namespace nuno
         if constexpr (!std::is_same_v<Tag, row_tag>)
             return invalid_id<row_tag>();
 
-        auto* anchor_node = doc_.get_node(anchor);
+        auto* anchor_node = doc_.peek_node(anchor);
         if (!anchor_node) return invalid_id<row_tag>();
 
         table_id table = anchor_node->table;
-        auto* tbl = doc_.get_node(table);
+        auto* tbl = doc_.peek_node(table);
         if (!tbl) return invalid_id<row_tag>();
 
         row_id new_id = append_row(table, std::move(cells));
         if (!valid(new_id)) return new_id;
 
-        // Remove auto-appended entry
-        std::erase(tbl->rows, new_id);
-        std::erase_if(tbl->ordered_items, [&](auto const& r) {
-            return std::holds_alternative<row_id>(r.id)
-                && std::get<row_id>(r.id) == new_id;
-        });
-
-        // Find anchor position
-        auto it = std::ranges::find_if(tbl->ordered_items, [&](auto const& r) {
-            return std::holds_alternative<row_id>(r.id)
-                && std::get<row_id>(r.id) == anchor;
-        });
-
-        auto row_it = std::ranges::find(tbl->rows, anchor);
-
-        // Insert based on direction
-        if (dir == insert_direction::after)
-        {
-            if (row_it != tbl->rows.end()) ++row_it;
-            if (it != tbl->ordered_items.end()) ++it;
-        }
-
-        tbl->rows.insert(row_it, new_id);
-        tbl->ordered_items.insert(it, {new_id});
+        // Relink the auto-appended entry next to the anchor
+        move_row_impl(new_id, anchor, dir);
 
         return new_id;
     }
@@ -1720,6 +2243,7 @@ namespace nuno
         id<Tag> anchor,
         std::vector<value> cells)
     {
+        journal_scope scope(doc_);
         return insert_row_impl(anchor, std::move(cells), insert_direction::before);
     }
 
@@ -1728,12 +2252,14 @@ namespace nuno
         id<Tag> anchor,
         std::vector<value> cells)
     {
+        journal_scope scope(doc_);
         return insert_row_impl(anchor, std::move(cells), insert_direction::after);
     }
     
     bool editor::erase_column(column_id id)
     {
-        auto* cn = doc_.get_node(id);
+        journal_scope scope(doc_);
+        auto* cn = doc_.peek_node(id);
         if (!cn) return false;
         
         auto* tbl = doc_.get_node(cn->table);
@@ -1779,10 +2305,10 @@ namespace nuno
         }
         
         // Remove column from table
-        tbl->columns.erase(col_it);
+        doc_.ids_erase(*tbl, id);
         
         // Remove column node
-        std::erase_if(doc_.columns_, [&](auto& c) { return c._id() == id; });
+        doc_.erase_node(id);
         
         return true;
     }
@@ -1793,11 +2319,12 @@ namespace nuno
         std::optional<value_type> declared_type
     )
     {
+        journal_scope scope(doc_);
         auto* tbl = doc_.get_node(table_id);
         if (!tbl) return invalid_id<column_tag>();
 
         column_id cid = create_column_node_only(table_id, name, declared_type);
-        tbl->columns.push_back(cid);
+        doc_.ids_push_back(*tbl, cid);
 
         for (auto rid : tbl->rows) 
         {
@@ -1827,7 +2354,8 @@ namespace nuno
         std::string_view name, 
         std::optional<value_type> declared_type )
     {
-        auto* anchor_node = doc_.get_node(anchor);
+        journal_scope scope(doc_);
+        auto* anchor_node = doc_.peek_node(anchor);
         if (!anchor_node) return invalid_id<column_tag>();
 
         table_id owner = anchor_node->table;
@@ -1837,8 +2365,8 @@ namespace nuno
         column_id cid = create_column_node_only(owner, name, declared_type);
 
         auto it = std::ranges::find(tbl->columns, anchor);
-        auto ins_it = tbl->columns.insert(it, cid);
-        auto dist = std::distance(tbl->columns.begin(), ins_it);
+        auto dist = std::distance(tbl->columns.begin(), it);
+        doc_.ids_insert(*tbl, static_cast<size_t>(dist), cid);
 
         for (auto rid : tbl->rows) 
         {
@@ -1870,7 +2398,8 @@ namespace nuno
         std::string_view name, 
         std::optional<value_type> declared_type )
     {
-        auto* anchor_node = doc_.get_node(anchor);
+        journal_scope scope(doc_);
+        auto* anchor_node = doc_.peek_node(anchor);
         if (!anchor_node) return invalid_id<column_tag>();
 
         table_id owner = anchor_node->table;
@@ -1881,8 +2410,8 @@ namespace nuno
 
         auto it = std::ranges::find(tbl->columns, anchor);
         if (it != tbl->columns.end()) ++it;
-        auto ins_it = tbl->columns.insert(it, cid);
-        auto dist = std::distance(tbl->columns.begin(), ins_it);
+        auto dist = std::distance(tbl->columns.begin(), it);
+        doc_.ids_insert(*tbl, static_cast<size_t>(dist), cid);
 
         for (auto rid : tbl->rows) 
         {
@@ -1914,10 +2443,11 @@ namespace nuno
         column_id col,
         value val)
     {
+        journal_scope scope(doc_);
         auto* rn = doc_.get_node(row);
         if (!rn) return;
 
-        auto* tbl = doc_.get_node(rn->table);
+        auto* tbl = doc_.peek_node(rn->table);
         if (!tbl) return;
 
         auto col_it = std::ranges::find(tbl->columns, col);
@@ -1926,7 +2456,7 @@ namespace nuno
         size_t idx = std::distance(tbl->columns.begin(), col_it);
         if (idx >= rn->cells.size()) return;
 
-        auto* cn = doc_.get_node(col);
+        auto* cn = doc_.peek_node(col);
         if (!cn) return;
 
         auto& cell = rn->cells[idx];
@@ -1964,10 +2494,11 @@ namespace nuno
         column_id col,
         std::vector<value> arr)
     {
+        journal_scope scope(doc_);
         auto* rn = doc_.get_node(row);
         if (!rn) return;
 
-        auto* tbl = doc_.get_node(rn->table);
+        auto* tbl = doc_.peek_node(rn->table);
         if (!tbl) return;
 
         auto col_it = std::ranges::find(tbl->columns, col);
@@ -1976,7 +2507,7 @@ namespace nuno
         size_t idx = std::distance(tbl->columns.begin(), col_it);
         if (idx >= rn->cells.size()) return;
 
-        auto* cn = doc_.get_node(col);
+        auto* cn = doc_.peek_node(col);
         if (!cn) return;
 
         auto& cell = rn->cells[idx];
@@ -2012,7 +2543,7 @@ namespace nuno
             typed_arr.push_back(std::move(elem));
         }
 
-        cell.val         = std::move(typed_arr);
+        cell.val         = typed_array(std::move(typed_arr));
         cell.type        = expected_array_type;
         cell.origin      = value_locus::table_cell;
         cell.creation    = creation_state::generated;
@@ -2033,70 +2564,65 @@ namespace nuno
 
     bool editor::erase_row(row_id id)
     {
-        auto* rn = doc_.get_node(id);
+        journal_scope scope(doc_);
+        auto* rn = doc_.peek_node(id);
         if (!rn) return false;
 
         auto* tbl = doc_.get_node(rn->table);
         if (!tbl) return false;
 
-        doc_.request_clear_contamination(id);
+        doc_.drop_contamination_source(id);
 
-        std::erase_if(tbl->ordered_items, [&](auto const& r)
-        {
-            return std::holds_alternative<row_id>(r.id)
-                && std::get<row_id>(r.id) == id;
-        });
+        doc_.items_erase(*tbl, {id});
 
-        std::erase_if(tbl->rows, [&](auto const& rid) {return rid == id;});
+        doc_.ids_erase(*tbl, id);
 
-        auto& rows = doc_.rows_;
-        rows.erase(
-            std::ranges::find_if(rows, [&](auto const& r){return r.id == id;})
-        );
+        doc_.erase_node(id);
 
         return true;
     }
 
     inline bool editor::erase_table(table_id id)
     {
-        auto* tbl = doc_.get_node(id);
+        journal_scope scope(doc_);
+        auto* tbl = doc_.peek_node(id);
         if (!tbl) return false;
 
         auto* cat = doc_.get_node(tbl->owner);
         if (!cat) return false;
 
+        // Items written after the table (keys, later tables, subcategories,
+        // comments) are listed by it rather than by the category
+        std::vector<document::source_item_ref> later;
+        for (auto const& item : tbl->ordered_items)
+            if (!std::holds_alternative<row_id>(item.id))
+                later.push_back(item);
+
         // 1. Erase rows (they may be contamination sources)
         for (auto rid : tbl->rows)
         {
-            doc_.request_clear_contamination(rid);
-
-            std::erase_if(cat->ordered_items, [&](auto const& r)
-            {
-                return std::holds_alternative<row_id>(r.id)
-                    && std::get<row_id>(r.id) == rid;
-            });
-
-            std::erase_if(doc_.rows_, [&](auto & r){return r.id == rid;});
+            doc_.drop_contamination_source(rid);
+            doc_.erase_node(rid);
         }
 
         // 2. Erase columns
         for (auto cid : tbl->columns)
-            std::erase_if(doc_.columns_, [&](auto & c){return c._id() == cid;});
+            doc_.erase_node(cid);
 
-        // 3. Remove table from category
-        std::erase(cat->tables, id);
+        // 3. Remove table from category. The items it listed take its
+        //    place in the list that holds it: the category's own, or
+        //    that of a table written before it.
+        doc_.ids_erase(*cat, id);
 
-        std::erase_if(cat->ordered_items, [&](auto const& r)
+        with_item_holder(tbl->owner, {id}, [&](auto& holder)
         {
-            return std::holds_alternative<table_id>(r.id)
-                && std::get<table_id>(r.id) == id;
+            for (auto const& item : later)
+                doc_.items_insert_before(holder, {id}, item);
+            return doc_.items_erase(holder, {id});
         });
 
         // 4. Remove table storage
-        std::erase_if(doc_.tables_, [&](auto & t){return t.id == id;});
-
-        // 5. Remove contamination from owning category
-        doc_.try_clear_category_contamination(cat->id);
+        doc_.erase_node(id);
 
         return true;
     }
@@ -2105,6 +2631,7 @@ namespace nuno
         category_id where,
         std::vector<std::string> column_names)
     {
+        journal_scope scope(doc_);
         std::vector<std::pair<std::string, std::optional<value_type>>> cols;
         cols.reserve(column_names.size());
 
@@ -2118,11 +2645,12 @@ namespace nuno
         category_id where,
         std::vector<std::pair<std::string, std::optional<value_type>>> columns)
     {
+        journal_scope scope(doc_);
         table_id id = create_table_node_only(where, std::move(columns));
         if (!valid(id)) return id;
 
         auto* cat = doc_.get_node(where);
-        cat->ordered_items.push_back({id});
+        doc_.items_push_back(*cat, {id});
 
         return id;
     }
@@ -2132,6 +2660,7 @@ namespace nuno
         id<Tag> anchor,
         std::vector<std::string> column_names)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<table_id>(
             anchor,
             [this, cols = std::move(column_names)](category_id where) mutable {
@@ -2149,6 +2678,7 @@ namespace nuno
         id<Tag> anchor,
         std::vector<std::string> column_names)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<table_id>(
             anchor,
             [this, cols = std::move(column_names)](category_id where) mutable {
@@ -2166,6 +2696,7 @@ namespace nuno
         id<Tag> anchor,
         std::vector<std::pair<std::string, std::optional<value_type>>> columns)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<table_id>(
             anchor,
             [this, cols = std::move(columns)](category_id where) mutable {
@@ -2179,6 +2710,7 @@ namespace nuno
         id<Tag> anchor,
         std::vector<std::pair<std::string, std::optional<value_type>>> columns)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<table_id>(
             anchor,
             [this, cols = std::move(columns)](category_id where) mutable {
@@ -2195,17 +2727,19 @@ namespace nuno
         category_id where,
         std::string_view text)
     {
+        journal_scope scope(doc_);
         comment_id id = create_comment_node_only(where, text);
         if (!valid(id)) return id;
 
         auto* cat = doc_.get_node(where);
-        cat->ordered_items.push_back({id});
+        doc_.items_push_back(*cat, {id});
 
         return id;
     }
 
     inline void editor::set_comment(comment_id id, std::string_view text)
     {
+        journal_scope scope(doc_);
         auto* cn = doc_.get_node(id);
         if (!cn) return;
 
@@ -2216,12 +2750,14 @@ namespace nuno
 
     inline bool editor::erase_comment(comment_id id)
     {
-        return erase_category_child(id, doc_.comments_);
+        journal_scope scope(doc_);
+        return erase_category_child(id);
     }
 
     template<typename K>
     inline comment_id editor::insert_comment_before(id<K> anchor, std::string_view text)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<comment_id>(
             anchor,
             [this, text](category_id where) {
@@ -2233,6 +2769,7 @@ namespace nuno
     template<typename K>
     inline comment_id editor::insert_comment_after(id<K> anchor, std::string_view text)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<comment_id>(
             anchor,
             [this, text](category_id where) {
@@ -2249,17 +2786,19 @@ namespace nuno
         category_id where,
         std::string_view text)
     {
+        journal_scope scope(doc_);
         paragraph_id id = create_paragraph_node_only(where, text);
         if (!valid(id)) return id;
 
         auto* cat = doc_.get_node(where);
-        cat->ordered_items.push_back({id});
+        doc_.items_push_back(*cat, {id});
 
         return id;
     }
 
     inline void editor::set_paragraph(paragraph_id id, std::string_view text)
     {
+        journal_scope scope(doc_);
         auto* pn = doc_.get_node(id);
         if (!pn) return;
 
@@ -2270,12 +2809,14 @@ namespace nuno
 
     inline bool editor::erase_paragraph(paragraph_id id)
     {
-        return erase_category_child(id, doc_.paragraphs_);
+        journal_scope scope(doc_);
+        return erase_category_child(id);
     }
 
     template<typename K>
     inline paragraph_id editor::insert_paragraph_before(id<K> anchor, std::string_view text)
     {
+        journal_scope scope(doc_);
         return insert_category_child_before_impl<paragraph_id>(
             anchor,
             [this, text](category_id where) {
@@ -2287,6 +2828,7 @@ namespace nuno
     template<typename K>
     inline paragraph_id editor::insert_paragraph_after(id<K> anchor, std::string_view text)
     {
+        journal_scope scope(doc_);
         return insert_category_child_after_impl<paragraph_id>(
             anchor,
             [this, text](category_id where) {
@@ -2304,6 +2846,7 @@ namespace nuno
         value_type type,
         type_ascription ascription)
     {
+        journal_scope scope(doc_);
         auto* kn = doc_.get_node(id);
         if (!kn) return false;
 
@@ -2336,7 +2879,7 @@ namespace nuno
                 else
                 {
                     // Check all elements against new array element type
-                    auto& arr = std::get<std::vector<typed_value>>(tv.val);
+                    auto& arr = std::get<typed_array>(tv.val);
                     value_type expected_elem_type = detail::array_element_type(type);
 
                     for (auto& elem : arr)
@@ -2351,6 +2894,7 @@ namespace nuno
                             elem.semantic = semantic_state::valid;
                         }
                     }
+                    arr.compact();
                 }
             }
             else
@@ -2391,10 +2935,11 @@ namespace nuno
         value_type type,
         type_ascription ascription)
     {
+        journal_scope scope(doc_);
         auto* cn = doc_.get_node(id);
         if (!cn) return false;
 
-        auto* tbl = doc_.get_node(cn->table);
+        auto* tbl = doc_.peek_node(cn->table);
         if (!tbl) return false;
 
         auto col_it = std::ranges::find(tbl->columns, id);
@@ -2433,7 +2978,7 @@ namespace nuno
                     }
                     else
                     {
-                        auto& arr = std::get<std::vector<typed_value>>(cell.val);
+                        auto& arr = std::get<typed_array>(cell.val);
                         value_type expected_elem_type = detail::array_element_type(type);
 
                         for (auto& elem : arr)
@@ -2448,6 +2993,7 @@ namespace nuno
                                 elem.semantic = semantic_state::valid;
                             }
                         }
+                        arr.compact();
                     }
                 }
                 else
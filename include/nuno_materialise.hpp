@@ -21,11 +21,9 @@
 #include <ranges>
 #include <unordered_map>
 
-#include <iostream>
-
 namespace nuno
 {
-    #define DBG_EMIT std::cout << "[M] "
+    #define DBG_EMIT NUNO_TRACE_STREAM("[M] ")
 
     //#define TRACE_CONTAM(where, x) \
     //    DBG_EMIT << where << ": semantic=" << int(x.semantic) \
@@ -35,6 +33,7 @@ namespace nuno
     {
         bool own_parser_data {true}; // Document will assume ownership of the parser data. Without it the serialiser will not be able to output the original format.
         size_t max_category_depth {64};
+        metrics_sink* metrics {nullptr}; // receives materialise_metrics, see nuno_metrics.hpp
     //--Debug options
         bool echo_lines  {false}; // prints each CST parser event to be handled
         bool echo_errors {false}; // prints each logged error 
@@ -90,10 +89,17 @@ namespace nuno
     struct materialiser
     {
         materialiser(const parse_context& ctx, materialiser_options opts);  // Non-owning
+        materialiser(parse_context&& ctx, materialiser_options opts);       // Owning
 
         material_context run();
 
     private:
+        materialiser(std::shared_ptr<parse_context> owned, const parse_context* ctx, materialiser_options opts);
+
+        // Parser data taken over by the document. While it is held
+        // here, row cells are moved out of its CST instead of copied.
+        std::shared_ptr<parse_context> owned_;
+
         // Immutable input
         const parse_context& ctx_;
         const cst_document&  cst_;
@@ -115,6 +121,8 @@ namespace nuno
 
 
         // Helpers
+        void reserve_storage();
+        std::string take_literal(row_id rid, size_t cell, typed_value & target);
         void insert_source_item(document::source_id id);
         document::table_node * find_table(table_id tid);
         document::category_node * find_category(category_id cid);
@@ -130,12 +138,14 @@ namespace nuno
         void log_err( semantic_error_kind what, std::string_view msg, source_location loc )
         {
             out_.errors.push_back({ what, loc, std::string(msg) });
-            if (opts_.echo_errors)
+            NUNO_TRACE_IF(opts_.echo_errors)
                 DBG_EMIT << "Error #" << std::to_string(static_cast<int>(what)) 
                         << ": " << semantic_error_string[static_cast<size_t>(what)] 
                         << ". Message: " << msg << "\n";
         }
 
+        void report_metrics(metrics_sink& sink, size_t propagations, std::chrono::nanoseconds elapsed);
+
         bool row_is_valid(document::row_node const& r);
         bool table_is_valid(document::table_node const& t, document const& doc);
     };
@@ -320,13 +330,8 @@ namespace
 
     inline bool array_has_invalid_elements(const typed_value& tv)
     {
-        if (!std::holds_alternative<std::vector<typed_value>>(tv.val))
-            return false;
-
-        auto const& elems = std::get<std::vector<typed_value>>(tv.val);
-        for (auto const& e : elems)
-            if (e.semantic == semantic_state::invalid)
-                return true;
+        if (auto arr = std::get_if<typed_array>(&tv.val))
+            return arr->any_invalid();
 
         return false;
     }
@@ -346,8 +351,7 @@ namespace
         tv.semantic    = semantic_state::valid;
         tv.creation    = creation_state::authored;
 
-        tv.val = std::vector<typed_value>{};
-        auto& values = std::get<std::vector<typed_value>>(tv.val);
+        typed_array values;     // packed as the elements arrive
 
         const bool want_int   = declared_type == value_type::integer_array;
         const bool want_float = declared_type == value_type::floating_point_array;
@@ -459,6 +463,10 @@ namespace
             values.push_back(std::move(elem));
         }
 
+        // Odd elements early on may have expanded the array
+        values.compact();
+        tv.val = std::move(values);
+
         if (array_contaminated)
         {
             tv.contamination = contamination_state::contaminated;
@@ -475,7 +483,7 @@ namespace
     }
 
     inline typed_value coerce_cell(
-        std::string_view literal,
+        std::string literal,
         value_type column_type,
         source_location loc,
         material_context & ctx
@@ -490,7 +498,7 @@ namespace
             column_type == value_type::string)
         {
             tv.type = value_type::string;
-            tv.val  = std::string(literal);
+            tv.val  = std::move(literal);
             return tv;
         }
 
@@ -500,7 +508,7 @@ namespace
         {
             // Degrade to string
             tv.type     = value_type::string;
-            tv.val      = std::string(literal);
+            tv.val      = std::move(literal);
             tv.semantic = semantic_state::invalid;
             return tv;
         }
@@ -579,20 +587,75 @@ namespace
 
     inline materialiser::materialiser(const parse_context& ctx,
                                       materialiser_options opts)
-        : ctx_(ctx)
-        , cst_(ctx.document)
+        : materialiser(nullptr, &ctx, opts)
+    {
+    }
+
+    inline materialiser::materialiser(parse_context&& ctx,
+                                      materialiser_options opts)
+        : materialiser(std::make_shared<parse_context>(std::move(ctx)), nullptr, opts)
+    {
+    }
+
+    inline materialiser::materialiser(std::shared_ptr<parse_context> owned,
+                                      const parse_context* ctx,
+                                      materialiser_options opts)
+        : owned_(std::move(owned))
+        , ctx_(owned_ ? *owned_ : *ctx)
+        , cst_(ctx_.document)
         , out_{}
         , doc_(out_.document)
         , opts_(opts)
         , active_table_(std::nullopt)
     {
         cst_to_doc_category_.resize(cst_.categories.size());
+        reserve_storage();
         category_id root = doc_.create_root();
         stack_.push_back(root);
     }
 
+    // The CST holds exact entity counts, so every store is sized once
+    // instead of growing event by event.
+    inline void materialiser::reserve_storage()
+    {
+        size_t columns = 0;
+        for (auto const& t : cst_.tables)
+            columns += t.columns.size();
+
+        size_t comments = 0, paragraphs = 0;
+        for (auto const& ev : cst_.events)
+        {
+            comments   += ev.kind == parse_event_kind::comment;
+            paragraphs += ev.kind == parse_event_kind::paragraph;
+        }
+
+        doc_.categories_.reserve(cst_.categories.size() + 1);
+        doc_.tables_.reserve(cst_.tables.size());
+        doc_.columns_.reserve(columns);
+        doc_.rows_.reserve(cst_.rows.size());
+        doc_.keys_.reserve(cst_.keys.size());
+        doc_.comments_.reserve(comments);
+        doc_.paragraphs_.reserve(paragraphs);
+    }
+
+    inline std::string materialiser::take_literal(row_id rid, size_t cell, typed_value & target)
+    {
+        // An owned cell already sits in the row; its string moves out
+        if (owned_)
+        {
+            if (auto* s = std::get_if<std::string>(&target.val))
+                return std::move(*s);
+            return target.value_to_string();
+        }
+
+        return cst_.rows[rid.val].cells[cell].value_to_string();
+    }
+
     inline material_context materialiser::run()
     {
+        auto* sink = detail::active_sink(opts_.metrics);
+        auto started = sink ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
         for (size_t i = 0; i < cst_.events.size(); ++i)
         {
             const auto& ev = cst_.events[i];
@@ -600,64 +663,70 @@ namespace
             switch (ev.kind)
             {
                 case parse_event_kind::category_open:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": category_open = " << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": category_open = " << ev.text << "\"" << std::endl;
                     handle_category_open(ev, i);
                     break;
 
                 case parse_event_kind::category_close:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": category_close = " << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": category_close = " << ev.text << "\"" << std::endl;
                     handle_category_close(ev, i);
                     break;
 
                 case parse_event_kind::table_header:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": table_header = " << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": table_header = " << ev.text << "\"" << std::endl;
                     handle_table_header(ev, i);
                     break;
 
                 case parse_event_kind::table_row:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": table_row = " << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": table_row = " << ev.text << "\"" << std::endl;
                     handle_table_row(ev, i);
                     break;
 
                 case parse_event_kind::key_value:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": key_value = " << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": key_value = " << ev.text << "\"" << std::endl;
                     handle_key(ev, i);
                     break;
 
                 case parse_event_kind::comment:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": comment \"" << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": comment \"" << ev.text << "\"" << std::endl;
                     handle_comment(ev, i);
                     break;
 
                 case parse_event_kind::paragraph:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << ": paragraph \"" << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << ": paragraph \"" << ev.text << "\"" << std::endl;
                     handle_paragraph(ev, i);
                     break;
 
                 default:
-                    if (opts_.echo_lines) DBG_EMIT << "event " << i << " unknown, skipped = " << ev.text << "\"" << std::endl;
+                    NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "event " << i << " unknown, skipped = " << ev.text << "\"" << std::endl;
                     break;
             }
         }
 
         if (opts_.own_parser_data)
         {
-            // Transfer ownership via move
-            out_.document.source_context_ = 
-                // This works, which is a bit surprising.
-                std::make_unique<parse_context>(std::move(ctx_));
-                // I had expected the const-ness of ctx_ to require:
-                //std::make_unique<parse_context>(std::move(const_cast<parse_context&>(ctx_)));
+            // Parser data handed over at construction moves in; data
+            // borrowed from the caller has to be copied.
+            out_.document.source_context_ = owned_
+                ? std::move(owned_)
+                : std::make_shared<parse_context>(ctx_);
         }
                 
         // Register contamination sources
+        size_t propagations = 0;
         for (auto const& key : doc_.keys_)
             if (key.contamination == contamination_state::contaminated)
+            {
                 doc_.mark_key_contaminated(key.id);
+                ++propagations;
+            }
 
         for (auto const& row : doc_.rows_)
             if (row.contamination == contamination_state::contaminated)
+            {
                 doc_.mark_row_contaminated(row.id);
+                ++propagations;
+            }
 
         if (!doc_.categories_.empty())  doc_.next_category_id_  = doc_.categories_.back().id + 1;
         if (!doc_.columns_.empty())     doc_.next_column_id_    = doc_.columns_.back()._id() + 1;
@@ -667,9 +736,35 @@ namespace
         if (!doc_.rows_.empty())        doc_.next_row_id_       = doc_.rows_.back().id + 1;
         if (!doc_.tables_.empty())      doc_.next_table_id_     = doc_.tables_.back().id + 1;
 
+        if (sink)
+            report_metrics(*sink, propagations, std::chrono::steady_clock::now() - started);
+
         return std::move(out_);
     }
 
+    // Value types are tallied from the finished document and failures
+    // from the error log, so that the coercion paths carry no counters
+    inline void materialiser::report_metrics(metrics_sink& sink, size_t propagations, std::chrono::nanoseconds elapsed)
+    {
+        materialise_metrics m;
+        m.elapsed                    = elapsed;
+        m.contamination_propagations = propagations;
+        m.errors                     = out_.errors.size();
+
+        for (auto const& key : doc_.keys_)
+            ++m.value_types[static_cast<size_t>(key.value.type)];
+
+        for (auto const& row : doc_.rows_)
+            for (auto const& cell : row.cells)
+                ++m.value_types[static_cast<size_t>(cell.type)];
+
+        for (auto const& e : out_.errors)
+            if (e.kind == semantic_error_kind::type_mismatch)
+                ++m.conversion_failures;
+
+        sink.on_materialise(m);
+    }
+
     inline void materialiser::handle_category_open(const parse_event& ev, size_t parse_idx)
     {
         auto cid = std::get<category_id>(ev.target);
@@ -713,9 +808,9 @@ namespace
         category_id parent  = stack_.back();
 
         category_id doc_id = doc_.create_category(cid, cst_cat.name, parent);
-        if (opts_.echo_lines) DBG_EMIT << "created category id: " << cid.val << ", name: " << cst_cat.name << std::endl;
+        NUNO_TRACE_IF(opts_.echo_lines) DBG_EMIT << "created category id: " << cid.val << ", name: " << cst_cat.name << std::endl;
 
-        auto it = std::ranges::find_if(doc_.categories_, [doc_id](document::category_node const &cat){return cat.id.val == doc_id.val;});
+        auto it = doc_.find_node_by_id(doc_.categories_, doc_id);
         assert (it != doc_.categories_.end());
 
         it->source_event_index_open = parse_idx;        
@@ -755,8 +850,7 @@ namespace
                 stack_.rend(),
                 [&](category_id cid)
                 {
-                    decltype(document::categories_)::iterator it;
-                    it = std::ranges::find_if(doc_.categories_, [cid](document::category_node const &cat){return cat.id.val == cid.val;});
+                    auto it = std::as_const(doc_).find_node_by_id(std::as_const(doc_.categories_), cid);
                     if (it != doc_.categories_.end())
                         return it->name == name;
                     return false;
@@ -771,7 +865,7 @@ namespace
                 return;
             }
 
-            auto cat_it = std::ranges::find_if(doc_.categories_, [cid = *it](document::category_node const &cat){return cat.id.val == cid.val;});
+            auto cat_it = doc_.find_node_by_id(doc_.categories_, *it);
             assert (cat_it != doc_.categories_.end());
             cat_it->source_event_index_close = parse_idx;
 
@@ -808,7 +902,7 @@ namespace
                 return;
             }
 
-            auto cat_it = std::ranges::find_if(doc_.categories_, [closing](document::category_node const &cat){return cat.id.val == closing.val;});
+            auto cat_it = doc_.find_node_by_id(doc_.categories_, closing);
             assert (cat_it != doc_.categories_.end());
             cat_it->source_event_index_close = parse_idx;
 
@@ -830,7 +924,8 @@ namespace
         tbl.creation = creation_state::authored;
         tbl.owner    = stack_.back();
         tbl.source_event_index = parse_idx;
-        tbl.rows.clear();
+        tbl.rows.reserve(cst_tbl.rows.size());
+        tbl.columns.reserve(cst_tbl.columns.size());
 
         for (const auto& cst_col : cst_tbl.columns)
         {
@@ -858,28 +953,22 @@ namespace
 
                     col.type = value_type::string; // collapse
                     col.semantic = semantic_state::invalid;
-                    tbl.contamination = contamination_state::contaminated;
                 }
                 else
                 {
                     col.type = *vt;
                     if (s == "date")
-                    {
                         col.semantic = semantic_state::invalid;
-                        tbl.contamination = contamination_state::contaminated;
-                    }
                 }
 
-                if (tbl.contamination == contamination_state::contaminated)
-                    doc_.propagate_contamination_up_category_chain(col_.owner);
             }
             else
             {
                 col.type = value_type::unresolved;
             }
 
-            doc_.columns_.push_back(col_);
             tbl.columns.push_back(col_.col.id);
+            doc_.columns_.push_back(std::move(col_));
         }
 
         // Store the table
@@ -927,7 +1016,13 @@ namespace
         row.semantic           = semantic_state::valid;
         row.contamination      = contamination_state::clean;        
         row.source_event_index = parse_idx;
-        row.cells.reserve(tbl.columns.size());
+
+        // Owned parser data hands its cell vector over to the row, and each
+        // cell is converted in place; borrowed data is copied cell by cell.
+        if (owned_)
+            row.cells = std::move(owned_->document.rows[rid.val].cells);
+        else
+            row.cells.resize(tbl.columns.size());
 
         // Column invalidity contaminates the row
         for (auto const& col_id : tbl.columns)
@@ -946,14 +1041,9 @@ namespace
             auto it = doc_.find_node_by_id(doc_.columns_, tbl.columns[i]);
             assert (it != doc_.columns_.end());
             auto & col = it->col;
+            auto & tv  = row.cells[i];
 
-            std::string literal =
-                (i < cst_row.cells.size())
-                    ? cst_row.cells[i].value_to_string()//std::string_view(cst_row.cells[i].source_literal.value())
-                    : "";
-
-            typed_value tv;
-            tv.origin = value_locus::table_cell;
+            std::string literal = take_literal(rid, i, tv);
 
             if (col.type == value_type::string_array ||
                 col.type == value_type::integer_array ||
@@ -963,10 +1053,8 @@ namespace
             }
             else
             {
-                tv = coerce_cell(literal, col.type, ev.loc, out_);
+                tv = coerce_cell(std::move(literal), col.type, ev.loc, out_);
             }
-
-            row.cells.push_back(std::move(tv));
         }
 
         // Cell or array invalidity contaminates the row
@@ -1059,17 +1147,9 @@ namespace
             k.contamination = contamination_state::contaminated;
         else if (target_is_array)
         {
-            for (auto& elem : std::get<std::vector<typed_value>>(tv.val))
-            {
-                elem.creation = creation_state::authored;
-
-                if (elem.semantic == semantic_state::invalid ||
-                    elem.contamination == contamination_state::contaminated)
-                {
-                    k.contamination = contamination_state::contaminated;
-                    break;
-                }
-            }
+            auto const& arr = std::get<typed_array>(tv.val);
+            if (arr.any_invalid() || arr.any_contaminated())
+                k.contamination = contamination_state::contaminated;
         }
 
         k.type  = tv.type;
@@ -1079,7 +1159,7 @@ namespace
         doc_.keys_.emplace_back(std::move(k));
         auto& key = doc_.keys_[id.val];
         
-        auto it = std::ranges::find_if(doc_.categories_, [&](auto const & c){return c.id.val == key.owner.val;});
+        auto it = doc_.find_node_by_id(doc_.categories_, key.owner);
         assert (it != doc_.categories_.end() && "Category doesn't exist");
         auto & cat = *it;
 
@@ -1089,17 +1169,13 @@ namespace
 
     document::table_node * materialiser::find_table(table_id tid)
     {
-        for (auto & t : doc_.tables_)
-            if (t.id == tid)
-                return &t;
-        return nullptr;
+        auto it = doc_.find_node_by_id(doc_.tables_, tid);
+        return it != doc_.tables_.end() ? &*it : nullptr;
     }
     document::category_node * materialiser::find_category(category_id cid)
     {
-        for (auto & c : doc_.categories_)
-            if (c.id == cid)
-                return &c;
-        return nullptr;
+        auto it = doc_.find_node_by_id(doc_.categories_, cid);
+        return it != doc_.categories_.end() ? &*it : nullptr;
     }
 
     void materialiser::insert_source_item(document::source_id id)  // Takes the variant directly
@@ -1129,7 +1205,7 @@ namespace
         
         doc_.comments_.push_back(std::move(cn));
         
-        if (opts_.echo_lines)
+        NUNO_TRACE_IF(opts_.echo_lines)
             DBG_EMIT << "Created comment_id{" << cid.val << "} with text: \"" << ev.text << "\"\n";
         
         insert_source_item(cid);
@@ -1148,7 +1224,7 @@ namespace
         
         doc_.paragraphs_.push_back(std::move(pn));
         
-        if (opts_.echo_lines)
+        NUNO_TRACE_IF(opts_.echo_lines)
             DBG_EMIT << "Created paragraph_id{" << pid.val << "} with text: \"" << ev.text << "\"\n";
         
         insert_source_item(pid);
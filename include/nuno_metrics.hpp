@@ -0,0 +1,220 @@
+// nuno_metrics.hpp - A Readable Format (NUNO) - Stage instrumentation
+// Version 0.3.0
+// Copyright 2025 Mikael Ueno A
+// Licenced as-is under the MIT licence.
+
+//========================================================================
+// Parsing, materialisation and serialization can report what they did
+// to a metrics_sink given in their options (the `metrics` member of
+// parser_options, materialiser_options and serializer_options). Each
+// stage gathers its figures while it runs and hands them over once, at
+// its end, so a sink sees one call per stage run.
+//
+// With no sink set a stage only tests the pointer; clocks are not read
+// and no figures are gathered. Defining NUNO_NO_METRICS removes even
+// that test: the sink is then ignored at compile time.
+//
+// load() passes the materialiser's sink on to the parser when the
+// parser options have none of their own, so that one sink set on
+// materialiser_options sees the whole load.
+//
+// A load_cache reports each lookup to the same sink. A hit restores the
+// document without running either stage, so it is the only report a
+// cached load makes.
+//========================================================================
+
+#ifndef NUNO_METRICS_HPP
+#define NUNO_METRICS_HPP
+
+#include "nuno_core.hpp"
+#include <array>
+#include <chrono>
+#include <streambuf>
+
+namespace nuno
+{
+    enum class parse_event_kind;
+
+#if defined(NUNO_NO_METRICS)
+    inline constexpr bool metrics_enabled = false;
+#else
+    inline constexpr bool metrics_enabled = true;
+#endif
+
+//========================================================================
+// Stage metrics
+//========================================================================
+
+    struct parse_metrics
+    {
+        std::chrono::nanoseconds elapsed {0};
+        size_t bytes_scanned {0};
+        size_t lines         {0};
+        size_t errors        {0};
+        std::array<size_t, 7> events {};    // indexed by parse_event_kind
+
+        size_t count(parse_event_kind kind) const { return events[static_cast<size_t>(kind)]; }
+    };
+
+    struct materialise_metrics
+    {
+        std::chrono::nanoseconds elapsed {0};
+
+        // Key values and table cells, by the type they resolved to.
+        // Values that failed to convert are counted as strings.
+        std::array<size_t, 9> value_types {}; // indexed by value_type
+
+        size_t conversion_failures        {0}; // literals that did not convert to their declared type
+        size_t contamination_propagations {0}; // keys and rows propagating contamination upward
+        size_t errors                     {0};
+
+        size_t values_of(value_type type) const { return value_types[static_cast<size_t>(type)]; }
+    };
+
+    // floating_point_array is the last value_type
+    static_assert(std::tuple_size_v<decltype(materialise_metrics::value_types)> == static_cast<size_t>(value_type::floating_point_array) + 1,
+                  "materialise_metrics::value_types needs one slot per value_type");
+
+    struct serialize_metrics
+    {
+        std::chrono::nanoseconds elapsed {0};
+        size_t bytes_written {0};
+    };
+
+    // One lookup counts either a hit or a miss. On a miss the parser and
+    // materialiser report their own runs as usual.
+    struct cache_metrics
+    {
+        std::chrono::nanoseconds elapsed {0}; // reading and restoring the image; zero on a miss
+        size_t hits       {0};
+        size_t misses     {0};
+        size_t bytes_read {0};                // image bytes restored on hits
+    };
+
+//========================================================================
+// Sinks
+//========================================================================
+
+    // Receives the metrics of each stage run. Override the stages of
+    // interest; the others ignore their figures. Calls come from the
+    // thread running the stage.
+    class metrics_sink
+    {
+    public:
+        virtual ~metrics_sink() = default;
+
+        virtual void on_parse(parse_metrics const&) {}
+        virtual void on_materialise(materialise_metrics const&) {}
+        virtual void on_serialize(serialize_metrics const&) {}
+        virtual void on_cache(cache_metrics const&) {}
+    };
+
+    // Sums the metrics of every run it receives. Not synchronised; give
+    // each thread its own recorder and merge them when exporting.
+    class metrics_recorder : public metrics_sink
+    {
+    public:
+        size_t parses           {0};
+        size_t materialisations {0};
+        size_t serializations   {0};
+        size_t cache_lookups    {0};
+
+        parse_metrics       parse;
+        materialise_metrics materialise;
+        serialize_metrics   serialize;
+        cache_metrics       cache;
+
+        void on_parse(parse_metrics const& m) override
+        {
+            ++parses;
+            parse.elapsed       += m.elapsed;
+            parse.bytes_scanned += m.bytes_scanned;
+            parse.lines         += m.lines;
+            parse.errors        += m.errors;
+            for (size_t i = 0; i < m.events.size(); ++i)
+                parse.events[i] += m.events[i];
+        }
+
+        void on_materialise(materialise_metrics const& m) override
+        {
+            ++materialisations;
+            materialise.elapsed                    += m.elapsed;
+            materialise.conversion_failures        += m.conversion_failures;
+            materialise.contamination_propagations += m.contamination_propagations;
+            materialise.errors                     += m.errors;
+            for (size_t i = 0; i < m.value_types.size(); ++i)
+                materialise.value_types[i] += m.value_types[i];
+        }
+
+        void on_serialize(serialize_metrics const& m) override
+        {
+            ++serializations;
+            serialize.elapsed       += m.elapsed;
+            serialize.bytes_written += m.bytes_written;
+        }
+
+        void on_cache(cache_metrics const& m) override
+        {
+            ++cache_lookups;
+            cache.elapsed    += m.elapsed;
+            cache.hits       += m.hits;
+            cache.misses     += m.misses;
+            cache.bytes_read += m.bytes_read;
+        }
+
+        void reset() { *this = metrics_recorder{}; }
+    };
+
+//========================================================================
+// Implementation details
+//========================================================================
+
+    namespace detail
+    {
+        // The sink a stage reports to; always null under NUNO_NO_METRICS so
+        // that the reporting code folds away.
+        inline metrics_sink* active_sink(metrics_sink* sink) noexcept
+        {
+            if constexpr (metrics_enabled)
+                return sink;
+            else
+                return nullptr;
+        }
+
+        // Forwards to another stream buffer, counting the bytes passed on
+        class counting_streambuf : public std::streambuf
+        {
+        public:
+            explicit counting_streambuf(std::streambuf* target) : target_(target) {}
+
+            size_t count() const noexcept { return count_; }
+
+        protected:
+            int_type overflow(int_type ch) override
+            {
+                if (traits_type::eq_int_type(ch, traits_type::eof()))
+                    return traits_type::not_eof(ch);
+                if (traits_type::eq_int_type(target_->sputc(traits_type::to_char_type(ch)), traits_type::eof()))
+                    return traits_type::eof();
+                ++count_;
+                return ch;
+            }
+
+            std::streamsize xsputn(const char* s, std::streamsize n) override
+            {
+                auto written = target_->sputn(s, n);
+                count_ += static_cast<size_t>(written);
+                return written;
+            }
+
+            int sync() override { return target_->pubsync(); }
+
+        private:
+            std::streambuf* target_;
+            size_t          count_ {0};
+        };
+    }
+
+} // namespace nuno
+
+#endif // NUNO_METRICS_HPP
@@ -7,14 +7,14 @@
 #define NUNO_PARSER_HPP
 
 #include "nuno_core.hpp"
+#include "nuno_metrics.hpp"
 #include <assert.h>
 #include <cstdlib>
 #include <sstream>
-#include <iostream>
 
 namespace nuno 
 {
-    #define DBG_EMIT std::cout << "[P] "
+    #define DBG_EMIT NUNO_TRACE_STREAM("[P] ")
 
 //========================================================================
 // Structure and parsing
@@ -33,6 +33,8 @@ namespace nuno
         category_close
     };
 
+    static_assert(static_cast<size_t>(parse_event_kind::category_close) + 1 == std::tuple_size_v<decltype(parse_metrics::events)>);
+
     inline std::string_view to_string(parse_event_kind kind)
     {
         switch (kind)
@@ -105,6 +107,7 @@ namespace nuno
 
     struct parser_options
     {
+        metrics_sink* metrics {nullptr}; // receives parse_metrics, see nuno_metrics.hpp
         bool echo_lines {false};
     };
 
@@ -140,6 +143,7 @@ namespace nuno
             void flush_all_pending();
 
             void parse(std::string_view input, parser_options opt = {});
+            void report_metrics(metrics_sink& sink, size_t bytes, size_t lines, std::chrono::nanoseconds elapsed);
             void add_error(const std::string& message);
 
             std::vector<std::string> split_lines(const std::string& input);
@@ -164,6 +168,8 @@ namespace nuno
         void parser_impl::parse(std::string_view input, parser_options opt)
         {
             this->opt = opt;
+            auto* sink = active_sink(opt.metrics);
+            auto started = sink ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
             size_t line_no = 0;
             create_root_category();
             
@@ -181,7 +187,7 @@ namespace nuno
                 if (!line.empty() && line.back() == '\r')
                     line.remove_suffix(1);
 
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "Extracted: " << line << std::endl;
                     
                 parse_line(line, ++line_no);
@@ -195,6 +201,26 @@ namespace nuno
             
             // Flush any pending blobs at end of document
             flush_all_pending();            
+
+            if (sink)
+                report_metrics(*sink, input.size(), line_no, std::chrono::steady_clock::now() - started);
+        }
+
+//---------------------------------------------------------------------------        
+
+        // Event kinds are counted from the finished event spine rather
+        // than as events are pushed, so parsing without a sink is untouched
+        void parser_impl::report_metrics(metrics_sink& sink, size_t bytes, size_t lines, std::chrono::nanoseconds elapsed)
+        {
+            parse_metrics m;
+            m.elapsed       = elapsed;
+            m.bytes_scanned = bytes;
+            m.lines         = lines;
+            m.errors        = ctx.errors.size();
+            for (auto const& ev : ctx.document.events)
+                ++m.events[static_cast<size_t>(ev.kind)];
+
+            sink.on_parse(m);
         }
 
 //---------------------------------------------------------------------------        
@@ -252,7 +278,7 @@ namespace nuno
                     {
                         cells.push_back(std::string(trim_sv(current)));
 
-                        if (opt.echo_lines)
+                        NUNO_TRACE_IF(opt.echo_lines)
                             DBG_EMIT << "  - Split out item \"" << cells.back() << "\"" << std::endl;
                         
                         current.clear();
@@ -301,7 +327,7 @@ namespace nuno
             }
             ev.text = std::move(blob);
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding comment \"" << ev.text << "\" as event #" << ctx.document.events.size() << std::endl;
             
             ctx.document.events.push_back(ev);
@@ -330,7 +356,7 @@ namespace nuno
 
             ev.text = std::move(blob);
             
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding paragraph \"" << ev.text << "\" as event #" << ctx.document.events.size() << std::endl;
 
             ctx.document.events.push_back(ev);
@@ -351,7 +377,7 @@ namespace nuno
     {
         std::string_view trimmed = trim_sv(line);
 
-        if (opt.echo_lines)
+        NUNO_TRACE_IF(opt.echo_lines)
             DBG_EMIT << "Trimmed: " << trimmed << std::endl;
             
         // Empty lines become paragraphs
@@ -359,7 +385,7 @@ namespace nuno
         {
             flush_pending_comment();
         
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Pushing empty line to paragraph queue" << std::endl;
                 
             pending_paragraph_lines.push_back(std::string(line));
@@ -371,7 +397,7 @@ namespace nuno
         {
             flush_pending_paragraph();
         
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Pushing comment to queue" << std::endl;
 
             pending_comment_lines.push_back(std::string(line));
@@ -422,7 +448,7 @@ namespace nuno
             if (!key_value(ev))
             {
                 // Malformed key - treat as paragraph
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "Pushing malformed key to paragraph queue" << std::endl;
                 pending_paragraph_lines.push_back(std::string(line));
             }
@@ -436,7 +462,7 @@ namespace nuno
             if (!table_row(trimmed, ev))
             {
                 // Not a valid row - treat as paragraph
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "Pushing malformed row to paragraph queue" << std::endl;
                 pending_paragraph_lines.push_back(std::string(line));
             }
@@ -445,7 +471,7 @@ namespace nuno
 
         // Otherwise: paragraph (non-grammar text)
         flush_pending_comment();
-        if (opt.echo_lines)
+        NUNO_TRACE_IF(opt.echo_lines)
             DBG_EMIT << "Pushing paragraph to queue" << std::endl;
         pending_paragraph_lines.push_back(std::string(line));
     }
@@ -475,7 +501,7 @@ namespace nuno
             ev.kind   = parse_event_kind::category_open;
             ev.target = cat.id;
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding create subcategory " << cat.name << " as event #" << ctx.document.events.size() << std::endl;
 
             ctx.document.events.push_back(ev);
@@ -494,7 +520,7 @@ namespace nuno
                 // comment; keep separate.
                 flush_all_pending();
 
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "Converting illegal category close to comment: " << name << std::endl;
 
                 pending_comment_lines.push_back(std::string("// ") + std::string(ev.text));
@@ -504,7 +530,7 @@ namespace nuno
             // Named close: preserve the name as written
             if (!name.empty())
             {
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "Close named category " << name << std::endl;
 
                 ev.target = unresolved_name{name};
@@ -512,7 +538,7 @@ namespace nuno
                 return;
             }
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Close current subcategory " << std::endl;
 
             category_id closing = category_stack.back();
@@ -522,7 +548,7 @@ namespace nuno
 
             ev.target = closing;
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding close subcategory \"" << ev.text << "\" as event #" << ctx.document.events.size() << std::endl;
 
             ctx.document.events.push_back(ev);
@@ -533,7 +559,7 @@ namespace nuno
 
         void parser_impl::start_table(std::string_view header, parse_event& ev)
         {
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Starting table" << std::endl;
 
             table tbl;
@@ -553,7 +579,7 @@ namespace nuno
                     col.type_source = type_ascription::declared;
                     col.declared_type = std::string(trim_sv(c.substr(pos + 1)));
 
-                    if (opt.echo_lines)
+                    NUNO_TRACE_IF(opt.echo_lines)
                         DBG_EMIT << "Extracted column " << col.name << " of type " << *col.declared_type << std::endl;
                 }
                 else
@@ -562,17 +588,17 @@ namespace nuno
                     col.type = value_type::unresolved;
                     col.type_source = type_ascription::tacit;
 
-                    if (opt.echo_lines)
+                    NUNO_TRACE_IF(opt.echo_lines)
                         DBG_EMIT << "Extracted untyped column " << col.name << std::endl;
                 }
 
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "Adding column " << col.name << std::endl;
 
                 tbl.columns.push_back(col);
             }
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding table with ID " << tbl.id << std::endl;
 
             ctx.document.tables.push_back(tbl);
@@ -581,7 +607,7 @@ namespace nuno
             ev.kind   = parse_event_kind::table_header;
             ev.target = tbl.id;
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding table " << tbl.id << " as event #" << ctx.document.events.size() << std::endl;
 
             ctx.document.events.push_back(ev);
@@ -591,7 +617,7 @@ namespace nuno
 
         bool parser_impl::table_row(std::string_view text, parse_event& ev)
         {
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Starting row \"" << text << "\"" << std::endl;
 
             auto cells = split_table_cells(text);
@@ -617,7 +643,7 @@ namespace nuno
                         ? std::string(cells[i])
                         : std::string{};
 
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "  - Adding cell " << tv.value_to_string() << " of type " << detail::type_to_string(tv.type) << std::endl;
 
                 row.cells.push_back(tv);
@@ -629,7 +655,7 @@ namespace nuno
             ev.kind   = parse_event_kind::table_row;
             ev.target = row.id;
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding row with ID " << row.id << " as event #" << ctx.document.events.size() << std::endl;
 
             ctx.document.events.push_back(ev);
@@ -640,7 +666,7 @@ namespace nuno
 
         bool parser_impl::key_value(parse_event& ev)
         {
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Parsing key \"" << ev.text << "\"" << std::endl;
 
             active_table = invalid_id<table_tag>();
@@ -648,7 +674,7 @@ namespace nuno
             auto pos = ev.text.find('=');
             if (pos == std::string::npos)
             {
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "  - Key malformed" << std::endl;
 
                 return false;  // Malformed
@@ -666,14 +692,14 @@ namespace nuno
                 name = to_lower(lhs.substr(0, type_pos));
                 declared = std::string(trim_sv(lhs.substr(type_pos + 1)));
 
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "  - Key named \"" << name << "\" of type " << *declared << std::endl;
             }
             else
             {
                 name = to_lower(lhs);
 
-                if (opt.echo_lines)
+                NUNO_TRACE_IF(opt.echo_lines)
                     DBG_EMIT << "  - Untyped key named \"" << name << "\"" << std::endl;
             }
 
@@ -691,7 +717,7 @@ namespace nuno
             ev.kind   = parse_event_kind::key_value;
             ev.target = id;
 
-            if (opt.echo_lines)
+            NUNO_TRACE_IF(opt.echo_lines)
                 DBG_EMIT << "Adding key \"" << key.name << "\" with ID " << id << " as event #" << ctx.document.events.size() << std::endl;
 
             ctx.document.events.push_back(ev);
@@ -20,11 +20,15 @@
 #include "nuno_document.hpp"
 #include "nuno_reflect.hpp"
 
+#include <algorithm>
 #include <charconv>
 #include <concepts>
+#include <iterator>
+#include <mutex>
 #include <optional>
 #include <span>
 #include <string_view>
+#include <tuple>
 #include <vector>
 
 namespace nuno
@@ -35,6 +39,9 @@ namespace nuno
     template<typename T>
     struct query_result;
 
+    template<typename T>
+    class array_view;
+
 //======================================================================
 // Public API:
 // =====================================================================
@@ -87,6 +94,14 @@ namespace nuno
     query_result<std::vector<double>>       get_reals(const document& doc, std::string_view path) noexcept;
     query_result<std::vector<std::string>>  get_strings(const document& doc, std::string_view path) noexcept;
 
+// Borrowing extraction (no copies; results refer into the document and
+// are valid while it lives and is not edited)
+// ---------------------------------------------------------------------
+    query_result<std::string_view>               get_string_view(const document& doc, std::string_view path) noexcept;
+    query_result<array_view<int64_t>>            get_integers_view(const document& doc, std::string_view path) noexcept;
+    query_result<array_view<double>>             get_reals_view(const document& doc, std::string_view path) noexcept;
+    query_result<array_view<std::string_view>>   get_strings_view(const document& doc, std::string_view path) noexcept;
+
 // =====================================================================
 // Query issues
 // =====================================================================
@@ -150,6 +165,59 @@ namespace nuno
         const typed_value*         value_ptr { nullptr };
     };
 
+    // Per-row outcome of a column-wise extraction (see query_handle::into)
+    enum class cell_status : uint8_t
+    {
+        valid,      // the cell holds a value of the requested type
+        missing,    // the row's table has no such column, or the cell is unresolved
+        invalid,    // the cell is invalid or holds another type
+    };
+
+    // Element types yielded by the borrowing and column-wise extractors
+    namespace details
+    {
+        template<typename T> struct element_traits;
+
+        template<> struct element_traits<int64_t>
+        {
+            static constexpr value_type element_type = value_type::integer;
+            static constexpr value_type array_type   = value_type::integer_array;
+            static int64_t get(typed_value const& tv) noexcept { return std::get<int64_t>(tv.val); }
+            static int64_t at(typed_array const& a, size_t i) { return a.integer_at(i); }
+            static std::span<int64_t const> buffer(typed_array const& a) noexcept { return a.integers(); }
+        };
+
+        template<> struct element_traits<double>
+        {
+            static constexpr value_type element_type = value_type::floating_point;
+            static constexpr value_type array_type   = value_type::floating_point_array;
+            static double get(typed_value const& tv) noexcept { return std::get<double>(tv.val); }
+            static double at(typed_array const& a, size_t i) { return a.real_at(i); }
+            static std::span<double const> buffer(typed_array const& a) noexcept { return a.reals(); }
+        };
+
+        template<> struct element_traits<std::string_view>
+        {
+            static constexpr value_type element_type = value_type::string;
+            static constexpr value_type array_type   = value_type::string_array;
+            static std::string_view get(typed_value const& tv) noexcept { return std::get<std::string>(tv.val); }
+            static std::string_view at(typed_array const& a, size_t i) { return a.string_at(i); }
+            static std::span<std::string_view const> buffer(typed_array const&) noexcept { return {}; }
+        };
+
+        template<> struct element_traits<bool>
+        {
+            static constexpr value_type element_type = value_type::boolean;
+            static bool get(typed_value const& tv) noexcept { return std::get<bool>(tv.val); }
+        };
+
+        template<typename T>
+        concept extractable_element = requires (typed_value const& tv)
+        {
+            { element_traits<T>::get(tv) } -> std::same_as<T>;
+        };
+    }
+
 // =====================================================================
 // to_string
 // =====================================================================
@@ -317,11 +385,32 @@ namespace nuno
 // Intended usage:
 //   query(...).table(0).rows().where(...).project("hp", "mp");
 //
+//
+// Column-wise extraction (bulk, into caller buffers)
+// ------------------------------------------------------------
+// into(name, span) / column_values<T>(name)
+//
+// Reads one column of every row in the working set straight from the
+// rows, without building a location per cell. Meant for filling
+// structure-of-arrays buffers:
+//   auto q = query(doc, "units.#0").where(eq("alive", true));
+//   damage.resize(q.row_count());
+//   q.into("damage", std::span(damage), status);
+//
 //-----------------------------------------------------------------------
+//
+// Thread safety: the selectors (select, rows, where, ...) mutate the
+// handle and need exclusive access. The const extraction functions may
+// be called concurrently on one handle; the issues they record are
+// appended, and a row or column left pending is resolved, under a lock.
+// Read issues() once those calls have returned.
+// Any number of handles may query the same document concurrently as
+// long as nothing edits it (see nuno_concurrency.hpp).
 
     class query_handle
     {
         template <typename T> friend struct query_result;        
+        friend class query_cache;
 
     public:
         struct axis_selection
@@ -337,7 +426,7 @@ namespace nuno
         // --------------------------------------------------------------
         // 1. Construction
         // --------------------------------------------------------------
-        explicit query_handle(const document& doc) noexcept : doc_(&doc) {}
+        explicit query_handle(const document& doc) noexcept : doc_(&doc), unscoped_(true) {}
 
         // --------------------------------------------------------------
         // 2. Path-based selection
@@ -372,6 +461,17 @@ namespace nuno
         // --------------------------------------------------------------
         query_handle& where(predicate pred);
 
+        // Keeps the key values, cells and array elements within the
+        // working set that hold exactly this value, as terminal values
+        // (see document::find_value). A handle with nothing applied yet
+        // searches the whole document: query(doc).where_value(4711). An
+        // empty working set gives an empty result.
+        query_handle& where_value(std::string_view value) { return where_value_(doc_->find_value(value)); }
+        query_handle& where_value(double value)           { return where_value_(doc_->find_value(value)); }
+
+        template<detail::strictly_integral T>
+        query_handle& where_value(T value) { return where_value_(doc_->find_value(value)); }
+
         template <std::convertible_to<std::string_view>... Names>
         query_handle& project(Names&&... names)
         {
@@ -409,7 +509,7 @@ namespace nuno
             if (locations_.empty()) return std::nullopt;
             
             reflect::inspect_context ictx{.doc = doc_};
-            auto insp = reflect::inspect(ictx, locations_.front().addr);
+            auto insp = reflect::locate(ictx, locations_.front().addr);
             
             if (!std::holds_alternative<document::view_for_t<Tag>>(insp.item))
                 return std::nullopt;
@@ -428,14 +528,55 @@ namespace nuno
         query_result<std::vector<double>>      as_reals() const noexcept;
         query_result<std::vector<std::string>> as_strings() const noexcept;
 
+        // Borrowing forms of the above. Nothing is copied or allocated;
+        // the results refer into the document.
+        query_result<std::string_view>             as_string_view() const noexcept;
+        query_result<array_view<int64_t>>          as_integers_view() const noexcept;
+        query_result<array_view<double>>           as_reals_view() const noexcept;
+        query_result<array_view<std::string_view>> as_strings_view() const noexcept;
+
+        // --------------------------------------------------------------
+        // 10. Column-wise extraction
+        // --------------------------------------------------------------
+        // Writes one named column of every row in the working set (tables,
+        // rows, or rows left by where()) into a contiguous buffer, in row
+        // order. T is int64_t, double, bool or std::string_view; a row whose
+        // cell is not a valid T gets T{} and, if a status buffer is given,
+        // the reason. Buffers must hold at least row_count() elements.
+        // Returns the number of rows written.
+        template<details::extractable_element T>
+        query_result<size_t> into(std::string_view column, std::span<T> out,
+                                  std::span<cell_status> status = {}) const noexcept;
+
+        // As into(), into a vector of row_count() elements
+        template<details::extractable_element T>
+        query_result<std::vector<T>> column_values(std::string_view column,
+                                                   std::vector<cell_status>* status = nullptr) const;
+
+        // Number of rows the working set covers
+        size_t row_count() const noexcept;
+
     private:
         const document*                   doc_ { nullptr };
         std::vector<value_location>       locations_;
         mutable std::vector<query_issue>  issues_;
         mutable std::vector<diagnostic>   diagnostics_;
         axis_selection                    pending_axis_;
+        bool                              unscoped_ { false };  // nothing applied yet, as query(doc) gives
+
+        // Guards issues_ and the resolution of a pending axis on the
+        // const path. Copies get their own lock.
+        struct issue_lock
+        {
+            std::mutex m;
+            issue_lock() = default;
+            issue_lock(issue_lock const&) noexcept {}
+            issue_lock& operator=(issue_lock const&) noexcept { return *this; }
+        };
+        mutable issue_lock                issue_lock_;
 
         void flush_pending_axis_();
+        void resolve_pending_axis_() const;
         bool all_locations_are(location_kind scope) const noexcept;
 
         // Note: may add ambiguity diagnostic to issues_ (mutable)
@@ -450,7 +591,16 @@ namespace nuno
         query_result<T>
         scalar_extract(bool convert) const noexcept;
 
+        template<typename T>
+        query_result<array_view<T>>
+        array_view_extract() const noexcept;
+
+        // Visits the rows in scope until fn returns false
+        template<typename Fn>
+        void for_each_row_(Fn&& fn) const;
+
         query_handle& project_impl(std::span<const std::string_view> column_names);
+        query_handle& where_value_(std::vector<document::value_occurrence> const& found);
         
         void report_issue(query_issue_kind kind, std::string_view context, size_t line = 0) const noexcept;
         void report_if_empty(query_issue_kind kind, std::string_view context, size_t line = 0) const noexcept;
@@ -544,6 +694,96 @@ namespace nuno
         const query_issue_kind& error() const { return error_value; }
     };    
 
+//======================================================================
+// array_view<T> - Borrowed view over the elements of an array value
+// =====================================================================
+//
+// Returned by the *_view extractors. Iterates the elements of an array
+// stored in the document and yields those of the requested type, which
+// is int64_t, double or std::string_view. Like the copying extractors,
+// elements that failed conversion are skipped.
+//
+// The view neither copies nor allocates; it must not outlive the
+// document nor be used after the array has been edited. Integer and
+// real arrays stored compactly (see typed_array) are also available
+// as a span through contiguous().
+//
+// Usage:
+//   if (auto weights = query(doc, "model.weights").as_reals_view())
+//       for (double w : *weights)
+//           total += w;
+//
+//----------------------------------------------------------------------
+    template<typename T>
+    class array_view
+    {
+        using element = details::element_traits<T>;
+
+    public:
+        using value_type = T;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = T;
+
+            iterator() = default;
+            iterator(typed_array const* array, size_t i) noexcept
+                : array_(array), i_(i) { skip(); }
+
+            T operator*() const { return element::at(*array_, i_); }
+
+            iterator& operator++() noexcept { ++i_; skip(); return *this; }
+            iterator  operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+            bool operator==(iterator const& o) const noexcept { return i_ == o.i_; }
+
+        private:
+            typed_array const* array_ { nullptr };
+            size_t             i_     { 0 };
+
+            void skip() noexcept
+            {
+                while (array_ && i_ < array_->size() && array_->type_at(i_) != element::element_type)
+                    ++i_;
+            }
+        };
+
+        array_view() = default;
+        explicit array_view(typed_array const& elements) noexcept : array_(&elements) {}
+
+        iterator begin() const noexcept { return { array_, 0 }; }
+        iterator end()   const noexcept { return { array_, array_ ? array_->size() : 0 }; }
+
+        // Number of elements yielded; linear, as skipped elements are not counted
+        size_t size() const noexcept { return static_cast<size_t>(std::distance(begin(), end())); }
+        bool   empty() const noexcept { return begin() == end(); }
+
+        // The elements as a contiguous buffer, when the array is stored
+        // compactly and every element is yielded; otherwise empty
+        std::span<T const> contiguous() const noexcept
+        {
+            if (!array_ || array_->aside_count() != 0)
+                return {};
+            auto buffer = element::buffer(*array_);
+            return buffer.size() == array_->size() ? buffer : std::span<T const>{};
+        }
+
+        // Elements as stored, including any that the iteration skips
+        typed_array const& elements() const noexcept
+        {
+            static const typed_array none;
+            return array_ ? *array_ : none;
+        }
+
+    private:
+        typed_array const* array_ { nullptr };
+    };
+
 // =====================================================================
 // DETAILS
 // =====================================================================
@@ -652,20 +892,15 @@ namespace nuno
                 filter_by_name = true;
             }
 
-            for (auto const& child : insp.structural_children(ctx))
+            for (auto const& child : insp.structural_children_range(ctx))
             {
                 if (child.kind != reflect::structural_child::kind::row)
                     continue;
 
-                auto child_addr = insp.extend_address(child);
-                
                 // If filtering by name, check it
                 if (filter_by_name)
                 {
-                    reflect::inspect_context row_ctx{ &doc };
-                    auto row_insp = reflect::inspect(row_ctx, child_addr);
-                    
-                    if (auto row_view = std::get_if<document::table_row_view>(&row_insp.item))
+                    if (auto row_view = std::get_if<document::table_row_view>(&child.item))
                     {
                         if (row_view->name() != row_name)
                             continue;  // Skip non-matching rows
@@ -673,7 +908,7 @@ namespace nuno
                 }
 
                 out.push_back({
-                    child_addr,
+                    insp.extend_address(child),
                     location_kind::row_scope,
                     nullptr
                 });
@@ -698,7 +933,7 @@ namespace nuno
                 ? extract_column_name(token) 
                 : token;
 
-            for (auto const& child : insp.structural_children(ctx))
+            for (auto const& child : insp.structural_children_range(ctx))
             {
                 if (child.kind != reflect::structural_child::kind::column)
                     continue;
@@ -706,15 +941,12 @@ namespace nuno
                 if (child.name != col_name)
                     continue;
 
-                auto child_addr = insp.extend_address(child);
-                auto child_insp = reflect::inspect(ctx, child_addr);
-
-                if (child_insp.value)
+                if (child.value)
                 {
                     out.push_back({
-                        child_addr,
+                        insp.extend_address(child),
                         location_kind::terminal_value,
-                        child_insp.value
+                        child.value
                     });
                 }
             }
@@ -734,7 +966,7 @@ namespace nuno
             reflect::inspect_context ctx{ &doc };
             auto insp = reflect::inspect(ctx, parent.addr);
             
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 if (child.kind != reflect::structural_child::kind::table)
                     continue;
@@ -799,7 +1031,7 @@ namespace nuno
                 // Bare "#" → all tables
                 if (token.size() == 1)
                 {
-                    for (const auto& child : insp.structural_children(ctx))
+                    for (const auto& child : insp.structural_children_range(ctx))
                     {
                         if (child.kind == reflect::structural_child::kind::table)
                         {
@@ -826,7 +1058,7 @@ namespace nuno
                 // Valid ordinal parsed - find matching table
                 if (ec == std::errc{} && ptr == ordinal_str.data() + ordinal_str.size())
                 {
-                    for (const auto& child : insp.structural_children(ctx))
+                    for (const auto& child : insp.structural_children_range(ctx))
                     {
                         using st = reflect::structural_child;
                         
@@ -850,41 +1082,25 @@ namespace nuno
             // ============================================================
             // Normal name-based matching
             // ============================================================
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 using st = reflect::structural_child;
                 
                 if (child.name != token)
                     continue;
 
+                // The child is already resolved; only its address is built
                 auto child_addr = insp.extend_address(child);
-                auto child_insp = reflect::inspect(ctx, child_addr);
 
-                // Keys: extract value manually
+                // Keys: the child carries the key's value
                 if (child.kind == st::kind::key)
                 {
-                    // Try to get key_view first
-                    if (auto key_view = std::get_if<document::key_view>(&child_insp.item))
-                    {
-                        out.push_back({
-                            child_addr,
-                            location_kind::terminal_value,
-                            &key_view->value()
-                        });
-                    }
-                    // For array keys, reflection stores the value directly
-                    else if (auto value_ptr = std::get_if<const typed_value*>(&child_insp.item))
-                    {
-                        out.push_back({
-                            child_addr,
-                            location_kind::terminal_value,
-                            *value_ptr
-                        });
-                    }
-                    else
-                    {
-                        assert(false && "only keys and arrays allowed");
-                    }                  
+                    assert(child.value && "keys resolve to their value");
+                    out.push_back({
+                        child_addr,
+                        location_kind::terminal_value,
+                        child.value
+                    });
                 }
                 // Tables (by name - rare but supported)
                 else if (child.kind == st::kind::table)
@@ -934,29 +1150,24 @@ namespace nuno
 
             size_t index = *index_opt;
 
+            // Only the selected element is referenced
+            auto const& elements = std::get<typed_array>(parent.value_ptr->val);
+            if (index >= elements.size())
+                return out;
+
             reflect::inspect_context ctx{ &doc };
             auto insp = reflect::inspect(ctx, parent.addr);
 
-            for (auto const& child : insp.structural_children(ctx))
-            {
-                if (child.kind != reflect::structural_child::kind::index)
-                    continue;
-
-                if (child.ordinal != index)
-                    continue;
-
-                auto child_addr = insp.extend_address(child);
-                auto child_insp = reflect::inspect(ctx, child_addr);
-
-                if (child_insp.value)
-                {
-                    out.push_back({
-                        child_addr,
-                        location_kind::terminal_value,
-                        child_insp.value
-                    });
-                }
-            }
+            out.push_back({
+                insp.extend_address({
+                    .kind    = reflect::structural_child::kind::index,
+                    .name    = {},
+                    .ordinal = index,
+                    .item    = {}
+                }),
+                location_kind::terminal_value,
+                &elements[index]
+            });
 
             return out;
         }
@@ -993,7 +1204,7 @@ namespace nuno
             reflect::inspect_context ctx{ &doc };
             auto insp = reflect::inspect(ctx, parent.addr);
 
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 if (child.kind != reflect::structural_child::kind::table)
                     continue;
@@ -1065,6 +1276,293 @@ namespace nuno
             return {};
         }
 
+    // --------------------------------------------------------------
+    // Glob matcher: * and **
+    // --------------------------------------------------------------
+    // A run of name and glob segments is matched against the category
+    // tree in one depth-first walk. The walk keeps a single address
+    // that grows and shrinks with it, and builds a location only for
+    // what matches; nothing is enumerated into intermediate working
+    // sets, and a subtree is entered only when a segment can match
+    // inside it. A name that follows a glob is looked up in an index of
+    // the category's members, built once per category by the walk.
+    //
+    //   *   any key or subcategory of the current category
+    //   **  the current category and every category below it
+    // --------------------------------------------------------------
+
+        inline bool is_glob(std::string_view token)
+        {
+            return token == "*" || token == "**";
+        }
+
+        // Segments a glob run may contain: names and globs. Table, row,
+        // column and index selectors end the run.
+        inline bool is_category_level(std::string_view token)
+        {
+            return !token.empty() &&
+                   !token.starts_with('#') &&
+                   !is_array_index(token) &&
+                   !is_row_selector(token) &&
+                   !is_column_selector(token);
+        }
+
+        class glob_matcher
+        {
+        public:
+            glob_matcher(const document& doc, std::span<const std::string_view> segments, working_set& out)
+                : doc_(doc), segments_(segments), out_(out)
+            {}
+
+            void run(const value_location& start)
+            {
+                if (start.kind != location_kind::category_scope)
+                    return;
+
+                reflect::inspect_context ctx{ &doc_ };
+                auto found = reflect::locate(ctx, start.addr);
+                auto cat   = std::get_if<document::category_view>(&found.item);
+                if (!cat || !found.ok(start.addr))
+                    return;
+
+                path_ = start.addr;
+                walk(*cat, 0);
+            }
+
+        private:
+            using member = std::variant<key_id, category_id>;
+
+            // A member of a category by name, at its place in authored order
+            struct named_member
+            {
+                std::string_view name;
+                size_t           place;
+                member           id;
+            };
+
+            // Where a category's members lie in names_, once indexed
+            struct name_slice
+            {
+                size_t first {0};
+                size_t count {npos()};
+            };
+
+            const document&                   doc_;
+            std::span<const std::string_view> segments_;
+            working_set&                      out_;
+            reflect::address                  path_;
+            std::vector<uint64_t>             visited_;   // bit per (category, segment) state reached by **
+            std::vector<named_member>         names_;     // per-category slices, by name then place
+            std::vector<name_slice>           indexed_;   // by category id
+
+            bool last(size_t seg) const noexcept { return seg + 1 == segments_.size(); }
+
+            // Marks a (category, segment) state, false if it was reached before
+            bool visit(category_id cat, size_t seg)
+            {
+                size_t bit  = static_cast<size_t>(cat) * segments_.size() + seg;
+                size_t word = bit / 64;
+                if (word >= visited_.size())
+                    visited_.resize(word + 1);
+
+                uint64_t mask = uint64_t{1} << (bit % 64);
+                if (visited_[word] & mask)
+                    return false;
+                visited_[word] |= mask;
+                return true;
+            }
+
+            void enter(document::category_view cat, document::category_view child, size_t seg)
+            {
+                if (cat.is_root()) path_.top(child.name());
+                else               path_.sub(child.name());
+
+                walk(child, seg);
+                path_.steps.pop_back();
+            }
+
+            void emit(document::key_view key)
+            {
+                path_.key(key.name());
+                out_.push_back({ path_, location_kind::terminal_value, &key.value() });
+                path_.steps.pop_back();
+            }
+
+            // Calls fn with the keys and subcategories of cat in authored
+            // order. Those opened after a table are listed by the table;
+            // any listed nowhere keep their place after the rest.
+            template<typename Fn>
+            void for_each_member(document::category_view cat, Fn&& fn) const
+            {
+                size_t listed = 0;
+                auto take = [&](document::source_id const& id)
+                {
+                    if (auto k = std::get_if<key_id>(&id))           { ++listed; fn(member{*k}); }
+                    else if (auto c = std::get_if<category_id>(&id)) { ++listed; fn(member{*c}); }
+                };
+
+                for (auto const& item : cat.node->ordered_items)
+                {
+                    if (auto t = std::get_if<table_id>(&item.id))
+                    {
+                        if (auto tbl = doc_.table(*t))
+                            for (auto const& row_item : tbl->node->ordered_items)
+                                take(row_item.id);
+                    }
+                    else
+                        take(item.id);
+                }
+
+                if (listed == cat.keys_count() + cat.children_count())
+                    return;
+
+                // Only documents whose order lists miss members get here
+                std::vector<member> seen;
+                seen.reserve(listed);
+                for (auto const& item : cat.node->ordered_items)
+                {
+                    auto note = [&seen](document::source_id const& id)
+                    {
+                        if (auto k = std::get_if<key_id>(&id))           seen.push_back(*k);
+                        else if (auto c = std::get_if<category_id>(&id)) seen.push_back(*c);
+                    };
+
+                    if (auto t = std::get_if<table_id>(&item.id))
+                    {
+                        if (auto tbl = doc_.table(*t))
+                            for (auto const& row_item : tbl->node->ordered_items)
+                                note(row_item.id);
+                    }
+                    else
+                        note(item.id);
+                }
+                std::ranges::sort(seen);
+
+                auto unseen = [&seen](member m) { return !std::ranges::binary_search(seen, m); };
+                for (auto k : cat.keys())     if (unseen(k)) fn(member{k});
+                for (auto c : cat.children()) if (unseen(c)) fn(member{c});
+            }
+
+            // The slice of names_ indexing cat's members, built on first use
+            name_slice index(document::category_view cat)
+            {
+                size_t slot = static_cast<size_t>(cat.id());
+                if (slot >= indexed_.size())
+                    indexed_.resize(slot + 1);
+                if (indexed_[slot].count != npos())
+                    return indexed_[slot];
+
+                size_t first = names_.size();
+                size_t place = 0;
+                for_each_member(cat, [&](member m)
+                {
+                    std::string_view name;
+                    if (auto k = std::get_if<key_id>(&m))
+                    {
+                        auto key = doc_.key(*k);
+                        if (!key) return;
+                        name = key->name();
+                    }
+                    else
+                    {
+                        auto child = doc_.category(std::get<category_id>(m));
+                        if (!child) return;
+                        name = child->name();
+                    }
+                    names_.push_back({ name, place++, m });
+                });
+
+                std::ranges::sort(names_.begin() + first, names_.end(), [](named_member const& l, named_member const& r)
+                    { return std::tie(l.name, l.place) < std::tie(r.name, r.place); });
+
+                indexed_[slot] = { first, names_.size() - first };
+                return indexed_[slot];
+            }
+
+            // A matching key is emitted or a matching subcategory entered
+            void take(document::category_view cat, member m, size_t seg)
+            {
+                if (auto k = std::get_if<key_id>(&m))
+                {
+                    if (auto key = doc_.key(*k); key && last(seg))
+                        emit(*key);
+                }
+                else if (auto child = doc_.category(std::get<category_id>(m)))
+                    enter(cat, *child, seg + 1);
+            }
+
+            // Matches in document order: the keys and subcategories of a
+            // category are taken as authored, each subcategory searched
+            // as it is reached
+            void walk(document::category_view cat, size_t seg)
+            {
+                if (seg == segments_.size())
+                {
+                    out_.push_back({ path_, location_kind::category_scope, nullptr });
+                    return;
+                }
+
+                // ** matches here and again in every subcategory
+                size_t deep = segments_.size();
+                if (segments_[seg] == "**")
+                {
+                    // Several ** can reach the same state by different routes
+                    if (!visit(cat.id(), seg))
+                        return;
+
+                    // Consecutive ** match as one
+                    if (seg + 1 < segments_.size() && segments_[seg + 1] == "**")
+                    {
+                        walk(cat, seg + 1);
+                        return;
+                    }
+
+                    deep = seg++;
+                    if (seg == segments_.size())
+                        out_.push_back({ path_, location_kind::category_scope, nullptr });
+                }
+
+                bool matching = seg < segments_.size();
+                auto token    = matching ? segments_[seg] : std::string_view{};
+                bool any      = token == "*";
+
+                // A name alone is looked up; only what it names is entered
+                if (matching && !any && deep == segments_.size())
+                {
+                    auto slice = index(cat);
+                    auto first = names_.begin() + slice.first;
+                    auto found = std::ranges::equal_range(first, first + slice.count, token, {}, &named_member::name);
+
+                    // names_ grows as the walk indexes deeper categories
+                    size_t from = found.begin() - names_.begin();
+                    size_t to   = found.end() - names_.begin();
+                    for (size_t i = from; i < to; ++i)
+                        take(cat, names_[i].id, seg);
+                    return;
+                }
+
+                for_each_member(cat, [&](member m)
+                {
+                    if (auto k = std::get_if<key_id>(&m))
+                    {
+                        // Keys have no named children, so they only match last
+                        auto key = doc_.key(*k);
+                        if (key && matching && last(seg) && (any || key->name() == token))
+                            emit(*key);
+                        return;
+                    }
+
+                    auto child = doc_.category(std::get<category_id>(m));
+                    if (!child)
+                        return;
+                    if (matching && (any || child->name() == token))
+                        enter(cat, *child, seg + 1);
+                    if (deep != segments_.size())
+                        enter(cat, *child, deep);
+                });
+            }
+        };
+
     // --------------------------------------------------------------
     // Core resolver loop
     // --------------------------------------------------------------
@@ -1090,7 +1588,7 @@ namespace nuno
                     if (axis.row && axis.column)
                     {
                         // Both row and column specified
-                        for (const auto& child : insp.structural_children(ctx))
+                        for (const auto& child : insp.structural_children_range(ctx))
                         {
                             if (child.kind != reflect::structural_child::kind::table)
                                 continue;
@@ -1133,7 +1631,7 @@ namespace nuno
                     else if (axis.row)
                     {
                         // Row only - return matching rows
-                        for (const auto& child : insp.structural_children(ctx))
+                        for (const auto& child : insp.structural_children_range(ctx))
                         {
                             if (child.kind != reflect::structural_child::kind::table)
                                 continue;
@@ -1294,8 +1792,10 @@ namespace nuno
             });
 
             size_t i = 0;
-            for (auto seg : segments)
+            for (size_t n = 0; n < segments.size(); ++n)
             {
+                auto seg = segments[n];
+
                 if (seg.empty())
                 {
                     issues_.push_back({
@@ -1336,6 +1836,28 @@ namespace nuno
                         return current;
                 }
 
+                // Glob step: the run of name and glob segments starting
+                // here is matched in one walk
+                if (is_glob(seg))
+                {
+                    size_t end = n + 1;
+                    while (end < segments.size() && is_category_level(segments[end]))
+                        ++end;
+
+                    working_set next;
+                    glob_matcher matcher(doc, segments.subspan(n, end - n), next);
+                    for (const auto& loc : current)
+                        matcher.run(loc);
+
+                    current = std::move(next);
+                    if (current.empty())
+                        return current;
+
+                    i += end - n;
+                    n  = end - 1;
+                    continue;
+                }
+
                 // Normal structural step
                 current = resolve_step(doc, current, seg, axis, diagnostics_, i);
                 if (current.empty())
@@ -1380,6 +1902,7 @@ namespace nuno
 
     void query_handle::report_issue(query_issue_kind kind, std::string_view context, size_t line) const noexcept
     {
+        std::lock_guard lock(issue_lock_.m);
         issues_.push_back({ kind, std::string(context), line });
     }
     void query_handle::report_if_empty(query_issue_kind kind, std::string_view context, size_t line) const noexcept
@@ -1394,6 +1917,7 @@ namespace nuno
 
         locations_.clear();
         issues_.clear();
+        unscoped_ = false;
 
         locations_ = details::resolve_dot_path(
             *doc_,
@@ -1419,20 +1943,18 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         for (const auto& loc : locations_)
         {
             reflect::inspect_context ctx{ doc_ };
             auto insp = reflect::inspect(ctx, loc.addr);
 
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 if (child.name != name)
                     continue;
 
-                auto child_addr = insp.extend_address(child);
-                auto child_insp = reflect::inspect(ctx, child_addr);
-
                 location_kind kind = location_kind::category_scope;
                 const typed_value* value_ptr = nullptr;
 
@@ -1441,10 +1963,7 @@ namespace nuno
                 {
                     case st::kind::key:
                         kind = location_kind::terminal_value;
-                        if (auto key_view = std::get_if<document::key_view>(&child_insp.item))
-                            value_ptr = &key_view->value();
-                        else if (auto val_ptr = std::get_if<const typed_value*>(&child_insp.item))
-                            value_ptr = *val_ptr;
+                        value_ptr = child.value;
                         break;
 
                     case st::kind::table:
@@ -1460,7 +1979,7 @@ namespace nuno
                         continue;  // Skip non-nameable children (rows, columns, indices)
                 }
 
-                next.push_back({ child_addr, kind, value_ptr });
+                next.push_back({ insp.extend_address(child), kind, value_ptr });
             }
         }
 
@@ -1476,6 +1995,7 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         for (const auto& loc : locations_)
         {
@@ -1485,7 +2005,7 @@ namespace nuno
             reflect::inspect_context ctx{ doc_ };
             auto insp = reflect::inspect(ctx, loc.addr);
 
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 if (child.kind != reflect::structural_child::kind::table)
                     continue;
@@ -1511,6 +2031,7 @@ namespace nuno
     query_handle& query_handle::table(size_t ordinal)
     {
         issues_.clear();
+        unscoped_ = false;
 
         // First enumerate tables in the current scope
         tables();
@@ -1540,6 +2061,7 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         for (const auto& loc : locations_)
         {
@@ -1549,7 +2071,7 @@ namespace nuno
             reflect::inspect_context ctx{ doc_ };
             auto insp = reflect::inspect(ctx, loc.addr);
 
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 if (child.kind != reflect::structural_child::kind::row)
                     continue;
@@ -1577,6 +2099,7 @@ namespace nuno
     query_handle& query_handle::row(size_t ordinal)
     {
         issues_.clear();
+        unscoped_ = false;
 
         rows();
 
@@ -1614,6 +2137,7 @@ namespace nuno
     query_handle& query_handle::row(std::string_view name)
     {
         issues_.clear();
+        unscoped_ = false;
 
         // If already in row scope, filter existing rows (progressive filtering)
         if (all_locations_are(location_kind::row_scope))
@@ -1623,7 +2147,7 @@ namespace nuno
             for (const auto& loc : locations_)
             {
                 reflect::inspect_context ctx{ doc_ };
-                auto insp = reflect::inspect(ctx, loc.addr);
+                auto insp = reflect::locate(ctx, loc.addr);
                 
                 if (auto row_view = std::get_if<document::table_row_view>(&insp.item))
                 {
@@ -1677,6 +2201,7 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         for (const auto& loc : locations_)
         {
@@ -1686,20 +2211,17 @@ namespace nuno
                 reflect::inspect_context ctx{ doc_ };
                 auto insp = reflect::inspect(ctx, loc.addr);
 
-                for (const auto& child : insp.structural_children(ctx))
+                for (const auto& child : insp.structural_children_range(ctx))
                 {
                     if (child.kind != reflect::structural_child::kind::column)
                         continue;
 
-                    auto child_addr = insp.extend_address(child);
-                    auto child_insp = reflect::inspect(ctx, child_addr);
-
-                    if (child_insp.value)
+                    if (child.value)
                     {
                         next.push_back({
-                            child_addr,
+                            insp.extend_address(child),
                             location_kind::terminal_value,
-                            child_insp.value
+                            child.value
                         });
                     }
                 }
@@ -1734,6 +2256,7 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         // Ensure column context exists (commutative)
         columns();
@@ -1755,20 +2278,17 @@ namespace nuno
             reflect::inspect_context ctx{ doc_ };
             auto insp = reflect::inspect(ctx, loc.addr);
 
-            for (const auto& child : insp.structural_children(ctx))
+            for (const auto& child : insp.structural_children_range(ctx))
             {
                 if (child.kind == reflect::structural_child::kind::column &&
                     child.ordinal == index)
                 {
-                    auto child_addr = insp.extend_address(child);
-                    auto child_insp = reflect::inspect(ctx, child_addr);
-
-                    if (child_insp.value)
+                    if (child.value)
                     {
                         next.push_back({
-                            child_addr,
+                            insp.extend_address(child),
                             location_kind::terminal_value,
-                            child_insp.value
+                            child.value
                         });
                     }
                 }
@@ -1789,6 +2309,7 @@ namespace nuno
     query_handle& query_handle::column(std::string_view name)
     {
         issues_.clear();
+        unscoped_ = false;
 
         // Set pending axis
         pending_axis_.column = name;
@@ -1828,6 +2349,7 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         for (const auto& loc : locations_)
         {
@@ -1837,26 +2359,23 @@ namespace nuno
             if (!is_array(*loc.value_ptr))
                 continue;
 
-            reflect::inspect_context ctx{ doc_ };
-            auto insp = reflect::inspect(ctx, loc.addr);
-
-            for (const auto& child : insp.structural_children(ctx))
+            // Only the selected element is referenced
+            auto const& elements = std::get<typed_array>(loc.value_ptr->val);
+            if (n < elements.size())
             {
-                if (child.kind == reflect::structural_child::kind::index &&
-                    child.ordinal == n)
-                {
-                    auto child_addr = insp.extend_address(child);
-                    auto child_insp = reflect::inspect(ctx, child_addr);
+                reflect::inspect_context ctx{ doc_ };
+                auto insp = reflect::inspect(ctx, loc.addr);
 
-                    if (child_insp.value)
-                    {
-                        next.push_back({
-                            child_addr,
-                            location_kind::terminal_value,
-                            child_insp.value
-                        });
-                    }
-                }
+                next.push_back({
+                    insp.extend_address({
+                        .kind    = reflect::structural_child::kind::index,
+                        .name    = {},
+                        .ordinal = n,
+                        .item    = {}
+                    }),
+                    location_kind::terminal_value,
+                    &elements[n]
+                });
             }
 
             if (next.empty() && !locations_.empty())
@@ -1968,6 +2487,7 @@ namespace nuno
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
     // Shorthand: where() on table == rows().where()
     // -----------------------------------------------
@@ -2049,11 +2569,119 @@ namespace nuno
         return *this;
     }
 
+    namespace details
+    {
+        // Category path from the root to cat, as address steps
+        inline void append_category_path(const document& doc, category_id cat, reflect::address& addr)
+        {
+            std::vector<std::string_view> names;
+            for (auto c = doc.category(cat); c && !c->is_root(); c = c->parent())
+                names.push_back(c->name());
+
+            for (size_t i = names.size(); i-- > 0; )
+            {
+                if (i + 1 == names.size()) addr.top(names[i]);
+                else                       addr.sub(names[i]);
+            }
+        }
+
+        inline bool category_contains(const document& doc, category_id outer, category_id inner)
+        {
+            for (auto c = doc.category(inner); c; c = c->parent())
+                if (c->id() == outer)
+                    return true;
+            return false;
+        }
+    }
+
+    query_handle& query_handle::where_value_(std::vector<document::value_occurrence> const& found)
+    {
+        // Only query(doc) searches the whole document; any other empty
+        // selection stays empty
+        bool whole_document = unscoped_;
+        unscoped_ = false;
+        issues_.clear();
+
+        // The scopes of the working set, resolved once
+        std::vector<nuno::category_id>  categories;
+        std::vector<nuno::table_id>     tables;
+        std::vector<nuno::row_id>       rows;
+        std::vector<const typed_value*> values;
+
+        for (auto const& loc : locations_)
+        {
+            reflect::inspect_context ctx{ doc_ };
+            auto found_loc = reflect::locate(ctx, loc.addr);
+            if (!found_loc.ok(loc.addr))
+                continue;
+
+            if (loc.kind == location_kind::terminal_value)
+                values.push_back(loc.value_ptr);
+            else if (auto cat = std::get_if<document::category_view>(&found_loc.item))
+                categories.push_back(cat->id());
+            else if (auto tbl = std::get_if<document::table_view>(&found_loc.item))
+                tables.push_back(tbl->id());
+            else if (auto row = std::get_if<document::table_row_view>(&found_loc.item))
+                rows.push_back(row->id());
+        }
+
+        std::vector<value_location> next;
+
+        for (auto const& occ : found)
+        {
+            reflect::address addr;
+            nuno::category_id owner;
+            nuno::table_id    table_of;
+
+            if (occ.is_key())
+            {
+                owner = doc_->key(occ.key)->node->owner;
+                details::append_category_path(*doc_, owner, addr);
+                addr.key(occ.key);
+            }
+            else
+            {
+                auto r = doc_->row(occ.row);
+                owner = r->node->owner;
+                table_of = r->node->table;
+                details::append_category_path(*doc_, owner, addr);
+                addr.table(table_of).row(occ.row).column(occ.column);
+            }
+
+            reflect::inspect_context ctx{ doc_ };
+            auto holder = reflect::locate(ctx, addr).value;
+
+            if (occ.element)
+                addr.index(*occ.element);
+
+            auto value = occ.element ? reflect::locate(ctx, addr).value : holder;
+            if (!value)
+                continue;
+
+            bool in_scope = whole_document
+                || std::ranges::find(rows, occ.row) != rows.end()
+                || std::ranges::find(tables, table_of) != tables.end()
+                || std::ranges::any_of(values, [&](auto v) { return v == holder || v == value; })
+                || std::ranges::any_of(categories, [&](auto c) { return details::category_contains(*doc_, c, owner); });
+
+            if (in_scope)
+                next.push_back({ std::move(addr), location_kind::terminal_value, value });
+        }
+
+        locations_ = std::move(next);
+
+        report_if_empty(query_issue_kind::empty_result,
+                        "where_value() - no value in scope matches");
+
+        return *this;
+    }
+
     query_handle& query_handle::project_impl(
         std::span<const std::string_view> column_names)
     {
         std::vector<value_location> next;
         issues_.clear();
+        unscoped_ = false;
 
         for (const auto& loc : locations_)
         {
@@ -2096,7 +2724,8 @@ namespace nuno
                 auto child = reflect::structural_child{
                     .kind    = reflect::structural_child::kind::column,
                     .name    = name,
-                    .ordinal = *idx
+                    .ordinal = *idx,
+                    .item    = {}
                 };
 
                 next.push_back({
@@ -2126,6 +2755,14 @@ namespace nuno
         pending_axis_.reset();
     }
 
+    // A row or column left pending by the selectors is resolved by the
+    // first extraction; readers sharing the handle wait for it
+    void query_handle::resolve_pending_axis_() const
+    {
+        std::lock_guard lock(issue_lock_.m);
+        const_cast<query_handle*>(this)->flush_pending_axis_();
+    }
+
     template<value_type vt>
     typed_value const *
     query_handle::common_extraction_checks(query_issue_kind* err) const noexcept
@@ -2254,7 +2891,7 @@ namespace nuno
     query_handle::scalar_extract(bool convert) const noexcept
     {
         // Flush any pending axis selections before extraction
-        const_cast<query_handle*>(this)->flush_pending_axis_();
+        resolve_pending_axis_();
 
         query_issue_kind err;
 
@@ -2284,7 +2921,7 @@ namespace nuno
     query_result<bool> query_handle::as_bool() const noexcept
     {
         // Flush any pending axis selections before extraction
-        const_cast<query_handle*>(this)->flush_pending_axis_();
+        resolve_pending_axis_();
 
         query_issue_kind err;
         if (auto v = common_extraction_checks<value_type::boolean>(&err); v != nullptr)
@@ -2312,17 +2949,20 @@ namespace nuno
     query_result<std::vector<int64_t>>
     query_handle::as_integers() const noexcept
     {
-        const_cast<query_handle*>(this)->flush_pending_axis_();
+        resolve_pending_axis_();
 
         query_issue_kind err;
         if (auto v = common_extraction_checks<value_type::integer_array>(&err); v != nullptr)
         {
-            const auto& elems = std::get<std::vector<typed_value>>(v->val);
+            const auto& arr = std::get<typed_array>(v->val);
+            if (auto buf = arr.integers(); buf.size() == arr.size() && arr.aside_count() == 0)
+                return std::vector<int64_t>(buf.begin(), buf.end());
+
             std::vector<int64_t> out;
-            out.reserve(elems.size());
-            for (const auto& e : elems)
-                if (e.type == value_type::integer)
-                    out.push_back(std::get<int64_t>(e.val));
+            out.reserve(arr.size());
+            for (size_t i = 0; i < arr.size(); ++i)
+                if (arr.type_at(i) == value_type::integer)
+                    out.push_back(arr.integer_at(i));
             return out;
         }
         return {err};
@@ -2331,17 +2971,20 @@ namespace nuno
     query_result<std::vector<double>>
     query_handle::as_reals() const noexcept
     {
-        const_cast<query_handle*>(this)->flush_pending_axis_();
+        resolve_pending_axis_();
 
         query_issue_kind err;
         if (auto v = common_extraction_checks<value_type::floating_point_array>(&err); v != nullptr)
         {
-            const auto& elems = std::get<std::vector<typed_value>>(v->val);
+            const auto& arr = std::get<typed_array>(v->val);
+            if (auto buf = arr.reals(); buf.size() == arr.size() && arr.aside_count() == 0)
+                return std::vector<double>(buf.begin(), buf.end());
+
             std::vector<double> out;
-            out.reserve(elems.size());
-            for (const auto& e : elems)
-                if (e.type == value_type::floating_point)
-                    out.push_back(std::get<double>(e.val));
+            out.reserve(arr.size());
+            for (size_t i = 0; i < arr.size(); ++i)
+                if (arr.type_at(i) == value_type::floating_point)
+                    out.push_back(arr.real_at(i));
             return out;
         }
         return {err};
@@ -2350,22 +2993,232 @@ namespace nuno
     query_result<std::vector<std::string>>
     query_handle::as_strings() const noexcept
     {
-        const_cast<query_handle*>(this)->flush_pending_axis_();
+        resolve_pending_axis_();
 
         query_issue_kind err;
         if (auto v = common_extraction_checks<value_type::string_array>(&err); v != nullptr)
         {
-            const auto& elems = std::get<std::vector<typed_value>>(v->val);
+            const auto& arr = std::get<typed_array>(v->val);
             std::vector<std::string> out;
-            out.reserve(elems.size());
-            for (const auto& e : elems)
-                if (e.type == value_type::string)
-                    out.push_back(std::get<std::string>(e.val));
+            out.reserve(arr.size());
+            for (size_t i = 0; i < arr.size(); ++i)
+                if (arr.type_at(i) == value_type::string)
+                    out.emplace_back(arr.string_at(i));
             return out;
         }
         return {err};
     }
 
+// =====================================================================
+// Borrowing extraction
+// =====================================================================
+// Same checks and errors as as_string() and the whole-array extractors,
+// but the results refer into the document instead of copying from it.
+// =====================================================================
+
+    query_result<std::string_view> query_handle::as_string_view() const noexcept
+    {
+        resolve_pending_axis_();
+
+        query_issue_kind err;
+        if (auto v = common_extraction_checks<value_type::string>(&err); v != nullptr)
+            return std::string_view(std::get<std::string>(v->val));
+        return {err};
+    }
+
+    template<typename T>
+    query_result<array_view<T>>
+    query_handle::array_view_extract() const noexcept
+    {
+        resolve_pending_axis_();
+
+        query_issue_kind err;
+        if (auto v = common_extraction_checks<details::element_traits<T>::array_type>(&err); v != nullptr)
+            return array_view<T>(std::get<typed_array>(v->val));
+        return {err};
+    }
+
+    query_result<array_view<int64_t>> query_handle::as_integers_view() const noexcept
+    {
+        return array_view_extract<int64_t>();
+    }
+
+    query_result<array_view<double>> query_handle::as_reals_view() const noexcept
+    {
+        return array_view_extract<double>();
+    }
+
+    query_result<array_view<std::string_view>> query_handle::as_strings_view() const noexcept
+    {
+        return array_view_extract<std::string_view>();
+    }
+
+// =====================================================================
+// Column-wise extraction
+// =====================================================================
+// Rows are visited straight from the document: tables and categories in
+// the working set are expanded on the fly, row locations are located
+// once each, and the column index is resolved once per table. into()
+// fills its buffers in the same pass, checking their size as it goes.
+// =====================================================================
+
+    namespace details
+    {
+        inline std::optional<size_t>
+        find_column_index(const document::table_view& table, std::string_view name) noexcept
+        {
+            // Column views are made as the range is walked
+            size_t i = 0;
+            for (auto col : table.columns_range())
+            {
+                if (col.name() == name)
+                    return i;
+                ++i;
+            }
+            return std::nullopt;
+        }
+    }
+
+    template<typename Fn>
+    void query_handle::for_each_row_(Fn&& fn) const
+    {
+        reflect::inspect_context ctx{ doc_ };
+
+        auto visit_table = [&](document::table_view const& table)
+        {
+            for (auto row : table.rows_range())
+                if (!fn(row))
+                    return false;
+            return true;
+        };
+
+        for (const auto& loc : locations_)
+        {
+            auto found = reflect::locate(ctx, loc.addr);
+            bool more  = true;
+
+            if (loc.kind == location_kind::row_scope)
+            {
+                if (auto row = std::get_if<document::table_row_view>(&found.item))
+                    more = fn(*row);
+            }
+            else if (loc.kind == location_kind::table_scope)
+            {
+                if (auto table = std::get_if<document::table_view>(&found.item))
+                    more = visit_table(*table);
+            }
+            else if (loc.kind == location_kind::category_scope)
+            {
+                if (auto cat = std::get_if<document::category_view>(&found.item))
+                    for (auto table : cat->tables_range())
+                        if (!(more = visit_table(table)))
+                            break;
+            }
+
+            if (!more)
+                return;
+        }
+    }
+
+    size_t query_handle::row_count() const noexcept
+    {
+        resolve_pending_axis_();
+
+        size_t n = 0;
+        for_each_row_([&](document::table_row_view const&) { ++n; return true; });
+        return n;
+    }
+
+    template<details::extractable_element T>
+    query_result<size_t>
+    query_handle::into(std::string_view column, std::span<T> out, std::span<cell_status> status) const noexcept
+    {
+        using element = details::element_traits<T>;
+
+        resolve_pending_axis_();
+
+        size_t n = 0;
+        bool   found = false;
+        bool   overflow = false;
+        std::optional<nuno::table_id> last_table;
+        std::optional<size_t>         col;
+
+        for_each_row_([&](document::table_row_view const& row)
+        {
+            if (n >= out.size() || (!status.empty() && n >= status.size()))
+            {
+                overflow = true;
+                return false;
+            }
+
+            if (row.node->table != last_table)
+            {
+                last_table = row.node->table;
+                col = details::find_column_index(row.table(), column);
+                found = found || col.has_value();
+            }
+
+            auto state = cell_status::missing;
+            out[n] = T{};
+
+            if (col && *col < row.node->cells.size())
+            {
+                const auto& cell = row.node->cells[*col];
+
+                if (cell.type == value_type::unresolved)
+                    state = cell_status::missing;
+                else if (cell.type != element::element_type || cell.semantic == semantic_state::invalid)
+                    state = cell_status::invalid;
+                else
+                {
+                    out[n] = element::get(cell);
+                    state  = cell_status::valid;
+                }
+            }
+
+            if (!status.empty())
+                status[n] = state;
+            ++n;
+            return true;
+        });
+
+        if (overflow)
+        {
+            report_issue(query_issue_kind::invalid_index, "into() - buffer smaller than the row count");
+            return {query_issue_kind::invalid_index};
+        }
+
+        if (n == 0)
+        {
+            report_issue(query_issue_kind::empty_result, "into() - no rows in current scope");
+            return {query_issue_kind::empty_result};
+        }
+
+        if (!found)
+        {
+            report_issue(query_issue_kind::not_found,
+                         "into(\"" + std::string(column) + "\") - column not found");
+            return {query_issue_kind::not_found};
+        }
+
+        return n;
+    }
+
+    template<details::extractable_element T>
+    query_result<std::vector<T>>
+    query_handle::column_values(std::string_view column, std::vector<cell_status>* status) const
+    {
+        std::vector<T> out(row_count());
+        if (status)
+            status->assign(out.size(), cell_status::missing);
+
+        auto res = into(column, std::span<T>(out), status ? std::span<cell_status>(*status) : std::span<cell_status>{});
+        if (!res)
+            return {res.error()};
+
+        return out;
+    }
+
 // =====================================================================
 // Entry points
 // =====================================================================
@@ -2469,6 +3322,34 @@ namespace nuno
         return query(doc, path).as_strings();
     }
 
+// =====================================================================
+// Borrowing extraction
+// =====================================================================
+
+    inline query_result<std::string_view>
+    get_string_view(const document& doc, std::string_view path) noexcept
+    {
+        return query(doc, path).as_string_view();
+    }
+
+    inline query_result<array_view<int64_t>>
+    get_integers_view(const document& doc, std::string_view path) noexcept
+    {
+        return query(doc, path).as_integers_view();
+    }
+
+    inline query_result<array_view<double>>
+    get_reals_view(const document& doc, std::string_view path) noexcept
+    {
+        return query(doc, path).as_reals_view();
+    }
+
+    inline query_result<array_view<std::string_view>>
+    get_strings_view(const document& doc, std::string_view path) noexcept
+    {
+        return query(doc, path).as_strings_view();
+    }
+
 } // namespace nuno
 
 #endif // NUNO_QUERY_HPP
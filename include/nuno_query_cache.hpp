@@ -0,0 +1,167 @@
+// nuno_query_cache.hpp - A Readable Format (NUNO) - Query result cache
+// Version 0.3.0
+// Copyright 2025 Mikael Ueno A
+// Licenced as-is under the MIT licence.
+
+//========================================================================
+// The query cache memoises dot-path selection for one document. Each
+// distinct path is resolved once into a query handle; repeat lookups
+// are a hash lookup and an extraction from that handle.
+//
+// The cache follows the document's generation counter, which every
+// editor operation bumps. Resolved locations hold pointers into the
+// document, so on the first lookup after an edit the whole cache is
+// dropped rather than individual entries revalidated.
+//
+// Entries are kept in least-recently-used order and the oldest is
+// evicted beyond the capacity. A cache is not thread-safe; use one per
+// thread, or guard it, when several threads read the same document.
+//========================================================================
+
+#ifndef NUNO_QUERY_CACHE_HPP
+#define NUNO_QUERY_CACHE_HPP
+
+#include "nuno_query.hpp"
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace nuno
+{
+    struct query_cache_stats
+    {
+        size_t hits          {0};
+        size_t misses        {0};
+        size_t evictions     {0};  // entries dropped for capacity
+        size_t invalidations {0};  // times the cache was dropped after an edit
+    };
+
+    class query_cache
+    {
+    public:
+        explicit query_cache(const document& doc, size_t capacity = 256) noexcept
+            : doc_(&doc)
+            , capacity_(capacity ? capacity : 1)
+            , generation_(doc.generation())
+        {
+        }
+
+        // The resolved handle for a dot-path. The reference stays valid
+        // until the next call on the cache; copy it to refine further.
+        const query_handle& select(std::string_view path);
+
+        // Cached forms of the convenience getters in nuno_query.hpp
+        query_result<int64_t>          get_integer(std::string_view path)     { return extract(path, &query_handle::as_integer, false); }
+        query_result<double>           get_real(std::string_view path)        { return extract(path, &query_handle::as_real, false); }
+        query_result<bool>             get_bool(std::string_view path)        { return extract(path, &query_handle::as_bool); }
+        query_result<std::string>      get_string(std::string_view path)      { return extract(path, &query_handle::as_string, false); }
+        query_result<std::string_view> get_string_view(std::string_view path) { return extract(path, &query_handle::as_string_view); }
+
+        query_result<int64_t>          get_as_integer(std::string_view path)  { return extract(path, &query_handle::as_integer, true); }
+        query_result<double>           get_as_real(std::string_view path)     { return extract(path, &query_handle::as_real, true); }
+        query_result<std::string>      get_as_string(std::string_view path)   { return extract(path, &query_handle::as_string, true); }
+
+        void clear() noexcept;
+
+        size_t size() const noexcept     { return entries_.size(); }
+        size_t capacity() const noexcept { return capacity_; }
+
+        query_cache_stats const& stats() const noexcept { return stats_; }
+        void reset_stats() noexcept { stats_ = {}; }
+
+        // Cache key for a dot-path; a trailing '.' is ignored
+        static std::string_view canonical(std::string_view path) noexcept;
+
+    private:
+        struct entry
+        {
+            std::string  path;
+            query_handle handle;
+            size_t       issues;  // issues recorded by the selection itself
+        };
+
+        using entry_list = std::list<entry>;
+
+        const document*                                          doc_;
+        size_t                                                   capacity_;
+        uint64_t                                                 generation_;
+        entry_list                                               entries_;   // most recently used first
+        std::unordered_map<std::string_view, entry_list::iterator> index_;   // keys view entry paths
+        query_cache_stats                                        stats_;
+
+        entry& lookup(std::string_view path);
+
+        template<typename T, typename... Args>
+        query_result<T> extract(std::string_view path, query_result<T> (query_handle::*fn)(Args...) const noexcept, Args... args)
+        {
+            auto& e = lookup(path);
+            auto res = (e.handle.*fn)(args...);
+
+            // Failed extractions record an issue on the handle; drop it so
+            // that a cached handle does not grow with repeated lookups
+            e.handle.issues_.resize(e.issues);
+            return res;
+        }
+    };
+
+//------------------------------------------------------------------------
+
+    inline std::string_view query_cache::canonical(std::string_view path) noexcept
+    {
+        // Dot-path splitting ignores a trailing separator
+        if (path.ends_with('.'))
+            path.remove_suffix(1);
+        return path;
+    }
+
+    inline void query_cache::clear() noexcept
+    {
+        index_.clear();
+        entries_.clear();
+    }
+
+    inline query_cache::entry& query_cache::lookup(std::string_view path)
+    {
+        if (doc_->generation() != generation_)
+        {
+            if (!entries_.empty())
+                ++stats_.invalidations;
+            clear();
+            generation_ = doc_->generation();
+        }
+
+        path = canonical(path);
+
+        if (auto it = index_.find(path); it != index_.end())
+        {
+            ++stats_.hits;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return entries_.front();
+        }
+
+        ++stats_.misses;
+
+        if (entries_.size() >= capacity_)
+        {
+            index_.erase(entries_.back().path);
+            entries_.pop_back();
+            ++stats_.evictions;
+        }
+
+        auto& e = entries_.emplace_front(entry{ std::string(path), query(*doc_, path), 0 });
+        e.issues = e.handle.issues_.size();
+        index_.emplace(e.path, entries_.begin());
+        return e;
+    }
+
+    inline const query_handle& query_cache::select(std::string_view path)
+    {
+        auto& e = lookup(path);
+        e.handle.issues_.resize(e.issues);
+        return e.handle;
+    }
+}
+
+#endif // NUNO_QUERY_CACHE_HPP
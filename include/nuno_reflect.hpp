@@ -18,6 +18,8 @@
 #include <variant>
 #include <vector>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <string_view>
 
 namespace nuno::reflect
@@ -166,8 +168,9 @@ namespace nuno::reflect
 // ------------------------------------------------------------
 // addressed_step
 // ------------------------------------------------------------
-// Diagnostic is written by inspect().
-// Not thread-safe if the address is shared.
+// Diagnostic is written by inspect(ctx, address&).
+// Not thread-safe if the address is shared; threads sharing an
+// address use inspect(ctx, const address&) instead.
 // ------------------------------------------------------------
 
         struct addressed_step
@@ -359,6 +362,13 @@ namespace nuno::reflect
         kind kind;
         std::string_view name;   // empty for anonymous (row, index)
         size_t           ordinal = 0; // IDs for tables and rows, index for arrays
+
+        // What the child resolves to, as locating its extended address
+        // would report it. Filled by structural_child_range, so callers
+        // can step into a child without inspecting from the root again.
+        // Left empty for the elements of a compact array.
+        inspected_item     item;
+        const typed_value* value = nullptr;
     };
 
     inline std::string_view to_string(enum structural_child::kind kind)
@@ -376,6 +386,192 @@ namespace nuno::reflect
         }
     }
 
+// ------------------------------------------------------------
+// structural_child_range
+// ------------------------------------------------------------
+// Lazily yields the structural children of an inspected item,
+// in the same order as inspected::structural_children(), without
+// building a vector. Invalidated by edits to the document.
+// ------------------------------------------------------------
+
+    class structural_child_range : public std::ranges::view_interface<structural_child_range>
+    {
+    public:
+        using child_kind = enum structural_child::kind;
+
+        class iterator
+        {
+        public:
+            using iterator_concept  = std::forward_iterator_tag;
+            using iterator_category = std::input_iterator_tag;  // yields children by value
+            using value_type        = structural_child;
+            using difference_type   = std::ptrdiff_t;
+
+            iterator() = default;
+
+            structural_child operator*() const noexcept { return range_->child(segment_, index_, row_); }
+
+            iterator& operator++() noexcept
+            {
+                if (range_->segments_[segment_] == child_kind::row) ++row_;
+                ++index_;
+                settle();
+                return *this;
+            }
+            iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+            bool operator==(iterator const& rhs) const noexcept { return segment_ == rhs.segment_ && index_ == rhs.index_; }
+
+        private:
+            friend class structural_child_range;
+
+            iterator(const structural_child_range* range, size_t segment) noexcept
+                : range_(range), segment_(segment)
+            {
+                settle();
+            }
+
+            // Steps over exhausted and empty segments
+            void settle() noexcept
+            {
+                while (segment_ < range_->segment_count_ && index_ >= range_->count(range_->segments_[segment_]))
+                {
+                    ++segment_;
+                    index_ = 0;
+                }
+
+                // Rows are walked along their sequence rather than indexed
+                if (segment_ < range_->segment_count_ && index_ == 0 && range_->segments_[segment_] == child_kind::row)
+                    row_ = range_->rows_->begin();
+            }
+
+            const structural_child_range*          range_ {nullptr};
+            size_t                                 segment_ {0};
+            size_t                                 index_ {0};
+            document::row_sequence::const_iterator row_;
+        };
+
+        structural_child_range() = default;
+
+        structural_child_range(const document* doc, const inspected_item& item) noexcept
+            : doc_(doc)
+        {
+            if (!doc_)
+                return;
+
+            const typed_value* value = nullptr;
+
+            if (auto cat = std::get_if<document::category_view>(&item))
+            {
+                // The root lists top-level categories
+                children_ = cat->children();
+                keys_     = cat->keys();
+                tables_   = cat->tables();
+                add(cat->is_root() ? child_kind::top_category : child_kind::sub_category);
+                add(child_kind::key);
+                add(child_kind::table);
+            }
+            else if (auto tbl = std::get_if<document::table_view>(&item))
+            {
+                rows_ = &tbl->rows();
+                add(child_kind::row);
+            }
+            else if (auto row = std::get_if<document::table_row_view>(&item))
+            {
+                columns_ = row->table().columns();
+                cells_   = row->cells().data();
+                add(child_kind::column);
+            }
+            else if (auto pv = std::get_if<const typed_value*>(&item))
+                value = *pv;
+            else if (auto kv = std::get_if<document::key_view>(&item))
+                value = &kv->value();
+
+            if (value && is_array(*value))
+            {
+                array_   = &std::get<typed_array>(value->val);
+                indices_ = array_->size();
+                add(child_kind::index);
+            }
+        }
+
+        iterator begin() const noexcept { return {this, 0}; }
+        iterator end() const noexcept   { return {this, segment_count_}; }
+
+        size_t size() const noexcept
+        {
+            size_t n = 0;
+            for (size_t s = 0; s < segment_count_; ++s)
+                n += count(segments_[s]);
+            return n;
+        }
+
+    private:
+        const document*              doc_ {nullptr};
+        std::array<child_kind, 3>          segments_ {};
+        size_t                       segment_count_ {0};
+        std::span<const category_id> children_;
+        std::span<const key_id>      keys_;
+        std::span<const table_id>    tables_;
+        const document::row_sequence* rows_ {nullptr};
+        std::span<const column_id>   columns_;
+        size_t                       indices_ {0};
+        const typed_value*           cells_ {nullptr};
+        const typed_array*           array_ {nullptr};
+
+        void add(child_kind k) noexcept { segments_[segment_count_++] = k; }
+
+        size_t count(child_kind k) const noexcept
+        {
+            switch (k)
+            {
+                case child_kind::top_category:
+                case child_kind::sub_category: return children_.size();
+                case child_kind::key:          return keys_.size();
+                case child_kind::table:        return tables_.size();
+                case child_kind::row:          return rows_ ? rows_->size() : 0;
+                case child_kind::column:       return columns_.size();
+                case child_kind::index:        return indices_;
+            }
+            return 0;
+        }
+
+        // Array keys resolve to their value, so that they can be indexed.
+        // Elements of a compact array have no typed_value until referenced,
+        // so their children carry neither item nor value; locating the
+        // extended address references the element.
+        structural_child child(size_t segment, size_t i, document::row_sequence::const_iterator row) const noexcept
+        {
+            auto k = segments_[segment];
+            switch (k)
+            {
+                case child_kind::top_category:
+                case child_kind::sub_category:
+                {
+                    auto cat = *doc_->category(children_[i]);
+                    return { k, cat.name(), 0, cat };
+                }
+                case child_kind::key:
+                {
+                    auto key = *doc_->key(keys_[i]);
+                    auto val = &key.value();
+                    return { k, key.name(), 0, is_array(*val) ? inspected_item{val} : inspected_item{key}, val };
+                }
+                case child_kind::table:  return { k, {}, static_cast<size_t>(tables_[i]), *doc_->table(tables_[i]) };
+                case child_kind::row:    return { k, {}, static_cast<size_t>(*row), *doc_->row(*row) };
+                case child_kind::column: return { k, doc_->column(columns_[i])->name(), i, &cells_[i], &cells_[i] };
+                case child_kind::index:
+                {
+                    if (array_->is_compact())
+                        return { k, {}, i, inspected_item{}, nullptr };
+                    auto element = &(*array_)[i];
+                    return { k, {}, i, element, element };
+                }
+            }
+            return { k, {}, 0, inspected_item{}, nullptr };
+        }
+    };
+
     struct prefix_match
     {
         structural_child child;
@@ -435,6 +631,13 @@ namespace nuno::reflect
         std::vector<structural_child>
         structural_children(const inspect_context& ctx) const;
 
+        // As structural_children(), without allocating
+        structural_child_range
+        structural_children_range(const inspect_context& ctx) const noexcept
+        {
+            return { ctx.doc, item };
+        }
+
         // Returns the structural children that are valid continuations of the current
         // address prefix(the last successfully inspected prefix of this address).
         //
@@ -478,328 +681,313 @@ namespace nuno::reflect
     };    
 
 // ------------------------------------------------------------
-// inspect - mutable version
-// ------------------------------------------------------------
-// Mutable version: Writes diagnostics to addr.
-// Not thread-safe if addr is shared across threads.
-// Most efficient for single-threaded reuse.
+// locate - allocation-free inspection
 // ------------------------------------------------------------
-// Note: Addresses can be reused across multiple inspections.
-// Each inspection resets and rewrites address diagnostic state.
-// The address in the returned inpected object is a frozen copy.
+// Resolves an address without writing to it and without
+// allocating. Inspection stops at the first failing step; every
+// earlier step resolved ok and later steps are uninspected. The
+// diagnostics are carried by the result instead of the address,
+// so a shared address needs no copy.
+//
+// Thread-safe for shared addresses and a shared document,
+// provided each thread uses its own inspect_context.
 // ------------------------------------------------------------
 
-    inline inspected inspect(
-        inspect_context& ctx,
-        address& addr
-    )
+    struct location
     {
-        // reset context
-        ctx.category = ctx.doc->root();
-        ctx.table.reset();
-        ctx.row.reset();
-        ctx.column.reset();
-        ctx.key.reset();
-        ctx.value = nullptr;
+        inspected_item     item;
+        const typed_value* value = nullptr;
+        size_t             steps_inspected = 0;
+        step_error         error = step_error::none;  // of the last inspected step
 
-        inspected out;
-        out.item = *ctx.category;
-        out.value = nullptr;
-        out.steps_inspected = 0;
+        bool has_error() const noexcept { return error != step_error::none; }
+        bool ok(const address& addr) const noexcept { return !has_error() && steps_inspected == addr.steps.size(); }
 
-        inspected_item last_valid_item = *ctx.category;
+        step_diagnostic diagnostic(size_t step) const noexcept
+        {
+            if (step >= steps_inspected)
+                return { step_state::uninspected, step_error::none };
+            if (step + 1 == steps_inspected && has_error())
+                return { step_state::error, error };
+            return {};
+        }
+    };
 
-        for (size_t i = 0; i < addr.steps.size(); ++i)
+    namespace detail
+    {
+        inline void enter_category(inspect_context& ctx, std::optional<document::category_view> next)
         {
-            auto& astep = addr.steps[i];
-            auto& diag  = astep.diagnostic;
-            const auto& step = astep.step;
+            ctx.category = next;
+            ctx.table.reset();
+            ctx.row.reset();
+            ctx.column.reset();
+            ctx.value = nullptr;
+        }
 
-            diag = {};
-            diag.state = step_state::ok;
+        inline step_error inspect_step(inspect_context& ctx, const key_step& s)
+        {
+            if (!ctx.category)
+                return step_error::no_category_context;
 
-            auto error = [&diag](step_error what)
-            {
-                diag.state = step_state::error;
-                diag.error = what;
-            };
+            auto k =
+                std::holds_alternative<key_id>(s.id)
+                    ? ctx.doc->key(std::get<key_id>(s.id))
+                    : ctx.category->key(std::get<std::string_view>(s.id));
 
-            // ---------------- key
-            if (auto s = std::get_if<key_step>(&step))
-            {
-                if (!ctx.category)
-                    error(step_error::no_category_context);
-                else
-                {
-                    auto k =
-                        std::holds_alternative<key_id>(s->id)
-                            ? ctx.doc->key(std::get<key_id>(s->id))
-                            : ctx.category->key(std::get<std::string_view>(s->id));
+            if (!k)
+                return step_error::key_not_found;
 
-                    if (!k)
-                        error(step_error::key_not_found);
-                    else
-                    {
-                        ctx.value = &k->value();
-                        ctx.key = k;
-                    }
-                }
-            }
+            ctx.value = &k->value();
+            ctx.key = k;
+            return step_error::none;
+        }
 
-            // ---------------- top category
-            else if (auto s = std::get_if<top_category_step>(&step))
-            {
-                if (ctx.value)
-                    error(step_error::structure_after_value);
+        inline step_error inspect_step(inspect_context& ctx, const top_category_step& s)
+        {
+            if (ctx.value)
+                return step_error::structure_after_value;
 
-                else if (ctx.category && ctx.category->id() != ctx.doc->root()->id())
-                    error(step_error::top_category_after_category);
+            if (ctx.category && !ctx.category->is_root())
+                return step_error::top_category_after_category;
 
-                else
-                {
-                    auto next = ctx.doc->root()->child(s->name);
-                    if (!next)
-                        error(step_error::top_category_not_found);
-                    else
-                    {
-                        ctx.category = next;
-                        ctx.table.reset();
-                        ctx.row.reset();
-                        ctx.column.reset();
-                        ctx.value = nullptr;
-                    }
-                }
-            }
+            auto next = ctx.doc->root()->child(s.name);
+            if (!next)
+                return step_error::top_category_not_found;
 
-            // ---------------- sub category
-            else if (auto s = std::get_if<sub_category_step>(&step))
-            {
-                if (ctx.value)
-                    error(step_error::structure_after_value);
+            enter_category(ctx, next);
+            return step_error::none;
+        }
 
-                else if (!ctx.category)
-                    error(step_error::no_category_context);
+        inline step_error inspect_step(inspect_context& ctx, const sub_category_step& s)
+        {
+            if (ctx.value)
+                return step_error::structure_after_value;
 
-                else if (ctx.category->id() == ctx.doc->root()->id())
-                    error(step_error::sub_category_under_root);
+            if (!ctx.category)
+                return step_error::no_category_context;
 
-                else
-                {
-                    auto next = ctx.category->child(s->name);
-                    if (!next)
-                        error(step_error::sub_category_not_found);
-                    else
-                    {
-                        ctx.category = next;
-                        ctx.table.reset();
-                        ctx.row.reset();
-                        ctx.column.reset();
-                        ctx.value = nullptr;
-                    }
-                }
-            }
+            if (ctx.category->is_root())
+                return step_error::sub_category_under_root;
 
-            // ---------------- table
-            else if (auto s = std::get_if<table_step>(&step))
-            {
-                if (ctx.value)
-                    error(step_error::structure_after_value);
+            auto next = ctx.category->child(s.name);
+            if (!next)
+                return step_error::sub_category_not_found;
 
-                else if (!ctx.category)
-                    error(step_error::no_category_context);
+            enter_category(ctx, next);
+            return step_error::none;
+        }
 
-                else
-                {
-                    std::optional<table_id> tid =
-                        std::holds_alternative<table_id>(s->id)
-                            ? std::optional{ std::get<table_id>(s->id) }
-                            : resolve_table_ordinal(*ctx.category, std::get<size_t>(s->id));
+        inline step_error inspect_step(inspect_context& ctx, const table_step& s)
+        {
+            if (ctx.value)
+                return step_error::structure_after_value;
+
+            if (!ctx.category)
+                return step_error::no_category_context;
+
+            std::optional<table_id> tid =
+                std::holds_alternative<table_id>(s.id)
+                    ? std::optional{ std::get<table_id>(s.id) }
+                    : resolve_table_ordinal(*ctx.category, std::get<size_t>(s.id));
+
+            auto tbl = tid ? ctx.doc->table(*tid) : std::nullopt;
+            if (!tbl)
+                return step_error::table_not_found;
+
+            ctx.table = tbl;
+            ctx.row.reset();
+            ctx.column.reset();
+            ctx.value = nullptr;
+            return step_error::none;
+        }
 
-                    if (!tid)
-                        error(step_error::table_not_found);
+        inline step_error inspect_step(inspect_context& ctx, const row_step& s)
+        {
+            if (ctx.value)
+                return step_error::structure_after_value;
 
-                    else
-                    {
-                        auto tbl = ctx.doc->table(*tid);
-                        if (!tbl)
-                            error(step_error::table_not_found);
-                        else
-                        {
-                            ctx.table = tbl;
-                            ctx.row.reset();
-                            ctx.column.reset();
-                            ctx.value = nullptr;
-                        }
-                    }
-                }
-            }
+            if (!ctx.table)
+                return step_error::no_table_context;
 
-            // ---------------- row
-            else if (auto s = std::get_if<row_step>(&step))
-            {
-                if (ctx.value)
-                    error(step_error::structure_after_value);
+            auto r = ctx.doc->row(s.id);
+            if (!r)
+                return step_error::row_not_found;
 
-                else if (!ctx.table)
-                    error(step_error::no_table_context);
+            // Rows know their table; no need to search its row list
+            if (r->node->table != ctx.table->id())
+                return step_error::row_not_owned;
 
-                else
-                {
-                    auto r = ctx.doc->row(s->id);
-                    if (!r)
-                        error(step_error::row_not_found);
-                    else
-                    {
-                        bool owned = false;
-                        for (auto rid : ctx.table->rows())
-                        {
-                            if (rid == s->id)
-                            {
-                                owned = true;
-                                break;
-                            }
-                        }
-
-                        if (!owned)
-                            error( step_error::row_not_owned);
-
-                        else
-                        {
-                            ctx.row = r;
-                            ctx.column.reset();
-                            ctx.value = nullptr;
-                        }
-                    }
-                }
-            }
+            ctx.row = r;
+            ctx.column.reset();
+            ctx.value = nullptr;
+            return step_error::none;
+        }
 
-            // ---------------- column
-            else if (auto s = std::get_if<column_step>(&step))
-            {
-                if (ctx.value)
-                    error(step_error::structure_after_value);
+        inline step_error inspect_step(inspect_context& ctx, const column_step& s)
+        {
+            if (ctx.value)
+                return step_error::structure_after_value;
 
-                else if (!ctx.table)
-                    error(step_error::no_table_context);
+            if (!ctx.table)
+                return step_error::no_table_context;
 
-                else if (!ctx.row)
-                    error(step_error::no_row_context);
+            if (!ctx.row)
+                return step_error::no_row_context;
 
-                else
-                {
-                    auto col =
-                        std::holds_alternative<column_id>(s->id)
-                            ? ctx.doc->column(std::get<column_id>(s->id))
-                            : ctx.table->column(std::get<std::string_view>(s->id));
+            auto col =
+                std::holds_alternative<column_id>(s.id)
+                    ? ctx.doc->column(std::get<column_id>(s.id))
+                    : ctx.table->column(std::get<std::string_view>(s.id));
 
-                    if (!col)
-                        error(step_error::column_not_found);
-                    else
-                    {
-                        ctx.column = col;
-                        ctx.value = &ctx.row->cells()[col->index()];
-                    }
-                }
-            }
+            if (!col)
+                return step_error::column_not_found;
 
-            // ---------------- index
-            else if (auto s = std::get_if<index_step>(&step))
-            {
-                if (!ctx.value)
-                    error(step_error::no_context_value);
+            ctx.column = col;
+            ctx.value = &ctx.row->cells()[col->index()];
+            return step_error::none;
+        }
+
+        inline step_error inspect_step(inspect_context& ctx, const index_step& s)
+        {
+            if (!ctx.value)
+                return step_error::no_context_value;
 
-                else if (!is_array(*ctx.value))
-                    error(step_error::not_an_array);
+            if (!is_array(*ctx.value))
+                return step_error::not_an_array;
 
-                else
+            auto const& arr = std::get<typed_array>(ctx.value->val);
+            if (s.index >= arr.size())
+                return step_error::index_out_of_bounds;
+
+            ctx.value = &arr[s.index];
+            return step_error::none;
+        }
+
+        // The item a successfully inspected step leaves behind
+        inline void advance_item(const inspect_context& ctx, const address_step& step, inspected_item& item)
+        {
+            if (std::holds_alternative<index_step>(step))
+            {
+                item = ctx.value;
+            }
+            else if (std::holds_alternative<column_step>(step))
+            {
+                if (ctx.value)
+                    item = ctx.value;
+                else if (ctx.column)
+                    item = *ctx.column;
+            }
+            else if (std::holds_alternative<key_step>(step))
+            {
+                if (ctx.key)
                 {
-                    auto& arr = std::get<std::vector<typed_value>>(ctx.value->val);
-                    if (s->index >= arr.size())
-                        error(step_error::index_out_of_bounds);
+                    // If this is an array value and we might index it,
+                    // store the value pointer instead of the key_view
+                    const auto& val = ctx.key->value();
+                    if (is_array(val))
+                        item = &val;
                     else
-                        ctx.value = &arr[s->index];
+                        item = *ctx.key;
                 }
             }
+            else if (std::holds_alternative<row_step>(step))
+            {
+                item = *ctx.row;
+            }
+            else if (std::holds_alternative<table_step>(step))
+            {
+                item = *ctx.table;
+            }
+            else
+            {
+                item = *ctx.category;
+            }
+        }
+    }
+
+    inline location locate(inspect_context& ctx, const address& addr)
+    {
+        // reset context
+        ctx.category = ctx.doc->root();
+        ctx.table.reset();
+        ctx.row.reset();
+        ctx.column.reset();
+        ctx.key.reset();
+        ctx.value = nullptr;
+
+        location out;
+        out.item = *ctx.category;
 
+        for (const auto& astep : addr.steps)
+        {
+            out.error = std::visit([&ctx](const auto& s) { return detail::inspect_step(ctx, s); }, astep.step);
             ++out.steps_inspected;
 
-            if (diag.state == step_state::error)
+            if (out.has_error())
                 break;
-        
-            if (diag.state == step_state::ok)
-            {
-                if (std::holds_alternative<index_step>(astep.step))
-                {
-                    last_valid_item = ctx.value;
-                }
-                else if (std::holds_alternative<column_step>(astep.step))
-                {
-                    if (ctx.value)
-                        last_valid_item = ctx.value;
-                    else if (ctx.column)
-                        last_valid_item = *ctx.column;
-                }
-                else if (std::holds_alternative<key_step>(astep.step))
-                {
-                    if (ctx.key)
-                    {
-                        // If this is an array value and we might index it,
-                        // store the value pointer instead of the key_view
-                        const auto& val = ctx.key->value();
-                        if (is_array(val))
-                            last_valid_item = &val;
-                        else
-                            last_valid_item = *ctx.key;
-                    }
-                }
-                else if (std::holds_alternative<row_step>(astep.step))
-                {
-                    last_valid_item = *ctx.row;
-                }
-                else if (std::holds_alternative<table_step>(astep.step))
-                {
-                    last_valid_item = *ctx.table;
-                }
-                else if (std::holds_alternative<top_category_step>(astep.step) ||
-                        std::holds_alternative<sub_category_step>(astep.step))
-                {
-                    last_valid_item = *ctx.category;
-                }
-            }
 
+            detail::advance_item(ctx, astep.step, out.item);
         }
 
-        out.item = last_valid_item;
-        out.addr = addr;
-
         // Extract value from item
         if (auto pv = std::get_if<const typed_value*>(&out.item))
-        {
             out.value = *pv;
-        }
         else if (auto kv = std::get_if<document::key_view>(&out.item))
-        {
             out.value = &kv->value();
-        }
-        else
-        {
-            out.value = nullptr;
-        }    
 
         return out;
     }
 
+// ------------------------------------------------------------
+// inspect - mutable version
+// ------------------------------------------------------------
+// Mutable version: Writes diagnostics to addr.
+// Not thread-safe if addr is shared across threads.
+// ------------------------------------------------------------
+// Note: Addresses can be reused across multiple inspections.
+// Each inspection resets and rewrites address diagnostic state.
+// The address in the returned inpected object is a frozen copy.
+// Use locate() where only the resolved item is needed.
+// ------------------------------------------------------------
+
+    inline inspected inspect(
+        inspect_context& ctx,
+        address& addr
+    )
+    {
+        auto loc = locate(ctx, addr);
+
+        for (size_t i = 0; i < loc.steps_inspected; ++i)
+            addr.steps[i].diagnostic = loc.diagnostic(i);
+
+        inspected out;
+        out.addr = addr;
+        out.item = loc.item;
+        out.value = loc.value;
+        out.steps_inspected = loc.steps_inspected;
+        return out;
+    }
+
 // ------------------------------------------------------------
 // inspect - immutable version
 // ------------------------------------------------------------
-// Const version: Copies addr internally, returns diagnostics in result.
-// Thread-safe for shared addresses.
-// Slightly less efficient (one copy + allocation).
+// Const version: Returns diagnostics in the result's copy of addr.
+// Thread-safe for shared addresses and a shared document, provided
+// each thread uses its own inspect_context.
 // ------------------------------------------------------------
-    inspected inspect(inspect_context& ctx, const address& addr)
+    inline inspected inspect(inspect_context& ctx, const address& addr)
     {
-        address temp = addr;
-        return inspect(ctx, temp);
+        auto loc = locate(ctx, addr);
+
+        inspected out;
+        out.addr = addr;
+        for (size_t i = 0; i < loc.steps_inspected; ++i)
+            out.addr->steps[i].diagnostic = loc.diagnostic(i);
+
+        out.item = loc.item;
+        out.value = loc.value;
+        out.steps_inspected = loc.steps_inspected;
+        return out;
     }
 
 // ------------------------------------------------------------
@@ -809,134 +997,12 @@ namespace nuno::reflect
     inline std::vector<structural_child>
     inspected::structural_children(const inspect_context& ctx) const
     {
-        std::vector<structural_child> out;
-
-        if (!ctx.doc)
-            return out;
-
-        struct structural_query_result {};
-
-        auto query_category = [&](auto&& node) -> structural_query_result
-        {
-            // Special case: root category lists top-level categories
-            if (node.is_root())
-            {
-                for (const auto& cat : ctx.doc->categories())
-                {
-                    if (!cat.is_root() && cat.parent()->is_root())
-                    {
-                        out.push_back({
-                            structural_child::kind::top_category,
-                            cat.name(),
-                            0
-                        });
-                    }
-                }
-            }
-            else
-            {
-                // Non-root: list subcategories normally
-                for (auto sc : node.children())
-                    if (auto cat = ctx.doc->category(sc); cat.has_value())
-                    {
-                        out.push_back({
-                            structural_child::kind::sub_category,
-                            cat->name(),
-                            0
-                        });
-                    }
-            }
-
-            // keys
-            for (auto k : node.keys())
-                if (auto key = ctx.doc->key(k); key.has_value())
-                {
-                    out.push_back({
-                        structural_child::kind::key,
-                        key->name(),
-                        0
-                    });
-                }
-
-            // tables (ordinal only)
-            size_t i = 0;
-            for (auto tid : node.tables())
-            {
-                (void)tid;
-                out.push_back({
-                    structural_child::kind::table,
-                    {},
-                    static_cast<size_t>(tid)
-                });
-            }
-
-            return structural_query_result{};
-        };
-
-        auto query_table = [&](auto&& node) -> structural_query_result
-        {
-            for (auto rid : node.rows())
-            {
-                out.push_back({
-                    structural_child::kind::row,
-                    {},
-                    static_cast<size_t>(rid)
-                });
-            }
-            return structural_query_result{};
-        };
-
-        auto query_table_row = [&](auto&& node) -> structural_query_result
-        {
-            for (auto c : node.table().columns())
-                if (auto col = ctx.doc->column(c); col.has_value())
-                {
-                    out.push_back({
-                        structural_child::kind::column,
-                        col->name(),
-                        col->index()
-                    });
-                }
-            return structural_query_result{};
-        };
-
-        auto query_value = [&](auto&& node) -> structural_query_result
-        {
-            if (node && is_array(*node))
-            {
-                auto& arr = std::get<std::vector<typed_value>>(node->val);
-                for (size_t i = 0; i < arr.size(); ++i)
-                {
-                    out.push_back({
-                        structural_child::kind::index,
-                        {},
-                        i
-                    });
-                }
-            }
-            return structural_query_result{};
-        };
-
-        std::visit([&](auto&& node)
-        {
-            using T = std::decay_t<decltype(node)>;
-
-            if constexpr (std::is_same_v<T, document::category_view>)
-                query_category(node);
-
-            else if constexpr (std::is_same_v<T, document::table_view>)
-                query_table(node);
-
-            else if constexpr (std::is_same_v<T, document::table_row_view>)
-                query_table_row(node);
-
-            else if constexpr (std::is_same_v<T, const typed_value*>)
-                query_value(node);
-
-            else if constexpr (std::is_same_v<T, document::key_view>)
-                query_value(&node.value());
-        }, item);
+        auto range = structural_children_range(ctx);
 
+        std::vector<structural_child> out;
+        out.reserve(range.size());
+        for (auto child : range)
+            out.push_back(child);
         return out;
     }    
 
@@ -996,7 +1062,7 @@ namespace nuno::reflect
     {
         std::vector<prefix_match> out;
 
-        for (const auto& c : structural_children(ctx))
+        for (const auto& c : structural_children_range(ctx))
         {
             if (!prefix.empty())
             {
@@ -1036,8 +1102,7 @@ namespace nuno::reflect
         address& addr
     )
     {
-        auto res = inspect(ctx, addr);
-        return res.value;
+        return locate(ctx, addr).value;
     }
 
 } // namespace nuno::reflect
@@ -0,0 +1,956 @@
+// nuno_reload.hpp - A Readable Format (NUNO) - Incremental reload
+// Version 0.3.0
+// Copyright 2025 Mikael Ueno A
+// Licenced as-is under the MIT licence.
+
+//========================================================================
+// Reloading re-parses only the top-level sections whose text changed.
+//
+// digest_source() splits source text into spans: the root preamble
+// followed by one span per top-level category, each running from its
+// header line up to the next top-level header. Every span carries a
+// hash of its bytes. reload() compares the digest of the new text with
+// that of the previous one, parses each changed span on its own and
+// patches the result into a fork of the previous document with
+// diff/apply (see nuno_diff.hpp). Entities in unchanged spans are not
+// touched, and entities in changed spans that match keep their IDs.
+//
+// Text whose sections cannot be told apart by their lines alone, e.g.
+// because a close returns to the root in the middle of the file or a
+// top-level name is repeated, is reloaded in full; the patch is still
+// computed by diff, so IDs remain stable.
+//
+// The patched entities are then rebound to the text they were parsed
+// from (see source_rebinder), so a reloaded document serializes as a
+// load of the same text would: comments, paragraphs, the order of
+// categories and tables, and the authored form of each line are those
+// of the new text.
+//
+// file_watcher reports changes to a file, through inotify on Linux and
+// by polling its size and modification time elsewhere (or on request).
+// hot_document ties the two to a versioned_document.
+//========================================================================
+
+#ifndef NUNO_RELOAD_HPP
+#define NUNO_RELOAD_HPP
+
+#include "nuno.hpp"
+#include "nuno_concurrency.hpp"
+#include "nuno_diff.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && !defined(NUNO_NO_INOTIFY)
+    #define NUNO_HAS_INOTIFY 1
+    #include <cerrno>
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace nuno
+{
+//========================================================================
+// Source digests
+//========================================================================
+
+    struct source_span
+    {
+        std::string name;           // top-level category name; empty for the root preamble
+        size_t      offset     {0};
+        size_t      length     {0};
+        size_t      first_line {0}; // lines preceding the span
+        uint64_t    hash       {0};
+    };
+
+    struct source_digest
+    {
+        std::vector<source_span> spans;   // the preamble first, then in source order
+        bool splittable {true};
+
+        source_span const* find(std::string_view name) const noexcept
+        {
+            for (auto const& s : spans)
+                if (s.name == name)
+                    return &s;
+            return nullptr;
+        }
+    };
+
+    source_digest digest_source(std::string_view text);
+
+//========================================================================
+// Reload
+//========================================================================
+
+    struct reload_context : doc_context
+    {
+        source_digest            digest;    // digest of the new text
+        std::vector<std::string> reparsed;  // spans parsed by this reload, "" for the preamble
+        bool                     full {false};
+    };
+
+    // Errors are those of the re-parsed spans, with lines counted from
+    // the start of the whole text.
+    reload_context reload(document const& previous, source_digest const& previous_digest,
+                          std::string_view text, parser_options popt = {}, materialiser_options mopt = {});
+
+//========================================================================
+// Change notification
+//========================================================================
+
+    class file_watcher
+    {
+    public:
+        enum class mode
+        {
+            automatic,  // inotify where available, polling otherwise
+            polling,
+        };
+
+        explicit file_watcher(std::filesystem::path file, mode m = mode::automatic,
+                              std::chrono::milliseconds interval = std::chrono::milliseconds{20});
+        ~file_watcher();
+
+        file_watcher(file_watcher const&) = delete;
+        file_watcher& operator=(file_watcher const&) = delete;
+
+        // Waits up to timeout for the file to be written, replaced or
+        // removed. Returns true if it was since the previous call.
+        bool wait(std::chrono::milliseconds timeout);
+        bool changed() { return wait(std::chrono::milliseconds{0}); }
+
+        bool notified() const noexcept { return fd_ >= 0; }
+        std::filesystem::path const& path() const noexcept { return file_; }
+
+    private:
+        struct stamp
+        {
+            bool                            exists {false};
+            std::uintmax_t                  size   {0};
+            std::filesystem::file_time_type time   {};
+
+            bool operator==(stamp const&) const = default;
+        };
+
+        std::filesystem::path     file_;
+        std::chrono::milliseconds interval_;
+        stamp                     last_;
+        int                       fd_ {-1};
+
+        stamp current() const;
+        bool  poll_once();
+        bool  read_events(std::chrono::milliseconds timeout);
+    };
+
+//========================================================================
+// Hot document
+//========================================================================
+
+    struct hot_reload_options
+    {
+        parser_options       parser       {};
+        materialiser_options materialiser {};
+        file_watcher::mode   watch        {file_watcher::mode::automatic};
+    };
+
+    // The file is the source of truth for the sections it changes: a
+    // reload replaces edits made through versions() in those sections
+    // and keeps the others. Writes made while a reload runs wait for it
+    // and apply to the reloaded version.
+    class hot_document
+    {
+    public:
+        explicit hot_document(std::filesystem::path file, hot_reload_options opts = {});
+
+        versioned_document::snapshot_ptr snapshot() const { return versions_.snapshot(); }
+        versioned_document& versions() noexcept { return versions_; }
+
+        // Waits up to timeout for the file to change and reloads it.
+        // Returns true if a new version was published.
+        bool poll(std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+
+        // Errors and re-parsed spans of the latest load
+        std::vector<error<any_error>> const& errors() const noexcept { return errors_; }
+        std::vector<std::string> const& reparsed() const noexcept { return reparsed_; }
+
+    private:
+        // initial() fills the digest and errors before versions_ exists
+        hot_reload_options            opts_;
+        file_watcher                  watcher_;
+        source_digest                 digest_;
+        std::vector<error<any_error>> errors_;
+        std::vector<std::string>      reparsed_;
+        versioned_document            versions_;
+
+        static bool read_file(std::filesystem::path const& p, std::string& out);
+        static document initial(std::filesystem::path const& p, hot_reload_options const& opts,
+                                source_digest& digest, std::vector<error<any_error>>& errors);
+    };
+
+//========================================================================
+// Implementation
+//========================================================================
+
+    namespace detail
+    {
+        // Follows the line classification of the parser closely enough
+        // to see where top-level categories start and whether anything
+        // returns to the root between them.
+        class span_scanner
+        {
+        public:
+            explicit span_scanner(std::string_view text) : text_(text) {}
+
+            source_digest run()
+            {
+                begin_span("", 0, 0);
+
+                size_t start = 0, line_no = 0;
+                while (start < text_.size())
+                {
+                    size_t end = text_.find('\n', start);
+                    auto line = end == std::string_view::npos ? text_.substr(start) : text_.substr(start, end - start);
+
+                    scan_line(trim_sv(line), start, line_no);
+
+                    if (end == std::string_view::npos)
+                        break;
+                    start = end + 1;
+                    ++line_no;
+                }
+
+                end_span(text_.size());
+                return std::move(out_);
+            }
+
+        private:
+            std::string_view         text_;
+            source_digest            out_;
+            std::vector<std::string> open_; // top-level category first
+            size_t                   span_start_ {0};
+
+            void begin_span(std::string name, size_t offset, size_t line)
+            {
+                out_.spans.push_back({ .name = std::move(name), .offset = offset, .first_line = line });
+                span_start_ = offset;
+            }
+
+            void end_span(size_t offset)
+            {
+                auto& s = out_.spans.back();
+                s.length = offset - span_start_;
+                s.hash   = xxh64::hash(text_.substr(s.offset, s.length), 0);
+            }
+
+            void scan_line(std::string_view trimmed, size_t offset, size_t line_no)
+            {
+                if (trimmed.empty() || trimmed.starts_with("//"))
+                    return;
+
+                if (trimmed.starts_with(":"))
+                {
+                    // A subcategory of the root belongs to no span
+                    if (open_.empty())
+                        out_.splittable = false;
+                    open_.push_back(to_lower(std::string(trim_sv(trimmed.substr(1)))));
+                    return;
+                }
+
+                if (trimmed.starts_with("/") && trimmed.size() > 1)
+                {
+                    // Closes at the root become comments
+                    if (open_.empty())
+                        return;
+
+                    auto name = to_lower(std::string(trim_sv(trimmed.substr(1))));
+                    if (open_.size() > 1 && (name.empty() || name == open_.back()))
+                        open_.pop_back();
+                    else
+                        out_.splittable = false;    // back at the root, or resolved by name
+                    return;
+                }
+
+                if (trimmed.ends_with(":"))
+                {
+                    auto name = to_lower(std::string(trim_sv(trimmed.substr(0, trimmed.size() - 1))));
+                    if (out_.find(name))
+                        out_.splittable = false;
+
+                    end_span(offset);
+                    begin_span(name, offset, line_no);
+                    open_.assign(1, std::move(name));
+                }
+            }
+        };
+
+        inline void offset_lines(std::vector<error<any_error>>& errors, size_t lines)
+        {
+            for (auto& e : errors)
+            {
+                if (e.loc.line) e.loc.line += lines;
+                std::visit([&](auto& inner) { if (inner.loc.line) inner.loc.line += lines; }, e.kind);
+            }
+        }
+
+        // Gives the entities of a re-parsed span the source of the text
+        // they were parsed from. apply() leaves them equal in value to
+        // the part parsed, but edited, without the part's comments and
+        // paragraphs and with categories where they were. The rebinder
+        // pairs each entity with its counterpart in the part and takes
+        // over the part's authored order, comments, paragraphs and
+        // source events, so the document serializes as the text does.
+        //
+        // The new source is the previous one with the events of each
+        // rebound part appended: entities of unchanged spans keep their
+        // event indices, and the events of replaced ones are left
+        // behind until a full reload starts the source afresh.
+        class source_rebinder
+        {
+        public:
+            // Continuing the document's own source, or starting afresh
+            source_rebinder(document& doc, bool keep_source)
+                : doc_(doc)
+            {
+                if (!keep_source)
+                    source_ = std::make_shared<parse_context>();
+                else if (doc.source_context_)
+                    source_ = std::make_shared<parse_context>(*doc.source_context_);
+            }
+
+            // Rebinds the category `at` to `from` of the part, with its
+            // subcategories or only its own items. False, with nothing
+            // changed, if the two do not pair up.
+            bool rebind(category_id at, document const& part, category_id from, bool subcategories)
+            {
+                part_ = &part;
+                categories_.clear(); keys_.clear(); tables_.clear(); rows_.clear();
+                pairs_.clear(); table_pairs_.clear(); row_pairs_.clear();
+
+                if (!match(at, from, subcategories) || !mappable())
+                    return false;
+
+                base_ = 0;
+                if (source_ && part.source_context_)
+                {
+                    auto& events = source_->document.events;
+                    base_ = events.size();
+                    events.insert(events.end(), part.source_context_->document.events.begin(),
+                                                part.source_context_->document.events.end());
+                }
+                else
+                    source_.reset();
+
+                for (auto [a, b] : pairs_)
+                    take_category(a, b, subcategories || a != at);
+                for (auto [a, b] : table_pairs_)
+                    take_table(a, b);
+                for (auto [a, b] : row_pairs_)
+                    take_source(*doc_.get_node(a), *part.peek_node(b));
+                for (auto [b, a] : keys_)
+                    take_source(*doc_.get_node(a), *part.peek_node(key_id{b}));
+                return true;
+            }
+
+            // Puts the top-level categories in the order of the names
+            void order_top_level(std::vector<std::string_view> const& names)
+            {
+                auto const* root = doc_.peek_node(category_id{0});
+
+                std::vector<category_id> order;
+                order.reserve(root->children.size());
+                for (auto name : names)
+                    if (auto c = doc_.root()->child(name))
+                        order.push_back(c->id());
+                for (auto c : root->children)
+                    if (std::ranges::find(order, c) == order.end())
+                        order.push_back(c);
+
+                if (std::ranges::equal(order, root->children))
+                    return;
+
+                std::vector<document::source_item_ref> items;
+                for (auto const& item : root->ordered_items)
+                    if (!std::holds_alternative<category_id>(item.id))
+                        items.push_back(item);
+                for (auto c : order)
+                    items.push_back({c});
+
+                auto& node = *doc_.get_node(category_id{0});
+                node.children.edit() = std::move(order);
+                node.ordered_items.clear();
+                for (auto& item : items)
+                    node.ordered_items.push_back(std::move(item));
+            }
+
+            // Events in the new source, live or left behind
+            size_t events() const noexcept { return source_ ? source_->document.events.size() : 0; }
+
+            void finish() { doc_.source_context_ = std::move(source_); }
+
+        private:
+            template<typename Id>
+            using id_map = std::unordered_map<typename Id::value_type, Id>;
+
+            document&                      doc_;
+            document const*                part_ {nullptr};
+            std::shared_ptr<parse_context> source_;
+            size_t                         base_ {0};
+
+            // Part entity to document entity
+            id_map<category_id> categories_;
+            id_map<key_id>      keys_;
+            id_map<table_id>    tables_;
+            id_map<row_id>      rows_;
+
+            // Document entity and its part counterpart
+            std::vector<std::pair<category_id, category_id>> pairs_;
+            std::vector<std::pair<table_id, table_id>>       table_pairs_;
+            std::vector<std::pair<row_id, row_id>>           row_pairs_;
+
+            bool match(category_id at, category_id from, bool subcategories)
+            {
+                auto const* a = doc_.peek_node(at);
+                auto const* b = part_->peek_node(from);
+                if (!a || !b)
+                    return false;
+
+                categories_[from.val] = at;
+                pairs_.emplace_back(at, from);
+
+                // Keys by name, repeated names in order, as diff pairs them
+                auto km = match_siblings(a->keys.size(), b->keys.size(),
+                    [&](size_t i) { return doc_.peek_node(a->keys[i])->name; },
+                    [&](size_t j) { return part_->peek_node(b->keys[j])->name; });
+                if (a->keys.size() != b->keys.size())
+                    return false;
+                for (size_t j = 0; j < b->keys.size(); ++j)
+                {
+                    if (km.to_from[j] == sibling_match::none)
+                        return false;
+                    keys_[b->keys[j].val] = a->keys[km.to_from[j]];
+                }
+
+                // Tables and their rows by position
+                if (a->tables.size() != b->tables.size())
+                    return false;
+                for (size_t n = 0; n < b->tables.size(); ++n)
+                {
+                    auto const* ta = doc_.peek_node(a->tables[n]);
+                    auto const* tb = part_->peek_node(b->tables[n]);
+                    if (!ta || !tb || ta->columns.size() != tb->columns.size() || ta->rows.size() != tb->rows.size())
+                        return false;
+
+                    tables_[tb->id.val] = ta->id;
+                    table_pairs_.emplace_back(ta->id, tb->id);
+
+                    auto ra = ta->rows.begin();
+                    for (auto rb : tb->rows)
+                    {
+                        rows_[rb.val] = *ra;
+                        row_pairs_.emplace_back(*ra, rb);
+                        ++ra;
+                    }
+                }
+
+                if (!subcategories)
+                    return b->children.empty();
+
+                auto cm = match_siblings(a->children.size(), b->children.size(),
+                    [&](size_t i) { return doc_.peek_node(a->children[i])->name; },
+                    [&](size_t j) { return part_->peek_node(b->children[j])->name; });
+                if (a->children.size() != b->children.size())
+                    return false;
+                for (size_t j = 0; j < b->children.size(); ++j)
+                    if (cm.to_from[j] == sibling_match::none || !match(a->children[cm.to_from[j]], b->children[j], true))
+                        return false;
+                return true;
+            }
+
+            // Every item of the part has its counterpart
+            bool mappable() const
+            {
+                auto known = [this](document::source_item_ref const& item)
+                {
+                    return std::visit([this](auto const& id)
+                    {
+                        using T = std::decay_t<decltype(id)>;
+                        if constexpr (std::is_same_v<T, key_id>)                                return keys_.contains(id.val);
+                        else if constexpr (std::is_same_v<T, table_id>)                         return tables_.contains(id.val);
+                        else if constexpr (std::is_same_v<T, row_id>)                           return rows_.contains(id.val);
+                        else if constexpr (std::is_same_v<T, category_id>)                      return categories_.contains(id.val);
+                        else if constexpr (std::is_same_v<T, document::category_close_marker>)  return categories_.contains(id.which.val);
+                        else                                                                    return true;
+                    }, item.id);
+                };
+
+                for (auto [a, b] : pairs_)
+                    if (!std::ranges::all_of(part_->peek_node(b)->ordered_items, known))
+                        return false;
+                for (auto [a, b] : table_pairs_)
+                    if (!std::ranges::all_of(part_->peek_node(b)->ordered_items, known))
+                        return false;
+                return true;
+            }
+
+            std::optional<size_t> event(std::optional<size_t> index) const noexcept
+            {
+                return index && source_ ? std::optional<size_t>(*index + base_) : std::nullopt;
+            }
+
+            template<typename N, typename P>
+            void take_source(N& node, P const& from)
+            {
+                node.creation           = from.creation;
+                node.is_edited          = from.is_edited;
+                node.source_event_index = event(from.source_event_index);
+            }
+
+            template<typename Id>
+            static std::vector<Id> mapped(shared_list<Id> const& ids, id_map<Id> const& map)
+            {
+                std::vector<Id> res;
+                res.reserve(ids.size());
+                for (auto id : ids)
+                    res.push_back(map.at(id.val));
+                return res;
+            }
+
+            // Comments and paragraphs of the document are dropped and
+            // those of the part copied in their place
+            void drop_prose(document::ordered_item_list const& items)
+            {
+                std::vector<document::source_item_ref> prose;
+                for (auto const& item : items)
+                    if (std::holds_alternative<comment_id>(item.id) || std::holds_alternative<paragraph_id>(item.id))
+                        prose.push_back(item);
+
+                for (auto const& item : prose)
+                {
+                    if (auto const* c = std::get_if<comment_id>(&item.id)) doc_.erase_node(*c);
+                    else                                                   doc_.erase_node(std::get<paragraph_id>(item.id));
+                }
+            }
+
+            template<typename N>
+            document::source_item_ref copy_prose(N const& src)
+            {
+                N node = src;
+                node.owner              = categories_.at(src.owner.val);
+                node.source_event_index = event(src.source_event_index);
+
+                if constexpr (std::is_same_v<N, document::comment_node>)
+                {
+                    node.id = doc_.create_comment_id();
+                    doc_.comments_.push_back(node);
+                }
+                else
+                {
+                    node.id = doc_.create_paragraph_id();
+                    doc_.paragraphs_.push_back(node);
+                }
+                return {node.id};
+            }
+
+            std::vector<document::source_item_ref> map_items(document::ordered_item_list const& items)
+            {
+                std::vector<document::source_item_ref> res;
+                for (auto const& item : items)
+                {
+                    res.push_back(std::visit([this](auto const& id) -> document::source_item_ref
+                    {
+                        using T = std::decay_t<decltype(id)>;
+                        if constexpr (std::is_same_v<T, key_id>)          return {keys_.at(id.val)};
+                        else if constexpr (std::is_same_v<T, table_id>)   return {tables_.at(id.val)};
+                        else if constexpr (std::is_same_v<T, row_id>)     return {rows_.at(id.val)};
+                        else if constexpr (std::is_same_v<T, category_id>) return {categories_.at(id.val)};
+                        else if constexpr (std::is_same_v<T, document::category_close_marker>)
+                            return {document::category_close_marker{categories_.at(id.which.val), id.form}};
+                        else
+                            return copy_prose(*part_->peek_node(id));
+                    }, item.id));
+                }
+                return res;
+            }
+
+            static void assign(document::ordered_item_list& list, std::vector<document::source_item_ref> items)
+            {
+                list.clear();
+                list.reserve(items.size());
+                for (auto& item : items)
+                    list.push_back(std::move(item));
+            }
+
+            void take_category(category_id at, category_id from, bool subcategories)
+            {
+                auto const& src = *part_->peek_node(from);
+
+                drop_prose(doc_.peek_node(at)->ordered_items);
+                auto items = map_items(src.ordered_items);
+
+                auto& cat = *doc_.get_node(at);
+
+                // Only own items are taken; subcategories keep their place
+                if (subcategories)
+                    cat.children.edit() = mapped(src.children, categories_);
+                else
+                {
+                    for (auto const& item : cat.ordered_items)
+                        if (std::holds_alternative<category_id>(item.id))
+                            items.push_back(item);
+                }
+
+                assign(cat.ordered_items, std::move(items));
+                cat.keys.edit()   = mapped(src.keys, keys_);
+                cat.tables.edit() = mapped(src.tables, tables_);
+
+                cat.creation                 = src.creation;
+                cat.is_edited                = src.is_edited;
+                cat.source_event_index_open  = event(src.source_event_index_open);
+                cat.source_event_index_close = event(src.source_event_index_close);
+            }
+
+            void take_table(table_id at, table_id from)
+            {
+                auto const& src = *part_->peek_node(from);
+
+                drop_prose(doc_.peek_node(at)->ordered_items);
+                auto items = map_items(src.ordered_items);
+
+                auto& tbl = *doc_.get_node(at);
+                assign(tbl.ordered_items, std::move(items));
+                take_source(tbl, src);
+
+                for (size_t i = 0; i < tbl.columns.size(); ++i)
+                    take_source(*doc_.get_node(tbl.columns[i]), *part_->peek_node(src.columns[i]));
+            }
+        };
+
+        inline document_diff single_change(document const& from, document const& to, change c)
+        {
+            document_diff d { .from = &from, .to = &to };
+            d.changes.push_back(std::move(c));
+            return d;
+        }
+
+        class reloader
+        {
+        public:
+            reloader(document const& previous, source_digest const& previous_digest,
+                     std::string_view text, reload_context& out, parser_options popt, materialiser_options mopt)
+                : prev_(previous), prev_digest_(previous_digest), text_(text), out_(out), popt_(popt), mopt_(mopt)
+            {}
+
+            // Patches changed spans into out.document. False if the
+            // spans do not line up with the previous document.
+            bool spans()
+            {
+                editor ed(out_.document);
+                editor::batch settle(ed);
+                source_rebinder rebind(out_.document, true);
+
+                auto root = prev_.root()->id();
+
+                for (auto const& span : out_.digest.spans)
+                {
+                    auto const* before = prev_digest_.find(span.name);
+                    if (before && before->hash == span.hash)
+                        continue;
+
+                    auto part = parse_span(span);
+
+                    if (span.name.empty())
+                    {
+                        if (!apply(ed, diff(prev_, root, part.document, part.document.root()->id(), false))
+                         || !rebind.rebind(root, part.document, part.document.root()->id(), false))
+                            return false;
+                        continue;
+                    }
+
+                    auto now = part.document.root()->child(span.name);
+                    auto was = prev_.root()->child(span.name);
+                    if (!now || (before && !was))
+                        return false;
+
+                    bool ok = before
+                        ? apply(ed, diff(prev_, was->id(), part.document, now->id()))
+                        : apply(ed, single_change(prev_, part.document,
+                                                  { .kind = change_kind::added, .to = now->id(),
+                                                    .path = span.name, .owner = root }));
+                    auto at = out_.document.root()->child(span.name);
+                    if (!ok || !at || !rebind.rebind(at->id(), part.document, now->id(), true))
+                        return false;
+                }
+
+                for (auto const& span : prev_digest_.spans)
+                {
+                    if (span.name.empty() || out_.digest.find(span.name))
+                        continue;
+
+                    auto was = prev_.root()->child(span.name);
+                    if (!was)
+                        return false;
+
+                    if (!apply(ed, single_change(prev_, prev_, { .kind = change_kind::removed, .from = was->id(),
+                                                                 .path = span.name, .owner = root })))
+                        return false;
+                }
+
+                std::vector<std::string_view> names;
+                for (auto const& span : out_.digest.spans)
+                    if (!span.name.empty())
+                        names.push_back(span.name);
+                rebind.order_top_level(names);
+
+                // There are no more events than lines. Past twice that,
+                // most are left behind and a full reload starts afresh.
+                if (rebind.events() > 2 * (static_cast<size_t>(std::ranges::count(text_, '\n')) + 1))
+                    return false;
+
+                rebind.finish();
+                return true;
+            }
+
+            void whole()
+            {
+                out_.document = prev_.fork();
+                out_.errors.clear();
+                out_.reparsed.clear();
+                out_.full = true;
+
+                auto all = load(text_, popt_, mopt_);
+                for (auto const& span : out_.digest.spans)
+                    out_.reparsed.push_back(span.name);
+                out_.errors = std::move(all.errors);
+
+                editor ed(out_.document);
+                apply(ed, diff(prev_, all.document));
+
+                source_rebinder rebind(out_.document, false);
+                if (rebind.rebind(out_.document.root()->id(), all.document, all.document.root()->id(), true))
+                    rebind.finish();
+            }
+
+        private:
+            document const&      prev_;
+            source_digest const& prev_digest_;
+            std::string_view     text_;
+            reload_context&      out_;
+            parser_options       popt_;
+            materialiser_options mopt_;
+
+            doc_context parse_span(source_span const& span)
+            {
+                auto part = load(text_.substr(span.offset, span.length), popt_, mopt_);
+                offset_lines(part.errors, span.first_line);
+                out_.errors.insert(out_.errors.end(), part.errors.begin(), part.errors.end());
+                out_.reparsed.push_back(span.name);
+                return part;
+            }
+        };
+    }
+
+    inline source_digest digest_source(std::string_view text)
+    {
+        return detail::span_scanner(text).run();
+    }
+
+    inline reload_context reload(document const& previous, source_digest const& previous_digest,
+                                 std::string_view text, parser_options popt, materialiser_options mopt)
+    {
+        reload_context out;
+        out.digest   = digest_source(text);
+        out.document = previous.fork();
+
+        detail::reloader r(previous, previous_digest, text, out, popt, mopt);
+        if (!previous_digest.splittable || !out.digest.splittable || !r.spans())
+            r.whole();
+
+        return out;
+    }
+
+//------------------------------------------------------------------------
+
+    inline file_watcher::file_watcher(std::filesystem::path file, mode m, std::chrono::milliseconds interval)
+        : file_(std::move(file))
+        , interval_(interval)
+        , last_(current())
+    {
+#ifdef NUNO_HAS_INOTIFY
+        if (m == mode::automatic)
+        {
+            fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+            // Watch the directory: editors often replace a file rather
+            // than write it in place.
+            auto dir = file_.parent_path().empty() ? std::filesystem::path(".") : file_.parent_path();
+            constexpr uint32_t events = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM;
+            if (fd_ >= 0 && ::inotify_add_watch(fd_, dir.c_str(), events) < 0)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+#else
+        (void)m;
+#endif
+    }
+
+    inline file_watcher::~file_watcher()
+    {
+#ifdef NUNO_HAS_INOTIFY
+        if (fd_ >= 0)
+            ::close(fd_);
+#endif
+    }
+
+    inline file_watcher::stamp file_watcher::current() const
+    {
+        std::error_code ec;
+        stamp s;
+        s.size = std::filesystem::file_size(file_, ec);
+        if (ec) return s;
+        s.time = std::filesystem::last_write_time(file_, ec);
+        s.exists = !ec;
+        return s;
+    }
+
+    inline bool file_watcher::poll_once()
+    {
+        auto now = current();
+        if (now == last_)
+            return false;
+        last_ = now;
+        return true;
+    }
+
+    inline bool file_watcher::wait(std::chrono::milliseconds timeout)
+    {
+        if (fd_ >= 0)
+            return read_events(timeout);
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!poll_once())
+        {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero())
+                return false;
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(left, interval_));
+        }
+        return true;
+    }
+
+    inline bool file_watcher::read_events(std::chrono::milliseconds timeout)
+    {
+#ifdef NUNO_HAS_INOTIFY
+        auto name     = file_.filename().string();
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool seen     = false;
+
+        alignas(inotify_event) char buf[4096];
+        for (;;)
+        {
+            ssize_t n = ::read(fd_, buf, sizeof buf);
+            if (n > 0)
+            {
+                for (char* p = buf; p < buf + n; )
+                {
+                    auto const* ev = reinterpret_cast<inotify_event const*>(p);
+                    if (ev->len && name == ev->name)
+                        seen = true;
+                    p += sizeof(inotify_event) + ev->len;
+                }
+                continue;   // drain everything queued so far
+            }
+
+            if (seen)
+                break;
+
+            if (n < 0 && errno != EAGAIN && errno != EINTR)
+                return poll_once();
+
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+                return false;
+
+            pollfd pfd { fd_, POLLIN, 0 };
+            if (::poll(&pfd, 1, int(left.count())) == 0)
+                return false;
+        }
+
+        // Events for a write still in progress coalesce into this one
+        last_ = current();
+        return true;
+#else
+        (void)timeout;
+        return false;
+#endif
+    }
+
+//------------------------------------------------------------------------
+
+    inline hot_document::hot_document(std::filesystem::path file, hot_reload_options opts)
+        : opts_(opts)
+        , watcher_(file, opts.watch)
+        , versions_(initial(file, opts, digest_, errors_))
+    {
+    }
+
+    inline bool hot_document::read_file(std::filesystem::path const& p, std::string& out)
+    {
+        std::ifstream in(p, std::ios::binary);
+        if (!in)
+            return false;
+        out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return !in.bad();
+    }
+
+    inline document hot_document::initial(std::filesystem::path const& p, hot_reload_options const& opts,
+                                          source_digest& digest, std::vector<error<any_error>>& errors)
+    {
+        std::string text;
+        read_file(p, text);
+        digest = digest_source(text);
+
+        auto ctx = load(text, opts.parser, opts.materialiser);
+        errors = std::move(ctx.errors);
+        return std::move(ctx.document);
+    }
+
+    inline bool hot_document::poll(std::chrono::milliseconds timeout)
+    {
+        if (!watcher_.wait(timeout))
+            return false;
+
+        std::string text;
+        if (!read_file(watcher_.path(), text))
+            return false;
+
+        auto digest = digest_source(text);
+        bool same = digest.spans.size() == digest_.spans.size()
+                 && std::equal(digest.spans.begin(), digest.spans.end(), digest_.spans.begin(),
+                               [](source_span const& a, source_span const& b) { return a.name == b.name && a.hash == b.hash; });
+        if (same)
+            return false;
+
+        versions_.rebuild([&](document const& latest)
+        {
+            auto ctx = reload(latest, digest_, text, opts_.parser, opts_.materialiser);
+            digest_   = std::move(ctx.digest);
+            errors_   = std::move(ctx.errors);
+            reparsed_ = std::move(ctx.reparsed);
+            return std::move(ctx.document);
+        });
+        return true;
+    }
+}
+
+#endif
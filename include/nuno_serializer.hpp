@@ -14,7 +14,7 @@
 namespace nuno
 {
 
-    #define DBG_EMIT std::cout << "[S] "
+    #define DBG_EMIT NUNO_TRACE_STREAM("[S] ")
 
 //========================================================================
 // SERIALIZER_OPTIONS
@@ -39,6 +39,8 @@ namespace nuno
         bool emit_comments {true};      // If false, skip comment events
         bool emit_paragraphs {true};    // If false, skip paragraph events
 
+        metrics_sink* metrics {nullptr}; // receives serialize_metrics, see nuno_metrics.hpp
+
         bool echo_lines  {false};       // prints each node to be serialised
     };
 
@@ -56,14 +58,47 @@ namespace nuno
 
         void write(std::ostream& out)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write\n";
 
+            if (auto* sink = detail::active_sink(opts_.metrics))
+                return write_measured(out, *sink);
+
             out_ = &out;
             write_category_open(doc_.categories_.front());            
         }
 
     private:
+        // Writes through a counting buffer and reports to the sink
+        void write_measured(std::ostream& out, metrics_sink& sink)
+        {
+            auto started = std::chrono::steady_clock::now();
+
+            detail::counting_streambuf counter(out.rdbuf());
+            std::ostream counted(&counter);
+            counted.copyfmt(out);
+
+            // out_ must not be left on the local stream, even if the
+            // write throws
+            struct restore_out
+            {
+                std::ostream*& out_;
+                std::ostream*  saved;
+                ~restore_out() { out_ = saved; }
+            } restore { out_, &out };
+
+            out_ = &counted;
+            write_category_open(doc_.categories_.front());
+            counted.flush();
+            if (!counted)
+                out.setstate(counted.rdstate());
+
+            serialize_metrics m;
+            m.elapsed       = std::chrono::steady_clock::now() - started;
+            m.bytes_written = counter.count();
+            sink.on_serialize(m);
+        }
+
         const document&    doc_;
         std::ostream*      out_;        
         serializer_options opts_;
@@ -96,7 +131,7 @@ namespace nuno
 
         void write_source_item(const document::source_item_ref& ref)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_source_item\n";
             
             std::visit([&](auto&& id) { write_item(id); }, ref.id);
@@ -108,7 +143,7 @@ namespace nuno
 
         void write_item(key_id id)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(keyid)\n";
 
             auto it = doc_.find_node_by_id(doc_.keys_, id);
@@ -118,7 +153,7 @@ namespace nuno
 
         void write_item(category_id id)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(category_id), ID = " << id << std::endl;
 
             auto it = doc_.find_node_by_id(doc_.categories_, id);
@@ -128,7 +163,7 @@ namespace nuno
 
         void write_item(const document::category_close_marker& marker)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(category_close_id), ID = " << marker.which << std::endl;
 
             write_category_close(marker);
@@ -136,7 +171,7 @@ namespace nuno
 
         void write_item(table_id id)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(table_id)\n";
 
             auto it = doc_.find_node_by_id(doc_.tables_, id);
@@ -146,7 +181,7 @@ namespace nuno
 
         void write_item(row_id id)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(row_id)\n";
 
             auto it = doc_.find_node_by_id(doc_.rows_, id);
@@ -156,7 +191,7 @@ namespace nuno
 
         void write_item(comment_id id)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(comment_id{" << id.val << "})\n";
 
             if (!opts_.emit_comments)
@@ -176,7 +211,7 @@ namespace nuno
 
         void write_item(paragraph_id id)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_item(paragraph_id)\n";
 
             if (!opts_.emit_paragraphs)
@@ -195,7 +230,7 @@ namespace nuno
 
         void write_key(const document::key_node& k)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_key " << k.name << std::endl;
 
             bool force_reconstruct = 
@@ -234,7 +269,7 @@ namespace nuno
 
         void write_category_open(const document::category_node& cat)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_category_open: " << cat.name << std::endl;
 
             bool is_root = (cat.id == category_id{0});
@@ -287,7 +322,7 @@ namespace nuno
 
         void write_category_contents(const document::category_node& cat)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
             {
                 DBG_EMIT << "serializer::write_category_contents: "
                          << (cat.id == category_id{0} ? "__root__" : cat.name) << std::endl;
@@ -305,7 +340,7 @@ namespace nuno
 
         void write_category_close(const document::category_close_marker& marker)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_category_close\n";
 
             --indent_;
@@ -341,7 +376,7 @@ namespace nuno
 
         void write_table(const document::table_node& tbl)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_table\n";
 
             bool force_reconstruct = 
@@ -397,7 +432,7 @@ namespace nuno
 
         void write_row(const document::row_node& row)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_row\n";
 
             // Can replay source?
@@ -442,7 +477,7 @@ namespace nuno
 
         void write_comment(const document::comment_node& c)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_comment\n";
 
             // Comments are always emitted verbatim from stored text
@@ -456,7 +491,7 @@ namespace nuno
 
         void write_paragraph(const document::paragraph_node& p)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_paragraph\n";
 
             if (opts_.blank_lines == serializer_options::blank_line_policy::compact
@@ -580,7 +615,7 @@ namespace nuno
                 return;
             }
             
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_value_semantic\n";
 
             // TACIT type OR already matching - emit actual variant contents
@@ -608,22 +643,35 @@ namespace nuno
                 {
                     *out_ << (value ? "true" : "false");
                 }
-                else if constexpr (std::is_same_v<T, std::vector<typed_value>>)
+                else if constexpr (std::is_same_v<T, typed_array>)
                 {
-                    bool first = true;
-                    for (auto const& elem : value)
+                    for (size_t i = 0; i < value.size(); ++i)
                     {
-                        if (!first) *out_ << '|';
-                        write_value(elem);
-                        first = false;
+                        if (i) *out_ << '|';
+                        write_element(value, i);
                     }
                 }
             }, tv.val);
         }
 
+        // Elements held in a compact buffer are written straight from it
+        void write_element(typed_array const& arr, size_t i)
+        {
+            if (!arr.is_compact())
+                return write_value(arr[i]);
+
+            switch (arr.type_at(i))
+            {
+                case value_type::integer:        *out_ << arr.integer_at(i); break;
+                case value_type::floating_point: *out_ << arr.real_at(i); break;
+                case value_type::string:         *out_ << arr.string_at(i); break;
+                default:                         write_value(arr.element(i)); break;
+            }
+        }
+
         void write_converted_to_type(const value& v, value_type target)
         {
-            if (opts_.echo_lines)
+            NUNO_TRACE_IF(opts_.echo_lines)
                 DBG_EMIT << "serializer::write_converted_to_type\n";
 
             switch (target)
@@ -4,19 +4,77 @@
 #include "nuno_document_structure_tests.hpp"
 #include "nuno_reflection_tests.hpp"
 #include "nuno_query_tests.hpp"
+#include "nuno_query_cache_tests.hpp"
 #include "nuno_editor_tests.hpp"
 #include "nuno_serializer_tests.hpp"
 #include "nuno_integration_tests.hpp"
+#include "nuno_cache_tests.hpp"
+#include "nuno_concurrency_tests.hpp"
+#include "nuno_diff_tests.hpp"
+#include "nuno_reload_tests.hpp"
+#include "nuno_metrics_tests.hpp"
 
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <new>
 
 namespace nuno::tests 
 {
     std::vector<test_result> results;    
     char const * last_error = "";
+    std::atomic<size_t> allocated_bytes {0};
 }
 
+// Counting replacements for the global allocation functions, as in the
+// benchmarks. Every form is replaced so that each delete matches the
+// new that allocated.
+
+namespace
+{
+    void* counted_alloc(std::size_t size, std::size_t align)
+    {
+        nuno::tests::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0)
+            size = 1;
+        if (align <= alignof(std::max_align_t))
+            return std::malloc(size);
+
+        // aligned_alloc wants a multiple of the alignment
+        return std::aligned_alloc(align, (size + align - 1) / align * align);
+    }
+
+    void* counted_new(std::size_t size, std::size_t align)
+    {
+        if (void* p = counted_alloc(size, align))
+            return p;
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size)                                              { return counted_new(size, 0); }
+void* operator new[](std::size_t size)                                            { return counted_new(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al)                         { return counted_new(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al)                       { return counted_new(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept              { return counted_alloc(size, 0); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept            { return counted_alloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al, std::nothrow_t const&) noexcept   { return counted_alloc(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al, std::nothrow_t const&) noexcept { return counted_alloc(size, static_cast<std::size_t>(al)); }
+
+void operator delete(void* p) noexcept                                            { std::free(p); }
+void operator delete[](void* p) noexcept                                          { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept                               { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept                             { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept                          { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                        { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept             { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept           { std::free(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept                     { std::free(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept                   { std::free(p); }
+void operator delete(void* p, std::align_val_t, std::nothrow_t const&) noexcept   { std::free(p); }
+void operator delete[](void* p, std::align_val_t, std::nothrow_t const&) noexcept { std::free(p); }
+
 bool first = true;
 
 void run_tests( std::string suite_name, void(*pf_tests)() )
@@ -54,6 +112,10 @@ int main()
         run_tests("Queries", run_query_tests);
     #endif
 
+    #ifdef NUNO_TESTS_QUERY_CACHE__ 
+        run_tests("Query cache", run_query_cache_tests);
+    #endif
+
     #ifdef NUNO_TESTS_EDITOR__ 
         run_tests("Editor", run_editor_tests);
     #endif
@@ -62,6 +124,26 @@ int main()
         run_tests("Serialization", run_seriealizer_tests);
     #endif
 
+    #ifdef NUNO_TESTS_CACHE__ 
+        run_tests("Load cache", run_cache_tests);
+    #endif
+
+    #ifdef NUNO_TESTS_CONCURRENCY__ 
+        run_tests("Concurrency", run_concurrency_tests);
+    #endif
+
+    #ifdef NUNO_TESTS_DIFF__ 
+        run_tests("Diff", run_diff_tests);
+    #endif
+
+    #ifdef NUNO_TESTS_RELOAD__ 
+        run_tests("Reload", run_reload_tests);
+    #endif
+
+    #ifdef NUNO_TESTS_METRICS__ 
+        run_tests("Metrics", run_metrics_tests);
+    #endif
+
     #ifdef NUNO_TESTS_COMPREHENSSIVE__ 
         run_tests("Integration", run_integration_tests);
     #endif
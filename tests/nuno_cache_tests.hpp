@@ -0,0 +1,239 @@
+#ifndef NUNO_TESTS_CACHE__
+#define NUNO_TESTS_CACHE__
+
+#include "nuno_test_harness.hpp"
+#include "../include/nuno_cache.hpp"
+#include "../include/nuno_serializer.hpp"
+#include "../include/nuno_editor.hpp"
+#include "../include/nuno_query.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace nuno::tests
+{
+using namespace nuno;
+
+namespace
+{
+    constexpr std::string_view cache_src =
+        "version = 3\n"
+        "// settings\n"
+        "server:\n"
+        "    port:int = 8080\n"
+        "    hosts:str[] = a|b|c\n"
+        "    # name  weight:int\n"
+        "      alpha  1\n"
+        "      beta   oops\n"
+        "    :limits\n"
+        "        max = 10\n"
+        "    /limits\n";
+
+    std::filesystem::path fresh_cache_dir(std::string_view name)
+    {
+        auto dir = std::filesystem::temp_directory_path() / "nuno_cache_tests" / name;
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+        return dir;
+    }
+
+    std::string serialize(document const& doc)
+    {
+        std::ostringstream out;
+        serializer s(doc);
+        s.write(out);
+        return out.str();
+    }
+}
+
+static bool cache_hash_matches_reference()
+{
+    // Reference values of XXH64 with seed 0
+    EXPECT(detail::xxh64::hash("") == 0xEF46DB3751D8E999ull, "empty input hash");
+    EXPECT(detail::xxh64::hash("abc") == 0x44BC2CF5AD770999ull, "short input hash");
+    EXPECT(detail::xxh64::hash("abc", 1) != detail::xxh64::hash("abc"), "seed must affect hash");
+    return true;
+}
+
+static bool cache_miss_then_hit()
+{
+    load_cache cache({.directory = fresh_cache_dir("miss_then_hit")});
+
+    auto first = load(cache_src, {}, {}, cache);
+    EXPECT(cache.stats().misses == 1 && cache.stats().stores == 1, "first load should miss and store");
+
+    auto second = load(cache_src, {}, {}, cache);
+    EXPECT(cache.stats().hits == 1, "second load should hit");
+
+    EXPECT(second.errors.size() == first.errors.size(), "errors must be restored");
+    EXPECT(second->key_count() == first->key_count(), "key count differs");
+    EXPECT(second->row_count() == first->row_count(), "row count differs");
+    EXPECT(second->category_count() == first->category_count(), "category count differs");
+    EXPECT(second->has_contamination_sources() == first->has_contamination_sources(), "contamination differs");
+
+    auto port = get_integer(second.document, "server.port");
+    EXPECT(port.has_value() && *port == 8080, "value not restored");
+
+    EXPECT(serialize(second.document) == cache_src, "restored document must replay authored source");
+    return true;
+}
+
+static bool cache_restored_document_is_editable()
+{
+    load_cache cache({.directory = fresh_cache_dir("editable")});
+    (void)load(cache_src, cache);
+    auto ctx = load(cache_src, cache);
+    EXPECT(cache.stats().hits == 1, "expected hit");
+
+    editor ed(ctx.document);
+    auto k = ed.append_key(ctx->root()->id(), "added", int64_t{5});
+    EXPECT(k.valid(), "restored document should accept new keys");
+    EXPECT(ctx->key(k)->id() == k, "new key must not collide with restored IDs");
+    return true;
+}
+
+static bool cache_key_includes_options()
+{
+    load_cache cache({.directory = fresh_cache_dir("options")});
+
+    materialiser_options non_owning;
+    non_owning.own_parser_data = false;
+
+    (void)load(cache_src, {}, {}, cache);
+    (void)load(cache_src, {}, non_owning, cache);
+    EXPECT(cache.stats().misses == 2, "different options must not share an image");
+
+    materialiser_options echo;
+    echo.echo_errors = false;
+    echo.echo_lines = false;
+    (void)load(cache_src, {}, echo, cache);
+    EXPECT(cache.stats().hits == 1, "debug options must not affect the key");
+
+    (void)load(std::string(cache_src) + "extra = 1\n", cache);
+    EXPECT(cache.stats().misses == 3, "different source must miss");
+    return true;
+}
+
+static bool cache_reports_to_metrics_sink()
+{
+    load_cache cache({.directory = fresh_cache_dir("metrics")});
+
+    metrics_recorder rec;
+    materialiser_options mopt;
+    mopt.metrics = &rec;
+
+    (void)load(cache_src, {}, mopt, cache);
+    EXPECT(rec.cache_lookups == 1 && rec.cache.misses == 1 && rec.cache.hits == 0, "first load should report a miss");
+    EXPECT(rec.parses == 1 && rec.materialisations == 1, "a miss runs and reports both stages");
+
+    (void)load(cache_src, {}, mopt, cache);
+    EXPECT(rec.cache_lookups == 2 && rec.cache.hits == 1 && rec.cache.misses == 1, "second load should report a hit");
+    EXPECT(rec.parses == 1 && rec.materialisations == 1, "a hit runs neither stage");
+    EXPECT(rec.cache.bytes_read > 0, "a hit reports the image it restored");
+    EXPECT(rec.cache.hits == cache.stats().hits && rec.cache.misses == cache.stats().misses, "sink and stats agree");
+    return true;
+}
+
+static bool cache_invalidate_and_clear()
+{
+    load_cache cache({.directory = fresh_cache_dir("invalidate")});
+
+    (void)load(cache_src, cache);
+    EXPECT(cache.invalidate(cache_src), "image should exist");
+    EXPECT(!cache.invalidate(cache_src), "image should be gone");
+
+    (void)load(cache_src, cache);
+    EXPECT(cache.stats().misses == 2, "invalidated input must miss");
+
+    cache.clear();
+    (void)load(cache_src, cache);
+    EXPECT(cache.stats().misses == 3, "cleared cache must miss");
+    return true;
+}
+
+static bool cache_rejects_corrupt_image()
+{
+    load_cache cache({.directory = fresh_cache_dir("corrupt")});
+    (void)load(cache_src, cache);
+
+    auto p = cache.path_for(load_cache::key(cache_src, {}, {}));
+    std::filesystem::resize_file(p, std::filesystem::file_size(p) / 2);
+
+    auto ctx = load(cache_src, cache);
+    EXPECT(cache.stats().rejected == 1, "truncated image must be rejected");
+    EXPECT(cache.stats().misses == 2, "rejected image counts as miss");
+    EXPECT(serialize(ctx.document) == cache_src, "fallback load must be complete");
+
+    (void)load(cache_src, cache);
+    EXPECT(cache.stats().hits == 1, "image should have been rewritten");
+    return true;
+}
+
+static bool cache_rejects_flipped_byte()
+{
+    load_cache cache({.directory = fresh_cache_dir("flipped")});
+    (void)load(cache_src, cache);
+
+    // Alter a string in the payload; the image still decodes, so only
+    // the checksum can tell
+    auto p = cache.path_for(load_cache::key(cache_src, {}, {}));
+    std::string bytes;
+    {
+        std::ifstream in(p, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto at = bytes.find("alpha");
+    EXPECT(at != std::string::npos, "image should hold the row text");
+    bytes[at] ^= 0x20;
+    {
+        std::ofstream out(p, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    auto ctx = load(cache_src, cache);
+    EXPECT(cache.stats().rejected == 1, "altered image must be rejected");
+    EXPECT(serialize(ctx.document) == cache_src, "fallback load must be complete");
+    return true;
+}
+
+static bool cache_directory_is_bounded()
+{
+    load_cache cache({.directory = fresh_cache_dir("bounded"), .max_entries = 3});
+
+    for (int i = 0; i < 6; ++i)
+        (void)load("k = " + std::to_string(i) + "\n", cache);
+
+    size_t images = 0;
+    for (auto const& e : std::filesystem::directory_iterator(cache.options().directory))
+        if (e.path().extension() == load_cache::EXTENSION)
+            ++images;
+
+    EXPECT(images == 3, "directory must be bounded to max_entries");
+    EXPECT(cache.stats().evictions == 3, "evictions must be counted");
+    return true;
+}
+
+inline void run_cache_tests()
+{
+    SUBCAT("Hashing");
+    RUN_TEST(cache_hash_matches_reference);
+
+    SUBCAT("Hits and misses");
+    RUN_TEST(cache_miss_then_hit);
+    RUN_TEST(cache_restored_document_is_editable);
+    RUN_TEST(cache_key_includes_options);
+#ifndef NUNO_NO_METRICS
+    RUN_TEST(cache_reports_to_metrics_sink);
+#endif
+
+    SUBCAT("Invalidation and bounds");
+    RUN_TEST(cache_invalidate_and_clear);
+    RUN_TEST(cache_rejects_corrupt_image);
+    RUN_TEST(cache_rejects_flipped_byte);
+    RUN_TEST(cache_directory_is_bounded);
+}
+
+} // ns nuno::tests
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef NUNO_TESTS_CONCURRENCY__
+#define NUNO_TESTS_CONCURRENCY__
+
+// Stress tests for the thread-safety contract. They pass in any build,
+// but are meant to be run under -fsanitize=thread as well.
+
+#include "nuno_test_harness.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_query.hpp"
+#include "../include/nuno_concurrency.hpp"
+
+#include <atomic>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace nuno::tests
+{
+
+static bool concurrent_readers_see_whole_writes()
+{
+    auto ctx = load(
+        "a:int = 0\n"
+        "b:int = 0\n"
+        "t:\n"
+        "    # v:int\n"
+        "      0\n");
+    shared_document shared(std::move(ctx.document));
+
+    std::atomic<bool> done {false};
+    std::atomic<int>  torn {0};
+
+    auto reader = [&]
+    {
+        while (!done.load())
+        {
+            auto doc = shared.read();
+            auto a = get_integer(*doc, "a");
+            auto b = get_integer(*doc, "b");
+            auto v = query(*doc, "t").table(0).rows().project("v").as_integer();
+
+            if (!a || !b || !v || *a != *b || *v != *a)
+                ++torn;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+        readers.emplace_back(reader);
+
+    auto [a, b, row, col] = shared.read([](document const& doc)
+    {
+        auto tbl = doc.table(doc.category("t")->tables()[0]);
+        return std::tuple{doc.key("a")->id(), doc.key("b")->id(), tbl->rows()[0], tbl->columns()[0]};
+    });
+
+    for (int64_t i = 1; i <= 200; ++i)
+    {
+        shared.write([&, i](editor& ed)
+        {
+            ed.set_key_value(a, i);
+            ed.set_key_value(b, i);
+            ed.set_cell_value(row, col, i);
+        });
+    }
+
+    done = true;
+    for (auto& t : readers)
+        t.join();
+
+    EXPECT(torn == 0, "A reader observed a partial write");
+    EXPECT(shared.epoch() == 200, "Every write must advance the epoch");
+    EXPECT(shared.read(&document::key_count) == 2, "Functional read");
+    return true;
+}
+
+static bool shared_query_handle_extraction()
+{
+    auto ctx = load("name = alpha\n");
+    auto const& doc = ctx.document;
+
+    // Extracting a string as an integer records an issue per call
+    auto probe = query(doc, "name");
+    (void)probe.as_integer();
+    size_t per_call = probe.issues().size();
+
+    auto handle = query(doc, "name");
+    size_t before = handle.issues().size();
+
+    constexpr int THREADS = 4, CALLS = 500;
+    std::atomic<int> wrong {0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+        threads.emplace_back([&]
+        {
+            for (int i = 0; i < CALLS; ++i)
+                if (handle.as_integer().has_value() || !handle.as_string().has_value())
+                    ++wrong;
+        });
+
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT(wrong == 0, "Concurrent extraction returned wrong results");
+    EXPECT(handle.issues().size() == before + THREADS * CALLS * per_call, "Issues lost under contention");
+
+    // A column left pending is resolved by whichever extraction comes first
+    auto table = load("# name  hp:int\n  orc  7\n");
+    auto pending = query(table.document, "#0");
+    pending.column("hp");
+
+    threads.clear();
+    for (int t = 0; t < THREADS; ++t)
+        threads.emplace_back([&]
+        {
+            for (int i = 0; i < CALLS; ++i)
+                if (pending.as_integer().value_or(0) != 7)
+                    ++wrong;
+        });
+
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT(wrong == 0, "Concurrent extraction through a pending axis returned wrong results");
+    return true;
+}
+
+static bool concurrent_inspect_with_shared_address()
+{
+    auto ctx = load(
+        "server:\n"
+        "    port:int = 8080\n");
+    auto const& doc = ctx.document;
+
+    reflect::address addr;
+    addr.top("server").key("port");
+
+    std::atomic<int> wrong {0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&]
+        {
+            reflect::address const& shared_addr = addr;
+            for (int i = 0; i < 500; ++i)
+            {
+                reflect::inspect_context ictx{.doc = &doc};
+                auto insp = reflect::inspect(ictx, shared_addr);
+                if (!insp.value || std::get<int64_t>(insp.value->val) != 8080)
+                    ++wrong;
+            }
+        });
+
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT(wrong == 0, "Concurrent inspection failed");
+    return true;
+}
+
+static bool snapshots_stay_fixed_during_writes()
+{
+    auto ctx = load(
+        "a:int = 0\n"
+        "b:int = 0\n"
+        "t:\n"
+        "    # v:int\n"
+        "      0\n");
+    versioned_document versions(std::move(ctx.document));
+
+    auto first = versions.snapshot();
+    auto a = first->key("a")->id();
+    auto b = first->key("b")->id();
+
+    std::atomic<bool> done {false};
+    std::atomic<int>  torn {0};
+
+    auto reader = [&]
+    {
+        while (!done.load())
+        {
+            auto doc = versions.snapshot();
+            auto va = get_integer(*doc, "a");
+
+            // Give the writer time to publish, the snapshot must not move
+            std::this_thread::yield();
+            auto vb = get_integer(*doc, "b");
+            auto v  = query(*doc, "t").table(0).rows().project("v").as_integer();
+
+            if (!va || !vb || !v || *va != *vb || *v != *va)
+                ++torn;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+        readers.emplace_back(reader);
+
+    for (int64_t i = 1; i <= 200; ++i)
+    {
+        versions.write([&, i](editor& ed)
+        {
+            auto row = versions.snapshot()->table(table_id{0})->rows()[0];
+            ed.set_key_value(a, i);
+            ed.set_key_value(b, i);
+            ed.set_cell_value(row, column_id{0}, i);
+        });
+    }
+
+    done = true;
+    for (auto& t : readers)
+        t.join();
+
+    EXPECT(torn == 0, "A snapshot changed while held");
+    EXPECT(versions.version() == 200, "Every write must publish a version");
+    EXPECT(*get_integer(*first, "a") == 0, "The first snapshot must be kept as it was");
+    EXPECT(*get_integer(*versions.snapshot(), "a") == 200, "The latest version must hold every write");
+    return true;
+}
+
+// A version shares the member lists of every category and table it
+// does not restructure, so a structural edit beside a large category
+// costs a few chunks, not that category's lists.
+static bool structural_edits_share_unchanged_lists()
+{
+    constexpr size_t N = 20000;
+
+    std::string src = "a:\n";
+    for (size_t i = 0; i < N; ++i)
+        src += "  k" + std::to_string(i) + ":int = 0\n";
+    src += "  # v:int\n";
+    for (size_t i = 0; i < N; ++i)
+        src += "    " + std::to_string(i) + "\n";
+    src += "/a\n"
+           "b:\n"
+           "  x:int = 0\n"
+           "  y:int = 0\n"
+           "  # v:int\n"
+           "    0\n"
+           "    1\n"
+           "/b\n";
+
+    auto ctx = load(src);
+    versioned_document versions(std::move(ctx.document));
+
+    auto doc   = versions.snapshot();
+    auto b     = doc->category("b")->id();
+    auto y     = doc->category("b")->key("y")->id();
+    auto small = doc->category("b")->tables()[0];
+    auto row   = doc->table(small)->rows()[1];
+
+    auto cost = [&](auto&& edit)
+    {
+        auto before = allocated_bytes.load();
+        versions.write(edit);
+        return allocated_bytes.load() - before;
+    };
+
+    // One chunk of key nodes is the floor; a's lists come to over a
+    // megabyte.
+    constexpr size_t budget = 128 * 1024;
+
+    EXPECT(cost([&](editor& ed) { ed.append_key(b, "z", int64_t{1}); }) < budget, "Appending a key copied unchanged lists");
+    EXPECT(cost([&](editor& ed) { ed.erase_key(y); }) < budget, "Erasing a key copied unchanged lists");
+    EXPECT(cost([&](editor& ed) { ed.move_row_before(row, doc->table(small)->rows()[0]); }) < budget, "Moving a row copied unchanged lists");
+    EXPECT(cost([&](editor& ed) { ed.erase_row(row); }) < budget, "Erasing a row copied unchanged lists");
+
+    auto last = versions.snapshot();
+    EXPECT(last->category("a")->keys().size() == N, "The large category must be left as it was");
+    EXPECT(last->category("b")->keys().size() == 2, "Every edit must be published");
+    EXPECT(last->table(small)->rows().size() == 1, "Every edit must be published");
+    return true;
+}
+
+inline void run_concurrency_tests()
+{
+    SUBCAT("Readers and writers");
+    RUN_TEST(concurrent_readers_see_whole_writes);
+    RUN_TEST(shared_query_handle_extraction);
+    RUN_TEST(concurrent_inspect_with_shared_address);
+
+    SUBCAT("Snapshots");
+    RUN_TEST(snapshots_stay_fixed_during_writes);
+    RUN_TEST(structural_edits_share_unchanged_lists);
+}
+
+} // ns nuno::tests
+
+#endif
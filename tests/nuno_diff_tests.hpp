@@ -0,0 +1,236 @@
+#ifndef NUNO_TESTS_DIFF__
+#define NUNO_TESTS_DIFF__
+
+#include "nuno_test_harness.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_diff.hpp"
+#include "../include/nuno_serializer.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+namespace nuno::tests
+{
+
+// The data a diff compares, in document order
+inline void diff_dump(document const& doc, document::category_view cat, std::string& out)
+{
+    auto text = [](typed_value const& tv)
+    {
+        if (auto const* arr = std::get_if<typed_array>(&tv.val))
+        {
+            std::string s = "[";
+            for (auto const& e : *arr) s += e.value_to_string() + "|";
+            return s + "]";
+        }
+        return tv.value_to_string();
+    };
+
+    // Keys written after a table are listed by it
+    auto keys = [&](auto const& items, auto& self) -> void
+    {
+        for (auto const& item : items)
+        {
+            if (auto const* t = std::get_if<table_id>(&item.id))
+                self(doc.table(*t)->node->ordered_items, self);
+
+            auto const* k = std::get_if<key_id>(&item.id);
+            if (!k) continue;
+
+            auto kv = *doc.key(*k);
+            out += kv.name() + ":" + std::to_string(int(kv.node->type)) + "=" + text(kv.value()) + "\n";
+        }
+    };
+
+    out += "{" + std::string(cat.name()) + "\n";
+    keys(cat.node->ordered_items, keys);
+    for (auto t : cat.tables())
+    {
+        auto tv = *doc.table(t);
+        out += "#";
+        for (auto c : tv.columns()) out += " " + std::string(tv.column(c)->name());
+        out += "\n";
+        for (auto r : tv.rows())
+        {
+            for (auto const& cell : doc.row(r)->cells()) out += " " + text(cell);
+            out += "\n";
+        }
+    }
+    for (auto c : cat.children())
+        diff_dump(doc, *doc.category(c), out);
+    out += "}\n";
+}
+
+inline std::string diff_dump(document const& doc)
+{
+    std::string out;
+    diff_dump(doc, *doc.root(), out);
+    return out;
+}
+
+// The dump of what a document writes out, as loaded again
+inline std::string written_dump(document const& doc)
+{
+    std::ostringstream text;
+    serializer(doc).write(text);
+    return diff_dump(load(text.str()).document);
+}
+
+inline bool diff_of_equal_documents_is_empty()
+{
+    constexpr std::string_view src =
+        "a:int = 1\n"
+        "server:\n"
+        "    port:int = 80\n"
+        "    # name  v:int\n"
+        "      x     1\n";
+
+    auto a = load(src), b = load(src);
+    EXPECT(diff(a.document, b.document).empty(), "Equal documents must not differ");
+    return true;
+}
+
+inline bool diff_reports_changes_by_path()
+{
+    auto a = load(
+        "a:int = 1\n"
+        "b:int = 2\n"
+        "c:int = 3\n"
+        "gone:\n"
+        "    x = 1\n"
+        "server:\n"
+        "    port:int = 80\n"
+        "    # name  v:int\n"
+        "      alpha  1\n"
+        "      beta   2\n"
+        "      gamma  3\n"
+        "      delta  4\n");
+    auto b = load(
+        "c:int = 3\n"
+        "a:int = 10\n"
+        "b:int = 2\n"
+        "d:str = new\n"
+        "server:\n"
+        "    port:int = 80\n"
+        "    # name  v:int\n"
+        "      beta   2\n"
+        "      gamma  30\n"
+        "      alpha  1\n"
+        "      eps    5\n"
+        "fresh:\n"
+        "    y = 2\n");
+
+    auto d = diff(a.document, b.document);
+
+    auto has = [&](change_kind kind, std::string_view path)
+    {
+        return std::ranges::any_of(d.changes, [&](change const& c) { return c.kind == kind && c.path == path; });
+    };
+
+    EXPECT(has(change_kind::modified, "a"), "Modified key");
+    EXPECT(has(change_kind::moved, "c"), "Moved key");
+    EXPECT(has(change_kind::added, "d"), "Added key");
+    EXPECT(has(change_kind::removed, "gone"), "Removed category");
+    EXPECT(has(change_kind::added, "fresh"), "Added category");
+    EXPECT(has(change_kind::modified, "server.#0.-gamma-"), "Modified row");
+    EXPECT(has(change_kind::moved, "server.#0.-alpha-"), "Moved row");
+    EXPECT(has(change_kind::added, "server.#0.-eps-"), "Added row");
+    EXPECT(has(change_kind::removed, "server.#0.-delta-"), "Removed row");
+
+    // Moves are kept to the fewest that restore the order
+    EXPECT(d.count(change_kind::moved) == 2, "Only out-of-order siblings move");
+    EXPECT(!has(change_kind::modified, "server.port") && !has(change_kind::moved, "b"), "Unchanged entities reported");
+    return true;
+}
+
+inline bool diff_replaces_table_with_other_columns()
+{
+    auto a = load("# a:int  b:int\n  1  2\n");
+    auto b = load("# a:int  c:int\n  1  2\n");
+
+    auto d = diff(a.document, b.document);
+    EXPECT(d.size() == 2 && d.count(change_kind::removed) == 1 && d.count(change_kind::added) == 1,
+           "A table whose columns changed is replaced");
+    EXPECT(d.changes[0].path == "#0", "Table path");
+    return true;
+}
+
+inline bool apply_patches_first_into_second()
+{
+    std::vector<std::pair<std::string_view, std::string_view>> pairs
+    {
+        {
+            "a:int = 1\nb:int = 2\nc:int = 3\nold:\n    x = 1\n    :deep\n        z = 1\n    /deep\n"
+            "t:\n    # name  v:int\n      p  1\n      q  2\n      r  3\n      s  4\n",
+            "c:int = 3\na:int = 10\nn:int[] = 1|2\nb:str = two\n"
+            "t:\n    # name  v:int\n      s  4\n      q  20\n      new  9\n      p  1\n    # k\n      only\n"
+            "added:\n    y = 2\n    # h  w:int\n      u  1\n"
+        },
+        {
+            "k = v\n# x:int\n  1\n  2\n  3\n",
+            "k = w\nl = 1\n# x:int  y:int\n  3  1\n"
+        },
+        {
+            "a = 1\nb = 2\nc = 3\nd = 4\ne = 5\n",
+            "e = 5\nd = 4\nx = 0\nc = 3\nb = 2\na = 1\n"
+        },
+
+        // Items written after a table are listed by it, and must
+        // outlive its removal or replacement
+        {
+            "# a\n  1\n# b\n  2\n",
+            "# a\n  1\n"
+        },
+        {
+            "top:\n    # n  v:int\n      a  1\n    k0:int = 3\n",
+            "top:\n    k0:int = 0\n"
+        },
+        {
+            "# a\n  1\n# b\n  2\nk = 1\n# c\n  3\n",
+            "# a\n  1\nk = 1\n# c\n  3\n"
+        },
+        {
+            "# a:int\n  1\n# b:int\n  2\nk = 1\n",
+            "# c:int\n  1\n# b:int\n  2\nk = 1\nl = 2\n"
+        },
+        {
+            "top:\n    # n\n      a\n    k = 1\n    :sub\n        x = 1\n    /sub\n    # m\n      b\n",
+            "top:\n    # n\n      c\n      a\n    k = 2\n    j = 0\n    :sub\n        x = 2\n    /sub\n"
+        },
+    };
+
+    for (auto [from_src, to_src] : pairs)
+    {
+        auto from = load(from_src), to = load(to_src);
+        auto d = diff(from.document, to.document);
+
+        // Patch a fork so the diff's first document stays intact
+        document patched = from.document.fork();
+        {
+            editor ed(patched);
+            EXPECT(apply(ed, d), "Every change must apply");
+        }
+
+        EXPECT(diff_dump(patched) == diff_dump(to.document), "Patched document must match the second");
+        EXPECT(written_dump(patched) == diff_dump(to.document), "Patched document must write out the second");
+        EXPECT(diff(patched, to.document).empty(), "Nothing may differ after patching");
+        EXPECT(diff_dump(from.document) == diff_dump(load(from_src).document), "The first document must be untouched");
+    }
+    return true;
+}
+
+inline void run_diff_tests()
+{
+    SUBCAT("Diff");
+    RUN_TEST(diff_of_equal_documents_is_empty);
+    RUN_TEST(diff_reports_changes_by_path);
+    RUN_TEST(diff_replaces_table_with_other_columns);
+
+    SUBCAT("Apply");
+    RUN_TEST(apply_patches_first_into_second);
+}
+
+}
+
+#endif
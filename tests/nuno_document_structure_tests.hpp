@@ -4,6 +4,9 @@
 #include "nuno_test_harness.hpp"
 #include "../include/nuno.hpp"
 
+#include <algorithm>
+#include <ranges>
+
 namespace nuno::tests
 {
 
@@ -315,6 +318,47 @@ static bool subcategory_at_root_is_rejected()
     return true;
 }
 
+static bool view_ranges_match_vector_accessors()
+{
+    static_assert(std::ranges::forward_range<document::node_range<document::key_view, document::key_node>>);
+    static_assert(std::ranges::forward_range<document::id_range<row_id>>);
+    static_assert(std::ranges::view<document::id_range<category_id>>);
+
+    auto doc = load(
+        "a = 1\n"
+        "x:\n"
+        "  b = 2\n"
+        "  # v:int\n"
+        "    1\n"
+        "    2\n"
+        "  :y\n"
+        "    c = 3\n"
+        "  /y\n");
+
+    auto same = [](auto const& range, auto const& views)
+    {
+        return std::ranges::equal(range, views, [](auto const& l, auto const& r) { return l.id() == r.id(); })
+            && range.size() == views.size();
+    };
+
+    EXPECT(same(doc->categories_range(), doc->categories()), "categories_range");
+    EXPECT(same(doc->tables_range(), doc->tables()), "tables_range");
+    EXPECT(same(doc->columns_range(), doc->columns()), "columns_range");
+    EXPECT(same(doc->rows_range(), doc->rows()), "rows_range");
+    EXPECT(same(doc->keys_range(), doc->keys()), "keys_range");
+
+    auto x = *doc->category("x");
+    EXPECT(std::ranges::equal(x.children_range(), x.children(), {}, [](auto v) { return v.id(); }), "children_range");
+    EXPECT(std::ranges::equal(x.keys_range(), x.keys(), {}, [](auto v) { return v.id(); }), "keys_range");
+
+    auto t = *doc->table(x.tables()[0]);
+    EXPECT(std::ranges::equal(t.rows_range(), t.rows(), {}, [](auto v) { return v.id(); }), "rows_range of a table");
+    EXPECT(std::ranges::equal(t.columns_range(), t.columns(), {}, [](auto v) { return v.id(); }), "columns_range of a table");
+    EXPECT(doc->root()->tables_range().empty(), "Empty range");
+
+    return true;
+}
+
 //----------------------------------------------------------------------------
 
 inline void run_document_structure_tests()
@@ -365,6 +409,9 @@ Key placement rules
     RUN_TEST(keys_attach_to_current_category);
     RUN_TEST(root_key_before_category_is_allowed);
 
+    SUBCAT("Ranges");
+    RUN_TEST(view_ranges_match_vector_accessors);
+
 }
 
 }
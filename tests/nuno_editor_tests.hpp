@@ -4,6 +4,13 @@
 #include "nuno_test_harness.hpp"
 #include "../include/nuno_editor.hpp"
 #include "../include/nuno.hpp"
+#include "../include/nuno_serializer.hpp"
+
+#include <array>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 
 namespace nuno::tests
 {
@@ -91,7 +98,7 @@ inline bool key_scalar_to_array()
     auto & val = key_view->value();
     EXPECT(val.held_type() == value_type::integer_array, "Should become integer array");
 
-    auto & vec = std::get<std::vector<typed_value>>(val.val);
+    auto & vec = std::get<typed_array>(val.val);
     EXPECT(vec.size() == 3, "Array size mismatch");
 
     return true;
@@ -114,7 +121,7 @@ inline bool mutate_key_array_element()
 
     ed.set_array_element(key_view->id(), 1, 42);
 
-    auto & vec = std::get<std::vector<typed_value>>(key_view->value().val);
+    auto & vec = std::get<typed_array>(key_view->value().val);
     EXPECT(std::get<int64_t>(vec[1].val) == 42, "Array element not updated");
 
     return true;
@@ -136,7 +143,7 @@ inline bool append_key_array_element()
 
     ed.append_array_element(key_view->id(), 5);
 
-    auto & vec = std::get<std::vector<typed_value>>(key_view->value().val);
+    auto & vec = std::get<typed_array>(key_view->value().val);
     EXPECT(vec.size() == 2, "Append failed");
     EXPECT(std::get<int64_t>(vec[1].val) == 5, "Wrong appended value");
 
@@ -208,12 +215,42 @@ inline bool append_table_array_element()
     ed.set_cell_value(row->id(), tbl->column("a")->id(), std::vector<value>{1});
     ed.append_array_element(row->id(), tbl->column("a")->id(), 7);
 
-    with (auto vec = std::get<std::vector<typed_value>>(row->cells().front().val))
+    with (auto vec = std::get<typed_array>(row->cells().front().val))
         EXPECT(vec.size() == 2, "Append failed");
 
     return true;
 }
 
+inline bool array_edits_stay_compact()
+{
+    constexpr std::string_view src =
+        "v:int[] = 1|2|3|4|5\n";
+
+    auto ctx = load(src);
+    EXPECT(ctx.errors.empty(), "error emitted");
+
+    auto & doc = ctx.document;
+    auto ed = editor(doc);
+    auto id = doc.key("v")->id();
+
+    ed.append_array_element(id, 6);
+    ed.set_array_element(id, 0, 10);
+    ed.erase_array_element(id, 1);
+
+    auto const & arr = std::get<typed_array>(doc.key(id)->value().val);
+    EXPECT(arr.is_compact() && arr.aside_count() == 0, "edits should keep the array compact");
+    auto ints = arr.integers();
+    EXPECT(ints.size() == 5 && ints[0] == 10 && ints[1] == 3 && ints[4] == 6, "edited buffer mismatch");
+
+    ed.set_array_element(id, 1, std::string("x"));
+    EXPECT(arr.aside_count() == 1 && doc.key(id)->is_contaminated(), "invalid element should be kept aside");
+
+    ed.erase_array_element(id, 1);
+    EXPECT(arr.aside_count() == 0 && !doc.key(id)->is_contaminated(), "erasing the invalid element should clean the array");
+
+    return true;
+}
+
 inline bool append_row_test()
 {
     constexpr std::string_view src =
@@ -513,6 +550,987 @@ inline bool category_creation_and_nesting()
     return true;
 }
 
+inline bool inserted_keys_and_closed_categories_erase_cleanly()
+{
+    auto ctx = load(
+        "a = 1\n"
+        "outer:\n"
+        "    :inner\n"
+        "    /inner\n");
+    auto& doc = ctx.document;
+    editor ed(doc);
+
+    auto root = doc.root()->id();
+    auto b = ed.insert_key_after(doc.key("a")->id(), "b", int64_t{2});
+    EXPECT(doc.root()->keys_count() == 2, "Inserted key must be listed once");
+    EXPECT(ed.erase_key(b) && doc.root()->keys_count() == 1, "Erased key must not linger");
+
+    // The explicit close of inner must go with it
+    auto outer = doc.category("outer")->id();
+    EXPECT(ed.erase_category(doc.category(outer)->child("inner")->id()), "Empty category must erase");
+    EXPECT(ed.erase_category(outer), "Parent emptied of its child must erase");
+    EXPECT(doc.root()->children_count() == 0 && ed._unsafe_access_internal_document_container(root)->ordered_items.size() == 1,
+           "Only the key may remain");
+    return true;
+}
+
+inline bool erased_closed_category_leaves_no_close()
+{
+    auto ctx = load(
+        "outer:\n"
+        "    :x\n"
+        "    /x\n"
+        "    k = 1\n");
+    auto& doc = ctx.document;
+    editor ed(doc);
+
+    auto outer = doc.category("outer")->id();
+    EXPECT(ed.erase_category(doc.category(outer)->child("x")->id()), "Empty closed category must erase");
+
+    std::ostringstream out;
+    serializer(doc).write(out);
+    EXPECT(out.str() == "outer:\n    k = 1\n", "Close marker must go with its category");
+    return true;
+}
+
+inline bool items_after_a_table_outlive_its_edits()
+{
+    // Items written after a table are listed by it, later tables included
+    constexpr std::string_view src = "# a\n  1\n# b\n  2\nk = 1\n# c\n  3\n";
+    auto ctx = load(src);
+    auto& doc = ctx.document;
+    editor ed(doc);
+    ed.enable_journal();
+
+    auto text = [&doc]
+    {
+        std::ostringstream out;
+        serializer(doc).write(out);
+        return out.str();
+    };
+
+    auto tables = doc.root()->tables();
+    auto a = tables[0], b = tables[1];
+    EXPECT(ed.erase_table(b), "Table must erase");
+    EXPECT(text() == "# a\n  1\nk = 1\n# c\n  3\n", "Items after the table take its place");
+
+    EXPECT(ed.erase_key(doc.key("k")->id()), "Key must erase");
+    EXPECT(text() == "# a\n  1\n# c\n  3\n", "Key listed by a table must erase");
+
+    ed.append_row(a, { int64_t{4} });
+    auto again = load(text());
+    auto rows  = [&again](size_t n) { return again.document.table(again.document.root()->tables()[n])->rows().size(); };
+    EXPECT(rows(0) == 2 && rows(1) == 1, "Appended rows go before items written after the table");
+
+    while (ed.undo()) {}
+    EXPECT(text() == src, "Undo restores the table and what it listed");
+    return true;
+}
+
+inline std::vector<std::string> ordered_key_names(editor& ed, document const& doc, category_id cat)
+{
+    std::vector<std::string> names;
+    for (auto const& item : ed._unsafe_access_internal_document_container(cat)->ordered_items)
+        if (std::holds_alternative<key_id>(item.id))
+            names.push_back(std::string(doc.key(std::get<key_id>(item.id))->name()));
+    return names;
+}
+
+inline bool move_child_reorders_items()
+{
+    auto ctx = load("a = 1\nb = 2\nc = 3\n");
+    editor ed(ctx.document);
+
+    auto root = ctx.document.root()->id();
+    auto a = ctx.document.key("a")->id();
+    auto c = ctx.document.key("c")->id();
+
+    ed.move_child_before(c, a);
+    auto names = ordered_key_names(ed, ctx.document, root);
+    EXPECT((names == std::vector<std::string>{"c", "a", "b"}), "c should be moved before a");
+
+    ed.move_child_after(c, ctx.document.key("b")->id());
+    names = ordered_key_names(ed, ctx.document, root);
+    EXPECT((names == std::vector<std::string>{"a", "b", "c"}), "c should be moved back after b");
+
+    return true;
+}
+
+inline bool move_row_reorders_rows()
+{
+    auto ctx = load("# x\n  1\n  2\n  3\n");
+    editor ed(ctx.document);
+
+    auto tbl = ctx.document.table(table_id{0});
+    auto rows = std::vector<row_id>(tbl->rows().begin(), tbl->rows().end());
+    EXPECT(rows.size() == 3, "Wrong row count");
+
+    ed.move_row_before(rows[2], rows[0]);
+    EXPECT(tbl->rows()[0] == rows[2] && tbl->rows()[1] == rows[0], "Row 3 should lead");
+
+    ed.move_row_after(rows[2], rows[1]);
+    EXPECT(tbl->rows()[2] == rows[2], "Row 3 should be last again");
+
+    auto* tn = ed._unsafe_access_internal_document_container(tbl->id());
+    size_t i = 0;
+    for (auto const& item : tn->ordered_items)
+        if (std::holds_alternative<row_id>(item.id))
+            EXPECT(std::get<row_id>(item.id) == tbl->rows()[i++], "ordered_items out of step with rows");
+
+    return true;
+}
+
+inline bool large_table_row_edits_follow_model()
+{
+    std::string src = "# v:int\n";
+    for (int i = 0; i < 300; ++i)
+        src += "  " + std::to_string(i) + "\n";
+
+    auto ctx = load(src);
+    editor ed(ctx.document);
+
+    auto tbl = ctx.document.table(table_id{0});
+    std::vector<row_id> model(tbl->rows().begin(), tbl->rows().end());
+    EXPECT(model.size() == 300, "Wrong row count");
+
+    std::mt19937 rng(7);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    auto at = [&](row_id r) { return std::ranges::find(model, r) - model.begin(); };
+
+    for (int i = 0; i < 400; ++i)
+    {
+        row_id row    = model[pick(model.size())];
+        row_id anchor = model[pick(model.size())];
+        switch (rng() % 4)
+        {
+            case 0:
+                ed.move_row_before(row, anchor);
+                if (row != anchor)
+                {
+                    model.erase(model.begin() + at(row));
+                    model.insert(model.begin() + at(anchor), row);
+                }
+                break;
+            case 1:
+                ed.move_row_after(row, anchor);
+                if (row != anchor)
+                {
+                    model.erase(model.begin() + at(row));
+                    model.insert(model.begin() + at(anchor) + 1, row);
+                }
+                break;
+            case 2:
+            {
+                value cells[] = { int64_t{1}, int64_t{2} };
+                auto first = ed.insert_rows_after(anchor, cells);
+                EXPECT(valid(first), "Insert failed");
+                model.insert(model.begin() + at(anchor) + 1, { first, row_id{first.val + 1} });
+                break;
+            }
+            default:
+                if (model.size() > 1)
+                {
+                    EXPECT(ed.erase_row(row), "Erase failed");
+                    model.erase(model.begin() + at(row));
+                }
+                break;
+        }
+    }
+
+    auto const& rows = tbl->rows();
+    EXPECT(std::ranges::equal(rows, model), "Rows out of step with the model");
+    for (size_t i = 0; i < model.size(); i += 17)
+        EXPECT(rows[i] == model[i] && rows.position(model[i]) == i, "Positional lookup disagrees with iteration");
+
+    auto* tn = ed._unsafe_access_internal_document_container(tbl->id());
+    size_t i = 0;
+    for (auto const& item : tn->ordered_items)
+        if (std::holds_alternative<row_id>(item.id))
+            EXPECT(std::get<row_id>(item.id) == model[i++], "ordered_items out of step with rows");
+
+    return true;
+}
+
+inline bool large_category_insert_and_move()
+{
+    document doc;
+    doc.create_root();
+    editor ed(doc);
+
+    auto root = doc.root()->id();
+
+    // Enough items to go past the list's lookup index threshold
+    std::vector<key_id> keys;
+    for (int i = 0; i < 200; ++i)
+        keys.push_back(ed.append_key(root, "k" + std::to_string(i), int64_t{i}));
+
+    auto mid = ed.insert_key_before(keys[100], "mid", int64_t{-1});
+    EXPECT(valid(mid), "Insert into large category failed");
+
+    ed.move_child_after(keys[0], keys[199]);
+    EXPECT(ed.erase_key(keys[50]), "Erase from large category failed");
+
+    auto names = ordered_key_names(ed, doc, root);
+    EXPECT(names.size() == 200, "Wrong item count");
+    EXPECT(names[97] == "k99" && names[98] == "mid" && names[99] == "k100", "Inserted key misplaced");
+    EXPECT(names.front() == "k1" && names.back() == "k0", "Moved key misplaced");
+
+    return true;
+}
+
+inline std::vector<bool> contamination_snapshot(document const& doc)
+{
+    std::vector<bool> flags;
+    for (auto const& c : doc.categories()) flags.push_back(c.is_contaminated());
+    for (auto const& t : doc.tables())     flags.push_back(t.is_contaminated());
+    for (auto const& r : doc.rows())       flags.push_back(r.is_contaminated());
+    for (auto const& k : doc.keys())       flags.push_back(k.is_contaminated());
+    flags.push_back(doc.has_contamination_sources());
+    return flags;
+}
+
+inline void apply_random_edits(document& doc, unsigned seed, bool batched)
+{
+    editor ed(doc);
+    std::optional<editor::batch> b;
+    if (batched) b.emplace(ed);
+
+    std::mt19937 rng(seed);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    auto some_value = [&]() -> value
+    {
+        if (rng() % 3 == 0) return std::string("bad");
+        return int64_t(rng() % 100);
+    };
+
+    for (int i = 0; i < 300; ++i)
+    {
+        switch (rng() % 3)
+        {
+            case 0:
+            {
+                auto keys = doc.keys();
+                ed.set_key_value(keys[pick(keys.size())].id(), some_value());
+                break;
+            }
+            case 1:
+            {
+                auto rows = doc.rows();
+                auto row = rows[pick(rows.size())];
+                auto cols = row.table().columns();
+                ed.set_cell_value(row.id(), cols[pick(cols.size())], some_value());
+                break;
+            }
+            default:
+            {
+                auto tables = doc.tables();
+                auto tbl = tables[pick(tables.size())];
+                std::vector<value> cells;
+                for (size_t c = 0; c < tbl.column_count(); ++c)
+                    cells.push_back(some_value());
+                ed.append_row(tbl.id(), std::move(cells));
+                break;
+            }
+        }
+    }
+}
+
+inline bool batch_matches_eager_propagation()
+{
+    constexpr std::string_view src =
+        "a:int = 1\n"
+        "b:int = 2\n"
+        "# n:int  m:int\n"
+        "  1  2\n"
+        "  3  4\n"
+        "outer:\n"
+        "    c:int = 3\n"
+        "    # v:int\n"
+        "      5\n"
+        "    :inner\n"
+        "        d:int = 4\n"
+        "        # w:int  z:int\n"
+        "          1  2\n"
+        "    /inner\n";
+
+    for (unsigned seed = 1; seed <= 20; ++seed)
+    {
+        auto eager = load(src);
+        auto batched = load(src);
+
+        apply_random_edits(eager.document, seed, false);
+        apply_random_edits(batched.document, seed, true);
+
+        EXPECT(contamination_snapshot(eager.document) == contamination_snapshot(batched.document),
+               "Batched edits must settle to the same contamination as eager edits");
+    }
+
+    return true;
+}
+
+inline bool batch_defers_until_commit()
+{
+    auto ctx = load("outer:\n    k:int = 1\nother:\n    k:int = 1\n");
+    auto& doc = ctx.document;
+    editor ed(doc);
+
+    auto k = doc.category("outer")->key("k")->id();
+    {
+        editor::batch b(ed);
+        ed.set_key_value(k, std::string("bad"));
+
+        EXPECT(doc.key(k)->is_contaminated(), "Key flags apply immediately");
+        EXPECT(!doc.category("outer")->is_contaminated(), "Category waits for the batch");
+
+        b.commit();
+        EXPECT(doc.category("outer")->is_contaminated(), "Commit propagates");
+        EXPECT(doc.root()->is_contaminated(), "Commit reaches the root");
+    }
+
+    auto k2 = doc.category("other")->key("k")->id();
+    {
+        editor::batch outer(ed);
+        {
+            editor::batch inner(ed);
+            ed.set_key_value(k2, std::string("bad"));
+        }
+        EXPECT(!doc.category("other")->is_contaminated(), "Nested batch must not settle");
+    }
+    EXPECT(doc.category("other")->is_contaminated(), "Outermost batch settles");
+
+    return true;
+}
+
+inline bool batch_left_by_exception()
+{
+    auto ctx = load("outer:\n    k:int = 1\n");
+    auto& doc = ctx.document;
+    editor ed(doc);
+    auto k = doc.category("outer")->key("k")->id();
+
+    auto throw_in_batch = [&](int64_t v)
+    {
+        try
+        {
+            editor::batch b(ed);
+            ed.set_key_value(k, v);
+            ed.set_key_value(k, std::string("bad"));
+            throw std::runtime_error("abandoned");
+        }
+        catch (std::runtime_error const&) {}
+    };
+
+    // With a journal the edits are reverted, and leave no step behind
+    ed.enable_journal();
+    throw_in_batch(2);
+    EXPECT(std::get<int64_t>(doc.key(k)->value().val) == 1, "Value must be reverted");
+    EXPECT(!doc.key(k)->is_contaminated(), "Key flags must be reverted");
+    EXPECT(!doc.category("outer")->is_contaminated(), "Category flags must be reverted");
+    EXPECT(!ed.can_undo() && !ed.can_redo(), "A reverted batch is not a step");
+
+    ed.set_key_value(k, int64_t{3});
+    EXPECT(ed.can_undo(), "The journal must be usable afterwards");
+
+    // Without one they stay, and are settled
+    ed.disable_journal();
+    throw_in_batch(4);
+    EXPECT(doc.key(k)->is_contaminated(), "Edits without a journal are kept");
+    EXPECT(doc.category("outer")->is_contaminated(), "Kept edits are settled");
+    return true;
+}
+
+inline bool bulk_append_rows_matches_append_row()
+{
+    constexpr std::string_view src =
+        "# n:int  s:str\n"
+        "  1  a\n";
+
+    std::vector<value> cells {
+        int64_t{2}, std::string("b"),
+        std::string("oops"), std::string("c"),
+        int64_t{4}
+    };
+
+    auto one = load(src);
+    auto bulk = load(src);
+    auto t = table_id{0};
+
+    {
+        editor ed(one.document);
+        ed.append_row(t, {cells[0], cells[1]});
+        ed.append_row(t, {cells[2], cells[3]});
+        ed.append_row(t, {cells[4]});
+    }
+
+    editor ed(bulk.document);
+    auto first = ed.append_rows(t, std::span<const value>(cells));
+    EXPECT(valid(first), "Bulk append failed");
+
+    auto rows = bulk.document.table(t)->rows();
+    EXPECT(rows.size() == 4, "Wrong row count");
+    EXPECT(rows[1] == first && rows[3] == row_id{first.val + 2}, "Bulk rows must have consecutive IDs");
+
+    auto a = one.document.rows();
+    auto b = bulk.document.rows();
+    EXPECT(a.size() == b.size(), "Row count differs");
+    for (size_t r = 0; r < a.size(); ++r)
+    {
+        EXPECT(a[r].cells().size() == b[r].cells().size(), "Cell count differs");
+        for (size_t c = 0; c < a[r].cells().size(); ++c)
+        {
+            EXPECT(a[r].cells()[c].value_to_string() == b[r].cells()[c].value_to_string(), "Cell value differs");
+            EXPECT(a[r].cells()[c].semantic == b[r].cells()[c].semantic, "Cell validity differs");
+        }
+    }
+
+    EXPECT(contamination_snapshot(one.document) == contamination_snapshot(bulk.document),
+           "Bulk append must contaminate like row-by-row append");
+    EXPECT(bulk.document.table(t)->is_contaminated(), "Invalid row must contaminate its table");
+
+    return true;
+}
+
+inline bool bulk_append_columnar_rows()
+{
+    auto ctx = load("# id:int  name:str  w:float\n");
+    editor ed(ctx.document);
+
+    std::array<int64_t, 3>     ids   { 10, 20, 30 };
+    std::array<std::string, 2> names { "x", "y" };
+    std::array<double, 3>      ws    { 0.5, 1.5, 2.5 };
+
+    std::array<editor::column_cells, 3> columns {
+        std::span<const int64_t>(ids),
+        std::span<const std::string>(names),
+        std::span<const double>(ws)
+    };
+
+    auto first = ed.append_rows(table_id{0}, std::span<const editor::column_cells>(columns));
+    EXPECT(valid(first), "Columnar append failed");
+
+    auto tbl = ctx.document.table(table_id{0});
+    EXPECT(tbl->row_count() == 3, "Longest column sets the row count");
+
+    auto last = ctx.document.row(tbl->rows()[2]);
+    EXPECT(std::get<int64_t>(last->cells()[0].val) == 30, "Wrong integer cell");
+    EXPECT(std::holds_alternative<std::monostate>(last->cells()[1].val), "Short column must be padded");
+    EXPECT(std::get<double>(last->cells()[2].val) == 2.5, "Wrong real cell");
+    EXPECT(!ctx.document.row(tbl->rows()[0])->is_contaminated(), "Well-typed row must be clean");
+
+    return true;
+}
+
+inline bool bulk_insert_rows_keeps_block_order()
+{
+    auto ctx = load("# x:int\n  1\n  4\n");
+    editor ed(ctx.document);
+
+    auto tbl = ctx.document.table(table_id{0});
+    auto r1 = tbl->rows()[0];
+    auto r4 = tbl->rows()[1];
+
+    std::array<value, 2> mid { int64_t{2}, int64_t{3} };
+    auto first = ed.insert_rows_after(r1, std::span<const value>(mid));
+    EXPECT(valid(first), "Bulk insert failed");
+
+    std::array<value, 1> head { int64_t{0} };
+    ed.insert_rows_before(r1, std::span<const value>(head));
+
+    std::vector<int64_t> seen;
+    for (auto rid : tbl->rows())
+        seen.push_back(std::get<int64_t>(ctx.document.row(rid)->cells()[0].val));
+    EXPECT((seen == std::vector<int64_t>{0, 1, 2, 3, 4}), "Block must land at the anchor in order");
+    EXPECT(tbl->rows().back() == r4, "Trailing row must stay last");
+
+    auto* tn = ed._unsafe_access_internal_document_container(tbl->id());
+    size_t i = 0;
+    for (auto const& item : tn->ordered_items)
+        if (std::holds_alternative<row_id>(item.id))
+            EXPECT(std::get<row_id>(item.id) == tbl->rows()[i++], "ordered_items out of step with rows");
+
+    return true;
+}
+
+inline std::string journal_snapshot(document const& doc)
+{
+    std::ostringstream out;
+    serializer(doc).write(out);
+
+    auto ids = [&out](auto span) { out << '['; for (auto id : span) out << id.val << ' '; out << "]"; };
+
+    for (auto const& c : doc.categories())
+    {
+        out << "\ncat " << c.id().val << ' ' << c.name();
+        ids(c.children()); ids(c.keys()); ids(c.tables());
+    }
+    for (auto const& t : doc.tables())
+    {
+        out << "\ntbl " << t.id().val;
+        ids(t.columns()); ids(t.rows());
+    }
+    for (auto const& r : doc.rows())
+    {
+        out << "\nrow " << r.id().val;
+        for (auto const& cell : r.cells()) out << ' ' << cell.value_to_string() << ':' << (int)cell.semantic;
+    }
+    for (auto const& k : doc.keys())
+        out << "\nkey " << k.id().val << ' ' << k.name() << '=' << k.value().value_to_string() << ':' << (int)k.value().semantic;
+
+    out << '\n';
+    for (bool f : contamination_snapshot(doc)) out << f;
+    return out.str();
+}
+
+inline void random_journaled_edit(editor& ed, document& doc, std::mt19937& rng)
+{
+    auto pick = [&](auto const& v) { return v[rng() % v.size()]; };
+    auto some_value = [&]() -> value
+    {
+        if (rng() % 4 == 0) return std::string("bad");
+        return int64_t(rng() % 100);
+    };
+    auto some_cells = [&](document::table_view t)
+    {
+        std::vector<value> cells;
+        for (size_t c = 0; c < t.column_count(); ++c) cells.push_back(some_value());
+        return cells;
+    };
+
+    static int counter = 0;
+    auto fresh = [&] { return "n" + std::to_string(counter++); };
+
+    auto keys = doc.keys();
+    auto rows = doc.rows();
+    auto tables = doc.tables();
+    auto cats = doc.categories();
+
+    switch (rng() % 12)
+    {
+        case 0: ed.set_key_value(pick(keys).id(), some_value()); break;
+        case 1:
+        {
+            auto row = pick(rows);
+            ed.set_cell_value(row.id(), pick(row.table().columns()), some_value());
+            break;
+        }
+        case 2: { auto t = pick(tables); ed.append_row(t.id(), some_cells(t)); break; }
+        case 3: { auto row = pick(rows); ed.insert_row_before(row.id(), some_cells(row.table())); break; }
+        case 4: if (rows.size() > 3) ed.erase_row(pick(rows).id()); break;
+        case 5: ed.append_key(pick(cats).id(), fresh(), some_value()); break;
+        case 6: if (keys.size() > 3) ed.erase_key(pick(keys).id()); break;
+        case 7:
+        {
+            auto row = pick(rows);
+            ed.move_row_after(row.id(), pick(row.table().rows()));
+            break;
+        }
+        case 8:
+        {
+            auto cat = pick(cats);
+            if (cat.keys().size() >= 2)
+                ed.move_child_before(pick(cat.keys()), pick(cat.keys()));
+            break;
+        }
+        case 9:
+        {
+            auto t = pick(tables);
+            if (t.column_count() > 1 && rng() % 2)
+                ed.erase_column(pick(t.columns()));
+            else
+                ed.append_column(t.id(), fresh(), value_type::integer);
+            break;
+        }
+        case 10: ed.append_comment(pick(cats).id(), "// " + fresh()); break;
+        default:
+        {
+            editor::batch b(ed);
+            for (int i = 0; i < 3; ++i)
+            {
+                auto row = pick(doc.rows());
+                ed.set_cell_value(row.id(), pick(row.table().columns()), some_value());
+            }
+            break;
+        }
+    }
+}
+
+inline bool journal_undo_redo_round_trip()
+{
+    constexpr std::string_view src =
+        "a:int = 1\n"
+        "b:int = 2\n"
+        "c:int = 3\n"
+        "# n:int  m:int\n"
+        "  1  2\n"
+        "  3  4\n"
+        "  5  6\n"
+        "outer:\n"
+        "    d:int = 4\n"
+        "    e:int = 5\n"
+        "    # v:int\n"
+        "      7\n"
+        "      8\n";
+
+    for (unsigned seed = 1; seed <= 15; ++seed)
+    {
+        auto ctx = load(src);
+        auto& doc = ctx.document;
+        editor ed(doc);
+        ed.enable_journal();
+
+        std::mt19937 rng(seed);
+        std::vector<std::string> states { journal_snapshot(doc) };
+
+        for (int i = 0; i < 40; ++i)
+        {
+            random_journaled_edit(ed, doc, rng);
+            auto now = journal_snapshot(doc);
+            if (now != states.back())
+                states.push_back(std::move(now));
+        }
+
+        // Walk back to the loaded document, then forward again
+        for (size_t k = states.size() - 1; k > 0; --k)
+        {
+            while (journal_snapshot(doc) == states[k])
+                EXPECT(ed.undo(), "Ran out of undo steps");
+            EXPECT(journal_snapshot(doc) == states[k - 1], "Undo must restore the previous state");
+        }
+        while (ed.undo())
+            EXPECT(journal_snapshot(doc) == states.front(), "Undoing no-op steps must not change the document");
+
+        for (size_t k = 1; k < states.size(); ++k)
+        {
+            while (journal_snapshot(doc) == states[k - 1])
+                EXPECT(ed.redo(), "Ran out of redo steps");
+            EXPECT(journal_snapshot(doc) == states[k], "Redo must restore the next state");
+        }
+    }
+
+    return true;
+}
+
+inline bool journal_steps_and_cap()
+{
+    auto ctx = load("a:int = 1\n# x:int\n  1\n");
+    auto& doc = ctx.document;
+    editor ed(doc);
+
+    EXPECT(!ed.undo(), "No journal, no undo");
+
+    ed.enable_journal();
+    auto a = doc.key("a")->id();
+    auto row = doc.table(table_id{0})->rows()[0];
+    auto col = doc.table(table_id{0})->columns()[0];
+
+    EXPECT(!ed.erase_category(category_id{0}), "The root cannot be erased");
+    EXPECT(!ed.can_undo(), "A rejected edit must not leave a step");
+
+    {
+        editor::batch b(ed);
+        ed.set_key_value(a, int64_t{2});
+        ed.set_cell_value(row, col, int64_t{3});
+        EXPECT(!ed.undo(), "Undo must wait for the batch to close");
+    }
+    EXPECT(ed.can_undo(), "Batch should be one step");
+
+    EXPECT(ed.undo(), "Undo batch");
+    EXPECT(std::get<int64_t>(doc.key(a)->value().val) == 1, "Key not restored");
+    EXPECT(std::get<int64_t>(doc.row(row)->cells()[0].val) == 1, "Cell not restored");
+    EXPECT(!ed.can_undo() && ed.can_redo(), "Batch must undo as a single step");
+
+    ed.set_key_value(a, int64_t{4});
+    EXPECT(!ed.can_redo(), "New edits discard redo history");
+
+    // A cap below a single step keeps nothing
+    ed.disable_journal();
+    ed.enable_journal(1);
+    ed.set_key_value(a, int64_t{5});
+    EXPECT(!ed.can_undo(), "Steps over the cap must be dropped");
+
+    return true;
+}
+
+inline bool contamination_invariants_hold(document const& doc)
+{
+    // Containers are contaminated exactly when a source beneath them is
+    std::function<bool(category_id)> has_source = [&](category_id id)
+    {
+        auto cat = doc.category(id);
+        bool found = false;
+
+        for (auto k : cat->keys())
+            found |= doc.key(k)->is_contaminated();
+
+        for (auto t : cat->tables())
+        {
+            bool rows = false;
+            for (auto r : doc.table(t)->rows())
+                rows |= doc.row(r)->is_contaminated();
+
+            if (doc.table(t)->is_contaminated() != rows) return false;
+            found |= rows;
+        }
+
+        for (auto c : cat->children())
+        {
+            bool below = has_source(c);
+            if (doc.category(c)->is_contaminated() != below) return false;
+            found |= below;
+        }
+
+        return found;
+    };
+
+    bool any = has_source(doc.root()->id());
+    return doc.root()->is_contaminated() == any
+        && doc.has_contamination_sources() == any;
+}
+
+inline bool contamination_counts_follow_random_edits()
+{
+    constexpr std::string_view src =
+        "a:int = 1\n"
+        "# n:int  m:int\n"
+        "  1  2\n"
+        "  3  4\n"
+        "outer:\n"
+        "    b:int = 2\n"
+        "    c:int = 3\n"
+        "    # v:int\n"
+        "      7\n"
+        "      8\n"
+        "    :inner\n"
+        "        d:int = 4\n"
+        "        # w:int\n"
+        "          9\n"
+        "        # when:date  z:int\n"
+        "          x  1\n"
+        "          y  2\n"
+        "    /inner\n";
+
+    // The table declaring an invalid column, if it still has one
+    auto invalid_column_of = [](document const& doc) -> std::optional<std::pair<table_id, column_id>>
+    {
+        for (auto const& t : doc.tables())
+            for (auto c : t.columns())
+                if (!doc.column(c)->is_locally_valid())
+                    return std::pair{t.id(), c};
+        return std::nullopt;
+    };
+
+    for (unsigned seed = 1; seed <= 20; ++seed)
+    {
+        auto ctx = load(src);
+        auto& doc = ctx.document;
+        editor ed(doc);
+        EXPECT(invalid_column_of(doc), "Source must declare an invalid column");
+
+        std::mt19937 rng(seed);
+        for (int i = 0; i < 200; ++i)
+        {
+            auto invalid = invalid_column_of(doc);
+            if (invalid && rng() % 4 == 0)
+            {
+                auto [t, c] = *invalid;
+                switch (rng() % 6)
+                {
+                    case 0: case 1:
+                    {
+                        // Empty the table, leaving only its declarations
+                        auto rows = doc.table(t)->rows();
+                        std::vector<row_id> ids(rows.begin(), rows.end());
+                        for (auto r : ids) ed.erase_row(r);
+                        break;
+                    }
+                    case 2: case 3: ed.append_row(t, { std::string("x"), int64_t{3} }); break;
+                    case 4: ed.append_column(t, "n" + std::to_string(i), value_type::integer); break;
+                    default: ed.erase_column(c); break;
+                }
+            }
+            else
+                random_journaled_edit(ed, doc, rng);
+
+            EXPECT(contamination_invariants_hold(doc), "Contamination flags disagree with their sources");
+        }
+    }
+
+    return true;
+}
+
+inline bool id_bitset_insert_erase_iterate()
+{
+    id_bitset<row_id> set;
+    EXPECT(set.empty() && set.begin() == set.end(), "New set must be empty");
+
+    for (size_t id : {130, 0, 63, 64, 5000, 63})
+        set.insert(row_id{id});
+
+    EXPECT(set.size() == 5, "Duplicate insert must not count");
+    EXPECT(set.contains(row_id{64}) && !set.contains(row_id{65}) && !set.contains(row_id{90000}), "Membership");
+
+    std::vector<size_t> seen;
+    for (auto id : set) seen.push_back(id.val);
+    EXPECT((seen == std::vector<size_t>{0, 63, 64, 130, 5000}), "Iteration must be in ID order");
+
+    EXPECT(set.erase(row_id{63}) && !set.erase(row_id{63}) && !set.erase(row_id{90000}), "Erase reports change");
+    EXPECT(set.size() == 4 && !set.contains(row_id{63}), "Erase");
+
+    set.clear();
+    EXPECT(set.empty() && set.begin() == set.end(), "Clear");
+    return true;
+}
+
+inline bool contaminated_rows_lists_sources()
+{
+    auto ctx = load(
+        "k:int[] = 1|x|3\n"
+        "# a:int\n"
+        "  1\n"
+        "  oops\n"
+        "  3\n"
+        "  bad\n");
+    auto& doc = ctx.document;
+
+    auto rows = doc.table(table_id{0})->rows();
+    std::vector<row_id> broken(doc.contaminated_rows().begin(), doc.contaminated_rows().end());
+    EXPECT((broken == std::vector<row_id>{rows[1], rows[3]}), "Loaded sources not listed");
+    EXPECT(doc.contaminated_keys().size() == 1, "Key source not listed");
+
+    editor ed(doc);
+    ed.set_cell_value(rows[1], doc.table(table_id{0})->columns()[0], int64_t{2});
+    ed.erase_row(rows[3]);
+    ed.set_cell_value(rows[0], doc.table(table_id{0})->columns()[0], std::string("no"));
+
+    broken.assign(doc.contaminated_rows().begin(), doc.contaminated_rows().end());
+    EXPECT((broken == std::vector<row_id>{rows[0]}), "Sources must follow edits");
+    return true;
+}
+
+inline bool value_index_follows_random_edits()
+{
+    constexpr std::string_view src =
+        "a:int = 1\n"
+        "b:int[] = 2|7|2\n"
+        "# n:int  m:int\n"
+        "  1  2\n"
+        "  3  7\n"
+        "outer:\n"
+        "    d:int = 7\n"
+        "    # v:int\n"
+        "      2\n";
+
+    for (unsigned seed = 1; seed <= 10; ++seed)
+    {
+        auto ctx = load(src);
+        auto& doc = ctx.document;
+        editor ed(doc);
+        ed.enable_journal();
+        doc.enable_value_index();
+
+        // A fork carries no index, so it answers by scanning
+        auto agrees = [&doc]
+        {
+            auto scan = doc.fork();
+            for (int64_t v : {1, 2, 7, 42, 99})
+                if (doc.find_value(v) != scan.find_value(v))
+                    return false;
+            return doc.find_value("bad") == scan.find_value("bad");
+        };
+
+        std::mt19937 rng(seed);
+        for (int i = 0; i < 60; ++i)
+        {
+            random_journaled_edit(ed, doc, rng);
+            if (rng() % 5 == 0) ed.undo();
+            if (rng() % 7 == 0) ed.redo();
+            if (i % 3 == 0) EXPECT(agrees(), "Index must follow edits, undo and redo");
+        }
+
+        std::vector<value> cells(doc.table(table_id{0})->column_count() * 3, value{int64_t{42}});
+        ed.append_rows(table_id{0}, std::span<const value>(cells));
+        EXPECT(agrees(), "Index must see bulk rows");
+    }
+    return true;
+}
+
+inline bool node_store_shares_chunks_until_written()
+{
+    constexpr size_t N = node_store<int>::CHUNK * 3 + 17;
+
+    node_store<int> store;
+    std::vector<int> expect;
+    for (int i = 0; i < int(N); ++i) { store.push_back(i); expect.push_back(i); }
+
+    // Insert and erase across chunk boundaries, splitting a chunk
+    std::mt19937 rng(7);
+    for (int i = 0; i < 400; ++i)
+    {
+        size_t at = rng() % (expect.size() + 1);
+        if (rng() % 3 == 0 && at < expect.size())
+        {
+            store.erase(store.begin() + at);
+            expect.erase(expect.begin() + at);
+        }
+        else
+        {
+            store.insert(store.begin() + at, -i);
+            expect.insert(expect.begin() + at, -i);
+        }
+    }
+    EXPECT(std::ranges::equal(store, expect), "Store must behave as a sequence");
+    EXPECT(store.size() == expect.size() && store[expect.size() / 2] == expect[expect.size() / 2], "Indexing");
+
+    auto copy = store;
+    size_t chunks = copy.shared_chunks();
+    EXPECT(chunks > 1 && chunks == store.shared_chunks(), "A copy must share every chunk");
+
+    // Searching through a mutable store must not unshare anything
+    auto it = std::ranges::find(std::as_const(copy), expect.back());
+    EXPECT(copy.unconst(it) != copy.end() && copy.shared_chunks() == chunks, "Lookup unshared a chunk");
+
+    copy.back() = 12345;
+    EXPECT(copy.shared_chunks() == chunks - 1, "Writing must copy only the chunk written to");
+    EXPECT(store.back() == expect.back(), "The original must not see the write");
+    return true;
+}
+
+inline bool fork_isolates_versions()
+{
+    // Enough rows to span several storage chunks
+    std::string src = "a:int = 1\nb:int = 2\nouter:\n    c:int = 3\n    d:int = 4\n    # n:int  m:int\n";
+    for (int i = 0; i < 300; ++i)
+        src += "      " + std::to_string(i) + "  " + std::to_string(i % 7) + "\n";
+
+    for (unsigned seed = 1; seed <= 5; ++seed)
+    {
+        auto ctx = load(src);
+        auto& doc = ctx.document;
+        auto before = journal_snapshot(doc);
+
+        document next = doc.fork();
+        EXPECT(journal_snapshot(next) == before, "A fork must start out equal");
+
+        std::mt19937 rng(seed);
+        {
+            editor ed(next);
+            for (int i = 0; i < 60; ++i)
+                random_journaled_edit(ed, next, rng);
+        }
+        EXPECT(journal_snapshot(doc) == before, "Editing a fork must leave the original untouched");
+        EXPECT(contamination_invariants_hold(next), "Contamination flags disagree with their sources");
+
+        auto forked = journal_snapshot(next);
+        {
+            editor ed(doc);
+            for (int i = 0; i < 60; ++i)
+                random_journaled_edit(ed, doc, rng);
+        }
+        EXPECT(journal_snapshot(next) == forked, "Editing the original must leave the fork untouched");
+    }
+    return true;
+}
+
 //============================================================================
 // Test Runner
 //============================================================================
@@ -532,6 +1550,7 @@ inline void run_editor_tests()
     RUN_TEST(set_table_cell_value);
     RUN_TEST(table_cell_scalar_to_array);
     RUN_TEST(append_table_array_element);
+    RUN_TEST(array_edits_stay_compact);
 
     SUBCAT("Structural edits");
     RUN_TEST(append_row_test);
@@ -550,6 +1569,39 @@ inline void run_editor_tests()
     RUN_TEST(column_insertion_and_deletion);
     RUN_TEST(minimal_create_categories);
     RUN_TEST(category_creation_and_nesting);
+    RUN_TEST(inserted_keys_and_closed_categories_erase_cleanly);
+    RUN_TEST(erased_closed_category_leaves_no_close);
+    RUN_TEST(items_after_a_table_outlive_its_edits);
+
+    SUBCAT("Reordering");
+    RUN_TEST(move_child_reorders_items);
+    RUN_TEST(move_row_reorders_rows);
+    RUN_TEST(large_table_row_edits_follow_model);
+    RUN_TEST(large_category_insert_and_move);
+
+    SUBCAT("Batch edits");
+    RUN_TEST(batch_matches_eager_propagation);
+    RUN_TEST(batch_defers_until_commit);
+    RUN_TEST(batch_left_by_exception);
+
+    SUBCAT("Bulk rows");
+    RUN_TEST(bulk_append_rows_matches_append_row);
+    RUN_TEST(bulk_append_columnar_rows);
+    RUN_TEST(bulk_insert_rows_keeps_block_order);
+
+    SUBCAT("Undo / redo");
+    RUN_TEST(journal_undo_redo_round_trip);
+    RUN_TEST(journal_steps_and_cap);
+
+    SUBCAT("Contamination tracking");
+    RUN_TEST(contamination_counts_follow_random_edits);
+    RUN_TEST(id_bitset_insert_erase_iterate);
+    RUN_TEST(contaminated_rows_lists_sources);
+    RUN_TEST(value_index_follows_random_edits);
+
+    SUBCAT("Versions");
+    RUN_TEST(node_store_shares_chunks_until_written);
+    RUN_TEST(fork_isolates_versions);
 }
 
 }
@@ -8,8 +8,10 @@
 
 #include "nuno_test_harness.hpp"
 #include "../include/nuno.hpp"
+#include "../include/nuno_serializer.hpp"
 
 #include <ranges>
+#include <sstream>
 namespace nuno::tests
 {
 
@@ -376,6 +378,38 @@ static bool array_empty_elements_are_missing_not_contaminating()
     return true;
 }
 
+static bool array_elements_stored_compactly()
+{
+    constexpr std::string_view src =
+        "w:float[] = 1.5|2.5|3.5\n"
+        "n:int[] = 1|2||x|5|6|7|8|9\n"
+        "s:str[] = a||bc|d|e\n";
+
+    auto ctx = load(src);
+    auto & doc = ctx.document;
+
+    auto const & w = std::get<typed_array>(doc.key("w")->value().val);
+    EXPECT(w.is_compact() && w.aside_count() == 0, "valid float array should be compact");
+    EXPECT(w.reals().size() == 3 && w.reals()[1] == 2.5, "reals buffer mismatch");
+    EXPECT(w[2].type == value_type::floating_point && std::get<double>(w[2].val) == 3.5, "element reference mismatch");
+
+    auto const & n = std::get<typed_array>(doc.key("n")->value().val);
+    EXPECT(n.size() == 9 && n.is_compact(), "int array with a few odd elements should stay compact");
+    EXPECT(n.aside_count() == 2, "empty and invalid elements should be kept aside");
+    EXPECT(n.integers().size() == 9 && n.integers()[4] == 5, "integers buffer mismatch");
+    EXPECT(n.element(3).semantic == semantic_state::invalid, "invalid element lost");
+    EXPECT(n.any_invalid(), "invalid element not reported");
+
+    auto const & s = std::get<typed_array>(doc.key("s")->value().val);
+    EXPECT(s.is_compact() && s.string_at(2) == "bc", "string array should be compact");
+
+    std::ostringstream out;
+    serializer(doc).write(out);
+    EXPECT(out.str() == src, "compact arrays should round trip");
+
+    return true;
+}
+
 static bool scope_named_close_of_non_ancestor_is_error()
 {
     constexpr std::string_view src =
@@ -572,7 +606,7 @@ static bool max_category_depth_exceeded_recovers_scope()
     EXPECT(ctx.has_errors(), "depth error not reported");
 
     // x must belong to c, not crash or attach to nonsense
-    auto const& c = ctx.document.categories().at(3);
+    auto c = ctx.document.categories().at(3);
     EXPECT(c.keys().size() == 1, "scope not recovered after depth error");
 
     return true;
@@ -641,6 +675,42 @@ static bool no_key_owned_by_nonexistent_category()
     return true;
 }
 
+static bool owned_parser_data_matches_borrowed()
+{
+    constexpr std::string_view src =
+        "// header\n"
+        "t:\n"
+        "    # name  n:int  xs:int[]\n"
+        "      alpha  1  1|2\n"
+        "      beta   x  3\n"
+        "    k = v\n";
+
+    materialiser_options borrowed;
+    borrowed.own_parser_data = false;
+
+    auto owned = load(src);
+    auto plain = load(src, borrowed);
+
+    std::ostringstream out;
+    serializer(owned.document).write(out);
+    EXPECT(out.str() == src, "owned parser data must still replay the source");
+    EXPECT(owned.errors.size() == plain.errors.size(), "both loads report the same errors");
+
+    auto a = owned.document.rows(), b = plain.document.rows();
+    EXPECT(a.size() == 2 && a.size() == b.size(), "same rows");
+
+    for (size_t r = 0; r < a.size(); ++r)
+        for (size_t c = 0; c < a[r].cells().size(); ++c)
+        {
+            auto const& x = a[r].cells()[c];
+            auto const& y = b[r].cells()[c];
+            EXPECT(x.value_to_string() == y.value_to_string() && x.type == y.type && x.semantic == y.semantic,
+                   "cells taken from owned parser data must match copied cells");
+        }
+
+    return true;
+}
+
 //----------------------------------------------------------------------------
 
 inline void run_materialiser_tests()
@@ -729,6 +799,7 @@ SUBCAT("Arrays");
     RUN_TEST(array_table_cells_valid);
     RUN_TEST(array_invalid_element_contaminates_row);
     RUN_TEST(array_empty_elements_are_missing_not_contaminating);
+    RUN_TEST(array_elements_stored_compactly);
 
 SUBCAT("Correctness after error");
     RUN_TEST(error_then_continue_invalid_key_does_not_block_following_keys);
@@ -740,6 +811,7 @@ SUBCAT("Extras");
     RUN_TEST(category_ids_are_not_dense_indices);
     RUN_TEST(scope_stack_is_never_empty);
     RUN_TEST(no_key_owned_by_nonexistent_category);
+    RUN_TEST(owned_parser_data_matches_borrowed);
 }
 
 }
@@ -0,0 +1,89 @@
+#ifndef NUNO_TESTS_METRICS__
+#define NUNO_TESTS_METRICS__
+
+#include "nuno_test_harness.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_serializer.hpp"
+
+#include <sstream>
+#include <string>
+
+namespace nuno::tests
+{
+
+inline constexpr std::string_view metrics_source =
+    "// inventory\n"
+    "shop:\n"
+    "    name = corner\n"
+    "    open:bool = true\n"
+    "    # item  count:int  price:float\n"
+    "      pen  12  1.5\n"
+    "      ink  many  3.0\n"
+    "/shop\n";
+
+inline bool metrics_follow_each_stage()
+{
+    metrics_recorder rec;
+
+    materialiser_options mopt;
+    mopt.metrics = &rec;
+    auto ctx = load(metrics_source, mopt);
+
+    EXPECT(rec.parses == 1 && rec.materialisations == 1, "load reports both stages to the materialiser's sink");
+    EXPECT(rec.parse.bytes_scanned == metrics_source.size(), "Every byte is scanned");
+    EXPECT(rec.parse.lines == 8, "Lines counted");
+    EXPECT(rec.parse.count(parse_event_kind::table_row) == 2, "Rows counted by kind");
+    EXPECT(rec.parse.count(parse_event_kind::key_value) == 2, "Keys counted by kind");
+    EXPECT(rec.parse.count(parse_event_kind::comment) == 1, "Comments counted by kind");
+    EXPECT(rec.parse.count(parse_event_kind::category_open) == 1
+        && rec.parse.count(parse_event_kind::category_close) == 1, "Categories counted by kind");
+
+    auto const& m = rec.materialise;
+    EXPECT(m.values_of(value_type::integer) == 1, "One cell converted to int");
+    EXPECT(m.values_of(value_type::floating_point) == 2, "Both prices converted to float");
+    EXPECT(m.values_of(value_type::boolean) == 1, "One bool key");
+    EXPECT(m.values_of(value_type::string) == 4, "Names, and the failed count degraded to string");
+    EXPECT(m.conversion_failures == 1, "The failed count is reported");
+    EXPECT(m.contamination_propagations == 1, "The contaminated row propagates");
+    EXPECT(m.errors == ctx.errors.size(), "Errors counted");
+
+    serializer_options sopt;
+    sopt.metrics = &rec;
+    std::ostringstream out;
+    serializer(ctx.document, sopt).write(out);
+    EXPECT(rec.serializations == 1, "Serializer reports");
+    EXPECT(rec.serialize.bytes_written == out.str().size(), "Bytes written match the output");
+    EXPECT(out.str() == metrics_source, "Measured output is unchanged");
+    return true;
+}
+
+inline bool metrics_sink_is_optional()
+{
+    metrics_recorder rec;
+
+    parser_options popt;
+    popt.metrics = &rec;
+    auto ctx = load(metrics_source, popt, {});
+    EXPECT(rec.parses == 1 && rec.materialisations == 0, "Only the stage given a sink reports");
+
+    auto plain = load(metrics_source);
+    EXPECT(rec.parses == 1, "No sink, no report");
+
+    rec.reset();
+    EXPECT(rec.parses == 0 && rec.parse.bytes_scanned == 0, "Reset clears the totals");
+    return true;
+}
+
+inline void run_metrics_tests()
+{
+    // Sinks are ignored when metrics are compiled out
+#ifndef NUNO_NO_METRICS
+    SUBCAT("Stages");
+    RUN_TEST(metrics_follow_each_stage);
+    RUN_TEST(metrics_sink_is_optional);
+#endif
+}
+
+}
+
+#endif
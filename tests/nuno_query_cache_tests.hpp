@@ -0,0 +1,109 @@
+#ifndef NUNO_TESTS_QUERY_CACHE__
+#define NUNO_TESTS_QUERY_CACHE__
+
+#include "nuno_test_harness.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_editor.hpp"
+#include "../include/nuno_query_cache.hpp"
+
+#include <string>
+
+namespace nuno::tests
+{
+
+inline constexpr std::string_view query_cache_source =
+    "server:\n"
+    "    port:int = 8080\n"
+    "    host = localhost\n"
+    "    ratio:float = 0.5\n"
+    "    debug:bool = true\n";
+
+inline bool query_cache_hits_repeat_paths()
+{
+    auto ctx = load(query_cache_source);
+    query_cache cache(ctx.document);
+
+    EXPECT(*cache.get_integer("server.port") == 8080, "First lookup resolves");
+    EXPECT(*cache.get_integer("server.port") == 8080, "Repeat lookup");
+    EXPECT(*cache.get_integer("server.port.") == 8080, "Trailing separator is the same path");
+    EXPECT(cache.stats().misses == 1 && cache.stats().hits == 2, "One miss, then hits");
+
+    EXPECT(*cache.get_string_view("server.host") == "localhost", "Borrowed string");
+    EXPECT(*cache.get_bool("server.debug") && *cache.get_real("server.ratio") == 0.5, "Other types");
+    EXPECT(*cache.get_as_string("server.port") == "8080", "Converting getter");
+    EXPECT(cache.size() == 4, "One entry per path");
+
+    // Failures are cached too, and do not accumulate issues
+    for (int i = 0; i < 3; ++i)
+        EXPECT(cache.get_integer("server.host").error() == query_issue_kind::type_mismatch, "Cached failure");
+    EXPECT(cache.select("server.host").issues().empty(), "No issues left behind");
+    EXPECT(cache.get_integer("server.nothing").error() == query_issue_kind::empty_result, "Missing path");
+    return true;
+}
+
+inline bool query_cache_evicts_least_recently_used()
+{
+    auto ctx = load(query_cache_source);
+    query_cache cache(ctx.document, 2);
+
+    cache.get_integer("server.port");
+    cache.get_string("server.host");
+    cache.get_integer("server.port");   // port is now the most recent
+    cache.get_real("server.ratio");     // evicts host
+
+    EXPECT(cache.size() == 2 && cache.stats().evictions == 1, "Bounded by capacity");
+
+    auto before = cache.stats().misses;
+    cache.get_integer("server.port");
+    EXPECT(cache.stats().misses == before, "Recently used entry kept");
+    cache.get_string("server.host");
+    EXPECT(cache.stats().misses == before + 1, "Least recently used entry evicted");
+    return true;
+}
+
+inline bool query_cache_follows_document_generation()
+{
+    auto ctx = load(query_cache_source);
+    auto& doc = ctx.document;
+    query_cache cache(doc);
+
+    EXPECT(*cache.get_integer("server.port") == 8080, "Before the edit");
+
+    auto gen  = doc.generation();
+    auto port = doc.root()->child("server")->key("port")->id();
+    editor ed(doc);
+    ed.set_key_value(port, int64_t{9090});
+    EXPECT(doc.generation() > gen, "Edits bump the generation");
+
+    EXPECT(*cache.get_integer("server.port") == 9090, "Edited value is seen");
+    EXPECT(cache.stats().invalidations == 1 && cache.stats().misses == 2, "Cache dropped after the edit");
+
+    ed.enable_journal();
+    ed.set_key_value(port, int64_t{1});
+    cache.get_integer("server.port");
+    ed.undo();
+    EXPECT(*cache.get_integer("server.port") == 9090, "Undo is an edit too");
+
+    // Undo and redo with nothing to apply leave the cache alone
+    gen = doc.generation();
+    auto invalidations = cache.stats().invalidations;
+    EXPECT(!ed.undo() && ed.redo() && !ed.redo(), "One step to redo");
+    EXPECT(doc.generation() == gen + 1, "Only the applied step bumps the generation");
+    EXPECT(*cache.get_integer("server.port") == 1, "Redone value is seen");
+    EXPECT(cache.stats().invalidations == invalidations + 1, "Cache dropped once");
+    return true;
+}
+
+inline void run_query_cache_tests()
+{
+    SUBCAT("Lookup");
+    RUN_TEST(query_cache_hits_repeat_paths);
+    RUN_TEST(query_cache_evicts_least_recently_used);
+
+    SUBCAT("Invalidation");
+    RUN_TEST(query_cache_follows_document_generation);
+}
+
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include "../include/nuno_query.hpp"
 #include "../include/nuno.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -144,7 +145,7 @@ namespace nuno::tests
             EXPECT(k->name() == "arr", "The key should be named arr");
             EXPECT(k->is_array(), "The key should be an array");
             EXPECT(k->value().type == value_type::integer_array, "The key should be an array of integers");
-            auto const & arr = std::get<std::vector<typed_value>>(k->value().val);
+            auto const & arr = std::get<typed_array>(k->value().val);
             EXPECT(arr.size() == 3, "The array's arity should be 3");
             EXPECT(arr.at(1).type == value_type::integer && std::get<std::int64_t>(arr.at(1).val) == 13, "arr[1] != 13");
         }
@@ -874,6 +875,254 @@ namespace nuno::tests
         return true;
     }
 
+    // -----------------------------------------------------------------
+    // Dot-path globs
+    // -----------------------------------------------------------------
+
+    bool dotpath_globs_match_any_depth()
+    {
+        auto ctx = load(R"(
+            hp:int = 1
+            monsters:
+                count:int = 2
+                :orc
+                    hp:int = 10
+                    # name   armour:int
+                      grunt  1
+                      chief  3
+                /orc
+                :elf
+                    hp:int = 20
+                    :archer
+                        hp:int = 21
+                    /archer
+                /elf
+            players:
+                hp:int = 100
+        )");
+        auto& doc = ctx.document;
+
+        auto all = [&](std::string_view path)
+        {
+            std::vector<int64_t> out;
+            auto h = query(doc, path);
+            for (auto const& loc : h.locations())
+                if (loc.value_ptr && loc.value_ptr->type == value_type::integer)
+                    out.push_back(std::get<int64_t>(loc.value_ptr->val));
+            return out;
+        };
+
+        EXPECT(all("**.hp") == std::vector<int64_t>({1, 10, 20, 21, 100}), "** matches every depth in document order");
+        EXPECT(all("monsters.**.hp") == std::vector<int64_t>({10, 20, 21}), "** below a category");
+        EXPECT(all("**.**.hp") == all("**.hp"), "Repeated ** does not duplicate matches");
+        EXPECT(all("monsters.*.hp") == std::vector<int64_t>({10, 20}), "* matches one level");
+
+        auto star = query(doc, "monsters.*");
+        EXPECT(star.locations().size() == 3, "* matches keys and subcategories");
+
+        auto tables = query(doc, "monsters.*.#");
+        EXPECT(tables.locations().size() == 1 && tables.locations()[0].kind == location_kind::table_scope,
+               "Tables of every subcategory");
+
+        EXPECT(*query(doc, "**.#0.-chief-.|armour|").as_integer() == 3, "Axis selectors after a glob run");
+
+        auto located = query(doc, "**.archer.hp");
+        EXPECT(located.locations().size() == 1 && *located.as_integer() == 21, "Names inside a glob run");
+
+        // Keys after a subcategory, and a subcategory after a table
+        auto later = load(R"(
+            a:
+                :sub
+                    v:int = 1
+                /sub
+                v:int = 2
+                # x
+                  0
+                :tail
+                    v:int = 3
+                /tail
+            b:
+                v:int = 4
+        )");
+        std::vector<int64_t> order;
+        auto h = query(later.document, "**.v");
+        for (auto const& loc : h.locations())
+            order.push_back(std::get<int64_t>(loc.value_ptr->val));
+        EXPECT(order == std::vector<int64_t>({1, 2, 3, 4}), "** follows the authored order");
+
+        // A name looked up after * finds a subcategory and a key sharing it in authored order
+        auto shared = load(R"(
+            a:
+                w:int = 0
+                :x
+                    y:int = 1
+                /x
+                x:int = 2
+        )");
+        auto named = query(shared.document, "*.x");
+        EXPECT(named.locations().size() == 2
+               && named.locations()[0].kind == location_kind::category_scope
+               && named.locations()[1].kind == location_kind::terminal_value
+               && std::get<int64_t>(named.locations()[1].value_ptr->val) == 2, "Shared names in authored order");
+        EXPECT(*query(shared.document, "*.x.y").as_integer() == 1, "Looked-up subcategory is entered");
+
+        reflect::inspect_context ictx{ &doc };
+        EXPECT(reflect::locate(ictx, located.locations()[0].addr).value == located.locations()[0].value_ptr,
+               "Glob matches carry resolvable addresses");
+
+        EXPECT(query(doc, "**.nothing").empty(), "No match");
+        return true;
+    }
+
+    bool where_value_finds_references()
+    {
+        auto ctx = load(R"(
+            owner:int = 4711
+            items:
+                # id:int  name   refs:int[]
+                  4711    sword  1|2
+                  12      bow    4711|4711
+                :loot
+                    chest:int[] = 3|4711
+                    label:str = 4711
+                /loot
+            other:
+                best:int = 4711
+        )");
+        auto& doc = ctx.document;
+
+        auto scanned = doc.find_value(4711);
+        doc.enable_value_index();
+        auto indexed = doc.find_value(4711);
+
+        EXPECT(scanned == indexed, "The index answers as the scan does");
+        EXPECT(indexed.size() == 6, "Keys, cells and array elements holding 4711");
+        EXPECT(indexed[0].is_key() && indexed[0].key == doc.root()->key("owner")->id(), "Keys come first");
+        EXPECT(indexed[1].is_key() && indexed[1].element == 1, "Array element position");
+        EXPECT(doc.find_value("4711").size() == 1, "Strings do not match integers");
+        EXPECT(doc.find_value(4711.0).empty(), "Reals do not match integers");
+
+        EXPECT(query(doc).where_value(4711).locations().size() == 6, "A new handle searches the whole document");
+
+        auto items = query(doc, "items").where_value(4711);
+        EXPECT(items.locations().size() == 4, "Category scope includes subcategories");
+        for (auto const& loc : items.locations())
+        {
+            reflect::inspect_context ictx{ &doc };
+            EXPECT(loc.kind == location_kind::terminal_value && reflect::locate(ictx, loc.addr).value == loc.value_ptr,
+                   "Matches carry resolvable addresses");
+        }
+
+        EXPECT(query(doc, "items.#0").where_value(4711).locations().size() == 3, "Table scope");
+        EXPECT(query(doc, "items.#0.-12-").where_value(4711).locations().size() == 2, "Row scope");
+        EXPECT(*query(doc, "items.loot.chest").where_value(4711).as_integer() == 4711, "Terminal array scope");
+        EXPECT(query(doc, "other").where_value(12).empty(), "No match in scope");
+
+        EXPECT(query(doc, "nonexistent").where_value(4711).empty(), "An empty selection is not widened");
+        EXPECT(query(doc).where_value(99).where_value(4711).empty(), "An empty filter result is not widened");
+        return true;
+    }
+
+    // -----------------------------------------------------------------
+    // Borrowing extraction
+    // -----------------------------------------------------------------
+
+    bool borrowed_extraction_matches_copies()
+    {
+        auto ctx = load(R"(
+            top:
+                name = a_string_longer_than_small_buffers
+                ints:int[] = 10|nope|30
+                reals:float[] = 1.5|2.5
+                strs:str[] = alpha|beta|gamma
+        )");
+
+        auto name = query(ctx.document, "top.name").as_string_view();
+        EXPECT(name.has_value() && *name == *query(ctx.document, "top.name").as_string(), "string view value");
+
+        auto key = ctx.document.root()->child("top")->key("name");
+        EXPECT(name->data() == std::get<std::string>(key->value().val).data(), "string view must refer into the document");
+
+        auto ints = query(ctx.document, "top.ints").as_integers_view();
+        EXPECT(ints.has_value(), "as_integers_view() should succeed on int[]");
+        EXPECT(ints->size() == 2 && ints->elements().size() == 3, "invalid elements are skipped, not removed");
+        EXPECT(std::ranges::equal(*ints, *query(ctx.document, "top.ints").as_integers()), "integer view values");
+
+        auto reals = get_reals_view(ctx.document, "top.reals");
+        EXPECT(reals.has_value() && std::ranges::equal(*reals, std::vector<double>{1.5, 2.5}), "real view values");
+        EXPECT(reals->contiguous().size() == 2 && reals->contiguous()[1] == 2.5, "valid real array should be contiguous");
+        EXPECT(ints->contiguous().empty(), "array with skipped elements has no contiguous buffer");
+
+        auto strs = get_strings_view(ctx.document, "top.strs");
+        EXPECT(strs.has_value() && std::ranges::equal(*strs, *get_strings(ctx.document, "top.strs")), "string array view values");
+
+        auto wrong = query(ctx.document, "top.strs").as_integers_view();
+        EXPECT(!wrong.has_value() && wrong.error() == query_issue_kind::type_mismatch, "type mismatch as for copies");
+
+        auto missing = get_string_view(ctx.document, "top.nothing");
+        EXPECT(!missing.has_value() && missing.error() == query_issue_kind::empty_result, "empty result as for copies");
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------
+    // Column-wise extraction
+    // -----------------------------------------------------------------
+
+    bool column_extraction_fills_buffers()
+    {
+        auto ctx = load(R"(
+            units:
+                # name   damage:int  speed:float  alive:bool
+                  orc    10          1.5          true
+                  elf    nope        2.5          false
+                  troll  30          0.5          true
+                # name   speed:float
+                  ghost  9.5
+        )");
+
+        // Table scope: rows in order, the invalid cell reported separately
+        std::vector<int64_t>     damage(3, -1);
+        std::vector<cell_status> status(3);
+        auto q = query(ctx.document, "units.#0");
+
+        EXPECT(q.row_count() == 3, "row count of one table");
+        auto before = allocated_bytes.load();
+        auto n = q.into("damage", std::span(damage), std::span(status));
+        EXPECT(allocated_bytes.load() == before, "filling buffers allocates nothing");
+        EXPECT(n.has_value() && *n == 3, "every row written");
+        EXPECT(damage[0] == 10 && damage[1] == 0 && damage[2] == 30, "invalid cells are zeroed");
+        EXPECT(status[0] == cell_status::valid && status[1] == cell_status::invalid && status[2] == cell_status::valid,
+               "invalid mask");
+
+        // After where(), only the matching rows
+        auto alive = query(ctx.document, "units.#0").where(eq("alive", true)).column_values<double>("speed");
+        EXPECT(alive.has_value() && *alive == std::vector<double>({1.5, 0.5}), "filtered rows");
+
+        // Category scope spans tables; rows of a table without the column are missing
+        std::vector<cell_status> st;
+        auto dmg = query(ctx.document, "units").column_values<int64_t>("damage", &st);
+        EXPECT(dmg.has_value() && dmg->size() == 4, "rows of both tables");
+        EXPECT(st[3] == cell_status::missing, "missing mask");
+
+        auto names = query(ctx.document, "units").column_values<std::string_view>("name");
+        EXPECT(names.has_value() && (*names)[3] == "ghost", "borrowed strings");
+
+        // Errors
+        std::vector<int64_t> small(2);
+        EXPECT(query(ctx.document, "units.#0").into("damage", std::span(small)).error() == query_issue_kind::invalid_index,
+               "short buffer");
+        EXPECT(query(ctx.document, "units.#0").into("damage", std::span<int64_t>{}).error() == query_issue_kind::invalid_index,
+               "no buffer");
+        EXPECT(query(ctx.document, "units").column_values<int64_t>("armour").error() == query_issue_kind::not_found,
+               "unknown column");
+        EXPECT(query(ctx.document, "units.#0").where(eq("damage", 99)).column_values<int64_t>("damage").error()
+                   == query_issue_kind::empty_result,
+               "no rows");
+
+        return true;
+    }
+
     bool array_whole_extraction_skips_invalid()
     {
         // int[] with one non-integer element: contaminated array.
@@ -1060,6 +1309,10 @@ namespace nuno::tests
         RUN_TEST(query_hash_n_out_of_range);
         RUN_TEST(query_hash_selects_all_tables);
         RUN_TEST(query_hash_then_row_selection);
+        SUBCAT("Dot-path globs");
+        RUN_TEST(dotpath_globs_match_any_depth);
+        SUBCAT("Value lookup");
+        RUN_TEST(where_value_finds_references);
         SUBCAT("Array extraction");
         RUN_TEST(array_whole_extraction_integers);
         RUN_TEST(array_whole_extraction_reals);
@@ -1068,6 +1321,8 @@ namespace nuno::tests
         RUN_TEST(array_whole_extraction_empty_path);
         RUN_TEST(array_whole_extraction_ambiguous);
         RUN_TEST(array_whole_extraction_skips_invalid);
+        RUN_TEST(borrowed_extraction_matches_copies);
+        RUN_TEST(column_extraction_fills_buffers);
         RUN_TEST(array_indexed_get_integer);
         RUN_TEST(array_indexed_get_real);
         RUN_TEST(array_indexed_get_string);
@@ -5,6 +5,9 @@
 #include "../include/nuno.hpp"
 #include "../include/nuno_reflect.hpp"
 
+#include <algorithm>
+#include <ranges>
+
 namespace nuno::tests
 {
 template <typename T>
@@ -421,6 +424,47 @@ static bool inspect_reports_partial_progress()
     return true;
 }
 
+static bool locate_leaves_address_untouched()
+{
+    using namespace nuno::reflect;
+
+    auto ctx = load(
+        "a:\n"
+        "  x = 1\n"
+        "  # v:int\n"
+        "    5\n"
+        "b:\n"
+        "  # v:int\n"
+        "    7\n"
+    );
+
+    auto ta = ctx.document.category("a")->tables()[0];
+    auto tb = ctx.document.category("b")->tables()[0];
+    auto foreign = ctx.document.table(tb)->rows()[0];
+
+    inspect_context ictx{ .doc = &ctx.document };
+
+    const address good = root().top("a").table(ta).row(ctx.document.table(ta)->rows()[0]).column("v");
+    auto loc = locate(ictx, good);
+
+    EXPECT(loc.ok(good) && loc.value && std::get<int64_t>(loc.value->val) == 5, "locate must resolve the cell");
+    EXPECT(good.steps[0].diagnostic.state == step_state::uninspected, "locate must not write diagnostics");
+
+    const address bad = root().top("a").table(ta).row(foreign).column("v");
+    loc = locate(ictx, bad);
+
+    EXPECT(loc.steps_inspected == 3 && loc.error == step_error::row_not_owned, "A row of another table is not owned");
+    EXPECT(loc.diagnostic(1).state == step_state::ok && loc.diagnostic(2).state == step_state::error
+           && loc.diagnostic(3).state == step_state::uninspected, "Per-step diagnostics");
+    EXPECT(std::holds_alternative<document::table_view>(loc.item), "Last valid item is the table");
+
+    auto res = inspect(ictx, bad);
+    EXPECT(res.steps_inspected == loc.steps_inspected && res.addr->steps[2].diagnostic.error == step_error::row_not_owned,
+           "inspect must agree with locate");
+
+    return true;
+}
+
 static bool structural_children_of_category()
 {
     using namespace nuno::reflect;
@@ -475,6 +519,91 @@ static bool structural_children_of_category()
     return true;
 }
 
+static bool structural_children_range_matches_vector()
+{
+    using namespace nuno::reflect;
+
+    static_assert(std::ranges::forward_range<structural_child_range>);
+
+    auto ctx = load(
+        "r = 1\n"
+        "a:\n"
+        "  x = 1\n"
+        "  n:int[] = 1|2|3\n"
+        "  # c  d\n"
+        "    1  2\n"
+        "  :s\n"
+        "  /s\n"
+        "b:\n"
+    );
+
+    inspect_context ictx{ .doc = &ctx.document };
+    auto tid = ctx.document.category("a")->tables()[0];
+    auto rid = ctx.document.table(tid)->rows()[0];
+
+    const address addrs[] =
+    {
+        root(),
+        root().top("a"),
+        root().top("a").key("n"),
+        root().top("a").key("x"),
+        root().top("a").table(tid),
+        root().top("a").table(tid).row(rid),
+        root().top("a").sub("missing"),
+    };
+
+    for (auto const& addr : addrs)
+    {
+        auto res = inspect(ictx, addr);
+        auto vec = res.structural_children(ictx);
+        auto range = res.structural_children_range(ictx);
+
+        EXPECT(range.size() == vec.size(), "Range size");
+        EXPECT(std::ranges::equal(range, vec, [](structural_child const& l, structural_child const& r)
+               { return l.kind == r.kind && l.name == r.name && l.ordinal == r.ordinal; }), "Range must match vector");
+    }
+
+    auto top = inspect(ictx, root()).structural_children(ictx);
+    EXPECT(top.size() == 3 && top[0].kind == structural_child::kind::top_category && top[0].name == "a"
+           && top[1].name == "b" && top[2].kind == structural_child::kind::key, "Root lists top-level categories, then keys");
+
+    return true;
+}
+
+static bool structural_children_of_compact_array_reference_nothing()
+{
+    using namespace nuno::reflect;
+
+    auto ctx = load(
+        "a:\n"
+        "  n:int[] = 1|2|3\n"
+    );
+
+    inspect_context ictx{ .doc = &ctx.document };
+    auto res = inspect(ictx, root().top("a").key("n"));
+
+    auto const& arr = std::get<typed_array>(res.value->val);
+    EXPECT(arr.is_compact(), "integer arrays load compact");
+
+    auto before = allocated_bytes.load();
+    size_t indices = 0;
+    for (auto const& c : res.structural_children_range(ictx))
+    {
+        if (c.kind != structural_child::kind::index)
+            continue;
+        EXPECT(c.ordinal == indices++, "indices in order");
+        EXPECT(!c.value && std::holds_alternative<std::monostate>(c.item), "compact elements carry no reference");
+    }
+    EXPECT(indices == 3, "every element is listed");
+    EXPECT(allocated_bytes.load() == before, "listing the elements builds nothing");
+
+    // Stepping into an element references it
+    auto element = inspect(ictx, res.extend_address({ .kind = structural_child::kind::index, .name = {}, .ordinal = 1, .item = {} }));
+    EXPECT(element.ok() && element.value && std::get<int64_t>(element.value->val) == 2, "element resolves by address");
+
+    return true;
+}
+
 static bool structural_children_after_failed_inspection()
 {
     using namespace nuno::reflect;
@@ -827,6 +956,7 @@ inline void run_reflection_tests()
     RUN_TEST(reflect_empty_address_is_root);
     RUN_TEST(reflect_empty_address_has_item_but_no_value);
     RUN_TEST(inspect_reports_partial_progress);
+    RUN_TEST(locate_leaves_address_untouched);
 
     SUBCAT("Address semantics");
     RUN_TEST(reflect_top_level_category_key);
@@ -849,6 +979,8 @@ inline void run_reflection_tests()
     SUBCAT("Structural queries");
     RUN_TEST(structural_children_of_category);
     RUN_TEST(structural_children_after_failed_inspection);
+    RUN_TEST(structural_children_range_matches_vector);
+    RUN_TEST(structural_children_of_compact_array_reference_nothing);
     RUN_TEST(structural_children_of_table_row);
     RUN_TEST(structural_children_of_scalar_value_is_empty);
     RUN_TEST(structural_extend_address_from_category);
@@ -0,0 +1,308 @@
+#ifndef NUNO_TESTS_RELOAD__
+#define NUNO_TESTS_RELOAD__
+
+#include "nuno_test_harness.hpp"
+#include "../include/nuno.hpp"
+#include "../include/nuno_reload.hpp"
+#include "../include/nuno_serializer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace nuno::tests
+{
+
+inline constexpr std::string_view reload_source =
+    "version = 3\n"
+    "server:\n"
+    "    port:int = 8080\n"
+    "    host = local\n"
+    "    # name  weight:int\n"
+    "      alpha  1\n"
+    "      beta   2\n"
+    "    :limits\n"
+    "        max:int = 10\n"
+    "    /limits\n"
+    "client:\n"
+    "    retries:int = 3\n"
+    "    // trailing comment\n";
+
+inline bool digest_splits_top_level_sections()
+{
+    auto d = digest_source(reload_source);
+
+    EXPECT(d.splittable, "Plain sections split");
+    EXPECT(d.spans.size() == 3, "Preamble and two sections");
+    EXPECT(d.spans[0].name.empty() && d.spans[1].name == "server" && d.spans[2].name == "client", "Span names");
+    EXPECT(reload_source.substr(d.spans[2].offset, d.spans[2].length).starts_with("client:"), "Spans start at their header");
+    EXPECT(d.spans[2].first_line == 10, "Lines before the span");
+
+    size_t total = 0;
+    for (auto const& s : d.spans) total += s.length;
+    EXPECT(total == reload_source.size(), "Spans cover the text");
+
+    EXPECT(!digest_source("a:\n  x = 1\n/a\ny = 2\n").splittable, "Returning to the root is not splittable");
+    EXPECT(!digest_source("a:\n  x = 1\nb:\nA:\n").splittable, "Repeated sections are not splittable");
+    return true;
+}
+
+inline bool reload_reparses_only_changed_sections()
+{
+    auto first = load(reload_source);
+    auto& doc  = first.document;
+
+    std::string text(reload_source);
+    text.replace(text.find("beta   2"), 8, "beta   5");
+    text += "    timeout:int = 30\n";
+
+    auto ctx = reload(doc, digest_source(reload_source), text);
+
+    EXPECT(!ctx.full, "Sections line up");
+    EXPECT(ctx.reparsed.size() == 2 && ctx.reparsed[0] == "server" && ctx.reparsed[1] == "client",
+           "Only changed sections are parsed");
+    EXPECT(diff(ctx.document, load(text).document).empty(), "Reload must equal a full load");
+
+    // Unchanged entities keep their IDs
+    auto const& re = ctx.document;
+    EXPECT(re.root()->child("server")->id() == doc.root()->child("server")->id(), "Category ID");
+    EXPECT(re.root()->key("version")->id() == doc.root()->key("version")->id(), "Preamble key ID");
+
+    auto port = doc.root()->child("server")->key("port")->id();
+    EXPECT(re.key(port) && re.key(port)->value().value_to_string() == "8080", "Untouched key in a changed section");
+
+    auto t = doc.root()->child("server")->tables().front();
+    auto beta = doc.table(t)->rows()[1];
+    EXPECT(re.row(beta) && re.row(beta)->cells()[1].value_to_string() == "5", "Modified row keeps its ID");
+
+    EXPECT(doc.row(beta)->cells()[1].value_to_string() == "2", "The previous document is untouched");
+    return true;
+}
+
+inline bool reload_adds_and_removes_sections()
+{
+    auto first = load(reload_source);
+
+    std::string text(reload_source);
+    text.erase(text.find("client:"));
+    text += "extra:\n    on = yes\n";
+
+    auto ctx = reload(first.document, digest_source(reload_source), text);
+
+    EXPECT(!ctx.full, "Sections line up");
+    EXPECT(ctx.reparsed.size() == 1 && ctx.reparsed[0] == "extra", "Only the new section is parsed");
+    EXPECT(!ctx.document.root()->child("client"), "Removed section");
+    EXPECT(ctx.document.root()->child("extra"), "Added section");
+    EXPECT(diff(ctx.document, load(text).document).empty(), "Reload must equal a full load");
+    return true;
+}
+
+inline bool reload_falls_back_to_full_parse()
+{
+    constexpr std::string_view before = "a:\n    x = 1\n/a\ny = 2\nb:\n    z = 3\n";
+    constexpr std::string_view after  = "a:\n    x = 1\n/a\ny = 5\nb:\n    z = 3\n";
+
+    auto first = load(before);
+    auto ctx   = reload(first.document, digest_source(before), after);
+
+    EXPECT(ctx.full, "Unsplittable text is parsed in full");
+    EXPECT(diff(ctx.document, load(after).document).empty(), "Reload must equal a full load");
+
+    auto z = first.document.root()->child("b")->key("z")->id();
+    EXPECT(ctx.document.key(z), "IDs survive a full reload");
+    return true;
+}
+
+inline bool reload_reports_lines_of_whole_text()
+{
+    constexpr std::string_view before = "a:\n    x:int = 1\nb:\n    y:int = 2\n";
+    constexpr std::string_view after  = "a:\n    x:int = 1\nb:\n    y:int = oops\n";
+
+    auto first = load(before);
+    auto ctx   = reload(first.document, digest_source(before), after);
+
+    auto full = load(after);
+    EXPECT(!ctx.errors.empty() && ctx.errors.size() == full.errors.size(), "Errors of the changed section");
+
+    auto line = [](error<any_error> const& e) { return std::visit([](auto const& x) { return x.loc.line; }, e.kind); };
+    EXPECT(line(ctx.errors[0]) == line(full.errors[0]), "Lines count from the start of the text");
+    return true;
+}
+
+inline std::string serialized(document const& doc)
+{
+    std::ostringstream out;
+    serializer(doc).write(out);
+    return out.str();
+}
+
+inline std::string replaced(std::string_view text, std::string_view what, std::string_view with)
+{
+    std::string res(text);
+    res.replace(res.find(what), what.size(), with);
+    return res;
+}
+
+// Comments, paragraphs, order and authored form survive a reload as
+// they do a load of the same text
+inline bool reload_serializes_as_a_fresh_load()
+{
+    std::string nested = replaced(reload_source, "    /limits\n", "    /limits\n    :retry\n        n:int = 1\n    /retry\n");
+    std::string swapped_nested = replaced(nested, "    :limits\n        max:int = 10\n    /limits\n", "");
+    swapped_nested = replaced(swapped_nested, "    /retry\n", "    /retry\n    :limits\n        max:int = 10\n    /limits\n");
+
+    auto client = std::string(reload_source).substr(std::string_view(reload_source).find("client:"));
+    auto swapped_top = client + std::string(reload_source).substr(0, std::string_view(reload_source).find("client:"));
+    swapped_top = "version = 3\n" + replaced(swapped_top, "version = 3\n", "");
+
+    struct edit { char const* what; std::string before; std::string after; };
+    std::vector<edit> edits {
+        { "comment",        std::string(reload_source), replaced(reload_source, "// trailing comment", "// another comment") },
+        { "paragraph",      std::string(reload_source), replaced(reload_source, "    host = local\n", "    host = local\n\n    Some prose.\n\n") },
+        { "subcategories",  nested,                     swapped_nested },
+        { "top level",      std::string(reload_source), swapped_top },
+        { "key form",       std::string(reload_source), std::string(reload_source) + "    w:int =   7   // note\n" },
+        { "preamble",       std::string(reload_source), replaced(reload_source, "version = 3\n", "// header\nversion = 3\n") },
+        { "full reload",    "a:\n    x = 1\n/a\ny = 2\n", "a:\n    // x\n    x =  1\n/a\n\ny = 2\n" },
+    };
+
+    for (auto const& e : edits)
+    {
+        auto first = load(e.before);
+        auto ctx   = reload(first.document, digest_source(e.before), e.after);
+        auto fresh = load(e.after);
+
+        if (ctx.full != (e.what == std::string_view("full reload"))
+         || serialized(ctx.document) != serialized(fresh.document) || serialized(fresh.document) != e.after)
+        {
+            std::cout << "  (" << e.what << ")\n";
+            EXPECT(false, "Reload must serialize as a load of the same text");
+        }
+    }
+
+    // A reload of a reload keeps the source of both
+    auto first  = load(reload_source);
+    auto second = replaced(reload_source, "beta   2", "beta   7  // seven");
+    auto third  = replaced(second, "// trailing comment", "retries:int   =  4\n");
+    auto r2 = reload(first.document, digest_source(reload_source), second);
+    auto r3 = reload(r2.document, r2.digest, third);
+    EXPECT(!r3.full && serialized(r3.document) == third, "Chained reloads keep the source of each");
+    EXPECT(diff(r3.document, load(third).document).empty(), "Chained reloads must equal a full load");
+    return true;
+}
+
+inline bool hot_document_publishes_reloads()
+{
+    auto dir = std::filesystem::temp_directory_path() / "nuno_reload_tests";
+    std::filesystem::create_directories(dir);
+
+    for (auto watch : { file_watcher::mode::polling, file_watcher::mode::automatic })
+    {
+        auto path = dir / "hot.nuno";
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << reload_source;
+
+        hot_document hot(path, { .watch = watch });
+        EXPECT(hot.snapshot()->root()->child("server"), "Initial load");
+        EXPECT(!hot.poll(), "Nothing changed yet");
+
+        auto old = hot.snapshot();
+
+        std::string text(reload_source);
+        text.replace(text.find("retries:int = 3"), 15, "retries:int = 42");
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+
+        EXPECT(hot.poll(std::chrono::seconds(2)), "The change is seen");
+        EXPECT(hot.versions().version() == 1, "One version published");
+        EXPECT(hot.reparsed().size() == 1 && hot.reparsed()[0] == "client", "Only the changed section is parsed");
+
+        auto retries = hot.snapshot()->root()->child("client")->key("retries");
+        EXPECT(retries && retries->value().value_to_string() == "42", "New value");
+        EXPECT(old->root()->child("client")->key("retries")->value().value_to_string() == "3",
+               "Earlier snapshots are unchanged");
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return true;
+}
+
+inline bool hot_document_keeps_writes_made_during_a_reload()
+{
+    auto dir = std::filesystem::temp_directory_path() / "nuno_reload_tests";
+    std::filesystem::create_directories(dir);
+    auto path = dir / "hot_write.nuno";
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << reload_source;
+
+    // Starts a write while the reload is parsing
+    struct write_during_parse : metrics_sink
+    {
+        hot_document* hot {nullptr};
+        key_id        port;
+        std::thread   writer;
+
+        void start()
+        {
+            writer = std::thread([this]
+            {
+                hot->versions().write([this](editor& ed) { ed.set_key_value(port, int64_t{9090}); });
+            });
+        }
+
+        void on_parse(parse_metrics const&) override
+        {
+            if (hot && !writer.joinable())
+                start();
+        }
+    } sink;
+
+    hot_reload_options opts { .watch = file_watcher::mode::polling };
+    opts.parser.metrics = &sink;
+    hot_document hot(path, opts);
+    sink.port = hot.snapshot()->root()->child("server")->key("port")->id();
+    sink.hot  = &hot;
+
+    std::string text(reload_source);
+    text.replace(text.find("retries:int = 3"), 15, "retries:int = 42");
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+
+    EXPECT(hot.poll(std::chrono::seconds(2)), "The change is seen");
+
+    // Without metrics the sink is never called
+    if (!sink.writer.joinable())
+        sink.start();
+    sink.writer.join();
+
+    auto doc = hot.snapshot();
+    EXPECT(hot.versions().version() == 2, "Reload and write both published");
+    EXPECT(doc->root()->child("server")->key("port")->value().value_to_string() == "9090", "The write is kept");
+    EXPECT(doc->root()->child("client")->key("retries")->value().value_to_string() == "42", "The reload is kept");
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return true;
+}
+
+inline void run_reload_tests()
+{
+    SUBCAT("Digest");
+    RUN_TEST(digest_splits_top_level_sections);
+
+    SUBCAT("Reload");
+    RUN_TEST(reload_reparses_only_changed_sections);
+    RUN_TEST(reload_adds_and_removes_sections);
+    RUN_TEST(reload_falls_back_to_full_parse);
+    RUN_TEST(reload_reports_lines_of_whole_text);
+    RUN_TEST(reload_serializes_as_a_fresh_load);
+
+    SUBCAT("Watch");
+    RUN_TEST(hot_document_publishes_reloads);
+    RUN_TEST(hot_document_keeps_writes_made_during_a_reload);
+}
+
+}
+
+#endif
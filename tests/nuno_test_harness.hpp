@@ -1,6 +1,7 @@
 #ifndef NUNO_TESTS_HARNESS__
 #define NUNO_TESTS_HARNESS__
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -17,6 +18,9 @@ namespace nuno::tests
     extern std::vector<test_result> results;
     extern char const * last_error;
 
+    // Bytes requested from the global operator new so far (main.cpp)
+    extern std::atomic<size_t> allocated_bytes;
+
     #define EXPECT(cond, false_msg)                        \
         do                                                 \
         {                                                  \